@@ -0,0 +1,31 @@
+#include "Aad.hpp"
+
+thread_local AadTape *AadTape::active_ = nullptr;
+
+void AadTape::Backward(uint32_t output) {
+    adjoints_.assign(nodes_.size(), 0.0);
+    if (output >= nodes_.size()) return;
+    adjoints_[output] = 1.0;
+
+    // nodes only refer to earlier ones : one sweep from the output down propagates every adjoint
+    for (size_t i = output + 1; i-- > 0;) {
+        const double adjoint = adjoints_[i];
+        if (adjoint == 0.0) continue;
+        const Node &n = nodes_[i];
+        if (n.arg[0] != Constant) adjoints_[n.arg[0]] += adjoint * n.partial[0];
+        if (n.arg[1] != Constant) adjoints_[n.arg[1]] += adjoint * n.partial[1];
+    }
+}
+
+AadSensitivities ComputeAadGreeks(double K, double S, double r, double q, double T, double sigma, bool isCall, AadTape &tape,
+                                  PricingModel model) {
+    return Differentiate(K, S, r, q, T, sigma, tape,
+                         [&](const AadReal &k, const AadReal &s, const AadReal &rate, const AadReal &yield, const AadReal &t, const AadReal &vol) {
+                             return OptionPrice(k, s, rate, yield, t, vol, isCall, model);
+                         });
+}
+
+void ComputeAadBatch(const OptionBatch &batch, size_t begin, size_t end, AadSensitivities *out, AadTape &tape, PricingModel model) {
+    for (size_t k = begin; k < end; ++k)
+        out[k] = ComputeAadGreeks(batch.K[k], batch.S[k], batch.r[k], batch.q[k], batch.T[k], batch.sigma[k], batch.isCall[k] != 0, tape, model);
+}
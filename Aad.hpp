@@ -0,0 +1,176 @@
+#ifndef AAD_HPP_
+#define AAD_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "GreekSet.hpp"
+#include "Greeks.hpp"
+
+// Adjoint algorithmic differentiation (reverse mode) on a tape.
+//
+// A pricing function written once as a template on its arithmetic runs with double to price, and with AadReal to
+// record every operation on the tape of the thread : one node per operation holding the partial derivatives of
+// its result with respect to its (at most 2) arguments. One backward sweep over the tape then gives the derivative
+// of the price with respect to every input, whatever their number, at a small constant multiple of the cost of
+// the price. Constants (a strike that is not differentiated, literals) are not recorded.
+//
+// The tape is an arena : Clear() keeps its capacity, so once it has grown to the size of a pricing, recording and
+// sweeping allocate nothing.
+
+class AadTape {
+public:
+    static constexpr uint32_t Constant = 0xffffffffu;   // node of a value that is not on the tape
+
+    // New input of the recording
+    uint32_t Leaf() { return Record(Constant, 0.0, Constant, 0.0); }
+    // Result of an operation on a (and b), with the partial derivatives da and db of the result
+    uint32_t Record(uint32_t a, double da, uint32_t b = Constant, double db = 0.0) {
+        nodes_.push_back({{a, b}, {da, db}});
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    // Adjoints of every node : d output / d node, read with Adjoint()
+    void Backward(uint32_t output);
+    double Adjoint(uint32_t node) const { return node < adjoints_.size() ? adjoints_[node] : 0.0; }
+
+    void Clear() { nodes_.clear(); adjoints_.clear(); }   // keeps the capacity
+    void Reserve(size_t nodes) { nodes_.reserve(nodes); adjoints_.reserve(nodes); }
+    size_t Size() const { return nodes_.size(); }
+
+    // Tape AadReal operations of this thread are recorded on, nullptr outside a Recording
+    static AadTape *Active() { return active_; }
+
+    // Makes `tape` the active tape of this thread for its lifetime (the previous one is restored after)
+    class Recording {
+    public:
+        explicit Recording(AadTape &tape) : previous_(active_) { active_ = &tape; }
+        ~Recording() { active_ = previous_; }
+        Recording(const Recording &) = delete;
+        Recording &operator=(const Recording &) = delete;
+
+    private:
+        AadTape *previous_;
+    };
+
+private:
+    struct Node {
+        uint32_t arg[2];
+        double partial[2];
+    };
+    std::vector<Node> nodes_;
+    std::vector<double> adjoints_;
+    static thread_local AadTape *active_;
+};
+
+// Number recorded on the active tape. Built from a double it is a constant
+struct AadReal {
+    double value = 0.0;
+    uint32_t node = AadTape::Constant;
+
+    AadReal() = default;
+    AadReal(double v) : value(v) {}
+    AadReal(double v, uint32_t n) : value(v), node(n) {}
+
+    // New input on the active tape
+    static AadReal Input(double v) { return AadReal(v, AadTape::Active()->Leaf()); }
+    bool IsConstant() const { return node == AadTape::Constant; }
+};
+
+// Result of a unary operation of value v and derivative dv
+inline AadReal AadUnary(const AadReal &x, double v, double dv) {
+    return x.IsConstant() ? AadReal(v) : AadReal(v, AadTape::Active()->Record(x.node, dv));
+}
+inline AadReal AadBinary(const AadReal &a, const AadReal &b, double v, double da, double db) {
+    if (a.IsConstant()) return AadUnary(b, v, db);
+    if (b.IsConstant()) return AadUnary(a, v, da);
+    return AadReal(v, AadTape::Active()->Record(a.node, da, b.node, db));
+}
+
+inline AadReal operator+(const AadReal &a, const AadReal &b) { return AadBinary(a, b, a.value + b.value, 1.0, 1.0); }
+inline AadReal operator-(const AadReal &a, const AadReal &b) { return AadBinary(a, b, a.value - b.value, 1.0, -1.0); }
+inline AadReal operator*(const AadReal &a, const AadReal &b) { return AadBinary(a, b, a.value * b.value, b.value, a.value); }
+inline AadReal operator/(const AadReal &a, const AadReal &b) {
+    const double inv = 1.0 / b.value;
+    return AadBinary(a, b, a.value * inv, inv, -a.value * inv * inv);
+}
+inline AadReal operator-(const AadReal &x) { return AadUnary(x, -x.value, -1.0); }
+
+inline AadReal exp(const AadReal &x) {
+    const double v = std::exp(x.value);
+    return AadUnary(x, v, v);
+}
+inline AadReal log(const AadReal &x) { return AadUnary(x, std::log(x.value), 1.0 / x.value); }
+inline AadReal sqrt(const AadReal &x) {
+    const double v = std::sqrt(x.value);
+    return AadUnary(x, v, 0.5 / v);
+}
+
+// Standard normal N' and N, for double and AadReal (N' = -x N'(x), dN = N')
+inline double NormPdf(double x) { return 0.3989422804014327 * std::exp(-0.5 * x * x); }
+inline double NormCdf(double x) { return 0.5 * std::erfc(-x * 0.7071067811865476); }
+inline AadReal NormPdf(const AadReal &x) {
+    const double pdf = NormPdf(x.value);
+    return AadUnary(x, pdf, -x.value * pdf);
+}
+inline AadReal NormCdf(const AadReal &x) { return AadUnary(x, NormCdf(x.value), NormPdf(x.value)); }
+
+// Price of a European option, written once for double and AadReal. Same models as the Greek kernels
+// (GreekKernels.hpp) : with Black76 and Bachelier S is the forward and q is ignored, Bachelier sigma is a normal vol
+template <typename Real>
+Real OptionPrice(const Real &K, const Real &S, const Real &r, const Real &q, const Real &T, const Real &sigma, bool isCall,
+                 PricingModel model = Model_BlackScholes) {
+    using std::exp;
+    using std::log;
+    using std::sqrt;
+    const Real sqrtT = sqrt(T);
+    const Real volSqrtT = sigma * sqrtT;
+    const Real discR = exp(-r * T);
+    if (model == Model_Bachelier) {
+        const Real d = (S - K) / volSqrtT;
+        return isCall ? discR * ((S - K) * NormCdf(d) + volSqrtT * NormPdf(d))
+                      : discR * ((K - S) * NormCdf(-d) + volSqrtT * NormPdf(d));
+    }
+    const Real forward = model == Model_Black76 ? S : S * exp((r - q) * T);
+    const Real d1 = (log(forward / K) + 0.5 * sigma * sigma * T) / volSqrtT;
+    const Real d2 = d1 - volSqrtT;
+    return isCall ? discR * (forward * NormCdf(d1) - K * NormCdf(d2))
+                  : discR * (K * NormCdf(-d2) - forward * NormCdf(-d1));
+}
+
+// Price and first order sensitivities of one option. Theta is dV/dt = -dV/dT per year and Rho dV/dr, as the
+// analytic Greeks; dividend is dV/dq (0 for Black76 and Bachelier)
+struct AadSensitivities {
+    double price;
+    double delta;
+    double vega;
+    double theta;
+    double rho;
+    double dividend;
+};
+
+// Records price(K, S, r, q, T, sigma) (AadReal arguments, AadReal result) on `tape` and returns the price and its
+// sensitivities from one backward sweep. `tape` is cleared first; the strike is a constant. This is how a new
+// payoff or model gets its Greeks : write its price once as a template, no formula and no bump
+template <class Pricer>
+AadSensitivities Differentiate(double K, double S, double r, double q, double T, double sigma, AadTape &tape, Pricer &&price) {
+    tape.Clear();
+    AadTape::Recording recording(tape);
+    const AadReal s = AadReal::Input(S), rate = AadReal::Input(r), yield = AadReal::Input(q);
+    const AadReal t = AadReal::Input(T), vol = AadReal::Input(sigma);
+    const AadReal v = price(AadReal(K), s, rate, yield, t, vol);
+    if (v.IsConstant()) return {v.value, 0.0, 0.0, 0.0, 0.0, 0.0};
+    tape.Backward(v.node);
+    return {v.value, tape.Adjoint(s.node), tape.Adjoint(vol.node), -tape.Adjoint(t.node), tape.Adjoint(rate.node), tape.Adjoint(yield.node)};
+}
+
+// OptionPrice of one contract differentiated on `tape` (28 nodes for Black-Scholes, 24 for Black76, 19 for Bachelier)
+AadSensitivities ComputeAadGreeks(double K, double S, double r, double q, double T, double sigma, bool isCall, AadTape &tape,
+                                  PricingModel model = Model_BlackScholes);
+
+// Options [begin, end) of the batch, out[k] for option k, recorded one after the other on `tape`
+void ComputeAadBatch(const OptionBatch &batch, size_t begin, size_t end, AadSensitivities *out, AadTape &tape,
+                     PricingModel model = Model_BlackScholes);
+
+#endif /* AAD_HPP_ */
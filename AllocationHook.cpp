@@ -0,0 +1,41 @@
+// Replacement of every global operator new and delete, counting the calls and bytes into the Profiler
+// counters (Counter_Allocations, Counter_Bytes). Compiled into the programs that count their allocations,
+// greeks_bench and the GUI, never into greeks_core: a replacement in the library would be picked up by every
+// program linking it.
+//
+// The aligned forms (over-aligned types such as the GreekTensor storage) go through the same counter. Every
+// delete frees through Release(), kept out of line: inlined into a caller, its free() of a new'd pointer
+// would be flagged by -Wmismatched-new-delete.
+#include "Profiler.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+void *Acquire(size_t size, size_t alignment) {
+    Profiler::CountAllocation(size);
+    size = size ? size : 1;
+    // aligned_alloc wants a multiple of the alignment; both are released by free()
+    void *p = alignment <= alignof(std::max_align_t) ? std::malloc(size)
+                                                     : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (p) return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void Release(void *p) noexcept { std::free(p); }
+
+} // namespace
+
+void *operator new(size_t size) { return Acquire(size, 0); }
+void *operator new[](size_t size) { return Acquire(size, 0); }
+void *operator new(size_t size, std::align_val_t alignment) { return Acquire(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, std::align_val_t alignment) { return Acquire(size, static_cast<size_t>(alignment)); }
+void operator delete(void *p) noexcept { Release(p); }
+void operator delete[](void *p) noexcept { Release(p); }
+void operator delete(void *p, size_t) noexcept { Release(p); }
+void operator delete[](void *p, size_t) noexcept { Release(p); }
+void operator delete(void *p, std::align_val_t) noexcept { Release(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { Release(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { Release(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { Release(p); }
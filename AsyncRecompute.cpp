@@ -0,0 +1,87 @@
+#include "AsyncRecompute.hpp"
+#include "Profiler.hpp"
+
+AsyncRecompute::AsyncRecompute() : worker_(&AsyncRecompute::WorkerLoop, this) {}
+
+AsyncRecompute::~AsyncRecompute() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        cancel_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+}
+
+void AsyncRecompute::Submit(const RecomputeRequest &request) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = request;
+        hasPending_ = true;
+        ++submitted_;
+        if (computing_) cancel_ = true;   // the job in flight is stale now
+    }
+    wake_.notify_one();
+}
+
+bool AsyncRecompute::Poll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ready_) return false;
+    ready_ = false;
+    if (redrawOnly_) {
+        // the values on display are still valid for the new request
+        front_.request = back_.request;
+        front_.version = back_.version;
+        front_.pointsComputed = 0;
+        return true;
+    }
+    front_.StockPrices.swap(back_.StockPrices);
+    front_.TimeToMaturities.swap(back_.TimeToMaturities);
+    front_.GreekValues.swap(back_.GreekValues);
+    std::swap(front_.request, back_.request);
+    std::swap(front_.version, back_.version);
+    std::swap(front_.computedAt, back_.computedAt);
+    std::swap(front_.pointsComputed, back_.pointsComputed);
+    return true;
+}
+
+bool AsyncRecompute::Busy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hasPending_ || computing_;
+}
+
+double AsyncRecompute::AgeSeconds() const {
+    if (front_.version == 0) return -1.0;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - front_.computedAt).count();
+}
+
+void AsyncRecompute::WorkerLoop() {
+    GREEKS_PROFILE_THREAD("recompute");
+    for (;;) {
+        RecomputeRequest request;
+        unsigned long long version = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || hasPending_; });
+            if (stop_) return;
+            request = pending_;
+            version = submitted_;
+            hasPending_ = false;
+            computing_ = true;
+            cancel_ = false;
+            ready_ = false;   // an unpublished result is older than this request, back_ is ours again
+        }
+
+        const int status = IncrementalRecompute(request, front_, back_, scratch_, &cancel_);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        computing_ = false;
+        if ((status == 0 || status == 2) && !hasPending_) {
+            back_.request = request;
+            back_.version = version;
+            if (status == 0) back_.computedAt = std::chrono::steady_clock::now();
+            redrawOnly_ = (status == 2);
+            ready_ = true;
+        }
+    }
+}
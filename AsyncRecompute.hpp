@@ -0,0 +1,56 @@
+#ifndef ASYNCRECOMPUTE_HPP_
+#define ASYNCRECOMPUTE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "GreekTensor.hpp"
+#include "RecomputePlan.hpp"
+
+// Runs Recompute on a background thread so the GUI keeps rendering the last completed surface.
+//
+// Submit() supersedes any queued request and cancels the one in flight. The worker computes into
+// the back buffer; Poll() (GUI thread) publishes a finished result by swapping it with the front
+// buffer, so Front() never changes while the GUI reads it and no grid is ever copied.
+// Each request only recomputes what depends on the parameters that changed since the front
+// buffer (IncrementalRecompute); the worker reads the front buffer, which Poll() never swaps
+// while a job is running.
+class AsyncRecompute {
+public:
+    AsyncRecompute();
+    ~AsyncRecompute();
+    AsyncRecompute(const AsyncRecompute &) = delete;
+    AsyncRecompute &operator=(const AsyncRecompute &) = delete;
+
+    void Submit(const RecomputeRequest &request);
+
+    // GUI thread : publish a finished result, true if Front() changed
+    bool Poll();
+    const GreekGrid &Front() const { return front_; }
+
+    bool Busy() const;           // a request is queued or being computed
+    double AgeSeconds() const;   // age of Front(), negative before the first result
+
+private:
+    void WorkerLoop();
+
+    GreekGrid front_;        // published result, read by the GUI and, during a job, by the worker
+    GreekGrid back_;         // written by the worker while computing
+    GreekTensor scratch_;    // partial results of incremental updates
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    RecomputeRequest pending_{};
+    bool hasPending_ = false;
+    bool computing_ = false;
+    bool ready_ = false;     // back_ holds a finished result not yet published
+    bool redrawOnly_ = false; // ... or only a new request for the values of front_
+    bool stop_ = false;
+    unsigned long long submitted_ = 0;
+    std::atomic<bool> cancel_{false};
+    std::thread worker_;
+};
+
+#endif /* ASYNCRECOMPUTE_HPP_ */
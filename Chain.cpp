@@ -0,0 +1,218 @@
+#include "Chain.hpp"
+#include "GreekKernels.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// The whole of `text` (blanks around) as a number : std::from_chars, as greeks_batch reads its options, so no locale,
+// hex floats, inf or nan
+template <typename Number>
+bool ParseNumber(const std::string &text, Number &x) {
+    const char *p = text.data(), *end = text.data() + text.size();
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    const auto res = std::from_chars(p, end, x);
+    if (res.ec != std::errc()) return false;
+    p = res.ptr;
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    return p == end;
+}
+
+// Numbers of fields [first, end) of a CSV line
+bool ParseNumbers(const std::vector<std::string> &fields, size_t first, std::vector<double> &values) {
+    values.clear();
+    for (size_t k = first; k < fields.size(); ++k) {
+        double x;
+        if (!ParseNumber(fields[k], x)) return false;
+        values.push_back(x);
+    }
+    return true;
+}
+
+// A list of values or from:to:count
+bool ParseAxis(const std::vector<std::string> &fields, std::vector<double> &axis) {
+    const size_t colon = fields.size() == 2 ? fields[1].find(':') : std::string::npos;
+    if (colon != std::string::npos) {
+        const std::string &text = fields[1];
+        const size_t colon2 = text.find(':', colon + 1);
+        double from, to;
+        unsigned long count;
+        if (colon2 == std::string::npos || !ParseNumber(text.substr(0, colon), from) || !ParseNumber(text.substr(colon + 1, colon2 - colon - 1), to) ||
+            !ParseNumber(text.substr(colon2 + 1), count) || count == 0) return false;
+        axis.resize(count);
+        for (size_t k = 0; k < count; ++k) axis[k] = count == 1 ? from : from + (to - from) * double(k) / double(count - 1);
+        return true;
+    }
+    return ParseNumbers(fields, 1, axis);
+}
+
+bool PositiveIncreasing(const std::vector<double> &axis) {
+    if (axis.empty() || axis[0] <= 0) return false;
+    for (size_t k = 1; k < axis.size(); ++k)
+        if (!(axis[k] > axis[k - 1])) return false;
+    return true;
+}
+
+int Validate(const ChainSpec &chain) {
+    const VolSmile &s = chain.smile;
+    const char *error = nullptr;
+    if (!PositiveIncreasing(chain.strikes)) error = "strikes must be positive and increasing";
+    else if (!PositiveIncreasing(chain.expiries)) error = "expiries must be positive and increasing";
+    else if (!PositiveIncreasing(s.strikes)) error = "smile strikes must be positive and increasing";
+    else if (!PositiveIncreasing(s.maturities)) error = "smile maturities must be positive and increasing";
+    else if (s.vols.size() != s.strikes.size() * s.maturities.size()) error = "every smile maturity needs one vol per smile strike";
+    else if (std::any_of(s.vols.begin(), s.vols.end(), [](double v) { return !(v > 0); })) error = "smile vols must be positive";
+    if (!error) return 0;
+    std::cerr << "Chain: " << error << "." << std::endl;
+    return -1;
+}
+
+// Left point of the segment of an increasing axis holding x and the weight of its right point, clamped to the ends
+void Bracket(const std::vector<double> &axis, double x, size_t &i, double &w) {
+    if (axis.size() == 1 || x <= axis.front()) { i = 0; w = 0; return; }
+    if (x >= axis.back()) { i = axis.size() - 2; w = 1; return; }
+    i = std::upper_bound(axis.begin(), axis.end(), x) - axis.begin() - 1;
+    w = (x - axis[i]) / (axis[i + 1] - axis[i]);
+}
+
+} // namespace
+
+double VolSmile::Vol(double K, double T) const {
+    size_t i, j;
+    double wK, wT;
+    Bracket(strikes, K, i, wK);
+    Bracket(maturities, T, j, wT);
+    const size_t nK = strikes.size(), nT = maturities.size();
+    auto along = [&](size_t row) {
+        const double *v = vols.data() + row * nK;
+        return nK == 1 ? v[0] : v[i] + wK * (v[i + 1] - v[i]);
+    };
+    if (nT == 1 || T <= maturities.front()) return along(0);
+    if (T >= maturities.back()) return along(nT - 1);
+    const double v0 = along(j), v1 = along(j + 1);
+    const double variance = (1 - wT) * v0 * v0 * maturities[j] + wT * v1 * v1 * maturities[j + 1];
+    return std::sqrt(variance / T);
+}
+
+int ReadChain(std::istream &in, ChainSpec &chain) {
+    chain = ChainSpec{};
+    bool smile = false, expiries = false;
+    std::string line, field;
+    std::vector<std::string> fields;
+    std::vector<double> values;
+    size_t number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        const size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') continue;
+        std::stringstream items(line.substr(first));
+        fields.clear();
+        while (std::getline(items, field, ',')) fields.push_back(field);
+
+        bool ok = true;
+        if (fields[0] == "Strikes") ok = ParseAxis(fields, chain.strikes);
+        else if (fields[0] == "Expiries") ok = expiries = ParseAxis(fields, chain.expiries);
+        else if (fields[0] == "Smile") ok = smile = ParseNumbers(fields, 1, chain.smile.strikes);
+        else if (smile && ParseNumbers(fields, 0, values) && values.size() == chain.smile.strikes.size() + 1) {
+            chain.smile.maturities.push_back(values[0]);
+            chain.smile.vols.insert(chain.smile.vols.end(), values.begin() + 1, values.end());
+        }
+        else ok = false;
+        if (!ok) {
+            std::cerr << "Chain: invalid line " << number << ": " << line << std::endl;
+            return -1;
+        }
+    }
+    if (!expiries) chain.expiries = chain.smile.maturities;
+    return Validate(chain);
+}
+
+int ReadChainFile(const std::string &filename, ChainSpec &chain) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return -1;
+    }
+    return ReadChain(file, chain);
+}
+
+int OptionChain::Set(const ChainSpec &spec) {
+    if (Validate(spec) != 0) return -1;
+    strikes_ = spec.strikes;
+    expiries_ = spec.expiries;
+    vols_.resize(size());
+    for (size_t i = 0; i < strikes_.size(); ++i)
+        for (size_t j = 0; j < expiries_.size(); ++j) vols_[i * expiries_.size() + j] = spec.smile.Vol(strikes_[i], expiries_[j]);
+    return 0;
+}
+
+int OptionChain::Compute(double S, double r, double q, unsigned greeks, unsigned options, PricingModel model, GreekTensor &GreekValues,
+                         ThreadPool *pool) {
+    greeks &= Greek_All;
+    options &= Option_All;
+    if (!greeks || !options || size() == 0) {
+        std::cerr << "Chain: nothing to compute (no contract, Greek or option type)." << std::endl;
+        return -1;
+    }
+    if (IsLatticeModel(model)) {
+        std::cerr << "Chain: closed form models only (BlackScholes, Black76, Bachelier)." << std::endl;
+        return -1;
+    }
+    GREEKS_PROFILE_SCOPE("OptionChain");
+    GREEKS_PROFILE_COUNT(Counter_Points, size());
+
+    // expiry factors : the drift of every model is affine in sigma^2, base_ holds it at sigma 0
+    const size_t nK = strikes_.size(), nT = expiries_.size();
+    base_.Compute(r, q, expiries_, 0, model);
+    unit_.Compute(r, q, expiries_, 1, model);
+    driftVar_.resize(nT);
+    for (size_t j = 0; j < nT; ++j) driftVar_[j] = unit_.drift[j] - base_.drift[j];
+
+    GreekValues.Reshape(CountFlags(greeks), CountFlags(options), nK, nT);
+    const ChainKernelFunction kernel = KernelsOf(model).chain[(greeks & Greek_HigherOrder) != 0];
+    ThreadPool &threads = pool ? *pool : DefaultThreadPool();
+    scratch_.resize(threads.NumThreads() * 15 * nT);
+
+    // slots in GreekValues, -1 if not requested (same order as ComputeGreek)
+    auto slot = [](unsigned mask, unsigned flag) { return (mask & flag) ? static_cast<int>(SlotOf(mask, flag)) : -1; };
+    const int callIndex = slot(options, Option_Call), putIndex = slot(options, Option_Put);
+    const int deltaIndex = slot(greeks, Greek_Delta), thetaIndex = slot(greeks, Greek_Theta), rhoIndex = slot(greeks, Greek_Rho);
+    const int charmIndex = slot(greeks, Greek_Charm);
+    const int sharedIndex = callIndex >= 0 ? callIndex : putIndex;
+    // Greeks shared by calls and puts, in the order of their scratch rows from 2
+    const int sharedGreeks[] = {slot(greeks, Greek_Gamma), slot(greeks, Greek_Vega), slot(greeks, Greek_Vanna), slot(greeks, Greek_Volga),
+                                slot(greeks, Greek_Speed), slot(greeks, Greek_Color), slot(greeks, Greek_Zomma)};
+    const size_t sharedSpares[] = {2, 3, 8, 9, 12, 13, 14};
+
+    // blocks of ~4096 contracts
+    const size_t strikesPerBlock = std::max<size_t>(1, 4096 / nT);
+    const size_t numBlocks = (nK + strikesPerBlock - 1) / strikesPerBlock;
+    threads.ParallelFor(numBlocks, [&](size_t block, size_t worker) {
+        // row of a requested [greek][option] slice, or scratch row `spare` of this worker
+        auto row = [&](int g, int o, size_t i, size_t spare) -> double * {
+            if (g >= 0 && o >= 0) return GreekValues.Slice(g, o).Row(i);
+            return scratch_.data() + (worker * 15 + spare) * nT;
+        };
+        double *shared[7];
+        const size_t i1 = std::min(nK, (block + 1) * strikesPerBlock);
+        for (size_t i = block * strikesPerBlock; i < i1; ++i) {
+            for (size_t k = 0; k < 7; ++k) shared[k] = row(sharedGreeks[k], sharedIndex, i, sharedSpares[k]);
+            kernel(strikes_[i], S, r, q, 0, nT, base_.T.data(), base_.sqrtT.data(), base_.drift.data(), driftVar_.data(),
+                   base_.discQ.data(), base_.discR.data(), vols_.data() + i * nT,
+                   row(deltaIndex, callIndex, i, 0), row(deltaIndex, putIndex, i, 1), shared[0], shared[1],
+                   row(thetaIndex, callIndex, i, 4), row(thetaIndex, putIndex, i, 5), row(rhoIndex, callIndex, i, 6), row(rhoIndex, putIndex, i, 7),
+                   shared[2], shared[3], row(charmIndex, callIndex, i, 10), row(charmIndex, putIndex, i, 11), shared[4], shared[5], shared[6]);
+            if (callIndex >= 0 && putIndex >= 0) {
+                for (size_t k = 0; k < 7; ++k)
+                    if (sharedGreeks[k] >= 0) std::copy(shared[k], shared[k] + nT, GreekValues.Slice(sharedGreeks[k], putIndex).Row(i));
+            }
+        }
+    });
+    return 0;
+}
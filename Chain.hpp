@@ -0,0 +1,73 @@
+#ifndef CHAIN_HPP_
+#define CHAIN_HPP_
+
+#include <istream>
+#include <string>
+#include <vector>
+#include "Greeks.hpp"
+#include "GreekSet.hpp"
+#include "GreekTensor.hpp"
+#include "ThreadPool.hpp"
+
+// Option chains : every contract of a strike x expiry chain of one underlying, each at the implied volatility of
+// its strike and expiry on a smile.
+//
+// Chain file (CSV, blank lines and lines starting with # are skipped) :
+//   Strikes,80,82.5,85,...          strikes of the chain, or from:to:count
+//   Expiries,0.25,0.5,1,2           expiries in years, or from:to:count (the smile maturities when absent)
+//   Smile,80,90,100,110,120         strikes of the implied volatility grid, then one line per smile maturity :
+//   0.25,0.28,0.24,0.21,0.22,0.24   T, and a vol per smile strike
+//   1,0.25,0.23,0.21,0.21,0.22
+// Strikes, expiries and smile maturities must be positive and increasing, vols positive. Vols are in the units of
+// the model : lognormal for BlackScholes and Black76, normal (price per square root of a year) for Bachelier.
+
+// Implied volatility grid, vols[j * strikes.size() + i] at maturities[j] and strikes[i]
+struct VolSmile {
+    std::vector<double> strikes, maturities, vols;
+
+    // Linear in strike along the maturities, linear in total variance (sigma^2 T) between them, flat beyond the grid
+    double Vol(double K, double T) const;
+};
+
+struct ChainSpec {
+    std::vector<double> strikes, expiries;
+    VolSmile smile;
+};
+
+// Returns 0, -1 for a malformed chain (message on std::cerr)
+int ReadChain(std::istream &in, ChainSpec &chain);
+int ReadChainFile(const std::string &filename, ChainSpec &chain);
+
+// A chain ready to be priced : the smile is interpolated once, when the chain is set, and every Compute() prices
+// the contracts at those vols.
+//
+// Compute() shares the work by expiry and by strike. The factors of an expiry (sqrt(T), both discounts and the
+// drift without its sigma^2 term) are computed once for every strike, ln(S / K) once per strike for every expiry,
+// and the contracts of a strike run through the vectorised chain kernel (GreekKernels.hpp), several expiries per
+// instruction. Blocks of strikes are shared between the threads; every contract is computed by the same code
+// whatever the block, so results do not depend on the number of threads.
+class OptionChain {
+public:
+    // Returns 0, -1 for an invalid chain (nothing changes)
+    int Set(const ChainSpec &spec);
+
+    // Greeks of every contract into GreekValues, reshaped like a ComputeGreek tensor with the strikes in place of
+    // the stock prices : [greek][option][strike][expiry]. S is the forward with Black76 and Bachelier.
+    // Returns 0, -1 for an empty chain, empty masks or a lattice model (closed form models only)
+    int Compute(double S, double r, double q, unsigned greeks, unsigned options, PricingModel model, GreekTensor &GreekValues,
+                ThreadPool *pool = nullptr);
+
+    const std::vector<double> &Strikes() const { return strikes_; }
+    const std::vector<double> &Expiries() const { return expiries_; }
+    double Vol(size_t i, size_t j) const { return vols_[i * expiries_.size() + j]; }   // strike i, expiry j
+    size_t size() const { return strikes_.size() * expiries_.size(); }
+
+private:
+    std::vector<double> strikes_, expiries_;
+    std::vector<double> vols_;               // [strike][expiry]
+    MaturityColumns base_, unit_;            // expiry factors at sigma 0 and 1, capacity kept between calls
+    std::vector<double> driftVar_;           // unit_.drift - base_.drift
+    std::vector<double> scratch_;            // rows nobody asked for, 15 per thread
+};
+
+#endif /* CHAIN_HPP_ */
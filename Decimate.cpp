@@ -0,0 +1,87 @@
+#include "Decimate.hpp"
+#include <algorithm>
+#include <cmath>
+
+void DecimateLttb(const std::vector<double> &x, StridedView<const double> y, size_t maxPoints, std::vector<size_t> &kept) {
+    const size_t n = std::min(x.size(), y.size);
+    kept.clear();
+    if (maxPoints >= n || maxPoints < 3) {
+        for (size_t i = 0; i < n; ++i) kept.push_back(i);
+        return;
+    }
+
+    // points 1 .. n-2 split into maxPoints - 2 buckets of `every` points
+    const size_t buckets = maxPoints - 2;
+    const double every = double(n - 2) / buckets;
+    size_t previous = 0;
+    kept.push_back(0);
+    for (size_t b = 0; b < buckets; ++b) {
+        const size_t start = 1 + static_cast<size_t>(b * every);
+        const size_t end = std::min(n - 1, 1 + static_cast<size_t>((b + 1) * every));
+
+        // mean of the next bucket (the last point after the last bucket), over its finite values
+        const double ax = x[previous], ay = y[previous];
+        const bool anchored = std::isfinite(ay);
+        const size_t nextStart = end;
+        const size_t nextEnd = b + 1 < buckets ? std::min(n - 1, 1 + static_cast<size_t>((b + 2) * every)) : n;
+        double meanX = 0, meanY = 0;
+        size_t finite = 0;
+        for (size_t i = nextStart; i < nextEnd; ++i) {
+            if (!std::isfinite(y[i])) continue;
+            meanX += x[i];
+            meanY += y[i];
+            ++finite;
+        }
+        if (finite) {
+            meanX /= double(finite);
+            meanY /= double(finite);
+        } else {
+            meanX = x[nextEnd - 1];
+            meanY = anchored ? ay : 0.0;
+        }
+
+        // twice the area of the triangle (previous, i, mean), the largest wins. Non-finite values (a Greek at
+        // S = 0) are never picked, after one the distance to the mean stands in for the area; a bucket without
+        // a finite value keeps no point
+        size_t best = start;
+        double bestArea = -1;
+        for (size_t i = start; i < end; ++i) {
+            if (!std::isfinite(y[i])) continue;
+            const double area = anchored ? std::fabs((ax - meanX) * (y[i] - ay) - (ax - x[i]) * (meanY - ay))
+                                         : std::fabs(y[i] - meanY);
+            if (area > bestArea) {
+                bestArea = area;
+                best = i;
+            }
+        }
+        if (bestArea < 0) continue;
+        kept.push_back(best);
+        previous = best;
+    }
+    kept.push_back(n - 1);
+}
+
+double DecimationError(const std::vector<double> &x, StridedView<const double> y, const std::vector<size_t> &kept) {
+    const size_t n = std::min(x.size(), y.size);
+    if (n == 0 || kept.empty()) return 0;
+    double lo = INFINITY, hi = -INFINITY;
+    for (size_t i = 0; i < n; ++i)
+        if (std::isfinite(y[i])) {
+            lo = std::min(lo, y[i]);
+            hi = std::max(hi, y[i]);
+        }
+    if (!(hi > lo)) return 0;
+
+    // non-finite values are gaps of both polylines
+    double worst = 0;
+    for (size_t k = 0; k + 1 < kept.size(); ++k) {
+        const size_t a = kept[k], b = kept[k + 1];
+        if (!std::isfinite(y[a]) || !std::isfinite(y[b])) continue;
+        for (size_t i = a + 1; i < b; ++i) {
+            if (!std::isfinite(y[i])) continue;
+            const double w = x[b] != x[a] ? (x[i] - x[a]) / (x[b] - x[a]) : 0.0;
+            worst = std::max(worst, std::fabs(y[i] - (y[a] + w * (y[b] - y[a]))));
+        }
+    }
+    return worst / (hi - lo);
+}
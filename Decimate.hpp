@@ -0,0 +1,25 @@
+#ifndef DECIMATE_HPP_
+#define DECIMATE_HPP_
+
+#include <cstddef>
+#include <vector>
+#include "GreekTensor.hpp"
+
+// Largest-triangle-three-buckets decimation (S. Steinarsson, 2013) of the polyline (x[i], y[i]).
+//
+// Keeps the first and last points and, for each of maxPoints - 2 buckets of the points between them, the
+// point forming the largest triangle with the point kept before it and the mean of the next bucket. Peaks
+// survive (a bucket keeps its extreme point, not its mean) while flat stretches collapse, so a curve drawn
+// at one point every couple of pixels looks like the full one. O(n), no allocation once `kept` has capacity.
+//
+// `kept` receives the indices of the kept points, increasing. Every point is kept when maxPoints >= n or
+// maxPoints < 3. `y` is typically one T column of a slice (SliceView::AlongS), y.size must be x.size(); its
+// non-finite values (gaps) are never kept but as the first or last point, a bucket holding only such values keeps
+// no point, so fewer than maxPoints may be kept
+void DecimateLttb(const std::vector<double> &x, StridedView<const double> y, size_t maxPoints, std::vector<size_t> &kept);
+
+// Largest distance, in units of the y range, between a point of the polyline and the decimated polyline
+// (linear interpolation between the kept points) : 0.01 is 1% of the height of the plot. Non-finite values are skipped
+double DecimationError(const std::vector<double> &x, StridedView<const double> y, const std::vector<size_t> &kept);
+
+#endif /* DECIMATE_HPP_ */
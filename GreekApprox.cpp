@@ -0,0 +1,259 @@
+#include "GreekApprox.hpp"
+#include "Greeks.hpp"
+#include "VecMath.hpp"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+using ExactGreek = double (*)(double &, double &, double &, double &, double &, double &, bool);
+
+constexpr int N = GreekApprox::Nodes;
+constexpr int Block = N * N * N;   // tensor of the fit, before the truncation to total degree Degree
+constexpr int CheckPoints = 5;   // per axis and cell : edges, centre and halfway between them
+constexpr double Pi = 3.14159265358979323846;
+
+// Chebyshev nodes of [-1, 1], cos(T_j) terms at the nodes and T_j in the monomial basis
+struct ChebyshevTables {
+    double node[N];
+    double cosine[N][N];      // cosine[j][k] = T_j(node[k])
+    double monomial[N][N];    // T_j(t) = sum_p monomial[j][p] t^p
+    int storage[GreekApprox::CellSize];   // block index (i * N + j) * N + k of each stored coefficient, in Horner order
+
+    ChebyshevTables() {
+        for (int k = 0; k < N; ++k) node[k] = std::cos(Pi * (k + 0.5) / N);
+        for (int j = 0; j < N; ++j)
+            for (int k = 0; k < N; ++k) cosine[j][k] = std::cos(Pi * j * (k + 0.5) / N);
+        for (auto &row : monomial) std::fill(row, row + N, 0.0);
+        monomial[0][0] = 1;
+        if (N > 1) monomial[1][1] = 1;
+        for (int j = 2; j < N; ++j)   // T_j = 2 t T_(j-1) - T_(j-2)
+            for (int p = 0; p < N; ++p)
+                monomial[j][p] = (p > 0 ? 2 * monomial[j - 1][p - 1] : 0.0) - monomial[j - 2][p];
+        int n = 0;   // same loops as GreekApprox::Horner
+        for (int i = N - 1; i >= 0; --i)
+            for (int j = N - 1 - i; j >= 0; --j)
+                for (int k = N - 1 - i - j; k >= 0; --k) storage[n++] = (i * N + j) * N + k;
+    }
+};
+
+const ChebyshevTables &Tables() {
+    static const ChebyshevTables tables;
+    return tables;
+}
+
+// Transform along one axis of a [N][N][N] block : out = sum_k in[k] * w[j][k] along `axis`
+void TransformAxis(const double *in, double *out, int axis, const double (&w)[N][N]) {
+    const int stride = axis == 0 ? N * N : (axis == 1 ? N : 1);
+    for (int base = 0; base < Block; ++base) {
+        if ((base / stride) % N != 0) continue;   // first index along the axis
+        for (int j = 0; j < N; ++j) {
+            double sum = 0;
+            for (int k = 0; k < N; ++k) sum += w[j][k] * in[base + k * stride];
+            out[base + j * stride] = sum;
+        }
+    }
+}
+
+struct WorkerCheck {
+    double maxError = 0, worstRatio = 0;
+};
+
+} // namespace
+
+void GreekApprox::Axis::Update() {
+    const size_t n = edges.size() - 1;
+    centre.resize(n);
+    invHalfWidth.resize(n);
+    next.resize(n);
+    double minWidth = edges[n] - edges[0];
+    for (size_t i = 0; i < n; ++i) {
+        centre[i] = 0.5 * (edges[i] + edges[i + 1]);
+        invHalfWidth[i] = 2.0 / (edges[i + 1] - edges[i]);
+        next[i] = i + 1 < n ? edges[i + 1] : std::numeric_limits<double>::infinity();
+        minWidth = std::min(minWidth, edges[i + 1] - edges[i]);
+    }
+    // buckets narrower than the narrowest cell, so Locate() steps over at most one edge
+    lower = edges[0];
+    const size_t buckets = static_cast<size_t>(std::ceil((edges[n] - edges[0]) / minWidth)) + 1;
+    bucketScale = (buckets - 1) / (edges[n] - edges[0]);
+    lastBucket = static_cast<double>(buckets - 1);
+    bucketCell.resize(buckets);
+    for (size_t b = 0; b < buckets; ++b) {
+        const double start = lower + b / bucketScale;
+        bucketCell[b] = static_cast<size_t>(std::max<ptrdiff_t>(0, std::upper_bound(edges.begin(), edges.end() - 1, start) - edges.begin() - 1));
+    }
+}
+
+int GreekApprox::Build(const std::string &greek, bool isCall, double r, double q, const ApproxDomain &domain,
+                       const ApproxTolerance &tolerance, ThreadPool *pool) {
+    ExactGreek exact = nullptr;
+    if (greek == "Delta") { exact = Delta; strikePower_ = 0; }
+    else if (greek == "Theta") { exact = Theta; strikePower_ = 1; }
+    else if (greek == "Rho") { exact = Rho; strikePower_ = 1; }
+    else if (greek == "Gamma") {
+        std::cerr << "Gamma is not approximated: its table is larger and slower than the exact function." << std::endl;
+        return -1;
+    } else if (greek == "Vega") {
+        std::cerr << "Vega is not approximated: a lookup is no faster than the exact function." << std::endl;
+        return -1;
+    } else {
+        std::cerr << "Unknown Greek: " << greek << std::endl;
+        return -1;
+    }
+    if (!(domain.moneynessMin > 0 && domain.moneynessMin < domain.moneynessMax && domain.TMin > 0 && domain.TMin < domain.TMax &&
+          domain.sigmaMin > 0 && domain.sigmaMin < domain.sigmaMax)) {
+        std::cerr << "Invalid approximation domain: bounds must be positive and increasing." << std::endl;
+        return -1;
+    }
+    const double lower[3] = {domain.moneynessMin, std::sqrt(domain.TMin), domain.sigmaMin};
+    const double upper[3] = {domain.moneynessMax, std::sqrt(domain.TMax), domain.sigmaMax};
+    for (int a = 0; a < 3; ++a) axes_[a].edges = {lower[a], 0.5 * (lower[a] + upper[a]), upper[a]};
+
+    const ChebyshevTables &tables = Tables();
+    // Chebyshev coefficients from the node values : (2 - [j == 0]) / N * sum_k f(node k) T_j(node k)
+    double analysis[N][N];
+    for (int j = 0; j < N; ++j)
+        for (int k = 0; k < N; ++k) analysis[j][k] = (j == 0 ? 1.0 : 2.0) / N * tables.cosine[j][k];
+    // monomial coefficients from the Chebyshev ones : a_p = sum_j c_j monomial[j][p]
+    double synthesis[N][N];
+    for (int p = 0; p < N; ++p)
+        for (int j = 0; j < N; ++j) synthesis[p][j] = tables.monomial[j][p];
+
+    ThreadPool &threads = pool ? *pool : DefaultThreadPool();
+    std::vector<WorkerCheck> checks(threads.NumThreads());
+    std::vector<signed char> split;   // per cell : axis to split, -1 if the cell passed
+    for (;;) {
+        for (Axis &axis : axes_) axis.Update();
+        const size_t cells[3] = {axes_[0].Cells(), axes_[1].Cells(), axes_[2].Cells()};
+        const size_t numCells = cells[0] * cells[1] * cells[2];
+        coefficients_.assign(numCells * CellSize, 0.0);
+        split.assign(numCells, -1);
+        std::fill(checks.begin(), checks.end(), WorkerCheck());
+
+        threads.ParallelFor(numCells, [&](size_t cell, size_t worker) {
+            const size_t index[3] = {cell / (cells[1] * cells[2]), cell / cells[2] % cells[1], cell % cells[2]};
+            double centre[3], halfWidth[3];
+            for (int a = 0; a < 3; ++a) {
+                centre[a] = axes_[a].centre[index[a]];
+                halfWidth[a] = 1.0 / axes_[a].invHalfWidth[index[a]];
+            }
+            // exact Greek at K = 1 from the cell coordinates
+            auto value = [&](double tx, double tt, double ts) {
+                double K = 1.0, S = centre[0] + tx * halfWidth[0];
+                const double sqrtT = centre[1] + tt * halfWidth[1];
+                double T = sqrtT * sqrtT, sigma = centre[2] + ts * halfWidth[2];
+                double rate = r, yield = q;
+                return exact(K, S, rate, yield, T, sigma, isCall);
+            };
+
+            // fit : node values -> Chebyshev coefficients, truncated to total degree <= Degree -> monomials
+            double f[Block], c[Block], tmp[Block];
+            for (int i = 0; i < N; ++i)
+                for (int j = 0; j < N; ++j)
+                    for (int k = 0; k < N; ++k) f[(i * N + j) * N + k] = value(tables.node[i], tables.node[j], tables.node[k]);
+            TransformAxis(f, tmp, 0, analysis);
+            TransformAxis(tmp, f, 1, analysis);
+            TransformAxis(f, c, 2, analysis);
+            // share of each axis in the terms of degree >= Degree : the dropped ones are the error of the
+            // cell, the ones of degree Degree are the next to go when the cell is halved along that axis
+            double tail[3] = {0, 0, 0};
+            for (int i = 0; i < N; ++i)
+                for (int j = 0; j < N; ++j)
+                    for (int k = 0; k < N; ++k) {
+                        double &term = c[(i * N + j) * N + k];
+                        const int degree = i + j + k;
+                        if (degree < GreekApprox::Degree) continue;
+                        const double size = std::fabs(term) / degree;
+                        tail[0] += i * size; tail[1] += j * size; tail[2] += k * size;
+                        if (degree > GreekApprox::Degree) term = 0;
+                    }
+            TransformAxis(c, tmp, 0, synthesis);
+            TransformAxis(tmp, f, 1, synthesis);
+            TransformAxis(f, c, 2, synthesis);
+            double *out = coefficients_.data() + cell * CellSize;
+            for (int n = 0; n < CellSize; ++n) out[n] = c[tables.storage[n]];
+
+            // check against the exact Greek
+            WorkerCheck &check = checks[worker];
+            bool failed = false;
+            for (int i = 0; i < CheckPoints; ++i)
+                for (int j = 0; j < CheckPoints; ++j)
+                    for (int k = 0; k < CheckPoints; ++k) {
+                        const double tx = -1.0 + 0.5 * i, tt = -1.0 + 0.5 * j, ts = -1.0 + 0.5 * k;
+                        const double reference = value(tx, tt, ts);
+                        const double error = std::fabs(Horner(out, 0, tx, tt, ts) - reference);
+                        const double ratio = error / std::max(tolerance.absolute, tolerance.relative * std::fabs(reference));
+                        check.maxError = std::max(check.maxError, error);
+                        check.worstRatio = std::max(check.worstRatio, ratio);
+                        failed |= !(ratio <= 1.0);
+                    }
+            if (failed) split[cell] = static_cast<signed char>(std::max_element(tail, tail + 3) - tail);
+        });
+
+        maxError_ = worstRatio_ = 0;
+        for (const WorkerCheck &check : checks) {
+            maxError_ = std::max(maxError_, check.maxError);
+            worstRatio_ = std::max(worstRatio_, check.worstRatio);
+        }
+        if (worstRatio_ <= 1.0) return 0;
+
+        // halve every interval holding a failing cell along that cell's worst axis
+        std::vector<char> halve[3];
+        for (int a = 0; a < 3; ++a) halve[a].assign(cells[a], 0);
+        for (size_t cell = 0; cell < numCells; ++cell) {
+            if (split[cell] < 0) continue;
+            const size_t index[3] = {cell / (cells[1] * cells[2]), cell / cells[2] % cells[1], cell % cells[2]};
+            halve[split[cell]][index[split[cell]]] = 1;
+        }
+        size_t next = 1;
+        for (int a = 0; a < 3; ++a) next *= cells[a] + std::count(halve[a].begin(), halve[a].end(), 1);
+        if (next > tolerance.maxCells) {
+            std::cerr << "Approximation of " << greek << " stops at " << cells[0] << "x" << cells[1] << "x" << cells[2]
+                      << " cells: error " << maxError_ << " is " << worstRatio_ << " times the tolerance." << std::endl;
+            return -1;
+        }
+        for (int a = 0; a < 3; ++a) {
+            std::vector<double> edges;
+            for (size_t i = 0; i < cells[a]; ++i) {
+                edges.push_back(axes_[a].edges[i]);
+                if (halve[a][i]) edges.push_back(axes_[a].centre[i]);
+            }
+            edges.push_back(axes_[a].edges[cells[a]]);
+            axes_[a].edges.swap(edges);
+        }
+    }
+}
+
+GREEKS_DISPATCH
+void GreekApprox::EvaluateBatch(size_t n, const double *K, const double *S, const double *T, const double *sigma, double *out) const {
+    constexpr size_t Lanes = 16;   // cells located for every lane first, then one Horner scheme across the lanes
+    const double *coefficients = coefficients_.data();
+    const size_t cellsT = axes_[1].Cells(), cellsSigma = axes_[2].Cells();
+    for (size_t begin = 0; begin < n; begin += Lanes) {
+        const size_t count = std::min(Lanes, n - begin);
+        size_t offset[Lanes];
+        double tx[Lanes], tt[Lanes], ts[Lanes];
+        for (size_t l = 0; l < count; ++l) {
+            const size_t k = begin + l;
+            const size_t i = axes_[0].Locate(S[k] / K[k], tx[l]), j = axes_[1].Locate(std::sqrt(T[k]), tt[l]),
+                         m = axes_[2].Locate(sigma[k], ts[l]);
+            offset[l] = CellSize * ((i * cellsT + j) * cellsSigma + m);
+        }
+        for (size_t l = count; l < Lanes; ++l) {
+            offset[l] = 0;
+            tx[l] = tt[l] = ts[l] = 0;
+        }
+        double v[Lanes];
+        for (size_t l = 0; l < Lanes; ++l) v[l] = Horner(coefficients, offset[l], tx[l], tt[l], ts[l]);
+        for (size_t l = 0; l < count; ++l) out[begin + l] = v[l] * Scale(K[begin + l]);
+    }
+}
+
+bool GreekApprox::InDomain(double K, double S, double T, double sigma) const {
+    const double x[3] = {S / K, std::sqrt(T), sigma};
+    for (int a = 0; a < 3; ++a)
+        if (!(x[a] >= axes_[a].edges.front() && x[a] <= axes_[a].edges.back())) return false;
+    return true;
+}
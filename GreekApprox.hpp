@@ -0,0 +1,122 @@
+#ifndef GREEKAPPROX_HPP_
+#define GREEKAPPROX_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "ThreadPool.hpp"
+
+// Box of inputs an approximation is fitted on
+struct ApproxDomain {
+    double moneynessMin = 0.5, moneynessMax = 2.0;   // S / K
+    double TMin = 0.1, TMax = 2.0;
+    double sigmaMin = 0.1, sigmaMax = 0.8;
+};
+
+// Accepted error : |approx - exact| <= max(absolute, relative * |exact|), for a strike of 1 (see GreekApprox)
+struct ApproxTolerance {
+    double absolute = 1e-4;
+    double relative = 1e-4;
+    size_t maxCells = 1 << 20;   // Build() gives up beyond this many cells (160 bytes each)
+};
+
+// Piecewise Chebyshev approximation of one Greek of a call or a put over (S / K, T, sigma), at fixed r and q.
+//
+// The box is cut into a grid of cells in (S / K, sqrt(T), sigma); on every cell the Greek is interpolated
+// at the 4x4x4 Chebyshev nodes, the terms of total degree above 3 are dropped and the remaining cubic is
+// stored in the monomial basis of the cell's [-1, 1]^3 coordinates. Evaluation is a cell lookup (a bucket
+// table per axis, no search) and a 20 term Horner scheme : no exp, log or erf. EvaluateBatch() does both
+// for 16 options at a time, vectorised across the options (the coefficients are gathered from their cells).
+// With the default tolerance the tables take 1.5 to 3 MB.
+//
+// A table replaces the scalar Delta, Theta and Rho of Greeks.hpp (about 3 to 4 times faster), not FusedGreeksBatch :
+// a batched lookup costs about as much as the fused kernel computing all eight rows of a contract. Vega is not
+// offered, its exact function being as fast as a lookup, nor Gamma : peaked near the money at short maturity
+// and low volatility, it needs 40 MB of cells and a lookup is slower than the exact function.
+//
+// Build() starts from the exact functions of Greeks.cpp with K = 1 and checks the fit against them on
+// 5x5x5 points of every cell (the cell edges, the centre and halfway between them). Every cell that misses
+// the tolerance has its interval split in two along the axis with the largest cubic term, so cells only
+// get small where the Greek bends (near the money at short maturity and low volatility); this repeats
+// until every check passes or maxCells is reached.
+// Greeks are homogeneous in (S, K) : Delta is read as is, Theta and Rho multiplied by K. The tolerance therefore
+// holds for K = 1, absolute errors scaling the same way.
+// Inputs outside the domain are extrapolated from the edge cells and have no error bound.
+class GreekApprox {
+public:
+    static constexpr int Degree = 3;
+    static constexpr int Nodes = Degree + 1;
+    static constexpr int CellSize = (Degree + 1) * (Degree + 2) * (Degree + 3) / 6;   // monomials of total degree <= Degree
+
+    // greek : "Delta", "Theta" or "Rho". Returns 0, -1 for another greek, an empty domain or
+    // a tolerance that needs more than maxCells cells (the last fit is kept, see WorstRatio())
+    int Build(const std::string &greek, bool isCall, double r, double q, const ApproxDomain &domain,
+              const ApproxTolerance &tolerance = ApproxTolerance(), ThreadPool *pool = nullptr);
+
+    double Evaluate(double K, double S, double T, double sigma) const {
+        double tx, tt, ts;
+        const size_t i = axes_[0].Locate(S / K, tx), j = axes_[1].Locate(std::sqrt(T), tt), k = axes_[2].Locate(sigma, ts);
+        const double *c = coefficients_.data() + CellSize * ((i * axes_[1].Cells() + j) * axes_[2].Cells() + k);
+        return Horner(c, 0, tx, tt, ts) * Scale(K);
+    }
+    // out[k] for options k in [0, n)
+    void EvaluateBatch(size_t n, const double *K, const double *S, const double *T, const double *sigma, double *out) const;
+
+    bool InDomain(double K, double S, double T, double sigma) const;
+    size_t NumCells(int axis) const { return axes_[axis].Cells(); }
+    size_t MemoryBytes() const { return coefficients_.size() * sizeof(double); }
+    double MaxError() const { return maxError_; }        // largest |approx - exact| found by the checks (K = 1)
+    double WorstRatio() const { return worstRatio_; }    // largest error / accepted error, <= 1 once built
+
+private:
+    // Intervals of one axis, found in O(1) through a table of buckets narrower than any interval
+    struct Axis {
+        std::vector<double> edges;           // cells + 1 increasing edges
+        std::vector<double> centre, invHalfWidth;
+        std::vector<double> next;            // upper edge of each cell, +inf for the last one
+        std::vector<size_t> bucketCell;      // cell holding the start of each bucket (size_t : same width as the gathers of doubles)
+        double lower = 0, bucketScale = 0, lastBucket = 0;
+
+        size_t Cells() const { return centre.size(); }
+        void Update();                       // centre, widths and buckets from the edges
+        // Cell of x and its local coordinate t in [-1, 1] (beyond inside the edge cells), branch free
+        size_t Locate(double x, double &t) const {
+            const double last = lastBucket;   // read once, so the clamp stays a select in vectorised loops
+            double f = (x - lower) * bucketScale;
+            f = f < 0 ? 0 : (f > last ? last : f);
+            size_t i = bucketCell[static_cast<int>(f)];
+            i += x >= next[i];                // a bucket holds at most one edge
+            t = (x - centre[i]) * invHalfWidth[i];
+            return i;
+        }
+    };
+
+    // sum of c_ijk tx^i tt^j ts^k over i + j + k <= Degree, nested Horner reading c from c[p] in storage order.
+    // The loops unroll fully, so a loop over options calling Horner vectorises (EvaluateBatch)
+    static double Horner(const double *c, size_t p, double tx, double tt, double ts) {
+        double v = 0;
+#pragma GCC unroll 4
+        for (int i = Degree; i >= 0; --i) {
+            double a = 0;
+#pragma GCC unroll 4
+            for (int j = Degree - i; j >= 0; --j) {
+                double b = 0;
+#pragma GCC unroll 4
+                for (int k = Degree - i - j; k >= 0; --k) b = b * ts + c[p++];
+                a = a * tt + b;
+            }
+            v = v * tx + a;
+        }
+        return v;
+    }
+
+    double Scale(double K) const { return strikePower_ == 0 ? 1.0 : K; }
+
+    std::vector<double> coefficients_;   // CellSize per cell, cells in (moneyness, sqrt(T), sigma) row-major order
+    Axis axes_[3];
+    int strikePower_ = 0;                // Greek(K, S) = K^strikePower * Greek(1, S / K)
+    double maxError_ = 0, worstRatio_ = 0;
+};
+
+#endif /* GREEKAPPROX_HPP_ */
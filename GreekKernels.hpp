@@ -0,0 +1,421 @@
+#ifndef GREEKKERNELS_HPP_
+#define GREEKKERNELS_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include "GreekSet.hpp"
+#include "Greeks.hpp"
+#include "VecMath.hpp"
+
+// Kernels of the grid and batch paths, specialised at compile time for the pricing model, the Greek set and
+// the option set. Each model is instantiated in its own translation unit (GreekKernels<Model>.cpp): every
+// model has ~110 flattened, ISA-dispatched row kernels, which take a while to compile.
+
+// Model policies : Factors() holds what only depends on the maturity, Point() the call and put Greeks of one
+// (S, T) point. Both are branch-free and inlined into the kernels below, which are instantiated per policy.
+// MaturityFactors keeps its meaning across models : discQ discounts the underlying leg (e^-qT, or e^-rT
+// for a forward) and drift is the part of d1 added to ln(S / K).
+// Real is the arithmetic of the inputs, ln(S / K), d1, d2 and the assembly of the Greeks, Fast the one of
+// exp, N and N' (float for Precision_Mixed); the kernels write Output values.
+// Point() always assembles every Greek, the higher order ones and the call and put values from the same d1, d2, N
+// and N' : a kernel that does not store a Greek lets the compiler drop its arithmetic.
+
+// Higher order Greeks of the lognormal models from their shared intermediates, once g.gamma and g.vega are set.
+// yield discounts the underlying leg (q, or r for a forward) and carry is its drift (r - q, 0 for a forward)
+template <typename Real>
+inline void LognormalHigherOrder(Real S, Real sigma, Real yield, Real carry, Real d1v, Real d2v, Real pdf, Real Nd1, Real Nm1,
+                                 const BasicMaturityFactors<Real> &m, BasicGreekPoint<Real> &g) {
+    // 1 / sigma and 1 / S are hoisted out of the kernel loops, 1 / T and 1 / (sigma sqrt(T)) share one division
+    const Real invSigma = 1 / sigma, invS = 1 / S;
+    const Real inv = 1 / (m.T * m.volSqrtT);
+    const Real halfInvT = Real(0.5) * m.volSqrtT * inv, invVolSqrtT = m.T * inv;
+    const Real dd1dT = carry * invVolSqrtT - d2v * halfInvT;   // dd1/dT
+    const Real decay = m.discQ * pdf * dd1dT;
+    g.vanna = -m.discQ * pdf * d2v * invSigma;
+    g.volga = g.vega * d1v * d2v * invSigma;
+    g.charmCall = yield * m.discQ * Nd1 - decay;
+    g.charmPut = -yield * m.discQ * Nm1 - decay;
+    g.speed = -g.gamma * invS * (d1v * invVolSqrtT + 1);
+    g.color = g.gamma * (yield + d1v * dd1dT + halfInvT);
+    g.zomma = g.gamma * (d1v * d2v - 1) * invSigma;
+}
+
+template <typename Real, typename Fast = Real>
+struct BlackScholesPolicy {
+    using Output = Fast;
+
+    static BasicMaturityFactors<Real> Factors(Real r, Real q, Real T, Real sigma) {
+        const Real sqrtT = std::sqrt(T);
+        return {T, sqrtT, sigma * sqrtT, (r - q + Real(0.5) * sigma * sigma) * T, FastExp(-q * T), FastExp(-r * T)};
+    }
+    // same algebra as FusedGreeks, puts from N(-d1) and N(-d2) rather than parity : no cancellation deep in the money
+    static BasicGreekPoint<Real> Point(Real K, Real S, Real logSK, Real r, Real q, Real sigma, const BasicMaturityFactors<Real> &m) {
+        const Real d1v = (logSK + m.drift) / m.volSqrtT;
+        const Real d2v = d1v - m.volSqrtT;
+        const Real pdf = FastNormPdf(Fast(d1v));
+        Fast Nd1, Nm1, Nd2, Nm2;   // N(d) and N(-d)
+        FastNormCdfPair(Fast(d1v), Nd1, Nm1);
+        FastNormCdfPair(Fast(d2v), Nd2, Nm2);
+
+        const Real SdiscQ = S * m.discQ;
+        const Real KdiscR = K * m.discR;
+        const Real SdiscQpdf = SdiscQ * pdf;
+        const Real decay = -SdiscQpdf * sigma / (2 * m.sqrtT);
+
+        BasicGreekPoint<Real> g;
+        g.deltaCall = m.discQ * Nd1;
+        g.deltaPut = -m.discQ * Nm1;
+        g.gamma = m.discQ * pdf / (S * m.volSqrtT);
+        g.vega = SdiscQpdf * m.sqrtT;
+        g.thetaCall = decay - r * KdiscR * Nd2 + q * SdiscQ * Nd1;
+        g.thetaPut = decay + r * KdiscR * Nm2 - q * SdiscQ * Nm1;
+        g.rhoCall = KdiscR * m.T * Nd2;
+        g.rhoPut = -KdiscR * m.T * Nm2;
+        g.priceCall = SdiscQ * Nd1 - KdiscR * Nd2;
+        g.pricePut = KdiscR * Nm2 - SdiscQ * Nm1;
+        LognormalHigherOrder<Real>(S, sigma, q, r - q, d1v, d2v, pdf, Nd1, Nm1, m, g);
+        return g;
+    }
+};
+
+// Options on a forward F (the S input) : C = e^-rT (F N(d1) - K N(d2)), d1 = (ln(F / K) + sigma^2 T / 2) / (sigma sqrt(T)).
+// Rho is taken at a fixed forward, so it only discounts : -T C
+template <typename Real, typename Fast = Real>
+struct Black76Policy {
+    using Output = Fast;
+
+    static BasicMaturityFactors<Real> Factors(Real r, Real, Real T, Real sigma) {
+        const Real sqrtT = std::sqrt(T);
+        const Real disc = FastExp(-r * T);
+        return {T, sqrtT, sigma * sqrtT, Real(0.5) * sigma * sigma * T, disc, disc};
+    }
+    static BasicGreekPoint<Real> Point(Real K, Real F, Real logFK, Real r, Real, Real sigma, const BasicMaturityFactors<Real> &m) {
+        const Real d1v = (logFK + m.drift) / m.volSqrtT;
+        const Real d2v = d1v - m.volSqrtT;
+        const Real pdf = FastNormPdf(Fast(d1v));
+        Fast Nd1, Nm1, Nd2, Nm2;
+        FastNormCdfPair(Fast(d1v), Nd1, Nm1);
+        FastNormCdfPair(Fast(d2v), Nd2, Nm2);
+
+        const Real Fdisc = F * m.discR;
+        const Real Kdisc = K * m.discR;
+        const Real call = Fdisc * Nd1 - Kdisc * Nd2;
+        const Real put = Kdisc * Nm2 - Fdisc * Nm1;
+        const Real decay = -Fdisc * pdf * sigma / (2 * m.sqrtT);
+
+        BasicGreekPoint<Real> g;
+        g.deltaCall = m.discR * Nd1;
+        g.deltaPut = -m.discR * Nm1;
+        g.gamma = m.discR * pdf / (F * m.volSqrtT);
+        g.vega = Fdisc * pdf * m.sqrtT;
+        g.thetaCall = decay + r * call;
+        g.thetaPut = decay + r * put;
+        g.rhoCall = -m.T * call;
+        g.rhoPut = -m.T * put;
+        g.priceCall = call;
+        g.pricePut = put;
+        LognormalHigherOrder<Real>(F, sigma, r, Real(0), d1v, d2v, pdf, Nd1, Nm1, m, g);
+        return g;
+    }
+};
+
+// Normal model on a forward F : C = e^-rT ((F - K) N(d) + s N'(d)), s = sigma sqrt(T), d = (F - K) / s
+template <typename Real, typename Fast = Real>
+struct BachelierPolicy {
+    using Output = Fast;
+
+    static BasicMaturityFactors<Real> Factors(Real r, Real, Real T, Real sigma) {
+        const Real sqrtT = std::sqrt(T);
+        const Real disc = FastExp(-r * T);
+        return {T, sqrtT, sigma * sqrtT, Real(0), disc, disc};
+    }
+    static BasicGreekPoint<Real> Point(Real K, Real F, Real, Real r, Real, Real sigma, const BasicMaturityFactors<Real> &m) {
+        const Real d = (F - K) / m.volSqrtT;
+        const Real pdf = FastNormPdf(Fast(d));
+        Fast Nd, Nm;
+        FastNormCdfPair(Fast(d), Nd, Nm);
+
+        const Real call = m.discR * ((F - K) * Nd + m.volSqrtT * pdf);
+        const Real put = m.discR * ((K - F) * Nm + m.volSqrtT * pdf);
+        const Real decay = -m.discR * pdf * sigma / (2 * m.sqrtT);
+
+        BasicGreekPoint<Real> g;
+        g.deltaCall = m.discR * Nd;
+        g.deltaPut = -m.discR * Nm;
+        g.gamma = m.discR * pdf / m.volSqrtT;
+        g.vega = m.discR * pdf * m.sqrtT;
+        g.thetaCall = decay + r * call;
+        g.thetaPut = decay + r * put;
+        g.rhoCall = -m.T * call;
+        g.rhoPut = -m.T * put;
+        g.priceCall = call;
+        g.pricePut = put;
+
+        // d depends on sigma and T through s only : dd/dsigma = -d / sigma, dd/dT = -d / 2T
+        const Real invSigma = 1 / sigma;
+        const Real inv = 1 / (m.T * m.volSqrtT);
+        const Real halfInvT = Real(0.5) * m.volSqrtT * inv, invVolSqrtT = m.T * inv;
+        const Real pdfTerm = m.discR * pdf * d * halfInvT;   // -e^-rT dN(d)/dT
+        g.vanna = -m.discR * pdf * d * invSigma;
+        g.volga = g.vega * d * d * invSigma;
+        g.charmCall = r * m.discR * Nd + pdfTerm;
+        g.charmPut = -r * m.discR * Nm + pdfTerm;
+        g.speed = -g.gamma * d * invVolSqrtT;
+        g.color = g.gamma * (r + (1 - d * d) * halfInvT);
+        g.zomma = g.gamma * (d * d - 1) * invSigma;
+        return g;
+    }
+};
+
+// Row kernel : one stock price against maturities [begin, end), only the requested rows are computed and
+// written (the others may be null). One instantiation per Greek set, option set and model, so the loop
+// body holds no test. Every array is a separate restrict parameter so the compiler can vectorise without
+// alias checks. Gamma, Vega and the higher order Greeks but Charm go to their call row, or their put row when
+// only puts are requested.
+// Flattened : with ~300 instantiations GCC would otherwise run out of inlining budget and leave the loop scalar
+template <unsigned Greeks, unsigned Options, typename Model, typename Real = double, typename Output = typename Model::Output>
+GREEKS_DISPATCH GREEKS_FLATTEN
+void GridRowKernel(Real K, Real S, Real r, Real q, Real sigma, size_t begin, size_t end,
+                   const Real *__restrict T, const Real *__restrict sqrtT, const Real *__restrict volSqrtT,
+                   const Real *__restrict drift, const Real *__restrict discQ, const Real *__restrict discR,
+                   Output *__restrict deltaCall, Output *__restrict deltaPut, Output *__restrict gamma, Output *__restrict vega,
+                   Output *__restrict thetaCall, Output *__restrict thetaPut, Output *__restrict rhoCall, Output *__restrict rhoPut,
+                   Output *__restrict vanna, Output *__restrict volga, Output *__restrict charmCall, Output *__restrict charmPut,
+                   Output *__restrict speed, Output *__restrict color, Output *__restrict zomma) {
+    constexpr bool call = Options & Option_Call, put = Options & Option_Put;
+    const Real logSK = FastLog(S / K);
+    for (size_t j = begin; j < end; ++j) {
+        const BasicMaturityFactors<Real> m = {T[j], sqrtT[j], volSqrtT[j], drift[j], discQ[j], discR[j]};
+        const BasicGreekPoint<Real> g = Model::Point(K, S, logSK, r, q, sigma, m);
+        if constexpr ((Greeks & Greek_Delta) && call) deltaCall[j] = g.deltaCall;
+        if constexpr ((Greeks & Greek_Delta) && put) deltaPut[j] = g.deltaPut;
+        if constexpr ((Greeks & Greek_Gamma) != 0) gamma[j] = g.gamma;
+        if constexpr ((Greeks & Greek_Vega) != 0) vega[j] = g.vega;
+        if constexpr ((Greeks & Greek_Theta) && call) thetaCall[j] = g.thetaCall;
+        if constexpr ((Greeks & Greek_Theta) && put) thetaPut[j] = g.thetaPut;
+        if constexpr ((Greeks & Greek_Rho) && call) rhoCall[j] = g.rhoCall;
+        if constexpr ((Greeks & Greek_Rho) && put) rhoPut[j] = g.rhoPut;
+        if constexpr ((Greeks & Greek_Vanna) != 0) vanna[j] = g.vanna;
+        if constexpr ((Greeks & Greek_Volga) != 0) volga[j] = g.volga;
+        if constexpr ((Greeks & Greek_Charm) && call) charmCall[j] = g.charmCall;
+        if constexpr ((Greeks & Greek_Charm) && put) charmPut[j] = g.charmPut;
+        if constexpr ((Greeks & Greek_Speed) != 0) speed[j] = g.speed;
+        if constexpr ((Greeks & Greek_Color) != 0) color[j] = g.color;
+        if constexpr ((Greeks & Greek_Zomma) != 0) zomma[j] = g.zomma;
+    }
+}
+
+// Batch kernel : independent contracts, every first order Greek of both option types, and every higher order
+// one with HigherOrder (their rows are not touched otherwise). Inputs are read as double and converted to the
+// Real of the policy
+template <typename Model, bool HigherOrder, typename Real = double, typename Output = typename Model::Output>
+GREEKS_DISPATCH GREEKS_FLATTEN
+void BatchKernel(size_t begin, size_t end,
+                 const double *__restrict K, const double *__restrict S, const double *__restrict T,
+                 const double *__restrict sigma, const double *__restrict r, const double *__restrict q,
+                 Output *__restrict deltaCall, Output *__restrict deltaPut, Output *__restrict gamma, Output *__restrict vega,
+                 Output *__restrict thetaCall, Output *__restrict thetaPut, Output *__restrict rhoCall, Output *__restrict rhoPut,
+                 Output *__restrict vanna, Output *__restrict volga, Output *__restrict charmCall, Output *__restrict charmPut,
+                 Output *__restrict speed, Output *__restrict color, Output *__restrict zomma) {
+    for (size_t k = begin; k < end; ++k) {
+        const Real Kk = Real(K[k]), Sk = Real(S[k]), rk = Real(r[k]), qk = Real(q[k]), sigmak = Real(sigma[k]);
+        const BasicMaturityFactors<Real> m = Model::Factors(rk, qk, Real(T[k]), sigmak);
+        const BasicGreekPoint<Real> g = Model::Point(Kk, Sk, FastLog(Sk / Kk), rk, qk, sigmak, m);
+        deltaCall[k] = g.deltaCall;
+        deltaPut[k] = g.deltaPut;
+        gamma[k] = g.gamma;
+        vega[k] = g.vega;
+        thetaCall[k] = g.thetaCall;
+        thetaPut[k] = g.thetaPut;
+        rhoCall[k] = g.rhoCall;
+        rhoPut[k] = g.rhoPut;
+        if constexpr (HigherOrder) {
+            vanna[k] = g.vanna;
+            volga[k] = g.volga;
+            charmCall[k] = g.charmCall;
+            charmPut[k] = g.charmPut;
+            speed[k] = g.speed;
+            color[k] = g.color;
+            zomma[k] = g.zomma;
+        }
+    }
+}
+
+// Scenario kernels (Scenario.hpp), options [begin, end) of a block under one (vol, rate) shock.
+// ScenarioFactorsKernel writes the shocked sigma (floored at minVol) and r, ln(S / K), the maturity factors and the
+// option type as a double (1 call, 0 put), computed once and reused by every spot shock. ScenarioKernel then prices
+// the block with S scaled by spotFactor, ln(S / K) shifted by logSpotFactor, and writes the value, Delta, Gamma, Vega,
+// Theta and Rho of the call or the put. A byte wide type would halve the vector width of the pricing loop
+template <typename Model>
+GREEKS_DISPATCH GREEKS_FLATTEN
+void ScenarioFactorsKernel(size_t begin, size_t end,
+                           const double *__restrict K, const double *__restrict S, const double *__restrict T,
+                           const double *__restrict sigma, const double *__restrict r, const double *__restrict q,
+                           const unsigned char *__restrict isCall, double volShock, double rateShock, double minVol,
+                           double *__restrict shockedSigma, double *__restrict shockedR, double *__restrict logSK,
+                           double *__restrict sqrtT, double *__restrict volSqrtT, double *__restrict drift,
+                           double *__restrict discQ, double *__restrict discR, double *__restrict call) {
+    for (size_t k = begin; k < end; ++k) {
+        const double vol = std::max(sigma[k] + volShock, minVol), rate = r[k] + rateShock;
+        const BasicMaturityFactors<double> m = Model::Factors(rate, q[k], T[k], vol);
+        shockedSigma[k] = vol;
+        shockedR[k] = rate;
+        logSK[k] = FastLog(S[k] / K[k]);
+        sqrtT[k] = m.sqrtT;
+        volSqrtT[k] = m.volSqrtT;
+        drift[k] = m.drift;
+        discQ[k] = m.discQ;
+        discR[k] = m.discR;
+        call[k] = isCall[k] ? 1.0 : 0.0;
+    }
+}
+
+template <typename Model>
+GREEKS_DISPATCH GREEKS_FLATTEN
+void ScenarioKernel(size_t begin, size_t end, double spotFactor, double logSpotFactor,
+                    const double *__restrict K, const double *__restrict S, const double *__restrict T,
+                    const double *__restrict q, const double *__restrict call,
+                    const double *__restrict shockedSigma, const double *__restrict shockedR, const double *__restrict logSK,
+                    const double *__restrict sqrtT, const double *__restrict volSqrtT, const double *__restrict drift,
+                    const double *__restrict discQ, const double *__restrict discR,
+                    double *__restrict value, double *__restrict delta, double *__restrict gamma, double *__restrict vega,
+                    double *__restrict theta, double *__restrict rho) {
+    for (size_t k = begin; k < end; ++k) {
+        const BasicMaturityFactors<double> m = {T[k], sqrtT[k], volSqrtT[k], drift[k], discQ[k], discR[k]};
+        const GreekPoint g = Model::Point(K[k], S[k] * spotFactor, logSK[k] + logSpotFactor, shockedR[k], q[k], shockedSigma[k], m);
+        const bool isCall = call[k] != 0;
+        value[k] = isCall ? g.priceCall : g.pricePut;
+        delta[k] = isCall ? g.deltaCall : g.deltaPut;
+        gamma[k] = g.gamma;
+        vega[k] = g.vega;
+        theta[k] = isCall ? g.thetaCall : g.thetaPut;
+        rho[k] = isCall ? g.rhoCall : g.rhoPut;
+    }
+}
+
+// Chain kernel (Chain.hpp) : one strike against expiries [begin, end) of a chain, each contract at its own vol, read from
+// the strike's row of the smile. The expiry columns hold sqrt(T), both discounts and the drift split as
+// driftBase + sigma^2 driftVar (affine in sigma^2 in every model), so the exps of an expiry are shared by every strike.
+// Every first order row of both option types, and every higher order one with HigherOrder
+template <typename Model, bool HigherOrder>
+GREEKS_DISPATCH GREEKS_FLATTEN
+void ChainRowKernel(double K, double S, double r, double q, size_t begin, size_t end,
+                    const double *__restrict T, const double *__restrict sqrtT, const double *__restrict driftBase,
+                    const double *__restrict driftVar, const double *__restrict discQ, const double *__restrict discR,
+                    const double *__restrict sigma,
+                    double *__restrict deltaCall, double *__restrict deltaPut, double *__restrict gamma, double *__restrict vega,
+                    double *__restrict thetaCall, double *__restrict thetaPut, double *__restrict rhoCall, double *__restrict rhoPut,
+                    double *__restrict vanna, double *__restrict volga, double *__restrict charmCall, double *__restrict charmPut,
+                    double *__restrict speed, double *__restrict color, double *__restrict zomma) {
+    const double logSK = FastLog(S / K);
+    for (size_t j = begin; j < end; ++j) {
+        const double vol = sigma[j];
+        const MaturityFactors m = {T[j], sqrtT[j], vol * sqrtT[j], driftBase[j] + vol * vol * driftVar[j], discQ[j], discR[j]};
+        const GreekPoint g = Model::Point(K, S, logSK, r, q, vol, m);
+        deltaCall[j] = g.deltaCall;
+        deltaPut[j] = g.deltaPut;
+        gamma[j] = g.gamma;
+        vega[j] = g.vega;
+        thetaCall[j] = g.thetaCall;
+        thetaPut[j] = g.thetaPut;
+        rhoCall[j] = g.rhoCall;
+        rhoPut[j] = g.rhoPut;
+        if constexpr (HigherOrder) {
+            vanna[j] = g.vanna;
+            volga[j] = g.volga;
+            charmCall[j] = g.charmCall;
+            charmPut[j] = g.charmPut;
+            speed[j] = g.speed;
+            color[j] = g.color;
+            zomma[j] = g.zomma;
+        }
+    }
+}
+
+template <typename Real, typename Output>
+using BasicRowKernel = void (*)(Real, Real, Real, Real, Real, size_t, size_t,
+                                const Real *, const Real *, const Real *, const Real *, const Real *, const Real *,
+                                Output *, Output *, Output *, Output *, Output *, Output *, Output *, Output *,
+                                Output *, Output *, Output *, Output *, Output *, Output *, Output *);
+template <typename Output>
+using BasicBatchKernel = void (*)(size_t, size_t, const double *, const double *, const double *, const double *, const double *, const double *,
+                                  Output *, Output *, Output *, Output *, Output *, Output *, Output *, Output *,
+                                  Output *, Output *, Output *, Output *, Output *, Output *, Output *);
+using RowKernel = BasicRowKernel<double, double>;
+using BatchKernelFunction = BasicBatchKernel<double>;
+using ScenarioFactorsFunction = void (*)(size_t, size_t, const double *, const double *, const double *, const double *, const double *,
+                                         const double *, const unsigned char *, double, double, double, double *, double *, double *,
+                                         double *, double *, double *, double *, double *, double *);
+using ScenarioKernelFunction = void (*)(size_t, size_t, double, double, const double *, const double *, const double *, const double *,
+                                        const double *, const double *, const double *, const double *, const double *,
+                                        const double *, const double *, const double *, const double *,
+                                        double *, double *, double *, double *, double *, double *);
+using ChainKernelFunction = void (*)(double, double, double, double, size_t, size_t, const double *, const double *, const double *,
+                                     const double *, const double *, const double *, const double *,
+                                     double *, double *, double *, double *, double *, double *, double *, double *,
+                                     double *, double *, double *, double *, double *, double *, double *);
+
+// Every kernel of one model : row[option set - 1][Greek set] for the first order Greek sets, option and Greek sets
+// being OptionFlag and GreekFlag masks, and allOrders[option set - 1] for any set holding a higher order Greek : it
+// computes all eleven and ComputeGreek sends the rows nobody asked for to scratch memory. The higher order Greeks
+// reuse the exp and N of the first order ones and only add a few products and divisions, where a kernel per set of
+// eleven Greeks would multiply the build by 64.
+// The reduced precision and batch kernels come in two : [0] every first order Greek of both option types, [1] every
+// Greek (the float and mixed kernels, mostly exp and N, barely change cost with the number of rows written, and 93
+// more instantiations per precision would double the build)
+struct ModelKernels {
+    std::array<RowKernel, Greek_FirstOrder + 1> row[Option_All];
+    RowKernel allOrders[Option_All];
+    BatchKernelFunction batch[2];
+    BasicRowKernel<float, float> rowFloat[2];     // Precision_Float, float columns (MaturityColumnsF)
+    BasicRowKernel<double, float> rowMixed[2];    // Precision_Mixed, double columns
+    BasicBatchKernel<float> batchFloat[2], batchMixed[2];
+    ScenarioFactorsFunction scenarioFactors;
+    ScenarioKernelFunction scenario;
+    ChainKernelFunction chain[2];                 // [0] first order Greeks, [1] every Greek
+};
+
+template <typename Model, unsigned Options, size_t... Greeks>
+std::array<RowKernel, sizeof...(Greeks)> RowKernels(std::index_sequence<Greeks...>) {
+    return {{&GridRowKernel<Greeks, Options, Model>...}};
+}
+
+// Model : BlackScholesPolicy, Black76Policy or BachelierPolicy
+template <template <typename, typename> class Model>
+ModelKernels MakeModelKernels() {
+    using Double = Model<double, double>;
+    using Float = Model<float, float>;
+    using Mixed = Model<double, float>;
+    ModelKernels kernels;
+    kernels.row[Option_Call - 1] = RowKernels<Double, Option_Call>(std::make_index_sequence<Greek_FirstOrder + 1>());
+    kernels.row[Option_Put - 1] = RowKernels<Double, Option_Put>(std::make_index_sequence<Greek_FirstOrder + 1>());
+    kernels.row[Option_All - 1] = RowKernels<Double, Option_All>(std::make_index_sequence<Greek_FirstOrder + 1>());
+    kernels.allOrders[Option_Call - 1] = &GridRowKernel<Greek_All, Option_Call, Double>;
+    kernels.allOrders[Option_Put - 1] = &GridRowKernel<Greek_All, Option_Put, Double>;
+    kernels.allOrders[Option_All - 1] = &GridRowKernel<Greek_All, Option_All, Double>;
+    kernels.batch[0] = &BatchKernel<Double, false>;
+    kernels.batch[1] = &BatchKernel<Double, true>;
+    kernels.rowFloat[0] = &GridRowKernel<Greek_FirstOrder, Option_All, Float, float>;
+    kernels.rowFloat[1] = &GridRowKernel<Greek_All, Option_All, Float, float>;
+    kernels.rowMixed[0] = &GridRowKernel<Greek_FirstOrder, Option_All, Mixed, double>;
+    kernels.rowMixed[1] = &GridRowKernel<Greek_All, Option_All, Mixed, double>;
+    kernels.batchFloat[0] = &BatchKernel<Float, false, float>;
+    kernels.batchFloat[1] = &BatchKernel<Float, true, float>;
+    kernels.batchMixed[0] = &BatchKernel<Mixed, false, double>;
+    kernels.batchMixed[1] = &BatchKernel<Mixed, true, double>;
+    kernels.scenarioFactors = &ScenarioFactorsKernel<Double>;
+    kernels.scenario = &ScenarioKernel<Double>;
+    kernels.chain[0] = &ChainRowKernel<Double, false>;
+    kernels.chain[1] = &ChainRowKernel<Double, true>;
+    return kernels;
+}
+
+const ModelKernels &BlackScholesKernels();   // GreekKernelsBlackScholes.cpp
+const ModelKernels &Black76Kernels();        // GreekKernelsBlack76.cpp
+const ModelKernels &BachelierKernels();      // GreekKernelsBachelier.cpp
+const ModelKernels &KernelsOf(PricingModel model);   // Greeks.cpp
+
+#endif /* GREEKKERNELS_HPP_ */
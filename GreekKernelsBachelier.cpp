@@ -0,0 +1,6 @@
+#include "GreekKernels.hpp"
+
+const ModelKernels &BachelierKernels() {
+    static const ModelKernels kernels = MakeModelKernels<BachelierPolicy>();
+    return kernels;
+}
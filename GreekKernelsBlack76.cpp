@@ -0,0 +1,6 @@
+#include "GreekKernels.hpp"
+
+const ModelKernels &Black76Kernels() {
+    static const ModelKernels kernels = MakeModelKernels<Black76Policy>();
+    return kernels;
+}
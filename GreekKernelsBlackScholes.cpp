@@ -0,0 +1,6 @@
+#include "GreekKernels.hpp"
+
+const ModelKernels &BlackScholesKernels() {
+    static const ModelKernels kernels = MakeModelKernels<BlackScholesPolicy>();
+    return kernels;
+}
@@ -0,0 +1,603 @@
+#include "GreekRenderer.hpp"
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+#define GL_GLEXT_PROTOTYPES   // prototypes only name the types of the pointers below, nothing links against them
+#if defined(__APPLE__)
+#include <OpenGL/gl3.h>
+#else
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// Functions above OpenGL 1.1, loaded by Init(); 1.1 is exported by every GL library
+struct GlApi {
+    decltype(&glGenBuffers) GenBuffers;
+    decltype(&glDeleteBuffers) DeleteBuffers;
+    decltype(&glBindBuffer) BindBuffer;
+    decltype(&glBufferData) BufferData;
+    decltype(&glBufferSubData) BufferSubData;
+    decltype(&glGenVertexArrays) GenVertexArrays;
+    decltype(&glDeleteVertexArrays) DeleteVertexArrays;
+    decltype(&glBindVertexArray) BindVertexArray;
+    decltype(&glEnableVertexAttribArray) EnableVertexAttribArray;
+    decltype(&glVertexAttribPointer) VertexAttribPointer;
+    decltype(&glCreateShader) CreateShader;
+    decltype(&glShaderSource) ShaderSource;
+    decltype(&glCompileShader) CompileShader;
+    decltype(&glGetShaderiv) GetShaderiv;
+    decltype(&glGetShaderInfoLog) GetShaderInfoLog;
+    decltype(&glDeleteShader) DeleteShader;
+    decltype(&glCreateProgram) CreateProgram;
+    decltype(&glAttachShader) AttachShader;
+    decltype(&glBindAttribLocation) BindAttribLocation;
+    decltype(&glLinkProgram) LinkProgram;
+    decltype(&glGetProgramiv) GetProgramiv;
+    decltype(&glGetProgramInfoLog) GetProgramInfoLog;
+    decltype(&glUseProgram) UseProgram;
+    decltype(&glDeleteProgram) DeleteProgram;
+    decltype(&glGetUniformLocation) GetUniformLocation;
+    decltype(&glUniform1i) Uniform1i;
+    decltype(&glUniform2f) Uniform2f;
+    decltype(&glUniform4f) Uniform4f;
+    decltype(&glUniformMatrix4fv) UniformMatrix4fv;
+    decltype(&glGenFramebuffers) GenFramebuffers;
+    decltype(&glDeleteFramebuffers) DeleteFramebuffers;
+    decltype(&glBindFramebuffer) BindFramebuffer;
+    decltype(&glFramebufferTexture2D) FramebufferTexture2D;
+    decltype(&glCheckFramebufferStatus) CheckFramebufferStatus;
+    decltype(&glGenRenderbuffers) GenRenderbuffers;
+    decltype(&glDeleteRenderbuffers) DeleteRenderbuffers;
+    decltype(&glBindRenderbuffer) BindRenderbuffer;
+    decltype(&glRenderbufferStorage) RenderbufferStorage;
+    decltype(&glFramebufferRenderbuffer) FramebufferRenderbuffer;
+};
+GlApi gl;
+
+template <typename F>
+bool Load(GlProcLoader loader, const char *name, F &function) {
+    function = reinterpret_cast<F>(loader(name));
+    if (!function) std::cerr << "GreekRenderer: OpenGL function " << name << " is missing." << std::endl;
+    return function != nullptr;
+}
+
+bool LoadApi(GlProcLoader loader) {
+    bool ok = true;
+    ok &= Load(loader, "glGenBuffers", gl.GenBuffers);
+    ok &= Load(loader, "glDeleteBuffers", gl.DeleteBuffers);
+    ok &= Load(loader, "glBindBuffer", gl.BindBuffer);
+    ok &= Load(loader, "glBufferData", gl.BufferData);
+    ok &= Load(loader, "glBufferSubData", gl.BufferSubData);
+    ok &= Load(loader, "glGenVertexArrays", gl.GenVertexArrays);
+    ok &= Load(loader, "glDeleteVertexArrays", gl.DeleteVertexArrays);
+    ok &= Load(loader, "glBindVertexArray", gl.BindVertexArray);
+    ok &= Load(loader, "glEnableVertexAttribArray", gl.EnableVertexAttribArray);
+    ok &= Load(loader, "glVertexAttribPointer", gl.VertexAttribPointer);
+    ok &= Load(loader, "glCreateShader", gl.CreateShader);
+    ok &= Load(loader, "glShaderSource", gl.ShaderSource);
+    ok &= Load(loader, "glCompileShader", gl.CompileShader);
+    ok &= Load(loader, "glGetShaderiv", gl.GetShaderiv);
+    ok &= Load(loader, "glGetShaderInfoLog", gl.GetShaderInfoLog);
+    ok &= Load(loader, "glDeleteShader", gl.DeleteShader);
+    ok &= Load(loader, "glCreateProgram", gl.CreateProgram);
+    ok &= Load(loader, "glAttachShader", gl.AttachShader);
+    ok &= Load(loader, "glBindAttribLocation", gl.BindAttribLocation);
+    ok &= Load(loader, "glLinkProgram", gl.LinkProgram);
+    ok &= Load(loader, "glGetProgramiv", gl.GetProgramiv);
+    ok &= Load(loader, "glGetProgramInfoLog", gl.GetProgramInfoLog);
+    ok &= Load(loader, "glUseProgram", gl.UseProgram);
+    ok &= Load(loader, "glDeleteProgram", gl.DeleteProgram);
+    ok &= Load(loader, "glGetUniformLocation", gl.GetUniformLocation);
+    ok &= Load(loader, "glUniform1i", gl.Uniform1i);
+    ok &= Load(loader, "glUniform2f", gl.Uniform2f);
+    ok &= Load(loader, "glUniform4f", gl.Uniform4f);
+    ok &= Load(loader, "glUniformMatrix4fv", gl.UniformMatrix4fv);
+    ok &= Load(loader, "glGenFramebuffers", gl.GenFramebuffers);
+    ok &= Load(loader, "glDeleteFramebuffers", gl.DeleteFramebuffers);
+    ok &= Load(loader, "glBindFramebuffer", gl.BindFramebuffer);
+    ok &= Load(loader, "glFramebufferTexture2D", gl.FramebufferTexture2D);
+    ok &= Load(loader, "glCheckFramebufferStatus", gl.CheckFramebufferStatus);
+    ok &= Load(loader, "glGenRenderbuffers", gl.GenRenderbuffers);
+    ok &= Load(loader, "glDeleteRenderbuffers", gl.DeleteRenderbuffers);
+    ok &= Load(loader, "glBindRenderbuffer", gl.BindRenderbuffer);
+    ok &= Load(loader, "glRenderbufferStorage", gl.RenderbufferStorage);
+    ok &= Load(loader, "glFramebufferRenderbuffer", gl.FramebufferRenderbuffer);
+    return ok;
+}
+
+// Grid coordinates (S, T) scaled to [0, 1] in attribute 0, the value in attribute 1.
+// uLayout : 0 = value against S, 1 = value against T, 2 = surface (S, value, T) in a box centred on the origin
+const char *VertexShader = R"(#version 130
+in vec2 aGrid;
+in float aValue;
+uniform mat4 uTransform;
+uniform vec2 uRange;     // value offset and scale to [0, 1]
+uniform int uLayout;
+out float vFade;
+out float vHeight;
+void main() {
+    float h = (aValue - uRange.x) * uRange.y;
+    vFade = aGrid.y;
+    vHeight = h;
+    vec3 p = uLayout == 2 ? vec3(2.0 * aGrid.x - 1.0, 1.4 * h - 0.7, 1.0 - 2.0 * aGrid.y)
+                          : vec3(uLayout == 0 ? aGrid.x : aGrid.y, h, 0.0);
+    gl_Position = uTransform * vec4(p, 1.0);
+}
+)";
+
+// uShading : 0 = flat, 1 = darker as T grows, 2 = darker as the value drops
+const char *FragmentShader = R"(#version 130
+in float vFade;
+in float vHeight;
+uniform vec4 uColor;
+uniform int uShading;
+out vec4 fragColor;
+void main() {
+    float light = uShading == 1 ? 1.0 - 0.65 * vFade : (uShading == 2 ? 0.45 + 0.55 * clamp(vHeight, 0.0, 1.0) : 1.0);
+    fragColor = vec4(uColor.rgb * light, uColor.a);
+}
+)";
+
+unsigned CompileShader(GLenum type, const char *source) {
+    const GLuint shader = gl.CreateShader(type);
+    gl.ShaderSource(shader, 1, &source, nullptr);
+    gl.CompileShader(shader);
+    GLint ok = 0;
+    gl.GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        gl.GetShaderInfoLog(shader, sizeof log, nullptr, log);
+        std::cerr << "GreekRenderer: shader does not compile: " << log << std::endl;
+        gl.DeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// Column-major 4x4 matrices, as glUniformMatrix4fv reads them
+struct Mat4 {
+    float m[16];
+};
+
+Mat4 Identity() {
+    Mat4 r{};
+    r.m[0] = r.m[5] = r.m[10] = r.m[15] = 1;
+    return r;
+}
+
+Mat4 Multiply(const Mat4 &a, const Mat4 &b) {
+    Mat4 r{};
+    for (int c = 0; c < 4; ++c)
+        for (int row = 0; row < 4; ++row)
+            for (int k = 0; k < 4; ++k) r.m[c * 4 + row] += a.m[k * 4 + row] * b.m[c * 4 + k];
+    return r;
+}
+
+// [0, 1]^2 to the panel, leaving room for the labels drawn over the image
+Mat4 PlotTransform() {
+    Mat4 r = Identity();
+    r.m[0] = 1.80f; r.m[12] = -0.88f;
+    r.m[5] = 1.70f; r.m[13] = -0.82f;
+    return r;
+}
+
+Mat4 CameraTransform(const PlotCamera &camera, float aspect) {
+    // view : the eye orbits the origin at `distance`
+    const float cp = std::cos(camera.pitch), sp = std::sin(camera.pitch), cy = std::cos(camera.yaw), sy = std::sin(camera.yaw);
+    const float eye[3] = {camera.distance * cp * sy, camera.distance * sp, camera.distance * cp * cy};
+    const float f[3] = {-eye[0] / camera.distance, -eye[1] / camera.distance, -eye[2] / camera.distance};   // forward
+    float s[3] = {f[1] * 0 - f[2] * 1, f[2] * 0 - f[0] * 0, f[0] * 1 - f[1] * 0};                          // forward x up
+    const float sn = std::sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+    for (float &v : s) v /= sn;
+    const float u[3] = {s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0]};
+    Mat4 view = Identity();
+    view.m[0] = s[0]; view.m[4] = s[1]; view.m[8] = s[2];
+    view.m[1] = u[0]; view.m[5] = u[1]; view.m[9] = u[2];
+    view.m[2] = -f[0]; view.m[6] = -f[1]; view.m[10] = -f[2];
+    view.m[12] = -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]);
+    view.m[13] = -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]);
+    view.m[14] = f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2];
+
+    // 45 degree perspective
+    const float nearPlane = 0.05f, farPlane = 50.0f, t = 1.0f / std::tan(0.3927f);
+    Mat4 projection{};
+    projection.m[0] = t / aspect;
+    projection.m[5] = t;
+    projection.m[10] = (farPlane + nearPlane) / (nearPlane - farPlane);
+    projection.m[11] = -1;
+    projection.m[14] = 2 * farPlane * nearPlane / (nearPlane - farPlane);
+    return Multiply(projection, view);
+}
+
+const float CallColor[3] = {0.30f, 0.55f, 1.00f};
+const float PutColor[3] = {1.00f, 0.35f, 0.30f};
+const float AtmColor[3] = {0.30f, 0.80f, 0.30f};
+
+} // namespace
+
+void PlotCamera::Orbit(float dx, float dy) {
+    yaw -= dx * 0.01f;
+    pitch = std::min(1.5f, std::max(-1.5f, pitch + dy * 0.01f));
+}
+
+void PlotCamera::Zoom(float steps) {
+    distance = std::min(12.0f, std::max(1.2f, distance * std::pow(0.9f, steps)));
+}
+
+void PlotLayout(size_t count, int &rows, int &cols) {
+    if (count <= 1) { rows = 1; cols = 1; }
+    else if (count == 2) { rows = 1; cols = 2; }
+    else if (count == 3) { rows = 1; cols = 3; }
+    else if (count == 4) { rows = 2; cols = 2; }
+    else if (count <= 6) { rows = 2; cols = 3; }
+    else if (count <= 9) { rows = 3; cols = 3; }
+    else { rows = static_cast<int>((count + 2) / 3); cols = 3; }
+}
+
+int GreekRenderer::Init(GlProcLoader loader) {
+    Release();
+    if (!LoadApi(loader)) return -1;
+
+    const unsigned vertex = CompileShader(GL_VERTEX_SHADER, VertexShader);
+    const unsigned fragment = CompileShader(GL_FRAGMENT_SHADER, FragmentShader);
+    if (!vertex || !fragment) {
+        if (vertex) gl.DeleteShader(vertex);
+        if (fragment) gl.DeleteShader(fragment);
+        return -1;
+    }
+    program_ = gl.CreateProgram();
+    gl.AttachShader(program_, vertex);
+    gl.AttachShader(program_, fragment);
+    gl.BindAttribLocation(program_, 0, "aGrid");
+    gl.BindAttribLocation(program_, 1, "aValue");
+    gl.LinkProgram(program_);
+    gl.DeleteShader(vertex);
+    gl.DeleteShader(fragment);
+    GLint linked = 0;
+    gl.GetProgramiv(program_, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[1024];
+        gl.GetProgramInfoLog(program_, sizeof log, nullptr, log);
+        std::cerr << "GreekRenderer: shader program does not link: " << log << std::endl;
+        gl.DeleteProgram(program_);
+        program_ = 0;
+        return -1;
+    }
+    uTransform_ = gl.GetUniformLocation(program_, "uTransform");
+    uRange_ = gl.GetUniformLocation(program_, "uRange");
+    uLayout_ = gl.GetUniformLocation(program_, "uLayout");
+    uColor_ = gl.GetUniformLocation(program_, "uColor");
+    uShading_ = gl.GetUniformLocation(program_, "uShading");
+
+    GLint previousVao = 0, previousBuffer = 0;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVao);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previousBuffer);
+
+    // panel frames : a [0, 1]^2 box for the curves, the floor of the box for the surfaces (x, y, value)
+    const float frame[] = {0, 0, 0,  1, 0, 0,  1, 0, 1,  0, 0, 1,
+                           0, 0, 0,  1, 0, 0,  1, 1, 0,  0, 1, 0};
+    gl.GenBuffers(1, &frameBuffer_);
+    gl.BindBuffer(GL_ARRAY_BUFFER, frameBuffer_);
+    gl.BufferData(GL_ARRAY_BUFFER, sizeof frame, frame, GL_STATIC_DRAW);
+    gl.GenVertexArrays(1, &frameVao_);
+    gl.BindVertexArray(frameVao_);
+    gl.EnableVertexAttribArray(0);
+    gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+    gl.EnableVertexAttribArray(1);
+    gl.VertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 3 * sizeof(float), reinterpret_cast<const void *>(2 * sizeof(float)));
+
+    gl.GenBuffers(1, &gridBuffer_);
+    gl.GenBuffers(1, &curveIndices_);
+    gl.GenBuffers(1, &surfaceIndices_);
+
+    gl.BindVertexArray(previousVao);
+    gl.BindBuffer(GL_ARRAY_BUFFER, previousBuffer);
+    return 0;
+}
+
+void GreekRenderer::Release() {
+    if (!program_) return;
+    for (auto &greek : slices_)
+        for (Slice &slice : greek) {
+            if (slice.vao) gl.DeleteVertexArrays(1, &slice.vao);
+            if (slice.buffer) gl.DeleteBuffers(1, &slice.buffer);
+            slice = Slice();
+        }
+    const unsigned buffers[] = {gridBuffer_, curveIndices_, surfaceIndices_, frameBuffer_};
+    gl.DeleteBuffers(4, buffers);
+    gl.DeleteVertexArrays(1, &frameVao_);
+    if (framebuffer_) gl.DeleteFramebuffers(1, &framebuffer_);
+    if (depthBuffer_) gl.DeleteRenderbuffers(1, &depthBuffer_);
+    if (colorTexture_) glDeleteTextures(1, &colorTexture_);
+    gl.DeleteProgram(program_);
+    program_ = gridBuffer_ = curveIndices_ = surfaceIndices_ = frameBuffer_ = frameVao_ = 0;
+    framebuffer_ = colorTexture_ = depthBuffer_ = 0;
+    width_ = height_ = 0;
+    nS_ = nT_ = 0;
+    version_ = 0;
+    stockAxis_.clear();
+    maturityAxis_.clear();
+}
+
+void GreekRenderer::UpdateAxes(const GreekGrid &grid) {
+    stockAxis_ = grid.StockPrices;
+    maturityAxis_ = grid.TimeToMaturities;
+    const std::vector<double> *axes[2] = {&stockAxis_, &maturityAxis_};
+    for (int a = 0; a < 2; ++a) {
+        const auto range = std::minmax_element(axes[a]->begin(), axes[a]->end());
+        axisMin_[a] = *range.first;
+        axisMax_[a] = *range.second;
+    }
+    const double sScale = axisMax_[0] > axisMin_[0] ? 1.0 / (axisMax_[0] - axisMin_[0]) : 0.0;
+    const double tScale = axisMax_[1] > axisMin_[1] ? 1.0 / (axisMax_[1] - axisMin_[1]) : 0.0;
+
+    staging_.resize(2 * nS_ * nT_);
+    for (size_t i = 0; i < nS_; ++i)
+        for (size_t j = 0; j < nT_; ++j) {
+            staging_[2 * (i * nT_ + j)] = static_cast<float>((stockAxis_[i] - axisMin_[0]) * sScale);
+            staging_[2 * (i * nT_ + j) + 1] = static_cast<float>((maturityAxis_[j] - axisMin_[1]) * tScale);
+        }
+    gl.BindBuffer(GL_ARRAY_BUFFER, gridBuffer_);
+    gl.BufferData(GL_ARRAY_BUFFER, staging_.size() * sizeof(float), staging_.data(), GL_STATIC_DRAW);
+}
+
+void GreekRenderer::UpdateIndices() {
+    // curves along S, one per maturity but the first (as the Matplot++ figures)
+    std::vector<unsigned> indices;
+    const size_t firstColumn = nT_ > 1 ? 1 : 0;
+    indices.reserve(2 * (nT_ - firstColumn) * (nS_ > 0 ? nS_ - 1 : 0));
+    for (size_t j = firstColumn; j < nT_; ++j)
+        for (size_t i = 0; i + 1 < nS_; ++i) {
+            indices.push_back(static_cast<unsigned>(i * nT_ + j));
+            indices.push_back(static_cast<unsigned>((i + 1) * nT_ + j));
+        }
+    curveIndexCount_ = indices.size();
+    gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, curveIndices_);
+    gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned), indices.data(), GL_STATIC_DRAW);
+
+    // two triangles per grid cell
+    indices.clear();
+    for (size_t i = 0; i + 1 < nS_; ++i)
+        for (size_t j = 0; j + 1 < nT_; ++j) {
+            const unsigned a = static_cast<unsigned>(i * nT_ + j), b = a + 1;
+            const unsigned c = static_cast<unsigned>(a + nT_), d = c + 1;
+            indices.insert(indices.end(), {a, c, b, b, c, d});
+        }
+    surfaceIndexCount_ = indices.size();
+    gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, surfaceIndices_);
+    gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned), indices.data(), GL_STATIC_DRAW);
+}
+
+void GreekRenderer::BindSlice(Slice &slice) {
+    if (slice.vao) return;
+    gl.GenBuffers(1, &slice.buffer);
+    gl.GenVertexArrays(1, &slice.vao);
+    gl.BindVertexArray(slice.vao);
+    gl.BindBuffer(GL_ARRAY_BUFFER, gridBuffer_);
+    gl.EnableVertexAttribArray(0);
+    gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    gl.BindBuffer(GL_ARRAY_BUFFER, slice.buffer);
+    gl.EnableVertexAttribArray(1);
+    gl.VertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
+}
+
+size_t GreekRenderer::Update(const GreekGrid &grid) {
+    if (!program_ || grid.version == 0 || grid.version == version_) return 0;
+    const auto start = std::chrono::steady_clock::now();
+    version_ = grid.version;
+    uploaded_ = 0;
+
+    GLint previousVao = 0, previousBuffer = 0;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVao);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previousBuffer);
+    gl.BindVertexArray(0);   // the element buffer bindings below must not land in a vertex array
+
+    const GreekTensor &values = grid.GreekValues;
+    const bool newShape = values.NumStocks() != nS_ || values.NumMaturities() != nT_;
+    nS_ = values.NumStocks();
+    nT_ = values.NumMaturities();
+    if (newShape || grid.StockPrices != stockAxis_ || grid.TimeToMaturities != maturityAxis_) UpdateAxes(grid);
+    if (newShape) UpdateIndices();
+    greeks_ = grid.request.greeks & Greek_All;
+    options_ = grid.request.options & Option_All;
+
+    // slices are kept per Greek and option type, not per tensor slot : a Greek that stays in the set keeps
+    // its buffer and is only uploaded if its values moved
+    for (size_t k = 0; k < NumGreekKinds; ++k) {
+        const unsigned greek = 1u << k;
+        if (!(greeks_ & greek)) continue;
+        for (size_t o = 0; o < NumOptionKinds; ++o) {
+            const unsigned option = 1u << o;
+            if (!(options_ & option)) continue;
+            const SliceView<const double> slice = values.Slice(SlotOf(greeks_, greek), SlotOf(options_, option));
+            staging_.resize(nS_ * nT_);
+            double lo = INFINITY, hi = -INFINITY;
+            for (size_t i = 0; i < nS_; ++i)
+                for (size_t j = 0; j < nT_; ++j) {
+                    const double v = slice(i, j);
+                    staging_[i * nT_ + j] = static_cast<float>(v);
+                    if (std::isfinite(v)) { lo = std::min(lo, v); hi = std::max(hi, v); }
+                }
+
+            Slice &target = slices_[k][o];
+            target.minValue = lo;
+            target.maxValue = hi;
+            const bool unchanged = !newShape && target.vao && target.values.size() == staging_.size() &&
+                                   std::memcmp(target.values.data(), staging_.data(), staging_.size() * sizeof(float)) == 0;
+            if (unchanged) continue;
+
+            BindSlice(target);
+            gl.BindVertexArray(0);
+            gl.BindBuffer(GL_ARRAY_BUFFER, target.buffer);
+            if (target.values.size() == staging_.size())
+                gl.BufferSubData(GL_ARRAY_BUFFER, 0, staging_.size() * sizeof(float), staging_.data());
+            else
+                gl.BufferData(GL_ARRAY_BUFFER, staging_.size() * sizeof(float), staging_.data(), GL_DYNAMIC_DRAW);
+            target.values.swap(staging_);
+            ++uploaded_;
+        }
+    }
+
+    gl.BindVertexArray(previousVao);
+    gl.BindBuffer(GL_ARRAY_BUFFER, previousBuffer);
+    uploadMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return uploaded_;
+}
+
+int GreekRenderer::Resize(int width, int height) {
+    if (width == width_ && height == height_) return 0;
+    if (!framebuffer_) {
+        gl.GenFramebuffers(1, &framebuffer_);
+        glGenTextures(1, &colorTexture_);
+        gl.GenRenderbuffers(1, &depthBuffer_);
+    }
+    GLint previousTexture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+    glBindTexture(GL_TEXTURE_2D, colorTexture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, previousTexture);
+    gl.BindRenderbuffer(GL_RENDERBUFFER, depthBuffer_);
+    gl.RenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    gl.BindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture_, 0);
+    gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer_);
+    if (gl.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "GreekRenderer: incomplete framebuffer (" << width << "x" << height << ")" << std::endl;
+        width_ = height_ = 0;
+        return -1;
+    }
+    width_ = width;
+    height_ = height;
+    return 0;
+}
+
+void GreekRenderer::DrawPanel(PlotKind kind, size_t greekBit, const PlotPanel &panel, const PlotCamera &camera,
+                              const MoneynessRows rows[NumOptionKinds]) {
+    // the viewport does not clip what the camera projects outside of it
+    const GLint x = static_cast<GLint>(panel.x), y = static_cast<GLint>(height_ - panel.y - panel.height);
+    glViewport(x, y, static_cast<GLsizei>(panel.width), static_cast<GLsizei>(panel.height));
+    glScissor(x, y, static_cast<GLsizei>(panel.width), static_cast<GLsizei>(panel.height));
+    const bool surface = kind == Plot_Surface;
+    const Mat4 transform = surface ? CameraTransform(camera, panel.width / std::max(1.0f, panel.height)) : PlotTransform();
+    gl.UniformMatrix4fv(uTransform_, 1, GL_FALSE, transform.m);
+
+    // frame
+    gl.Uniform2f(uRange_, 0.0f, 1.0f);
+    gl.Uniform1i(uLayout_, surface ? 2 : 0);
+    gl.Uniform1i(uShading_, 0);
+    gl.Uniform4f(uColor_, 0.45f, 0.45f, 0.5f, 1.0f);
+    gl.BindVertexArray(frameVao_);
+    glDrawArrays(GL_LINE_LOOP, surface ? 4 : 0, 4);
+
+    const double span = panel.maxValue - panel.minValue;
+    gl.Uniform2f(uRange_, static_cast<float>(panel.minValue), static_cast<float>(1.0 / span));
+    gl.Uniform1i(uLayout_, surface ? 2 : (kind == Plot_Moneyness ? 1 : 0));
+    for (size_t o = 0; o < NumOptionKinds; ++o) {
+        if (!(options_ & (1u << o))) continue;
+        Slice &slice = slices_[greekBit][o];
+        const float *color = o == 0 ? CallColor : PutColor;
+        gl.BindVertexArray(slice.vao);
+        if (kind == Plot_Curves) {
+            gl.Uniform1i(uShading_, 1);
+            gl.Uniform4f(uColor_, color[0], color[1], color[2], 1.0f);
+            gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, curveIndices_);
+            glDrawElements(GL_LINES, static_cast<GLsizei>(curveIndexCount_), GL_UNSIGNED_INT, nullptr);
+        } else if (kind == Plot_Surface) {
+            gl.Uniform1i(uShading_, 2);
+            gl.Uniform4f(uColor_, color[0], color[1], color[2], 0.8f);
+            gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, surfaceIndices_);
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(surfaceIndexCount_), GL_UNSIGNED_INT, nullptr);
+        } else {
+            // ITM in the option colour, ATM green, OTM in a lighter option colour
+            const size_t picks[3] = {rows[o].itm, rows[o].atm, rows[o].otm};
+            for (int c = 0; c < 3; ++c) {
+                const size_t i = std::min(picks[c], nS_ - 1);
+                if (c == 1) gl.Uniform4f(uColor_, AtmColor[0], AtmColor[1], AtmColor[2], 1.0f);
+                else if (c == 0) gl.Uniform4f(uColor_, color[0], color[1], color[2], 1.0f);
+                else gl.Uniform4f(uColor_, 0.5f + 0.5f * color[0], 0.5f + 0.5f * color[1], 0.5f + 0.5f * color[2], 1.0f);
+                gl.Uniform1i(uShading_, 0);
+                glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(i * nT_), static_cast<GLsizei>(nT_));
+            }
+        }
+    }
+}
+
+unsigned GreekRenderer::Draw(PlotKind kind, int width, int height, const PlotCamera &camera, const MoneynessRows rows[NumOptionKinds]) {
+    if (!program_ || version_ == 0 || nS_ == 0 || nT_ == 0 || width <= 0 || height <= 0) return 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    // state restored on exit, the caller (ImGui) keeps its own
+    GLint previousFramebuffer = 0, previousProgram = 0, previousVao = 0, previousViewport[4], previousScissor[4];
+    GLfloat previousClear[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVao);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+    glGetIntegerv(GL_SCISSOR_BOX, previousScissor);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, previousClear);
+    const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST), blend = glIsEnabled(GL_BLEND);
+    const GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST), cull = glIsEnabled(GL_CULL_FACE);
+
+    if (Resize(width, height) != 0) {
+        gl.BindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        return 0;
+    }
+    gl.BindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glViewport(0, 0, width, height);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_CULL_FACE);
+    glClearColor(0.08f, 0.08f, 0.10f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_SCISSOR_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (kind == Plot_Surface) glEnable(GL_DEPTH_TEST);
+    else glDisable(GL_DEPTH_TEST);
+    gl.UseProgram(program_);
+
+    // one panel per Greek of the set, value range shared by its calls and puts (+-5%)
+    int layoutRows, layoutCols;
+    const size_t count = CountFlags(greeks_);
+    PlotLayout(count, layoutRows, layoutCols);
+    panels_.clear();
+    const float panelWidth = static_cast<float>(width) / layoutCols, panelHeight = static_cast<float>(height) / layoutRows;
+    for (size_t k = 0; k < NumGreekKinds; ++k) {
+        if (!(greeks_ & (1u << k))) continue;
+        const size_t index = panels_.size();
+        PlotPanel panel{(index % layoutCols) * panelWidth, (index / layoutCols) * panelHeight, panelWidth, panelHeight, k, INFINITY, -INFINITY};
+        for (size_t o = 0; o < NumOptionKinds; ++o)
+            if (options_ & (1u << o)) {
+                panel.minValue = std::min(panel.minValue, slices_[k][o].minValue);
+                panel.maxValue = std::max(panel.maxValue, slices_[k][o].maxValue);
+            }
+        if (!(panel.minValue <= panel.maxValue)) panel.minValue = panel.maxValue = 0;   // nothing finite
+        const double pad = std::max(0.05 * (panel.maxValue - panel.minValue), 1e-12 + 0.05 * std::fabs(panel.maxValue));
+        panel.minValue -= pad;
+        panel.maxValue += pad;
+        panels_.push_back(panel);
+        DrawPanel(kind, k, panel, camera, rows);
+    }
+
+    gl.BindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    gl.UseProgram(previousProgram);
+    gl.BindVertexArray(previousVao);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    glScissor(previousScissor[0], previousScissor[1], previousScissor[2], previousScissor[3]);
+    glClearColor(previousClear[0], previousClear[1], previousClear[2], previousClear[3]);
+    if (depthTest) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+    if (blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+    if (!scissor) glDisable(GL_SCISSOR_TEST);
+    if (cull) glEnable(GL_CULL_FACE);
+    drawMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return colorTexture_;
+}
@@ -0,0 +1,112 @@
+#ifndef GREEKRENDERER_HPP_
+#define GREEKRENDERER_HPP_
+
+#include <cstddef>
+#include <vector>
+#include "GreekSet.hpp"
+#include "RecomputePlan.hpp"
+
+// Native OpenGL 3 renderer of the GUI plots, drawn into an offscreen framebuffer shown with ImGui::Image.
+//
+// The grid axes live in one vertex buffer, the values of every [greek][option] slice in their own buffer
+// (floats, unpadded), and the index buffers of the curves and of the surface triangles only depend on the
+// grid shape. Update() converts the slices of a new result and uploads only those whose values changed,
+// the axes and indices only when they did; Draw() is a handful of draw calls per panel, with the value
+// range of each panel applied in the vertex shader. Needs no GLFW nor ImGui : the GL functions above 1.1
+// are loaded through the loader given to Init() (glfwGetProcAddress in the GUI).
+
+enum PlotKind {
+    Plot_Curves,      // Greek against S, one curve per maturity (darker as T grows)
+    Plot_Surface,     // Greek over (S, T)
+    Plot_Moneyness,   // Greek against T for the ITM, ATM and OTM stock prices
+};
+
+// Orbit camera of the surfaces, angles in radians
+struct PlotCamera {
+    float yaw = -0.75f, pitch = 0.45f, distance = 3.8f;
+
+    void Orbit(float dx, float dy);   // mouse drag in pixels
+    void Zoom(float steps);           // mouse wheel steps, > 0 moves closer
+    void Reset() { *this = PlotCamera(); }
+};
+
+// Stock price rows of the moneyness curves, per option type
+struct MoneynessRows {
+    size_t itm, atm, otm;
+};
+
+// One panel of the last Draw(), in pixels from the top left corner of the image
+struct PlotPanel {
+    float x, y, width, height;
+    size_t greek;                     // index in GreekNames
+    double minValue, maxValue;        // value range mapped to the panel height
+};
+
+// Subplot grid of `count` panels, the layout of the Matplot++ figures
+void PlotLayout(size_t count, int &rows, int &cols);
+
+typedef void (*GlProc)();
+typedef GlProc (*GlProcLoader)(const char *name);
+
+class GreekRenderer {
+public:
+    GreekRenderer() = default;
+    ~GreekRenderer() { Release(); }
+    GreekRenderer(const GreekRenderer &) = delete;
+    GreekRenderer &operator=(const GreekRenderer &) = delete;
+
+    // With the GL context current. Returns 0, -1 if a GL function is missing or a shader does not build (message on std::cerr)
+    int Init(GlProcLoader loader);
+    // Free the GL objects, while the context is still current (the destructor calls it too)
+    void Release();
+    bool Ready() const { return program_ != 0; }
+
+    // Bring the GPU buffers up to date with `grid`, nothing to do if its version was already uploaded.
+    // Returns the number of slices uploaded
+    size_t Update(const GreekGrid &grid);
+
+    // Draw one panel per Greek into a width x height texture and return it (0 before a first Update()).
+    // `rows` (per option type, call then put) is only read by Plot_Moneyness. Restores the GL state it changes
+    unsigned Draw(PlotKind kind, int width, int height, const PlotCamera &camera, const MoneynessRows rows[NumOptionKinds]);
+
+    const std::vector<PlotPanel> &Panels() const { return panels_; }
+    double AxisMin(int axis) const { return axisMin_[axis]; }   // 0 = S, 1 = T
+    double AxisMax(int axis) const { return axisMax_[axis]; }
+    double LastUploadMs() const { return uploadMs_; }
+    size_t LastUploadedSlices() const { return uploaded_; }
+    double LastDrawMs() const { return drawMs_; }                // CPU time spent issuing the draw calls
+
+private:
+    struct Slice {
+        std::vector<float> values;    // copy of what the buffer holds, [S][T] without padding
+        unsigned buffer = 0, vao = 0;
+        double minValue = 0, maxValue = 0;
+    };
+
+    void UpdateAxes(const GreekGrid &grid);
+    void UpdateIndices();
+    void BindSlice(Slice &slice);
+    int Resize(int width, int height);
+    void DrawPanel(PlotKind kind, size_t greekBit, const PlotPanel &panel, const PlotCamera &camera, const MoneynessRows rows[NumOptionKinds]);
+
+    unsigned program_ = 0;
+    int uTransform_ = -1, uRange_ = -1, uLayout_ = -1, uColor_ = -1, uShading_ = -1;
+    unsigned gridBuffer_ = 0, curveIndices_ = 0, surfaceIndices_ = 0, frameBuffer_ = 0, frameVao_ = 0;
+    size_t curveIndexCount_ = 0, surfaceIndexCount_ = 0;
+    unsigned framebuffer_ = 0, colorTexture_ = 0, depthBuffer_ = 0;
+    int width_ = 0, height_ = 0;
+
+    Slice slices_[NumGreekKinds][NumOptionKinds];
+    std::vector<float> staging_;
+    std::vector<double> stockAxis_, maturityAxis_;
+    size_t nS_ = 0, nT_ = 0;
+    unsigned greeks_ = 0, options_ = 0;
+    unsigned long long version_ = 0;
+    double axisMin_[2] = {0, 0}, axisMax_[2] = {0, 0};
+
+    std::vector<PlotPanel> panels_;
+    double uploadMs_ = 0, drawMs_ = 0;
+    size_t uploaded_ = 0;
+};
+
+#endif /* GREEKRENDERER_HPP_ */
@@ -0,0 +1,97 @@
+#include "GreekSet.hpp"
+#include <iostream>
+#include <sstream>
+
+const char *const GreekNames[NumGreekKinds] = {"Delta", "Gamma", "Vega", "Theta", "Rho", "Vanna", "Volga", "Charm", "Speed", "Color", "Zomma"};
+const char *const OptionNames[NumOptionKinds] = {"Call", "Put"};
+const char *const ModelNames[NumModels] = {"BlackScholes", "Black76", "Bachelier", "AmericanCRR", "AmericanLeisenReimer", "AmericanTrinomial"};
+const char *const PrecisionNames[NumPrecisions] = {"Double", "Float", "Mixed"};
+const char *const GridModeNames[NumGridModes] = {"Uniform", "Adaptive"};
+
+namespace {
+
+std::string Trim(const std::string &s) {
+    const size_t first = s.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return "";
+    return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+}
+
+int ParseList(const std::string &list, const char *const *names, size_t count, const char *what, unsigned &mask) {
+    unsigned parsed = 0;
+    std::stringstream items(list);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        item = Trim(item);
+        size_t k = 0;
+        while (k < count && item != names[k]) ++k;
+        if (k == count) {
+            std::cerr << "Unknown " << what << ": '" << item << "' in '" << list << "'" << std::endl;
+            return -1;
+        }
+        parsed |= 1u << k;
+    }
+    if (parsed == 0) {
+        std::cerr << "No " << what << " in '" << list << "'" << std::endl;
+        return -1;
+    }
+    mask = parsed;
+    return 0;
+}
+
+std::vector<std::string> List(unsigned mask, const char *const *names, size_t count) {
+    std::vector<std::string> list;
+    for (size_t k = 0; k < count; ++k)
+        if (mask & (1u << k)) list.push_back(names[k]);
+    return list;
+}
+
+} // namespace
+
+int ParseGreeks(const std::string &list, unsigned &mask) { return ParseList(list, GreekNames, NumGreekKinds, "Greek", mask); }
+int ParseOptions(const std::string &list, unsigned &mask) { return ParseList(list, OptionNames, NumOptionKinds, "option type", mask); }
+
+int ParseModel(const std::string &name, PricingModel &model) {
+    const std::string trimmed = Trim(name);
+    if (trimmed == "BSM") {
+        model = Model_BlackScholes;
+        return 0;
+    }
+    for (size_t k = 0; k < NumModels; ++k)
+        if (trimmed == ModelNames[k]) {
+            model = static_cast<PricingModel>(k);
+            return 0;
+        }
+    std::cerr << "Unknown pricing model: '" << trimmed << "' (BlackScholes, Black76, Bachelier, AmericanCRR, AmericanLeisenReimer or AmericanTrinomial)" << std::endl;
+    return -1;
+}
+
+int ParsePrecision(const std::string &name, Precision &precision) {
+    const std::string trimmed = Trim(name);
+    for (size_t k = 0; k < NumPrecisions; ++k)
+        if (trimmed == PrecisionNames[k]) {
+            precision = static_cast<Precision>(k);
+            return 0;
+        }
+    std::cerr << "Unknown precision: '" << trimmed << "' (Double, Float or Mixed)" << std::endl;
+    return -1;
+}
+
+int ParseGridMode(const std::string &name, GridMode &grid) {
+    const std::string trimmed = Trim(name);
+    for (size_t k = 0; k < NumGridModes; ++k)
+        if (trimmed == GridModeNames[k]) {
+            grid = static_cast<GridMode>(k);
+            return 0;
+        }
+    std::cerr << "Unknown grid: '" << trimmed << "' (Uniform or Adaptive)" << std::endl;
+    return -1;
+}
+
+std::vector<std::string> GreekList(unsigned mask) { return List(mask, GreekNames, NumGreekKinds); }
+std::vector<std::string> OptionList(unsigned mask) { return List(mask, OptionNames, NumOptionKinds); }
+
+std::string JoinNames(const std::vector<std::string> &names) {
+    std::string joined;
+    for (const auto &name : names) joined += (joined.empty() ? "" : ",") + name;
+    return joined;
+}
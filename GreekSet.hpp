@@ -0,0 +1,109 @@
+#ifndef GREEKSET_HPP_
+#define GREEKSET_HPP_
+
+#include <bitset>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Greeks and option types of a request, as bitmasks parsed once from the parameter file or the command line.
+// The bit order is the slice order of GreekTensor : a Greek is stored at slot SlotOf(mask, flag).
+// The higher order Greeks follow the conventions of the first order ones : Charm is dDelta/dt and Color
+// dGamma/dt (t the calendar time, -d/dT per year), Vanna, Volga and Zomma are per unit sigma
+enum GreekFlag : unsigned {
+    Greek_Delta = 1u << 0,
+    Greek_Gamma = 1u << 1,
+    Greek_Vega  = 1u << 2,
+    Greek_Theta = 1u << 3,
+    Greek_Rho   = 1u << 4,
+    Greek_Vanna = 1u << 5,    // dDelta/dsigma = dVega/dS
+    Greek_Volga = 1u << 6,    // dVega/dsigma
+    Greek_Charm = 1u << 7,    // dDelta/dt
+    Greek_Speed = 1u << 8,    // dGamma/dS
+    Greek_Color = 1u << 9,    // dGamma/dt
+    Greek_Zomma = 1u << 10,   // dGamma/dsigma
+    Greek_FirstOrder  = (1u << 5) - 1,
+    Greek_HigherOrder = ((1u << 11) - 1) & ~Greek_FirstOrder,
+    Greek_All   = (1u << 11) - 1,
+};
+
+enum OptionFlag : unsigned {
+    Option_Call = 1u << 0,
+    Option_Put  = 1u << 1,
+    Option_All  = (1u << 2) - 1,
+};
+
+// Pricing model of the grid and batch kernels.
+//   BlackScholes : S is the spot, q the dividend yield
+//   Black76      : S is the forward (futures price), q is ignored
+//   Bachelier    : S is the forward, sigma the normal volatility in price units per sqrt(year), q is ignored
+//   American...  : American exercise on a recombining tree (Lattice.hpp), S is the spot, q the dividend yield.
+//                  Cox-Ross-Rubinstein and Leisen-Reimer binomial trees, or a trinomial tree
+// The closed form models come first, the lattice models after them
+enum PricingModel : unsigned {
+    Model_BlackScholes = 0,
+    Model_Black76,
+    Model_Bachelier,
+    Model_AmericanCRR,
+    Model_AmericanLeisenReimer,
+    Model_AmericanTrinomial,
+};
+
+// Arithmetic of the grid and batch kernels.
+//   Double : every step in double, the reference
+//   Float  : every step in float, twice the SIMD lanes, float output (GreekTensorF, GreekRowsF)
+//   Mixed  : ln(S / K), d1 and d2 and the Greeks assembled in double, exp, N and N' in float, float output
+// Errors against Double are listed in the README (bounds asserted by the precision test of greeks_tests)
+enum Precision : unsigned {
+    Precision_Double = 0,
+    Precision_Float,
+    Precision_Mixed,
+};
+
+// Axes of the GUI grid (grid.hpp).
+//   Uniform  : S from 0 to 2K in K/100 steps, numMaturities + 1 evenly spaced maturities from 0.01 to T
+//   Adaptive : the same ranges (S from K/100, log(S/K) is -inf at 0) and number of maturities, points placed
+//              where the Greeks bend most, within a budget of grid points
+enum GridMode : unsigned {
+    Grid_Uniform = 0,
+    Grid_Adaptive,
+};
+
+constexpr size_t NumGreekKinds = 11;
+constexpr size_t NumOptionKinds = 2;
+constexpr size_t NumModels = 6;
+constexpr size_t NumClosedFormModels = 3;
+constexpr size_t NumPrecisions = 3;
+constexpr size_t NumGridModes = 2;
+
+extern const char *const GreekNames[NumGreekKinds];     // "Delta", "Gamma", "Vega", "Theta", "Rho", "Vanna", "Volga",
+                                                         // "Charm", "Speed", "Color", "Zomma"
+extern const char *const OptionNames[NumOptionKinds];   // "Call", "Put"
+extern const char *const ModelNames[NumModels];         // "BlackScholes", "Black76", "Bachelier", "AmericanCRR",
+                                                         // "AmericanLeisenReimer", "AmericanTrinomial"
+extern const char *const PrecisionNames[NumPrecisions]; // "Double", "Float", "Mixed"
+extern const char *const GridModeNames[NumGridModes];   // "Uniform", "Adaptive"
+
+inline bool IsLatticeModel(PricingModel model) { return model >= NumClosedFormModels; }
+
+inline size_t CountFlags(unsigned mask) { return std::bitset<32>(mask).count(); }
+// Slot of `flag` among the flags of `mask`, i.e. its slice index in a tensor holding `mask`
+inline size_t SlotOf(unsigned mask, unsigned flag) { return CountFlags(mask & (flag - 1)); }
+
+// Comma separated names, spaces around them ignored, e.g. "Delta, Gamma". Returns 0, -1 on an unknown or
+// missing name (message on std::cerr, `mask` untouched)
+int ParseGreeks(const std::string &list, unsigned &mask);
+int ParseOptions(const std::string &list, unsigned &mask);
+// "BlackScholes" (or "BSM"), "Black76", "Bachelier", "AmericanCRR", "AmericanLeisenReimer" or "AmericanTrinomial"
+int ParseModel(const std::string &name, PricingModel &model);
+// "Double", "Float" or "Mixed"
+int ParsePrecision(const std::string &name, Precision &precision);
+// "Uniform" or "Adaptive"
+int ParseGridMode(const std::string &name, GridMode &grid);
+
+// Names of the flags of a mask, in slot order
+std::vector<std::string> GreekList(unsigned mask);
+std::vector<std::string> OptionList(unsigned mask);
+std::string JoinNames(const std::vector<std::string> &names);   // "Delta,Gamma"
+
+#endif /* GREEKSET_HPP_ */
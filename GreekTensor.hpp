@@ -0,0 +1,124 @@
+#ifndef GREEKTENSOR_HPP_
+#define GREEKTENSOR_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// Strided 1D view, e.g. one T column of a slice read along the stock prices
+template <typename Real>
+struct StridedView {
+    Real *data = nullptr;
+    size_t size = 0;
+    size_t stride = 1;
+
+    Real &operator[](size_t k) const { return data[k * stride]; }
+};
+
+// 2D view of one [greek][option] slice : rows are stock prices, columns are maturities
+template <typename Real>
+struct SliceView {
+    Real *data = nullptr;
+    size_t rows = 0;       // StockPrices.size()
+    size_t cols = 0;       // TimeToMaturities.size()
+    size_t rowStride = 0;  // distance between two stock prices (>= cols, padded)
+
+    Real &operator()(size_t i, size_t j) const { return data[i * rowStride + j]; }
+    Real *Row(size_t i) const { return data + i * rowStride; }
+    StridedView<Real> AlongT(size_t i) const { return {data + i * rowStride, cols, 1}; }   // fixed S, varying T
+    StridedView<Real> AlongS(size_t j) const { return {data + j, rows, rowStride}; }       // fixed T, varying S
+};
+
+// Contiguous, 64-byte aligned storage for the Greek values, laid out as [greek][option][S][T].
+// Every S row is padded to a multiple of a cache line (8 doubles, 16 floats) so rows start on a cache line.
+// Reshape() only reallocates when the new shape does not fit in the current capacity.
+// GreekTensor holds doubles; GreekTensorF, half the memory, holds the output of the float and mixed
+// precision kernels (Precision in GreekSet.hpp)
+template <typename Real>
+class BasicGreekTensor {
+public:
+    static constexpr size_t Alignment = 64;
+    static constexpr size_t RowAlignment = Alignment / sizeof(Real);   // elements per cache line
+
+    BasicGreekTensor() = default;
+    BasicGreekTensor(size_t greeks, size_t options, size_t stocks, size_t maturities) { Reshape(greeks, options, stocks, maturities); }
+    BasicGreekTensor(const BasicGreekTensor &other) { *this = other; }
+    BasicGreekTensor(BasicGreekTensor &&other) noexcept { swap(other); }
+    ~BasicGreekTensor() { Release(); }
+
+    BasicGreekTensor &operator=(const BasicGreekTensor &other) {
+        if (this == &other) return *this;
+        Reshape(other.dims_[0], other.dims_[1], other.dims_[2], other.dims_[3]);
+        std::copy(other.data_, other.data_ + other.Size(), data_);
+        return *this;
+    }
+    BasicGreekTensor &operator=(BasicGreekTensor &&other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    void swap(BasicGreekTensor &other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(dims_, other.dims_);
+        std::swap(strides_, other.strides_);
+    }
+
+    // Set the shape, reusing the current buffer whenever it is large enough.
+    // Values are zeroed when the shape changes and left untouched otherwise.
+    void Reshape(size_t greeks, size_t options, size_t stocks, size_t maturities) {
+        const size_t rowStride = (maturities + RowAlignment - 1) / RowAlignment * RowAlignment;
+        const size_t needed = greeks * options * stocks * rowStride;
+        const bool sameShape = dims_[0] == greeks && dims_[1] == options && dims_[2] == stocks && dims_[3] == maturities;
+        if (needed > capacity_) {
+            Release();
+            data_ = static_cast<Real *>(::operator new(needed * sizeof(Real), std::align_val_t(Alignment)));
+            capacity_ = needed;
+        }
+        dims_[0] = greeks; dims_[1] = options; dims_[2] = stocks; dims_[3] = maturities;
+        strides_[3] = 1;
+        strides_[2] = rowStride;
+        strides_[1] = stocks * rowStride;
+        strides_[0] = options * strides_[1];
+        if (!sameShape) std::fill(data_, data_ + needed, Real(0));
+    }
+
+    Real &operator()(size_t g, size_t o, size_t i, size_t j) { return data_[Offset(g, o, i, j)]; }
+    const Real &operator()(size_t g, size_t o, size_t i, size_t j) const { return data_[Offset(g, o, i, j)]; }
+
+    SliceView<Real> Slice(size_t g, size_t o) { return {data_ + g * strides_[0] + o * strides_[1], dims_[2], dims_[3], strides_[2]}; }
+    SliceView<const Real> Slice(size_t g, size_t o) const { return {data_ + g * strides_[0] + o * strides_[1], dims_[2], dims_[3], strides_[2]}; }
+
+    size_t NumGreeks() const { return dims_[0]; }
+    size_t NumOptions() const { return dims_[1]; }
+    size_t NumStocks() const { return dims_[2]; }
+    size_t NumMaturities() const { return dims_[3]; }
+    size_t Stride(int axis) const { return strides_[axis]; }
+    size_t Size() const { return dims_[0] * strides_[0]; }   // elements in use, padding included
+    size_t Capacity() const { return capacity_; }
+    bool Empty() const { return Size() == 0; }
+    Real *Data() { return data_; }
+    const Real *Data() const { return data_; }
+
+private:
+    size_t Offset(size_t g, size_t o, size_t i, size_t j) const {
+        return g * strides_[0] + o * strides_[1] + i * strides_[2] + j;
+    }
+
+    void Release() {
+        if (data_) ::operator delete(data_, std::align_val_t(Alignment));
+        data_ = nullptr;
+        capacity_ = 0;
+    }
+
+    Real *data_ = nullptr;
+    size_t capacity_ = 0;
+    size_t dims_[4] = {0, 0, 0, 0};     // greeks, options, stocks, maturities
+    size_t strides_[4] = {0, 0, 0, 1};
+};
+
+using GreekTensor = BasicGreekTensor<double>;
+using GreekTensorF = BasicGreekTensor<float>;
+
+#endif /* GREEKTENSOR_HPP_ */
@@ -1,6 +1,14 @@
 #include "Greeks.hpp"
+#include "GreekKernels.hpp"
+#include "Lattice.hpp"
+#include "Profiler.hpp"
+#include "VecMath.hpp"
 #include <cmath>
 #include <random>
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <type_traits>
 
 
 // Normal distribution functions
@@ -9,7 +17,7 @@ double norm_pdf(double mu, double sigma, double x) { // N'
 }
 
 double norm_cdf(double mu, double sigma, double x) { // N
-    return 0.5 * (1 + erf((x-mu) / (sigma * sqrt(2))));
+    return 0.5 * erfc(-(x-mu) / (sigma * sqrt(2)));   // erfc keeps the left tail accurate, 1 + erf cancels there
 }
 
 // d1 and d2 functions
@@ -62,133 +70,322 @@ double Rho(double &K, double &S, double &r, double &q, double &T, double &sigma,
     }
 }
 
-double ComputeGreek(std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities,std::string greekTypes, std::string optionTypes, double &K, double &S, double &r, double &q, double &T, double &sigma, std::vector<std::vector<std::vector<std::vector<double>>>> &GreekValues) {
+// Option price via BSM
+
+double Price(double &K, double &S, double &r, double &q, double &T, double &sigma, bool isCall) {
+    if (isCall) {
+        return S * std::exp(-q * T) * norm_cdf(0.0, 1.0, d1(K, S, r, q, T, sigma))
+               - K * std::exp(-r * T) * norm_cdf(0.0, 1.0, d2(K, S, r, q, T, sigma));
+    } else {
+        return K * std::exp(-r * T) * norm_cdf(0.0, 1.0, -d2(K, S, r, q, T, sigma))
+               - S * std::exp(-q * T) * norm_cdf(0.0, 1.0, -d1(K, S, r, q, T, sigma));
+    }
+}
+
+// Fused kernel - one evaluation of d1, d2, N'(d1), N(d1) and N(d2) per grid point
+
+MaturityFactors ComputeMaturityFactors(double r, double q, double T, double sigma) {
+    MaturityFactors m;
+    m.T = T;
+    m.sqrtT = std::sqrt(T);
+    m.volSqrtT = sigma * m.sqrtT;
+    m.drift = (r - q + 0.5 * sigma * sigma) * T;
+    m.discQ = std::exp(-q * T);
+    m.discR = std::exp(-r * T);
+    return m;
+}
+
+GreekPoint FusedGreeks(double K, double S, double r, double q, double sigma, const MaturityFactors &m) {
+    const double d1v = (std::log(S / K) + m.drift) / m.volSqrtT;
+    const double d2v = d1v - m.volSqrtT;
+    const double pdf = norm_pdf(0.0, 1.0, d1v);
+    const double Nd1 = norm_cdf(0.0, 1.0, d1v);
+    const double Nd2 = norm_cdf(0.0, 1.0, d2v);
+
+    const double SdiscQ = S * m.discQ;   // S * exp(-qT)
+    const double KdiscR = K * m.discR;   // K * exp(-rT)
+    const double SdiscQpdf = SdiscQ * pdf;
+
+    GreekPoint g;
+    g.deltaCall = m.discQ * Nd1;
+    g.deltaPut = g.deltaCall - m.discQ;                                  // N(d1) - 1 = -N(-d1)
+    g.gamma = m.discQ * pdf / (S * m.volSqrtT);
+    g.vega = SdiscQpdf * m.sqrtT;
+    g.thetaCall = -SdiscQpdf * sigma / (2 * m.sqrtT) - r * KdiscR * Nd2 + q * SdiscQ * Nd1;
+    g.thetaPut = g.thetaCall + r * KdiscR - q * SdiscQ;                  // parity : dC/dt - dP/dt
+    g.rhoCall = KdiscR * m.T * Nd2;
+    g.rhoPut = g.rhoCall - KdiscR * m.T;                                 // N(d2) - 1 = -N(-d2)
+
+    const double dd1dT = (r - q) / m.volSqrtT - d2v / (2 * m.T);        // dd1/dT
+    g.vanna = -m.discQ * pdf * d2v / sigma;
+    g.volga = g.vega * d1v * d2v / sigma;
+    g.charmCall = q * m.discQ * Nd1 - m.discQ * pdf * dd1dT;
+    g.charmPut = g.charmCall - q * m.discQ;                              // parity : d(e^-qT)/dt
+    g.speed = -g.gamma / S * (d1v / m.volSqrtT + 1);
+    g.color = g.gamma * (q + d1v * dd1dT + 1 / (2 * m.T));
+    g.zomma = g.gamma * (d1v * d2v - 1) / sigma;
+    g.priceCall = SdiscQ * Nd1 - KdiscR * Nd2;
+    g.pricePut = g.priceCall - SdiscQ + KdiscR;                          // parity
+    return g;
+}
+
+const ModelKernels &KernelsOf(PricingModel model) {
+    switch (model) {
+    case Model_Black76: return Black76Kernels();
+    case Model_Bachelier: return BachelierKernels();
+    default: return BlackScholesKernels();
+    }
+}
+
+namespace {
+
+template <typename Model, typename Real>
+void ComputeColumns(double r, double q, double sigma, BasicMaturityColumns<Real> &c) {
+    for (size_t j = 0; j < c.size(); ++j) {
+        const BasicMaturityFactors<Real> m = Model::Factors(Real(r), Real(q), c.T[j], Real(sigma));
+        c.sqrtT[j] = m.sqrtT;
+        c.volSqrtT[j] = m.volSqrtT;
+        c.drift[j] = m.drift;
+        c.discQ[j] = m.discQ;
+        c.discR[j] = m.discR;
+    }
+}
+
+// Kernel of a Greek set, option set (not empty) and model, picked once per grid. A set with a higher order
+// Greek gets the kernel of all eleven (ModelKernels), which writes every row of its option set
+RowKernel SelectRowKernel(unsigned greeks, unsigned options, PricingModel model) {
+    const ModelKernels &kernels = KernelsOf(model);
+    if (greeks & Greek_HigherOrder) return kernels.allOrders[(options & Option_All) - 1];
+    return kernels.row[(options & Option_All) - 1][greeks & Greek_FirstOrder];
+}
+
+// Checks the masks against the tensor shape, with the message of ComputeGreek
+template <typename Real>
+bool MatchesShape(const std::vector<double> &StockPrices, const std::vector<double> &TimeToMaturities, unsigned greeks, unsigned options,
+                  const BasicGreekTensor<Real> &GreekValues) {
+    if (!greeks || !options || GreekValues.NumGreeks() != CountFlags(greeks) || GreekValues.NumOptions() != CountFlags(options) ||
+        GreekValues.NumStocks() != StockPrices.size() || GreekValues.NumMaturities() != TimeToMaturities.size()) {
+        std::cerr << "ComputeGreek: the tensor does not match the requested Greeks, options and axes." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Tiled sweep of the (S, T) grid behind every ComputeGreek. A kernel specialised for the Greek set only
+// writes the requested rows; with `allRows` it writes all of them and the others go to per-worker scratch rows
+template <typename Real, typename Output>
+double SweepGrid(const std::vector<double> &StockPrices, unsigned greeks, unsigned options, Real K, Real r, Real q, Real sigma,
+                 const BasicMaturityColumns<Real> &factors, BasicRowKernel<Real, Output> kernel, bool allRows,
+                 BasicGreekTensor<Output> &GreekValues, ThreadPool *pool, const std::atomic<bool> *cancel) {
+    // slots in GreekValues, -1 if not requested
+    // order for greek types : Delta, Gamma, Vega, Theta, Rho, Vanna, Volga, Charm, Speed, Color, Zomma
+    // order for option types : Call, Put
+    auto slot = [](unsigned mask, unsigned flag) { return (mask & flag) ? static_cast<int>(SlotOf(mask, flag)) : -1; };
+    const int callIndex = slot(options, Option_Call), putIndex = slot(options, Option_Put);
+    const int deltaIndex = slot(greeks, Greek_Delta), gammaIndex = slot(greeks, Greek_Gamma), vegaIndex = slot(greeks, Greek_Vega);
+    const int thetaIndex = slot(greeks, Greek_Theta), rhoIndex = slot(greeks, Greek_Rho);
+    const int vannaIndex = slot(greeks, Greek_Vanna), volgaIndex = slot(greeks, Greek_Volga), charmIndex = slot(greeks, Greek_Charm);
+    const int speedIndex = slot(greeks, Greek_Speed), colorIndex = slot(greeks, Greek_Color), zommaIndex = slot(greeks, Greek_Zomma);
+
+    // Cache sized tiles : up to 512 maturities x enough stock prices for ~16K points (8 output rows stay in L2),
+    // half as many with the 15 rows of the higher order Greeks
+    const size_t nS = StockPrices.size(), nT = factors.size();
+    GREEKS_PROFILE_SCOPE("SweepGrid");
+    GREEKS_PROFILE_COUNT(Counter_Points, nS * nT);
+    const size_t colsPerTile = std::min<size_t>(std::max<size_t>(nT, 1), 512);
+    const size_t pointsPerTile = (greeks & Greek_HigherOrder) ? 8192 : 16384;
+    const size_t rowsPerTile = std::max<size_t>(1, pointsPerTile / colsPerTile);
+    const size_t rowTiles = (nS + rowsPerTile - 1) / rowsPerTile;
+    const size_t colTiles = (nT + colsPerTile - 1) / colsPerTile;
+
+    ThreadPool &threads = pool ? *pool : DefaultThreadPool();
+    std::vector<Output> scratch(allRows ? threads.NumThreads() * 15 * nT : 0);
+
+    // Every grid point is computed by the same code whatever the tile or thread, so results are bitwise
+    // identical for any number of threads
+    threads.ParallelFor(rowTiles * colTiles, [&](size_t tile, size_t worker) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) return;
+        std::optional<ScopedFlushDenormals> flush;   // reduced precision only, the double grid keeps its subnormals
+        if (std::is_same<Output, float>::value) flush.emplace();
+        const size_t i0 = (tile / colTiles) * rowsPerTile, i1 = std::min(nS, i0 + rowsPerTile);
+        const size_t j0 = (tile % colTiles) * colsPerTile, j1 = std::min(nT, j0 + colsPerTile);
+        // row of a requested [greek][option] slice; for the others null (the kernel does not touch them)
+        // or scratch row `spare` of this worker
+        auto row = [&](int g, int o, size_t i, size_t spare) -> Output * {
+            if (g >= 0 && o >= 0) return GreekValues.Slice(g, o).Row(i);
+            return allRows ? scratch.data() + (worker * 15 + spare) * nT : nullptr;
+        };
+        const int sharedIndex = callIndex >= 0 ? callIndex : putIndex;
+        // Greeks shared by calls and puts, in the order of their scratch rows from 2
+        const int sharedGreeks[] = {gammaIndex, vegaIndex, vannaIndex, volgaIndex, speedIndex, colorIndex, zommaIndex};
+        const size_t sharedSpares[] = {2, 3, 8, 9, 12, 13, 14};
+        Output *shared[7];
+
+        for (size_t i = i0; i < i1; ++i) {
+            for (size_t k = 0; k < 7; ++k) shared[k] = row(sharedGreeks[k], sharedIndex, i, sharedSpares[k]);
+            kernel(K, Real(StockPrices[i]), r, q, sigma, j0, j1,
+                   factors.T.data(), factors.sqrtT.data(), factors.volSqrtT.data(), factors.drift.data(), factors.discQ.data(), factors.discR.data(),
+                   row(deltaIndex, callIndex, i, 0), row(deltaIndex, putIndex, i, 1), shared[0], shared[1],
+                   row(thetaIndex, callIndex, i, 4), row(thetaIndex, putIndex, i, 5), row(rhoIndex, callIndex, i, 6), row(rhoIndex, putIndex, i, 7),
+                   shared[2], shared[3], row(charmIndex, callIndex, i, 10), row(charmIndex, putIndex, i, 11), shared[4], shared[5], shared[6]);
+
+            // Gamma, Vega and the higher order Greeks but Charm are the same for calls and puts
+            if (callIndex >= 0 && putIndex >= 0) {
+                for (size_t k = 0; k < 7; ++k)
+                    if (sharedGreeks[k] >= 0) std::copy(shared[k] + j0, shared[k] + j1, GreekValues.Slice(sharedGreeks[k], putIndex).Row(i) + j0);
+            }
+        }
+    });
+
+    if (cancel && cancel->load()) return 1;
+    return 0;
+}
+
+} // namespace
+
+template <typename Real>
+void BasicMaturityColumns<Real>::Compute(double r, double q, const std::vector<double> &TimeToMaturities, double sigma, PricingModel model) {
+    const size_t n = TimeToMaturities.size();
+    T.assign(TimeToMaturities.begin(), TimeToMaturities.end());
+    sqrtT.resize(n); volSqrtT.resize(n); drift.resize(n); discQ.resize(n); discR.resize(n);
+    switch (model) {
+    case Model_Black76: ComputeColumns<Black76Policy<Real>>(r, q, sigma, *this); break;
+    case Model_Bachelier: ComputeColumns<BachelierPolicy<Real>>(r, q, sigma, *this); break;
+    default: ComputeColumns<BlackScholesPolicy<Real>>(r, q, sigma, *this); break;
+    }
+}
+
+template struct BasicMaturityColumns<double>;
+template struct BasicMaturityColumns<float>;
+
+void FusedGreeksRow(double K, double S, double r, double q, double sigma, const MaturityColumns &m, size_t begin, size_t end, const GreekRows &out,
+                    PricingModel model) {
+    SelectRowKernel(out.HigherOrder() ? Greek_All : Greek_FirstOrder, Option_All, model)(K, S, r, q, sigma, begin, end,
+        m.T.data(), m.sqrtT.data(), m.volSqrtT.data(), m.drift.data(), m.discQ.data(), m.discR.data(),
+        out.deltaCall, out.deltaPut, out.gamma, out.vega, out.thetaCall, out.thetaPut, out.rhoCall, out.rhoPut,
+        out.vanna, out.volga, out.charmCall, out.charmPut, out.speed, out.color, out.zomma);
+}
+
+void FusedGreeksBatch(const OptionBatch &batch, size_t begin, size_t end, const GreekRows &out, PricingModel model) {
+    if (IsLatticeModel(model)) return LatticeGreeksBatch(batch, begin, end, out, model);
+    KernelsOf(model).batch[out.HigherOrder()](begin, end, batch.K.data(), batch.S.data(), batch.T.data(), batch.sigma.data(), batch.r.data(), batch.q.data(),
+        out.deltaCall, out.deltaPut, out.gamma, out.vega, out.thetaCall, out.thetaPut, out.rhoCall, out.rhoPut,
+        out.vanna, out.volga, out.charmCall, out.charmPut, out.speed, out.color, out.zomma);
+}
+
+void FusedGreeksBatch(const OptionBatch &batch, size_t begin, size_t end, const GreekRowsF &out, Precision precision, PricingModel model) {
+    if (IsLatticeModel(model)) {
+        // the trees run in double on a copy of the options, rounded into the float rows
+        const size_t n = end - begin, numRows = out.HigherOrder() ? 15 : 8;
+        OptionBatch options;
+        for (size_t k = begin; k < end; ++k)
+            options.push_back(batch.K[k], batch.S[k], batch.T[k], batch.sigma[k], batch.r[k], batch.q[k], batch.isCall[k] != 0);
+        std::vector<double> values(numRows * n);
+        double *v = values.data();   // row r of option k at v[r * n + k - begin]
+        GreekRows rows{v, v + n, v + 2 * n, v + 3 * n, v + 4 * n, v + 5 * n, v + 6 * n, v + 7 * n};
+        if (out.HigherOrder()) {
+            rows.vanna = v + 8 * n; rows.volga = v + 9 * n; rows.charmCall = v + 10 * n; rows.charmPut = v + 11 * n;
+            rows.speed = v + 12 * n; rows.color = v + 13 * n; rows.zomma = v + 14 * n;
+        }
+        LatticeGreeksBatch(options, 0, n, rows, model);
+        float *const targets[15] = {out.deltaCall, out.deltaPut, out.gamma, out.vega, out.thetaCall, out.thetaPut, out.rhoCall, out.rhoPut,
+                                    out.vanna, out.volga, out.charmCall, out.charmPut, out.speed, out.color, out.zomma};
+        for (size_t r = 0; r < numRows; ++r)
+            for (size_t k = begin; k < end; ++k) targets[r][k] = float(v[r * n + k - begin]);
+        return;
+    }
+    const ModelKernels &kernels = KernelsOf(model);
+    const ScopedFlushDenormals flush;
+    (precision == Precision_Float ? kernels.batchFloat : kernels.batchMixed)[out.HigherOrder()](begin, end,
+        batch.K.data(), batch.S.data(), batch.T.data(), batch.sigma.data(), batch.r.data(), batch.q.data(),
+        out.deltaCall, out.deltaPut, out.gamma, out.vega, out.thetaCall, out.thetaPut, out.rhoCall, out.rhoPut,
+        out.vanna, out.volga, out.charmCall, out.charmPut, out.speed, out.color, out.zomma);
+}
+
+void ComputeBatch(const OptionBatch &batch, const GreekRows &out, ThreadPool *pool, PricingModel model) {
+    const size_t n = batch.size();
+    // options per task, 8 output rows of a block stay in L2; an option of a lattice model costs a few trees
+    const size_t block = IsLatticeModel(model) ? 16 : 4096;
+    ThreadPool &threads = pool ? *pool : DefaultThreadPool();
+    threads.ParallelFor((n + block - 1) / block, [&](size_t task, size_t) {
+        FusedGreeksBatch(batch, task * block, std::min(n, (task + 1) * block), out, model);
+    });
+}
+
+void ComputeBatch(const OptionBatch &batch, const GreekRowsF &out, Precision precision, ThreadPool *pool, PricingModel model) {
+    const size_t n = batch.size();
+    const size_t block = IsLatticeModel(model) ? 16 : 4096;
+    ThreadPool &threads = pool ? *pool : DefaultThreadPool();
+    threads.ParallelFor((n + block - 1) / block, [&](size_t task, size_t) {
+        FusedGreeksBatch(batch, task * block, std::min(n, (task + 1) * block), out, precision, model);
+    });
+}
+
+double ComputeGreek(std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities, unsigned greeks, unsigned options, PricingModel model, double &K, double &S, double &r, double &q, double &T, double &sigma, GreekTensor &GreekValues, ThreadPool *pool, const std::atomic<bool> *cancel) {
     /*
     Input :
-    greekTypes : string containing the types of Greeks to compute (e.g., "Delta,Gamma,Vega")
-    optionTypes : string containing the types of options to compute (e.g., "Call,Put")
+    greeks : Greeks to compute, a mask of GreekFlag (e.g., Greek_Delta | Greek_Gamma)
+    options : option types to compute, a mask of OptionFlag
+    model : pricing model (GreekSet.hpp)
     K : Strike price
     S : Stock price
     r : Risk-free interest rate
     q : Dividend yield
     T : Time to maturity
     sigma : Volatility
-    GreekValues : 4D vector to store computed Greek values [Number of Greeks][Number of Options][StockPrices.size()][TimeToMaturities.size()]
+    GreekValues : tensor to store computed Greek values [CountFlags(greeks)][CountFlags(options)][StockPrices.size()][TimeToMaturities.size()]
+    pool : threads sharing the grid tiles, nullptr for DefaultThreadPool()
+    cancel : optional flag, remaining tiles are skipped once it is set
 
-    Output : Filled in GreekValues matrix 
+    Output : Filled in GreekValues matrix, returns 0 (1 if cancelled, GreekValues is then partially filled,
+    -1 if the masks are empty or do not match the shape of GreekValues)
+
+    All requested Greeks are computed in a single pass over the (S, T) grid : the maturity dependent
+    factors are computed once per T column, and d1, d2, N'(d1), N(d1), N(d2) once per grid point,
+    several maturities at a time. The higher order Greeks (Vanna ... Zomma) are assembled from the same
+    intermediates. The row kernel is specialised for the Greek set, option set and model, and picked
+    once per call (a set with higher order Greeks shares the kernel of all eleven).
+    The lattice models price every point on trees of their own instead (LatticeGreekGrid, Lattice.hpp).
     */
-   using namespace std;
+    greeks &= Greek_All;
+    options &= Option_All;
+    if (!MatchesShape(StockPrices, TimeToMaturities, greeks, options, GreekValues)) return -1;
+    if (IsLatticeModel(model)) return LatticeGreekGrid(StockPrices, TimeToMaturities, greeks, options, model, K, r, q, sigma, GreekValues, pool, cancel);
 
-    // check if we need to compute call and/or put
-    bool computeCall = (optionTypes.find("Call") != std::string::npos);
-    bool computePut = (optionTypes.find("Put") != std::string::npos);
-    
+    // Maturity dependent factors, once per T column
+    MaturityColumns factors;
+    factors.Compute(r, q, TimeToMaturities, sigma, model);
+    return SweepGrid<double, double>(StockPrices, greeks, options, K, r, q, sigma, factors, SelectRowKernel(greeks, options, model),
+                                     (greeks & Greek_HigherOrder) != 0, GreekValues, pool, cancel);
+}
 
-    // Fill in GreekValues 4D vector
-    // order for greek types : Delta, Gamma, Vega, Theta, Rho
-    // order for option types : Call, Put
-    size_t greekIndex = 0;
-    if (greekTypes.find("Delta") != std::string::npos) {
-        size_t optionIndex = 0;
-        if (computeCall) {
-            // Fill in Call Delta values
-            for (size_t i = 0; i < StockPrices.size(); ++i) {
-                for (size_t j = 0; j < TimeToMaturities.size(); ++j) {
-                    GreekValues[greekIndex][optionIndex][i][j] = Delta(K, StockPrices[i], r, q, TimeToMaturities[j], sigma, true); // true for Call
-                }
-            }
-            optionIndex++;
-        }
-        if (computePut) {
-            // Fill in Put Delta values
-            for (size_t i = 0; i < StockPrices.size(); ++i) {
-                for (size_t j = 0; j < TimeToMaturities.size(); ++j) {
-                    GreekValues[greekIndex][optionIndex][i][j] = Delta(K, StockPrices[i], r, q, TimeToMaturities[j], sigma, false); // false for Put
-                }
-            }
-        }
-        greekIndex++;
-    } if (greekTypes.find("Gamma") != std::string::npos) {
-        size_t optionIndex = 0;
-        if (computeCall) {
-            // Fill in Call Gamma values
-            for (size_t i = 0; i < StockPrices.size(); ++i) {
-                for (size_t j = 0; j < TimeToMaturities.size(); ++j) {
-                    GreekValues[greekIndex][optionIndex][i][j] = Gamma(K, StockPrices[i], r, q, TimeToMaturities[j], sigma, true); // true for Call
-                }
-            }
-            optionIndex++;
-        }
-        if (computePut) {
-            // Fill in Put Gamma values
-            for (size_t i = 0; i < StockPrices.size(); ++i) {
-                for (size_t j = 0; j < TimeToMaturities.size(); ++j) {
-                    GreekValues[greekIndex][optionIndex][i][j] = Gamma(K, StockPrices[i], r, q, TimeToMaturities[j], sigma, false); // false for Put
-                }
-            }
-        }
-        greekIndex++;
-    } if (greekTypes.find("Vega") != std::string::npos) {
-        size_t optionIndex = 0;
-        if (computeCall) {
-            // Fill in Call Vega values
-            for (size_t i = 0; i < StockPrices.size(); ++i) {
-                for (size_t j = 0; j < TimeToMaturities.size(); ++j) {
-                    GreekValues[greekIndex][optionIndex][i][j] = Vega(K, StockPrices[i], r, q, TimeToMaturities[j], sigma, true); // true for Call
-                }
-            }
-            optionIndex++;
-        }
-        if (computePut) {
-            // Fill in Put Vega values
-            for (size_t i = 0; i < StockPrices.size(); ++i) {
-                for (size_t j = 0; j < TimeToMaturities.size(); ++j) {
-                    GreekValues[greekIndex][optionIndex][i][j] = Vega(K, StockPrices[i], r, q, TimeToMaturities[j], sigma, false); // false for Put
-                }
-            }
-        }
-        greekIndex++;
-    } if (greekTypes.find("Theta") != std::string::npos) {
-        size_t optionIndex = 0;
-        if (computeCall) {
-            // Fill in Call Theta values
-            for (size_t i = 0; i < StockPrices.size(); ++i) {
-                for (size_t j = 0; j < TimeToMaturities.size(); ++j) {
-                    GreekValues[greekIndex][optionIndex][i][j] = Theta(K, StockPrices[i], r, q, TimeToMaturities[j], sigma, true); // true for Call
-                }
-            }
-            optionIndex++;
-        }
-        if (computePut) {
-            // Fill in Put Theta values
-            for (size_t i = 0; i < StockPrices.size(); ++i) {
-                for (size_t j = 0; j < TimeToMaturities.size(); ++j) {
-                    GreekValues[greekIndex][optionIndex][i][j] = Theta(K, StockPrices[i], r, q, TimeToMaturities[j], sigma, false); // false for Put
-                }
-            }
-        }
-        greekIndex++;
-    } if (greekTypes.find("Rho") != std::string::npos) {
-        size_t optionIndex = 0;
-        if (computeCall) {
-            // Fill in Call Rho values
-            for (size_t i = 0; i < StockPrices.size(); ++i) {
-                for (size_t j = 0; j < TimeToMaturities.size(); ++j) {
-                    GreekValues[greekIndex][optionIndex][i][j] = Rho(K, StockPrices[i], r, q, TimeToMaturities[j], sigma, true); // true for Call
-                }
-            }
-            optionIndex++;
-        }
-        if (computePut) {
-            // Fill in Put Rho values
-            for (size_t i = 0; i < StockPrices.size(); ++i) {
-                for (size_t j = 0; j < TimeToMaturities.size(); ++j) {
-                    GreekValues[greekIndex][optionIndex][i][j] = Rho(K, StockPrices[i], r, q, TimeToMaturities[j], sigma, false); // false for Put
-                }
-            }
-        }
-        greekIndex++;
+double ComputeGreek(std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities, unsigned greeks, unsigned options, PricingModel model, double &K, double &S, double &r, double &q, double &T, double &sigma, GreekTensorF &GreekValues, Precision precision, ThreadPool *pool, const std::atomic<bool> *cancel) {
+    // Same grid as the double ComputeGreek, at half the memory. Precision_Float runs the whole kernel in
+    // float (float columns, 2x the lanes); Precision_Mixed keeps the double columns, ln(S / K), d1 and d2
+    greeks &= Greek_All;
+    options &= Option_All;
+    if (!MatchesShape(StockPrices, TimeToMaturities, greeks, options, GreekValues)) return -1;
+    if (IsLatticeModel(model)) {
+        // the trees run in double, rounded into the float tensor
+        GreekTensor values(GreekValues.NumGreeks(), GreekValues.NumOptions(), StockPrices.size(), TimeToMaturities.size());
+        const double status = LatticeGreekGrid(StockPrices, TimeToMaturities, greeks, options, model, K, r, q, sigma, values, pool, cancel);
+        for (size_t g = 0; g < values.NumGreeks(); ++g)
+            for (size_t o = 0; o < values.NumOptions(); ++o)
+                for (size_t i = 0; i < StockPrices.size(); ++i)
+                    std::transform(values.Slice(g, o).Row(i), values.Slice(g, o).Row(i) + TimeToMaturities.size(), GreekValues.Slice(g, o).Row(i),
+                                   [](double x) { return float(x); });
+        return status;
     }
 
-    return 0;
+    const ModelKernels &kernels = KernelsOf(model);
+    const bool allOrders = (greeks & Greek_HigherOrder) != 0;
+    if (precision == Precision_Float) {
+        MaturityColumnsF factors;
+        factors.Compute(r, q, TimeToMaturities, sigma, model);
+        return SweepGrid<float, float>(StockPrices, greeks, options, float(K), float(r), float(q), float(sigma), factors, kernels.rowFloat[allOrders],
+                                       true, GreekValues, pool, cancel);
+    }
+    MaturityColumns factors;
+    factors.Compute(r, q, TimeToMaturities, sigma, model);
+    return SweepGrid<double, float>(StockPrices, greeks, options, K, r, q, sigma, factors, kernels.rowMixed[allOrders], true, GreekValues, pool, cancel);
 }
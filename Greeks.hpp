@@ -1,8 +1,14 @@
 #ifndef GREEKS_HPP_
 #define GREEKS_HPP_
 
+#include <atomic>
 #include <cmath>
 #include <random>
+#include <string>
+#include <vector>
+#include "GreekSet.hpp"
+#include "GreekTensor.hpp"
+#include "ThreadPool.hpp"
 
 // Normal distribution functions
 double norm_pdf(double mu, double sigma, double x);
@@ -20,7 +26,113 @@ double Theta(double &K, double &S, double &r, double &q, double &T, double &sigm
 double Vega(double &K, double &S, double &r, double &q, double &T, double &sigma, bool isCall);
 double Rho(double &K, double &S, double &r, double &q, double &T, double &sigma, bool isCall);
 
+// Option price via BSM
+double Price(double &K, double &S, double &r, double &q, double &T, double &sigma, bool isCall);
 
-double ComputeGreek(std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities,std::string greekTypes, std::string optionTypes, double &K, double &S, double &r, double &q, double &T, double &sigma, std::vector<std::vector<std::vector<std::vector<double>>>> &GreekValues);
+// Fused kernel - every Greek of a grid point from one shared set of intermediates
+
+// Intermediates depending only on the maturity, shared by every stock price of a T column.
+// Templated on the arithmetic for the float kernels (Precision in GreekSet.hpp), MaturityFactors is the double one
+template <typename Real>
+struct BasicMaturityFactors {
+    Real T;         // Time to maturity
+    Real sqrtT;     // sqrt(T)
+    Real volSqrtT;  // sigma * sqrt(T)
+    Real drift;     // (r - q + 0.5 * sigma^2) * T
+    Real discQ;     // exp(-q * T)
+    Real discR;     // exp(-r * T)
+};
+using MaturityFactors = BasicMaturityFactors<double>;
+
+// Call and Put Greeks of a single (S, T) point. Puts are derived from the calls through put-call parity.
+// Of the higher order Greeks only Charm differs between calls and puts
+template <typename Real>
+struct BasicGreekPoint {
+    Real deltaCall, deltaPut;
+    Real gamma;
+    Real vega;
+    Real thetaCall, thetaPut;
+    Real rhoCall, rhoPut;
+    Real vanna;
+    Real volga;
+    Real charmCall, charmPut;
+    Real speed;
+    Real color;
+    Real zomma;
+    Real priceCall, pricePut;   // option values, for the scenario P&L
+};
+using GreekPoint = BasicGreekPoint<double>;
+
+MaturityFactors ComputeMaturityFactors(double r, double q, double T, double sigma);
+GreekPoint FusedGreeks(double K, double S, double r, double q, double sigma, const MaturityFactors &m);
+
+// Vectorised fused kernel - one stock price against every maturity, 2 to 8 maturities per instruction
+
+// MaturityFactors of every T column, stored as arrays so the row kernel can load them lane by lane.
+// For Black76 and Bachelier, discQ is e^-rT (the forward is discounted like the strike) and drift holds the
+// sigma^2 T / 2 of d1 (0 for Bachelier). The float columns feed the Precision_Float kernels
+template <typename Real>
+struct BasicMaturityColumns {
+    std::vector<Real> T, sqrtT, volSqrtT, drift, discQ, discR;
+
+    void Compute(double r, double q, const std::vector<double> &TimeToMaturities, double sigma, PricingModel model = Model_BlackScholes);
+    size_t size() const { return T.size(); }
+};
+using MaturityColumns = BasicMaturityColumns<double>;
+using MaturityColumnsF = BasicMaturityColumns<float>;
+
+// Output rows of the row kernel, one array of TimeToMaturities.size() values per Greek. Arrays must not overlap.
+// The higher order rows are optional : left null, they are not computed. GreekRowsF receives the float and mixed
+// precision kernels
+template <typename Real>
+struct BasicGreekRows {
+    Real *deltaCall, *deltaPut;
+    Real *gamma;
+    Real *vega;
+    Real *thetaCall, *thetaPut;
+    Real *rhoCall, *rhoPut;
+    Real *vanna = nullptr;
+    Real *volga = nullptr;
+    Real *charmCall = nullptr, *charmPut = nullptr;
+    Real *speed = nullptr;
+    Real *color = nullptr;
+    Real *zomma = nullptr;
+
+    bool HigherOrder() const { return vanna != nullptr; }
+};
+using GreekRows = BasicGreekRows<double>;
+using GreekRowsF = BasicGreekRows<float>;
+
+// Same values as FusedGreeks for columns [begin, end), using the vectorised kernels of VecMath.hpp.
+// `m` must have been computed for the same model
+void FusedGreeksRow(double K, double S, double r, double q, double sigma, const MaturityColumns &m, size_t begin, size_t end, const GreekRows &out,
+                    PricingModel model = Model_BlackScholes);
+
+// Independent contracts (an option book), one array per input
+struct OptionBatch {
+    std::vector<double> K, S, T, sigma, r, q;
+    std::vector<unsigned char> isCall;   // 1 for a call, 0 for a put
+
+    size_t size() const { return K.size(); }
+    void clear() { K.clear(); S.clear(); T.clear(); sigma.clear(); r.clear(); q.clear(); isCall.clear(); }
+    void push_back(double k, double s, double t, double vol, double rate, double yield, bool call) {
+        K.push_back(k); S.push_back(s); T.push_back(t); sigma.push_back(vol); r.push_back(rate); q.push_back(yield); isCall.push_back(call);
+    }
+};
+
+// Greeks of options [begin, end) of the batch, out[k] for option k. Puts are the parity values of the call rows.
+// The higher order rows are computed when out.vanna is set, and then must all be
+void FusedGreeksBatch(const OptionBatch &batch, size_t begin, size_t end, const GreekRows &out, PricingModel model = Model_BlackScholes);
+// Whole batch, blocks of options shared between the threads of `pool` (nullptr for DefaultThreadPool())
+void ComputeBatch(const OptionBatch &batch, const GreekRows &out, ThreadPool *pool = nullptr, PricingModel model = Model_BlackScholes);
+// Same at reduced precision, Precision_Float or Precision_Mixed (Precision_Double is computed as Precision_Mixed,
+// the closest to it with a float output)
+void FusedGreeksBatch(const OptionBatch &batch, size_t begin, size_t end, const GreekRowsF &out, Precision precision, PricingModel model = Model_BlackScholes);
+void ComputeBatch(const OptionBatch &batch, const GreekRowsF &out, Precision precision, ThreadPool *pool = nullptr, PricingModel model = Model_BlackScholes);
+
+
+double ComputeGreek(std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities, unsigned greeks, unsigned options, PricingModel model, double &K, double &S, double &r, double &q, double &T, double &sigma, GreekTensor &GreekValues, ThreadPool *pool = nullptr, const std::atomic<bool> *cancel = nullptr);
+// Float tensor, at Precision_Float or Precision_Mixed (Precision_Double as Precision_Mixed)
+double ComputeGreek(std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities, unsigned greeks, unsigned options, PricingModel model, double &K, double &S, double &r, double &q, double &T, double &sigma, GreekTensorF &GreekValues, Precision precision, ThreadPool *pool = nullptr, const std::atomic<bool> *cancel = nullptr);
 
 #endif /* GREEKS_HPP_ */
\ No newline at end of file
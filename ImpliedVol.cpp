@@ -0,0 +1,206 @@
+#include "ImpliedVol.hpp"
+#include "VecMath.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr size_t IvBlock = 256;              // options solved together, the working set stays in L1
+constexpr int IvMaxIterations = 40;          // Householder steps, or bisections when a step leaves the bracket
+constexpr double IvTolerance = 1e-13;        // relative bracket width on sigma sqrt(T) ending the iterations
+constexpr double IvHouseholderStep = 1e-6;   // ... or relative step : the error left after it is ~step^3 (Householder)
+constexpr double IvNewtonStep = 1e-8;        //     or ~step^2 (Newton)
+constexpr double IvResidual = 4e-15;         // ... or relative price residual, the rounding level of the price
+constexpr double IvMinPrice = 1e-280;        // normalised prices below are not resolved by the exp / cdf kernels
+constexpr double IvIntrinsicTolerance = 1e-14;   // time values within this of max(F, K) e^-rT are rounding : vol 0
+constexpr double IvMaxTotalVol = 100.0;      // sigma sqrt(T) at which every normalised price has reached its limit
+constexpr double Sqrt2Pi = 2.50662827463100050242;
+
+// Setup codes, one per option
+enum IvCode { Code_Solve = 0, Code_Bad, Code_Below, Code_Above, Code_Intrinsic, Code_Tiny };
+
+// Undiscounted call price / sqrt(F K) at xs = ln(F/K) <= 0 and total volatility s, with ex = e^(xs/2)
+inline double NormalisedCall(double xs, double ex, double exInv, double s) {
+    const double d1 = xs / s + 0.5 * s;
+    return ex * FastNormCdf(d1) - exInv * FastNormCdf(d1 - s);
+}
+
+struct IvBlockState {
+    alignas(64) double xs[IvBlock];       // -|ln(F/K)|
+    alignas(64) double ex[IvBlock];       // e^(xs/2)
+    alignas(64) double exInv[IvBlock];    // e^(-xs/2)
+    alignas(64) double beta[IvBlock];     // normalised out-of-the-money price
+    alignas(64) double lnBeta[IvBlock];
+    alignas(64) double lower[IvBlock];    // 1 : iterate on ln(price), below the inflection point
+    alignas(64) double s[IvBlock];        // total volatility sigma sqrt(T)
+    alignas(64) double lo[IvBlock], hi[IvBlock];
+    alignas(64) double done[IvBlock];
+    alignas(64) double sqrtT[IvBlock];
+    alignas(64) double code[IvBlock];
+    alignas(64) double theta[IvBlock];    // 1 for a call, -1 for a put (char masks next to double ones block vectorisation)
+};
+
+GREEKS_DISPATCH
+void IvSetup(size_t m, const double *__restrict K, const double *__restrict S, const double *__restrict T,
+             const double *__restrict r, const double *__restrict q, const double *__restrict price, const double *__restrict theta,
+             double *__restrict xsOut, double *__restrict exOut, double *__restrict exInvOut, double *__restrict betaOut,
+             double *__restrict lnBetaOut, double *__restrict lowerOut, double *__restrict sOut, double *__restrict loOut,
+             double *__restrict hiOut, double *__restrict doneOut, double *__restrict sqrtTOut, double *__restrict codeOut) {
+    using vecmath_detail::Select;
+    for (size_t k = 0; k < m; ++k) {
+        const double disc = FastExp(-r[k] * T[k]);
+        const double F = S[k] * FastExp((r[k] - q[k]) * T[k]);
+        const double x = FastLog(F / K[k]);
+        const double xs = -std::fabs(x);
+        const double ex = FastExp(0.5 * xs), exInv = 1.0 / ex;
+
+        // reduce to the out-of-the-money call : beta = b - max(theta (e^(x/2) - e^(-x/2)), 0)
+        const double b = price[k] / (disc * std::sqrt(F * K[k]));
+        const double sinh2 = Select(x > 0, exInv - ex, ex - exInv);
+        const double intrinsic = std::max(theta[k] * sinh2, 0.0);
+        const double beta = b - intrinsic;
+        // a price made of S e^-qT and K e^-rT terms is rounded at the scale of max(F, K) / sqrt(F K) = exInv, so a
+        // time value that small is the intrinsic value : 0 if in the money, only at or below 0 if out of it
+        // (an out-of-the-money price subtracts nothing, tiny ones are solved)
+        const double rounding = IvIntrinsicTolerance * exInv;
+        const double atIntrinsic = Select(intrinsic > 0, rounding, 0.0);   // and down to -rounding, below is Code_Below
+
+        // inflection point of the price in s, Householder converges from there on both sides
+        const double sc = std::sqrt(-2.0 * xs);
+        const double bc = NormalisedCall(xs, ex, exInv, std::max(sc, 1e-300));   // 0 at the money
+        const bool lower = beta < bc;
+        // above the inflection point the price is below its ATM value <= s / sqrt(2 pi), so s >= sqrt(2 pi) beta
+        const double s0 = std::max(sc, Sqrt2Pi * beta);
+        // below it, f <= N(d1) e^(x/2) <= e^(-x^2 / 2s^2) (Chernoff) : the root of the right hand side is a lower
+        // bound, from which the iterations on the concave ln f approach monotonically
+        const double lnBeta = FastLog(beta);
+        const double sl = std::min(-xs / std::sqrt(-2.0 * lnBeta), sc);
+        // closer start : ln f is nearly linear in 1/s^2 with slope <= -x^2 / 2, follow that slope down from sc
+        const double yl = 1.0 / (sc * sc) + 2.0 * (FastLog(bc) - lnBeta) / (xs * xs);
+        const double sg = std::max(sl, 1.0 / std::sqrt(yl));
+
+        // bitwise & and | on the masks : short-circuit operators stop GCC from vectorising the loop
+        const bool bad = !((K[k] > 0) & (S[k] > 0) & (T[k] > 0) & (std::fabs(price[k]) <= std::numeric_limits<double>::max()));
+        double code = Select(beta < IvMinPrice, double(Code_Tiny), double(Code_Solve));
+        code = Select(beta <= atIntrinsic, double(Code_Intrinsic), code);
+        code = Select(beta >= ex, double(Code_Above), code);
+        code = Select(beta < -rounding, double(Code_Below), code);
+        code = Select(bad, double(Code_Bad), code);
+
+        xsOut[k] = xs;
+        exOut[k] = ex;
+        exInvOut[k] = exInv;
+        betaOut[k] = beta;
+        lnBetaOut[k] = lnBeta;
+        lowerOut[k] = Select(lower, 1.0, 0.0);
+        sOut[k] = Select(lower, sg, s0);
+        loOut[k] = Select(lower, sl, s0);
+        hiOut[k] = Select(lower, sc, IvMaxTotalVol);
+        doneOut[k] = Select(code != Code_Solve, 1.0, 0.0);
+        sqrtTOut[k] = std::sqrt(T[k]);
+        codeOut[k] = code;
+    }
+}
+
+// One Householder step on every option of the block not done yet
+GREEKS_DISPATCH
+void IvIterate(size_t m, const double *__restrict xs, const double *__restrict ex, const double *__restrict exInv,
+               const double *__restrict beta, const double *__restrict lnBeta, const double *__restrict lower,
+               double *__restrict s, double *__restrict lo, double *__restrict hi, double *__restrict done) {
+    using vecmath_detail::Select;
+    for (size_t k = 0; k < m; ++k) {
+        const double sk = s[k];
+        const double d1 = xs[k] / sk + 0.5 * sk, d2 = d1 - sk;
+        const double f = ex[k] * FastNormCdf(d1) - exInv[k] * FastNormCdf(d2);
+        const double fp = ex[k] * FastNormPdf(d1);                                   // f'
+        const double r2 = d1 * d2 / sk;                                              // f'' / f'
+        const double r3 = r2 * r2 - 3.0 * xs[k] * xs[k] / (sk * sk * sk * sk) - 0.25; // f''' / f'
+
+        // g = f - beta above the inflection point, ln f - ln beta below; R2 = g'' / g', R3 = g''' / g'
+        const bool onLog = lower[k] != 0;
+        const double q1 = fp / f;
+        const double g = Select(onLog, FastLog(f) - lnBeta[k], f - beta[k]);
+        const double h = Select(onLog, -g / q1, -g / fp);
+        const double R2 = Select(onLog, r2 - q1, r2);
+        const double R3 = Select(onLog, r3 - 3.0 * q1 * r2 + 2.0 * q1 * q1, r3);
+        // Householder correction of the Newton step h, only trusted while it stays a correction
+        const double correction = (1.0 + 0.5 * h * R2) / (1.0 + h * (R2 + h * R3 / 6.0));
+        const bool householder = (std::fabs(h * R2) < 0.5) & (correction > 0.5) & (correction < 2.0);
+        const double step = Select(householder, h * correction, h);
+        const double residual = Select(onLog, std::fabs(g), std::fabs(g) / beta[k]);
+
+        // keep the bracket, bisect when the step leaves it (or is NaN after an underflow)
+        const bool above = f > beta[k];
+        const double newLo = Select(above, lo[k], std::max(lo[k], sk));
+        const double newHi = Select(above, std::min(hi[k], sk), hi[k]);
+        double next = sk + step;
+        const bool inside = (next > newLo) & (next < newHi);
+        next = Select(inside, next, 0.5 * (newLo + newHi));
+        next = Select(residual <= IvResidual, sk, next);
+        const double stepTolerance = Select(householder, IvHouseholderStep, IvNewtonStep);
+        const bool converged = (inside & (std::fabs(step) <= stepTolerance * sk)) | (residual <= IvResidual) | (newHi - newLo <= IvTolerance * sk);
+
+        const bool active = done[k] == 0;
+        s[k] = Select(active, next, sk);
+        lo[k] = Select(active, newLo, lo[k]);
+        hi[k] = Select(active, newHi, hi[k]);
+        done[k] = Select(active & converged, 1.0, done[k]);
+    }
+}
+
+} // namespace
+
+const char *IvStatusName(unsigned char status) {
+    switch (status) {
+        case Iv_Ok: return "Ok";
+        case Iv_BelowIntrinsic: return "BelowIntrinsic";
+        case Iv_AboveMaximum: return "AboveMaximum";
+        case Iv_NoConvergence: return "NoConvergence";
+        case Iv_BadInput: return "BadInput";
+        default: return "Unknown";
+    }
+}
+
+void ImpliedVolBatch(const OptionBatch &batch, const double *prices, size_t begin, size_t end, double *vols, unsigned char *status) {
+    IvBlockState st;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (size_t b0 = begin; b0 < end; b0 += IvBlock) {
+        const size_t m = std::min(IvBlock, end - b0);
+        for (size_t k = 0; k < m; ++k) st.theta[k] = batch.isCall[b0 + k] ? 1.0 : -1.0;
+        IvSetup(m, batch.K.data() + b0, batch.S.data() + b0, batch.T.data() + b0, batch.r.data() + b0, batch.q.data() + b0,
+                prices + b0, st.theta,
+                st.xs, st.ex, st.exInv, st.beta, st.lnBeta, st.lower, st.s, st.lo, st.hi, st.done, st.sqrtT, st.code);
+
+        for (int it = 0; it < IvMaxIterations; ++it) {
+            if (std::all_of(st.done, st.done + m, [](double d) { return d != 0; })) break;
+            IvIterate(m, st.xs, st.ex, st.exInv, st.beta, st.lnBeta, st.lower, st.s, st.lo, st.hi, st.done);
+        }
+
+        for (size_t k = 0; k < m; ++k) {
+            switch (static_cast<int>(st.code[k])) {
+                case Code_Solve:
+                    vols[b0 + k] = st.s[k] / st.sqrtT[k];
+                    status[b0 + k] = st.done[k] != 0 ? Iv_Ok : Iv_NoConvergence;
+                    break;
+                case Code_Intrinsic: vols[b0 + k] = 0.0; status[b0 + k] = Iv_Ok; break;
+                case Code_Tiny: vols[b0 + k] = st.s[k] / st.sqrtT[k]; status[b0 + k] = Iv_NoConvergence; break;
+                case Code_Below: vols[b0 + k] = nan; status[b0 + k] = Iv_BelowIntrinsic; break;
+                case Code_Above: vols[b0 + k] = nan; status[b0 + k] = Iv_AboveMaximum; break;
+                default: vols[b0 + k] = nan; status[b0 + k] = Iv_BadInput; break;
+            }
+        }
+    }
+}
+
+void ComputeImpliedVols(const OptionBatch &batch, const std::vector<double> &prices, std::vector<double> &vols,
+                        std::vector<unsigned char> &status, ThreadPool *pool) {
+    const size_t n = batch.size();
+    vols.resize(n);
+    status.resize(n);
+    const size_t block = 4096;   // options per task
+    ThreadPool &threads = pool ? *pool : DefaultThreadPool();
+    threads.ParallelFor((n + block - 1) / block, [&](size_t task, size_t) {
+        ImpliedVolBatch(batch, prices.data(), task * block, std::min(n, (task + 1) * block), vols.data(), status.data());
+    });
+}
@@ -0,0 +1,37 @@
+#ifndef IMPLIEDVOL_HPP_
+#define IMPLIEDVOL_HPP_
+
+#include <vector>
+#include "Greeks.hpp"
+#include "ThreadPool.hpp"
+
+// Outcome of one implied volatility inversion
+enum IvStatus : unsigned char {
+    Iv_Ok = 0,
+    Iv_BelowIntrinsic,   // price below the intrinsic value e^-rT max(F - K, 0) (call) : no volatility fits
+    Iv_AboveMaximum,     // price at or above S e^-qT (call) or K e^-rT (put) : no volatility fits
+    Iv_NoConvergence,    // iterations exhausted or price too small to resolve (~1e-280 of sqrt(F K)), vol holds an estimate
+    Iv_BadInput,         // K, S or T not positive, or price not finite
+};
+
+const char *IvStatusName(unsigned char status);
+
+// Implied volatility of options [begin, end) of `batch` from prices[k] (batch.sigma is ignored).
+// vols[k] is NaN unless status[k] is Iv_Ok or Iv_NoConvergence. A price within 1e-14 of max(F, K) e^-rT of the
+// intrinsic value (its rounding) gives 0, Iv_BelowIntrinsic is only returned below that.
+//
+// The price is normalised by sqrt(F K) e^-rT and reduced to the out-of-the-money call of the same
+// |ln(F/K)| through put-call parity, so the intrinsic value never has to be resolved by the solver.
+// Householder (3rd order) iterations on the total volatility sigma sqrt(T) then start from the
+// inflection point sqrt(2 |ln(F/K)|) of the price : above it on the price itself, below it on the log
+// of the price, which stays close to linear in the wings. A bracket is kept per option and any step
+// leaving it is replaced by bisection. At most about 6 iterations are needed; the vol is then accurate to
+// the precision the price resolves it (~1e-13 relative near the money, less where the time value is tiny).
+// Options are solved 256 at a time with the vectorised kernels of VecMath.hpp.
+void ImpliedVolBatch(const OptionBatch &batch, const double *prices, size_t begin, size_t end, double *vols, unsigned char *status);
+
+// Whole batch, blocks of options shared between the threads of `pool` (nullptr for DefaultThreadPool())
+void ComputeImpliedVols(const OptionBatch &batch, const std::vector<double> &prices, std::vector<double> &vols,
+                        std::vector<unsigned char> &status, ThreadPool *pool = nullptr);
+
+#endif /* IMPLIEDVOL_HPP_ */
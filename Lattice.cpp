@@ -0,0 +1,283 @@
+#include "Lattice.hpp"
+#include "Profiler.hpp"
+#include "VecMath.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+std::atomic<size_t> g_latticeSteps{DefaultLatticeSteps};
+
+constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+// Bumps of the Greeks that move the tree : large enough to step over the kinks of the price of a fixed number of
+// steps (the nodes move past the strike as sigma, T or S change), small against the curvature of the price
+constexpr double VolBump = 0.01;      // absolute, at most half of sigma
+constexpr double RateBump = 1e-3;
+constexpr double TimeBump = 1.0 / 52; // years, at most half of T
+constexpr double SpotBump = 0.01;     // relative
+
+// One step of backward induction on nodes [0, n] : v[j] <- max(down v[j] + up v[j + 1], exercise at spot ratio[j]),
+// the probabilities discounted. In place : v[j + 1] is read before it is overwritten
+GREEKS_DISPATCH
+void BinomialStep(size_t n, double down, double up, double spot, double sign, double K, const double *__restrict ratio, double *v) {
+    for (size_t j = 0; j <= n; ++j) v[j] = std::max(down * v[j] + up * v[j + 1], sign * (spot * ratio[j] - K));
+}
+
+GREEKS_DISPATCH
+void TrinomialStep(size_t n, double down, double middle, double up, double spot, double sign, double K, const double *__restrict ratio,
+                   double *v) {
+    for (size_t j = 0; j <= n; ++j) v[j] = std::max(down * v[j] + middle * v[j + 1] + up * v[j + 2], sign * (spot * ratio[j] - K));
+}
+
+// Delta and Gamma from three nodes (s0 < s1 < s2)
+void NodeGreeks(const double (&s)[3], const double (&v)[3], double &delta, double &gamma) {
+    delta = (v[2] - v[0]) / (s[2] - s[0]);
+    gamma = ((v[2] - v[1]) / (s[2] - s[1]) - (v[1] - v[0]) / (s[1] - s[0])) / (0.5 * (s[2] - s[0]));
+}
+
+// Peizer-Pratt inversion (method 2) of the normal cdf at z for n steps
+double PeizerPratt(double z, double n) {
+    const double x = z / (n + 1.0 / 3 + 0.1 / (n + 1));
+    return 0.5 + std::copysign(0.5 * std::sqrt(1 - std::exp(-x * x * (n + 1.0 / 6))), z);
+}
+
+void FillNaN(GreekPoint &g) {
+    g.deltaCall = g.deltaPut = g.gamma = g.vega = g.thetaCall = g.thetaPut = g.rhoCall = g.rhoPut = NaN;
+    g.vanna = g.volga = g.charmCall = g.charmPut = g.speed = g.color = g.zomma = g.priceCall = g.pricePut = NaN;
+}
+
+} // namespace
+
+void SetLatticeSteps(size_t steps) { g_latticeSteps.store(std::max<size_t>(steps, 3), std::memory_order_relaxed); }
+size_t LatticeSteps() { return g_latticeSteps.load(std::memory_order_relaxed); }
+
+LatticeEngine::LatticeEngine(PricingModel model, size_t steps) : model_(model), steps_(std::max<size_t>(steps, 3)) {
+    if (model_ == Model_AmericanLeisenReimer) steps_ |= 1;
+    // the trinomial tree has 2 n + 1 nodes at step n, the steps read up to two nodes past the last one; Volga
+    // prices Leisen-Reimer trees of steps_ | 1 steps, which fall back to the trinomial one
+    values_.resize(2 * (steps_ | 1) + 3);
+    ratios_.resize(2 * (steps_ | 1) + 3);
+}
+
+LatticeValue LatticeEngine::Value(double K, double S, double T, double sigma, double r, double q, bool isCall) {
+    return Tree(model_, steps_, K, S, T, sigma, r, q, isCall);
+}
+
+LatticeValue LatticeEngine::Tree(PricingModel model, size_t steps, double K, double S, double T, double sigma, double r, double q, bool isCall) {
+    const double sign = isCall ? 1 : -1;
+    if (!(sigma > 0)) return {NaN, NaN, NaN, NaN};
+    if (!(T > 0) || !(S > 0)) {
+        const double exercise = sign * (S - K);
+        return {std::max(exercise, 0.0), exercise > 0 ? sign : 0.0, 0, 0};
+    }
+    const double n = double(steps), dt = T / n, growth = std::exp((r - q) * dt);
+    double up, down, p;
+    switch (model) {
+    case Model_AmericanTrinomial:
+        return Trinomial(steps, K, S, T, sigma, r, q, isCall);
+    case Model_AmericanLeisenReimer: {
+        const double volSqrtT = sigma * std::sqrt(T);
+        const double d1 = (std::log(S / K) + (r - q + 0.5 * sigma * sigma) * T) / volSqrtT;
+        p = PeizerPratt(d1 - volSqrtT, n);
+        up = growth * PeizerPratt(d1, n) / p;
+        down = (growth - p * up) / (1 - p);
+        break;
+    }
+    default:
+        up = std::exp(sigma * std::sqrt(dt));
+        down = 1 / up;
+        p = (growth - down) / (up - down);
+        break;
+    }
+    // sigma sqrt(dt) below |r - q| dt (CRR) or d1 so far out that N(d2) rounds to 0 or 1 (Leisen-Reimer) : the
+    // growth falls outside [down, up], p leaves (0, 1) and the induction diverges. The trinomial tree narrows
+    // its spacing instead
+    if (!(p > 0 && p < 1 && down > 0 && up > down)) return Trinomial(steps, K, S, T, sigma, r, q, isCall);
+    return Binomial(steps, K, S, T, r, isCall, up, down, p);
+}
+
+LatticeValue LatticeEngine::Binomial(size_t n, double K, double S, double T, double r, bool isCall, double up, double down, double p) {
+    const double dt = T / double(n), disc = std::exp(-r * dt);
+    const double sign = isCall ? 1 : -1;
+    double *v = values_.data(), *ratio = ratios_.data();
+    const double step = up / down;
+    ratio[0] = 1;
+    for (size_t j = 1; j <= n; ++j) ratio[j] = ratio[j - 1] * step;
+
+    // expiry, node j at S u^j d^(n - j)
+    double spot = S * std::pow(down, double(n));
+    for (size_t j = 0; j <= n; ++j) v[j] = std::max(sign * (spot * ratio[j] - K), 0.0);
+    double v1[2] = {}, v2[3] = {};
+    for (size_t i = n; i-- > 0;) {
+        spot /= down;   // S d^i
+        BinomialStep(i, disc * (1 - p), disc * p, spot, sign, K, ratio, v);
+        if (i == 2) std::copy(v, v + 3, v2);
+        if (i == 1) std::copy(v, v + 2, v1);
+    }
+
+    LatticeValue value;
+    value.price = v[0];
+    value.delta = (v1[1] - v1[0]) / (S * (up - down));
+    const double s2[3] = {S * down * down, S * up * down, S * up * up};
+    double delta2;
+    NodeGreeks(s2, v2, delta2, value.gamma);
+    // the middle node of step 2 is S for CRR only : the value at S from the parabola through the three nodes
+    const double at = v2[1] + (S - s2[1]) * (delta2 + 0.5 * (S + s2[1] - s2[0] - s2[2]) * value.gamma);
+    value.theta = (at - v[0]) / (2 * dt);
+    return value;
+}
+
+LatticeValue LatticeEngine::Trinomial(size_t n, double K, double S, double T, double sigma, double r, double q, bool isCall) {
+    const double dt = T / double(n), disc = std::exp(-r * dt);
+    const double sign = isCall ? 1 : -1;
+    const double nu = r - q - 0.5 * sigma * sigma, var = sigma * sigma * dt + nu * nu * dt * dt;
+    // sigma sqrt(3 dt) keeps the middle probability at 2/3; within [sqrt(var), sigma^2 / |nu| + |nu| dt] every
+    // probability stays in [0, 1]
+    const double widest = nu != 0 ? sigma * sigma / std::abs(nu) + std::abs(nu) * dt : std::numeric_limits<double>::infinity();
+    const double dx = std::clamp(sigma * std::sqrt(3 * dt), std::sqrt(var), widest);
+    const double pUp = 0.5 * (var / (dx * dx) + nu * dt / dx), pDown = 0.5 * (var / (dx * dx) - nu * dt / dx);
+    const double pMiddle = 1 - pUp - pDown;
+    const double up = std::exp(dx);
+    double *v = values_.data(), *ratio = ratios_.data();
+    ratio[0] = 1;
+    for (size_t j = 1; j <= 2 * n; ++j) ratio[j] = ratio[j - 1] * up;
+
+    // expiry, node j at S u^(j - n)
+    double spot = S * std::exp(-double(n) * dx);
+    for (size_t j = 0; j <= 2 * n; ++j) v[j] = std::max(sign * (spot * ratio[j] - K), 0.0);
+    double v1[3] = {};
+    for (size_t i = n; i-- > 0;) {
+        spot *= up;   // S u^-i
+        TrinomialStep(2 * i, disc * pDown, disc * pMiddle, disc * pUp, spot, sign, K, ratio, v);
+        if (i == 1) std::copy(v, v + 3, v1);
+    }
+
+    LatticeValue value;
+    value.price = v[0];
+    const double s1[3] = {S / up, S, S * up};
+    NodeGreeks(s1, v1, value.delta, value.gamma);
+    value.theta = (v1[1] - v[0]) / dt;
+    return value;
+}
+
+GreekPoint LatticeEngine::Greeks(double K, double S, double T, double sigma, double r, double q, bool isCall, unsigned greeks) {
+    GreekPoint g;
+    FillNaN(g);
+    const LatticeValue v = Value(K, S, T, sigma, r, q, isCall);
+    double vega = NaN, rho = NaN, vanna = NaN, volga = NaN, charm = NaN, speed = NaN, color = NaN, zomma = NaN;
+    if (greeks & (Greek_Vega | Greek_Vanna | Greek_Volga | Greek_Zomma)) {
+        const double h = std::min(VolBump, 0.5 * sigma);
+        const LatticeValue up = Value(K, S, T, sigma + h, r, q, isCall), down = Value(K, S, T, sigma - h, r, q, isCall);
+        vega = (up.price - down.price) / (2 * h);
+        vanna = (up.delta - down.delta) / (2 * h);
+        zomma = (up.gamma - down.gamma) / (2 * h);
+        if (model_ == Model_AmericanLeisenReimer) {
+            volga = (up.price - 2 * v.price + down.price) / (h * h);
+        } else if (greeks & Greek_Volga) {
+            // the second difference over h^2 turns the odd/even error of CRR and trinomial prices, which moves with
+            // sigma as the nodes cross the strike, into hundreds of times Volga : Leisen-Reimer prices are smooth in sigma
+            const size_t n = steps_ | 1;
+            const LatticeValue at = Tree(Model_AmericanLeisenReimer, n, K, S, T, sigma, r, q, isCall);
+            const LatticeValue above = Tree(Model_AmericanLeisenReimer, n, K, S, T, sigma + h, r, q, isCall);
+            const LatticeValue below = Tree(Model_AmericanLeisenReimer, n, K, S, T, sigma - h, r, q, isCall);
+            volga = (above.price - 2 * at.price + below.price) / (h * h);
+        }
+    }
+    if (greeks & Greek_Rho) {
+        const LatticeValue up = Value(K, S, T, sigma, r + RateBump, q, isCall), down = Value(K, S, T, sigma, r - RateBump, q, isCall);
+        rho = (up.price - down.price) / (2 * RateBump);
+    }
+    if (greeks & (Greek_Charm | Greek_Color)) {
+        // d/dt of calendar time is -d/dT
+        const double h = std::min(TimeBump, 0.5 * T);
+        const LatticeValue longer = Value(K, S, T + h, sigma, r, q, isCall), shorter = Value(K, S, T - h, sigma, r, q, isCall);
+        charm = -(longer.delta - shorter.delta) / (2 * h);
+        color = -(longer.gamma - shorter.gamma) / (2 * h);
+    }
+    if (greeks & Greek_Speed) {
+        const double h = SpotBump * S;
+        const LatticeValue up = Value(K, S + h, T, sigma, r, q, isCall), down = Value(K, S - h, T, sigma, r, q, isCall);
+        speed = (up.gamma - down.gamma) / (2 * h);
+    }
+
+    g.gamma = v.gamma;
+    g.vega = vega;
+    g.vanna = vanna;
+    g.volga = volga;
+    g.speed = speed;
+    g.color = color;
+    g.zomma = zomma;
+    if (isCall) {
+        g.priceCall = v.price;
+        g.deltaCall = v.delta;
+        g.thetaCall = v.theta;
+        g.rhoCall = rho;
+        g.charmCall = charm;
+    } else {
+        g.pricePut = v.price;
+        g.deltaPut = v.delta;
+        g.thetaPut = v.theta;
+        g.rhoPut = rho;
+        g.charmPut = charm;
+    }
+    return g;
+}
+
+double LatticeGreekGrid(const std::vector<double> &StockPrices, const std::vector<double> &TimeToMaturities, unsigned greeks, unsigned options,
+                        PricingModel model, double K, double r, double q, double sigma, GreekTensor &GreekValues, ThreadPool *pool,
+                        const std::atomic<bool> *cancel) {
+    const size_t nS = StockPrices.size(), nT = TimeToMaturities.size();
+    GREEKS_PROFILE_SCOPE("LatticeGrid");
+    GREEKS_PROFILE_COUNT(Counter_Points, nS * nT);
+    ThreadPool &threads = pool ? *pool : DefaultThreadPool();
+    std::vector<LatticeEngine> engines(threads.NumThreads(), LatticeEngine(model, LatticeSteps()));
+
+    // one task per S row; every point is priced by the same code whatever the thread
+    threads.ParallelFor(nS, [&](size_t i, size_t worker) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) return;
+        LatticeEngine &engine = engines[worker];
+        for (unsigned option : {unsigned(Option_Call), unsigned(Option_Put)}) {
+            if (!(options & option)) continue;
+            const size_t o = SlotOf(options, option);
+            const bool call = option == Option_Call;
+            for (size_t j = 0; j < nT; ++j) {
+                const GreekPoint g = engine.Greeks(K, StockPrices[i], TimeToMaturities[j], sigma, r, q, call, greeks);
+                const double values[NumGreekKinds] = {call ? g.deltaCall : g.deltaPut, g.gamma, g.vega, call ? g.thetaCall : g.thetaPut,
+                                                      call ? g.rhoCall : g.rhoPut, g.vanna, g.volga, call ? g.charmCall : g.charmPut,
+                                                      g.speed, g.color, g.zomma};
+                for (size_t k = 0; k < NumGreekKinds; ++k)
+                    if (greeks & (1u << k)) GreekValues.Slice(SlotOf(greeks, 1u << k), o)(i, j) = values[k];
+            }
+        }
+    });
+
+    if (cancel && cancel->load()) return 1;
+    return 0;
+}
+
+void LatticeGreeksBatch(const OptionBatch &batch, size_t begin, size_t end, const GreekRows &out, PricingModel model) {
+    LatticeEngine engine(model, LatticeSteps());
+    const unsigned greeks = out.HigherOrder() ? Greek_All : Greek_FirstOrder;
+    for (size_t k = begin; k < end; ++k) {
+        const GreekPoint g = engine.Greeks(batch.K[k], batch.S[k], batch.T[k], batch.sigma[k], batch.r[k], batch.q[k], batch.isCall[k] != 0, greeks);
+        out.deltaCall[k] = g.deltaCall;
+        out.deltaPut[k] = g.deltaPut;
+        out.gamma[k] = g.gamma;
+        out.vega[k] = g.vega;
+        out.thetaCall[k] = g.thetaCall;
+        out.thetaPut[k] = g.thetaPut;
+        out.rhoCall[k] = g.rhoCall;
+        out.rhoPut[k] = g.rhoPut;
+        if (out.HigherOrder()) {
+            out.vanna[k] = g.vanna;
+            out.volga[k] = g.volga;
+            out.charmCall[k] = g.charmCall;
+            out.charmPut[k] = g.charmPut;
+            out.speed[k] = g.speed;
+            out.color[k] = g.color;
+            out.zomma[k] = g.zomma;
+        }
+    }
+}
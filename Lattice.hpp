@@ -0,0 +1,84 @@
+#ifndef LATTICE_HPP_
+#define LATTICE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "GreekSet.hpp"
+#include "GreekTensor.hpp"
+#include "Greeks.hpp"
+#include "ThreadPool.hpp"
+
+// American options on recombining trees, the lattice models of PricingModel (GreekSet.hpp) :
+//   AmericanCRR          : Cox-Ross-Rubinstein binomial tree, u = e^(sigma sqrt(dt)), d = 1 / u
+//   AmericanLeisenReimer : Leisen-Reimer binomial tree, probabilities from the Peizer-Pratt inversion of d1 and d2,
+//                          nodes centred on the strike at expiry (an odd number of steps, one more if even)
+//   AmericanTrinomial    : trinomial tree in ln(S), spacing sigma sqrt(3 dt) narrowed when a probability would
+//                          turn negative
+// Where a binomial tree cannot branch (sigma sqrt(dt) below |r - q| dt for CRR, an up probability of 0 or 1 for
+// Leisen-Reimer, both at very low vols) the option is priced on the trinomial tree.
+// S is the spot and q the dividend yield, as for BlackScholes. Early exercise is checked at every node.
+//
+// Price, Delta, Gamma and Theta are read off the nodes of the first steps of the tree that prices the option
+// (Delta from the two nodes of step 1, Gamma and Theta from the three of step 2 for the binomial trees, all from
+// step 1 for the trinomial one). Vega, Rho and the higher order Greeks move the tree itself and come from central
+// differences of the price and node Greeks of trees with sigma, r, T or S bumped, built only for the Greeks asked.
+// Volga, a second difference of prices, is taken on Leisen-Reimer trees for every model : the error of CRR and
+// trinomial prices jumps as the nodes cross the strike and would swamp it.
+//
+// Backward induction runs in place over one node buffer sized for the last step, allocated with the engine:
+// pricing allocates nothing, and a step is a single vectorised loop (continuation value against exercise value).
+
+constexpr size_t DefaultLatticeSteps = 201;
+
+// Steps of the trees built by ComputeGreek and ComputeBatch for the lattice models ("TreeSteps" of the
+// parameter file, --steps of greeks_batch), DefaultLatticeSteps until set. Any thread
+void SetLatticeSteps(size_t steps);
+size_t LatticeSteps();
+
+// Price and the Greeks read off the nodes
+struct LatticeValue {
+    double price, delta, gamma, theta;
+};
+
+class LatticeEngine {
+public:
+    // model : a lattice model, any other prices on the CRR tree
+    explicit LatticeEngine(PricingModel model = Model_AmericanCRR, size_t steps = DefaultLatticeSteps);
+
+    // One option. Expired (T <= 0) or at S <= 0 : its exercise value, Delta of the payoff and zero elsewhere;
+    // NaN for sigma <= 0
+    LatticeValue Value(double K, double S, double T, double sigma, double r, double q, bool isCall);
+
+    // Greeks of `greeks` (GreekFlag mask) of one option, in the call or the put fields of the point (price included,
+    // every other field NaN). The point follows the conventions of the closed forms : Theta and Charm per year
+    // of calendar time, Vega, Vanna, Volga and Zomma per unit sigma
+    GreekPoint Greeks(double K, double S, double T, double sigma, double r, double q, bool isCall, unsigned greeks);
+
+    PricingModel Model() const { return model_; }
+    size_t Steps() const { return steps_; }
+
+private:
+    // Value on a tree of `model` with n <= steps_ | 1 steps (odd for Leisen-Reimer)
+    LatticeValue Tree(PricingModel model, size_t n, double K, double S, double T, double sigma, double r, double q, bool isCall);
+    LatticeValue Binomial(size_t n, double K, double S, double T, double r, bool isCall, double up, double down, double p);
+    LatticeValue Trinomial(size_t n, double K, double S, double T, double sigma, double r, double q, bool isCall);
+
+    PricingModel model_;
+    size_t steps_;
+    std::vector<double> values_;   // node values, updated in place from the last step back to the root
+    std::vector<double> ratios_;   // S of node j at a step over S of node 0, u^j d^-j (binomial) or u^j (trinomial)
+};
+
+// ComputeGreek for a lattice model : every (S, T) point of the grid priced on its own trees, LatticeSteps() steps,
+// the S rows shared between the threads of `pool` with one engine per thread. Same contract as ComputeGreek
+double LatticeGreekGrid(const std::vector<double> &StockPrices, const std::vector<double> &TimeToMaturities, unsigned greeks, unsigned options,
+                        PricingModel model, double K, double r, double q, double sigma, GreekTensor &GreekValues, ThreadPool *pool = nullptr,
+                        const std::atomic<bool> *cancel = nullptr);
+
+// FusedGreeksBatch for a lattice model. An American call and put need trees of their own, so only the type of each
+// option is priced : its rows are filled, those of the other type are NaN, and the shared rows (Gamma, Vega, ...)
+// hold the values of that type
+void LatticeGreeksBatch(const OptionBatch &batch, size_t begin, size_t end, const GreekRows &out, PricingModel model);
+
+#endif /* LATTICE_HPP_ */
@@ -0,0 +1,436 @@
+#include "MonteCarlo.hpp"
+#include "Greeks.hpp"
+#include "VecMath.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+const char *const McPayoffNames[NumMcPayoffs] = {"European", "Asian"};
+const char *const McSamplerNames[NumMcSamplers] = {"Philox", "Sobol"};
+
+void Philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+        const uint64_t p0 = uint64_t(0xD2511F53u) * c0, p1 = uint64_t(0xCD9E8D57u) * c2;
+        const uint32_t hi0 = uint32_t(p0 >> 32), lo0 = uint32_t(p0), hi1 = uint32_t(p1 >> 32), lo1 = uint32_t(p1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += 0x9E3779B9u;   // Weyl sequence of the key
+        k1 += 0xBB67AE85u;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+double InverseNormCdf(double p) {
+    static const double a[6] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[5] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[4] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00};
+    const double low = 0.02425;
+    if (p < low || p > 1 - low) {
+        // tails : rational function of sqrt(-2 ln(p)), p taken on the near side
+        const double x = std::sqrt(-2 * std::log(p < low ? p : 1 - p));
+        const double z = (((((c[0] * x + c[1]) * x + c[2]) * x + c[3]) * x + c[4]) * x + c[5]) /
+                         ((((d[0] * x + d[1]) * x + d[2]) * x + d[3]) * x + 1);
+        return p < low ? z : -z;
+    }
+    const double x = p - 0.5, x2 = x * x;
+    return (((((a[0] * x2 + a[1]) * x2 + a[2]) * x2 + a[3]) * x2 + a[4]) * x2 + a[5]) * x /
+           (((((b[0] * x2 + b[1]) * x2 + b[2]) * x2 + b[3]) * x2 + b[4]) * x2 + 1);
+}
+
+namespace {
+
+constexpr size_t BatchSamples = 256;   // samples (antithetic pairs or single paths) of one batch
+constexpr size_t SobolDims = 32;
+constexpr size_t SobolBits = 32;
+
+// Primitive polynomials and initial direction numbers of Sobol dimensions 2 to 32 (Joe and Kuo, 2008) :
+// degree s, coefficients a of x^(s-1) ... x, m_1 ... m_s
+struct SobolPolynomial {
+    unsigned degree, coefficients;
+    unsigned m[7];
+};
+const SobolPolynomial SobolTable[SobolDims - 1] = {
+    {1, 0, {1}}, {2, 1, {1, 3}}, {3, 1, {1, 3, 1}}, {3, 2, {1, 1, 1}}, {4, 1, {1, 1, 3, 3}}, {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}}, {5, 4, {1, 1, 5, 5, 5}}, {5, 7, {1, 1, 7, 11, 19}}, {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}}, {5, 14, {1, 3, 5, 5, 31}}, {6, 1, {1, 3, 3, 9, 7, 49}}, {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}}, {6, 19, {1, 1, 1, 15, 7, 5}}, {6, 22, {1, 3, 1, 15, 13, 25}}, {6, 25, {1, 1, 5, 5, 19, 61}},
+    {7, 1, {1, 3, 7, 11, 23, 15, 103}}, {7, 4, {1, 3, 7, 13, 13, 15, 69}}, {7, 7, {1, 1, 3, 13, 7, 35, 63}},
+    {7, 8, {1, 3, 5, 9, 1, 25, 53}}, {7, 14, {1, 3, 1, 13, 9, 35, 107}}, {7, 19, {1, 3, 1, 5, 27, 61, 31}},
+    {7, 21, {1, 1, 5, 11, 19, 41, 61}}, {7, 28, {1, 3, 5, 3, 3, 13, 69}}, {7, 31, {1, 1, 7, 13, 1, 19, 1}},
+    {7, 32, {1, 3, 7, 5, 13, 19, 59}}, {7, 37, {1, 1, 3, 9, 25, 29, 41}}, {7, 41, {1, 3, 5, 13, 23, 1, 55}},
+    {7, 42, {1, 3, 7, 3, 13, 59, 17}},
+};
+
+// Direction numbers, directions[d * SobolBits + k] for bit k (most significant first) of dimension d
+const std::vector<uint32_t> &SobolDirections() {
+    static const std::vector<uint32_t> directions = [] {
+        std::vector<uint32_t> v(SobolDims * SobolBits);
+        for (size_t k = 0; k < SobolBits; ++k) v[k] = 1u << (31 - k);   // van der Corput
+        for (size_t d = 1; d < SobolDims; ++d) {
+            const SobolPolynomial &p = SobolTable[d - 1];
+            uint32_t *w = &v[d * SobolBits];
+            for (size_t k = 0; k < SobolBits; ++k) {
+                if (k < p.degree) {
+                    w[k] = p.m[k] << (31 - k);
+                    continue;
+                }
+                w[k] = w[k - p.degree] ^ (w[k - p.degree] >> p.degree);
+                for (unsigned j = 1; j < p.degree; ++j)
+                    if ((p.coefficients >> (p.degree - 1 - j)) & 1) w[k] ^= w[k - j];
+            }
+        }
+        return v;
+    }();
+    return directions;
+}
+
+// Uniform in (0, 1) from 32 random bits
+inline double ToUniform(uint32_t bits) { return (double(bits) + 0.5) * 2.3283064365386963e-10; }
+
+// One step of the Brownian bridge : W[target] = left * W[from] + right * W[to] + stdDev * Z
+struct BridgeStep {
+    size_t target, from, to;
+    double left, right, stdDev;
+};
+
+// Brownian bridge over W at t_i = i dt, i = 0 .. steps (W_0 = 0) : W_T first, then midpoints, coarsest first
+std::vector<BridgeStep> BuildBridge(size_t steps, double dt) {
+    std::vector<BridgeStep> bridge;
+    bridge.push_back({steps, 0, 0, 0.0, 0.0, std::sqrt(steps * dt)});
+    std::vector<std::pair<size_t, size_t>> intervals = {{0, steps}};
+    for (size_t k = 0; k < intervals.size(); ++k) {
+        const size_t l = intervals[k].first, r = intervals[k].second;
+        if (r - l < 2) continue;
+        const size_t m = (l + r) / 2;
+        const double tl = l * dt, tm = m * dt, tr = r * dt;
+        bridge.push_back({m, l, r, (tr - tm) / (tr - tl), (tm - tl) / (tr - tl), std::sqrt((tm - tl) * (tr - tm) / (tr - tl))});
+        intervals.push_back({l, m});
+        intervals.push_back({m, r});
+    }
+    return bridge;
+}
+
+// Estimators, each averaged over the samples along with its control (the same estimator of the European option)
+enum Estimator : unsigned {
+    Est_Price, Est_Delta, Est_Vega, Est_Rho, Est_Theta, Est_DeltaLR, Est_GammaLR, Est_VegaLR, Est_RhoLR, NumEstimators
+};
+
+// Means and centred (co)moments of the estimators and their controls, merged with Chan's pairwise formulas
+struct Moments {
+    double n = 0;
+    double meanY[NumEstimators] = {}, meanC[NumEstimators] = {};
+    double yy[NumEstimators] = {}, cc[NumEstimators] = {}, yc[NumEstimators] = {};
+
+    void Merge(const Moments &other) {
+        if (other.n == 0) return;
+        const double total = n + other.n, w = n * other.n / total;
+        for (size_t e = 0; e < NumEstimators; ++e) {
+            const double dy = other.meanY[e] - meanY[e], dc = other.meanC[e] - meanC[e];
+            meanY[e] += dy * other.n / total;
+            meanC[e] += dc * other.n / total;
+            yy[e] += other.yy[e] + dy * dy * w;
+            cc[e] += other.cc[e] + dc * dc * w;
+            yc[e] += other.yc[e] + dy * dc * w;
+        }
+        n = total;
+    }
+};
+
+// Inputs shared by every batch
+struct McSetup {
+    double K, S, r, q, T, sigma;
+    bool isCall;
+    McOptions options;
+    size_t dims;                     // normals per path, one per time step
+    size_t pathsPerSample;           // 2 with antithetics
+    size_t batchesPerReplication;
+    double dt, sqrtDt, mu, lnS, discount;
+    std::vector<BridgeStep> bridge;
+};
+
+// Per worker buffers, rows of BatchSamples * pathsPerSample values
+struct McScratch {
+    std::vector<double> Z, W;                        // dims rows of normals, steps + 1 rows of the Brownian motion
+    std::vector<double> lnS, S;
+    std::vector<double> sum, sumVega, sumRho, sumTheta, scoreVega, scoreRho, z1;   // Asian average, its derivatives, LR scores
+    std::vector<double> dSigmaT, dRateT, dTimeT;                                    // derivatives of S_T
+    std::vector<double> Y, C;                        // per estimator, per path
+    uint32_t sobol[SobolDims], shift[SobolDims];
+};
+
+// Normals of samples [first, first + count) of a replication into rows of Z
+void DrawNormals(const McSetup &m, size_t replication, size_t first, size_t count, McScratch &s) {
+    const size_t paths = count * m.pathsPerSample;
+    const uint32_t key[2] = {uint32_t(m.options.seed), uint32_t(m.options.seed >> 32)};
+    uint32_t words[4];
+    const bool sobol = m.options.sampler == Sampler_Sobol;
+    const size_t sobolDims = sobol ? std::min(m.dims, SobolDims) : 0;
+
+    if (sobol) {
+        // random digital shift of the replication, then the point before `first` (Gray code order)
+        const std::vector<uint32_t> &v = SobolDirections();
+        for (size_t d = 0; d < sobolDims; ++d) {
+            const uint32_t counter[4] = {uint32_t(d), uint32_t(replication), 0, 1};
+            Philox4x32(counter, key, words);
+            s.shift[d] = words[0];
+            const uint64_t gray = first ^ (first >> 1);
+            uint32_t x = 0;
+            for (size_t k = 0; k < SobolBits; ++k)
+                if ((gray >> k) & 1) x ^= v[d * SobolBits + k];
+            s.sobol[d] = x;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t n = first + i;
+        if (sobol && i > 0) {
+            // Gray code step : flip the direction of the lowest zero bit of n - 1
+            const std::vector<uint32_t> &v = SobolDirections();
+            size_t bit = 0;
+            while ((n >> bit & 1) == 0) ++bit;
+            for (size_t d = 0; d < sobolDims; ++d) s.sobol[d] ^= v[d * SobolBits + bit];
+        }
+        for (size_t d = 0; d < sobolDims; ++d) s.Z[d * paths + i] = InverseNormCdf(ToUniform(s.sobol[d] ^ s.shift[d]));
+        for (size_t d = sobolDims; d < m.dims; d += 4) {
+            const uint32_t counter[4] = {uint32_t(n), uint32_t(n >> 32) ^ uint32_t(replication << 16), uint32_t(d / 4), sobol ? 2u : 0u};
+            Philox4x32(counter, key, words);
+            for (size_t w = 0; w < 4 && d + w < m.dims; ++w) s.Z[(d + w) * paths + i] = InverseNormCdf(ToUniform(words[w]));
+        }
+    }
+    if (m.pathsPerSample == 2)
+        for (size_t d = 0; d < m.dims; ++d)
+            for (size_t i = 0; i < count; ++i) s.Z[d * paths + count + i] = -s.Z[d * paths + i];
+}
+
+// Estimators of one payoff for every path : X the underlying of the payoff and its derivatives along the path
+void Payoffs(const McSetup &m, const double *X, const double *dXdSigma, const double *dXdR, const double *dXdT, const McScratch &s,
+             size_t paths, double *out) {
+    const double K = m.K, D = m.discount, S0 = m.S;
+    const double deltaWeight = 1.0 / (S0 * m.sigma * m.sqrtDt);
+    const double gammaScale = 1.0 / (S0 * S0 * m.sigma * m.sigma * m.dt), gammaShift = 1.0 / (S0 * S0 * m.sigma * m.sqrtDt);
+    for (size_t p = 0; p < paths; ++p) {
+        const double x = X[p];
+        const double payoff = m.isCall ? std::max(x - K, 0.0) : std::max(K - x, 0.0);
+        const double slope = m.isCall ? (x > K ? 1.0 : 0.0) : (x < K ? -1.0 : 0.0);
+        const double z = s.z1[p], value = D * payoff;
+        out[Est_Price * paths + p] = value;
+        out[Est_Delta * paths + p] = D * slope * x / S0;
+        out[Est_Vega * paths + p] = D * slope * dXdSigma[p];
+        out[Est_Rho * paths + p] = D * slope * dXdR[p] - m.T * value;
+        out[Est_Theta * paths + p] = m.r * value - D * slope * dXdT[p];
+        out[Est_DeltaLR * paths + p] = value * z * deltaWeight;
+        out[Est_GammaLR * paths + p] = value * ((z * z - 1) * gammaScale - z * gammaShift);
+        out[Est_VegaLR * paths + p] = value * s.scoreVega[p];
+        out[Est_RhoLR * paths + p] = value * s.scoreRho[p] - m.T * value;
+    }
+}
+
+// Moments of one batch : samples [first, first + count) of a replication
+Moments SimulateBatch(const McSetup &m, size_t replication, size_t first, size_t count, McScratch &s) {
+    const size_t paths = count * m.pathsPerSample, steps = m.dims;
+    const bool asian = m.options.payoff == Payoff_Asian;
+    DrawNormals(m, replication, first, count, s);
+
+    // Brownian motion at every step, coarsest points first
+    std::fill(s.W.begin(), s.W.begin() + paths, 0.0);
+    for (size_t k = 0; k < m.bridge.size(); ++k) {
+        const BridgeStep &b = m.bridge[k];
+        double *w = &s.W[b.target * paths];
+        const double *wl = &s.W[b.from * paths], *wr = &s.W[b.to * paths], *z = &s.Z[k * paths];
+        for (size_t p = 0; p < paths; ++p) w[p] = b.left * wl[p] + b.right * wr[p] + b.stdDev * z[p];
+    }
+
+    // stock prices step by step, with the pathwise derivatives of the average and the likelihood ratio scores
+    std::fill(s.sum.begin(), s.sum.begin() + paths, 0.0);
+    std::fill(s.sumVega.begin(), s.sumVega.begin() + paths, 0.0);
+    std::fill(s.sumRho.begin(), s.sumRho.begin() + paths, 0.0);
+    std::fill(s.sumTheta.begin(), s.sumTheta.begin() + paths, 0.0);
+    std::fill(s.scoreVega.begin(), s.scoreVega.begin() + paths, 0.0);
+    std::fill(s.scoreRho.begin(), s.scoreRho.begin() + paths, 0.0);
+    const double invSqrtDt = 1.0 / m.sqrtDt;
+    for (size_t i = 1; i <= steps; ++i) {
+        const double t = i * m.dt;
+        const double *w = &s.W[i * paths], *previous = &s.W[(i - 1) * paths];
+        for (size_t p = 0; p < paths; ++p) s.lnS[p] = m.lnS + m.mu * t + m.sigma * w[p];
+        VecExp(s.lnS.data(), s.S.data(), paths);
+        for (size_t p = 0; p < paths; ++p) {
+            const double z = (w[p] - previous[p]) * invSqrtDt;
+            if (i == 1) s.z1[p] = z;
+            s.scoreVega[p] += (z * z - 1) / m.sigma - z * m.sqrtDt;
+            s.scoreRho[p] += z * m.sqrtDt / m.sigma;
+        }
+        if (asian)
+            for (size_t p = 0; p < paths; ++p) {
+                const double S = s.S[p];
+                s.sum[p] += S;
+                s.sumVega[p] += S * (w[p] - m.sigma * t);
+                s.sumRho[p] += S * t;
+                s.sumTheta[p] += S * (m.mu * t + 0.5 * m.sigma * w[p]) / m.T;
+            }
+    }
+
+    // European option on S_T (the payoff, or the control of an Asian one) : s.S holds the last step
+    const double *wT = &s.W[steps * paths];
+    if (!asian || m.options.controlVariate) {
+        for (size_t p = 0; p < paths; ++p) {
+            s.dSigmaT[p] = s.S[p] * (wT[p] - m.sigma * m.T);
+            s.dRateT[p] = s.S[p] * m.T;
+            s.dTimeT[p] = s.S[p] * (m.mu + 0.5 * m.sigma * wT[p] / m.T);
+        }
+        Payoffs(m, s.S.data(), s.dSigmaT.data(), s.dRateT.data(), s.dTimeT.data(), s, paths, asian ? s.C.data() : s.Y.data());
+    }
+    if (asian) {
+        const double inv = 1.0 / steps;
+        for (size_t p = 0; p < paths; ++p) {
+            s.sum[p] *= inv;
+            s.sumVega[p] *= inv;
+            s.sumRho[p] *= inv;
+            s.sumTheta[p] *= inv;
+        }
+        Payoffs(m, s.sum.data(), s.sumVega.data(), s.sumRho.data(), s.sumTheta.data(), s, paths, s.Y.data());
+    } else if (m.options.controlVariate) {
+        std::copy(s.Y.begin(), s.Y.begin() + NumEstimators * paths, s.C.begin());
+    }
+
+    // samples : the antithetic pairs averaged, then centred moments of the batch
+    Moments batch;
+    batch.n = double(count);
+    const bool control = m.options.controlVariate;
+    for (size_t e = 0; e < NumEstimators; ++e) {
+        const double *y = &s.Y[e * paths], *c = &s.C[e * paths];
+        auto sampleY = [&](size_t i) { return m.pathsPerSample == 2 ? 0.5 * (y[i] + y[i + count]) : y[i]; };
+        auto sampleC = [&](size_t i) { return !control ? 0.0 : m.pathsPerSample == 2 ? 0.5 * (c[i] + c[i + count]) : c[i]; };
+        double my = 0, mc = 0;
+        for (size_t i = 0; i < count; ++i) {
+            my += sampleY(i);
+            mc += sampleC(i);
+        }
+        my /= count;
+        mc /= count;
+        double yy = 0, cc = 0, yc = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const double dy = sampleY(i) - my, dc = sampleC(i) - mc;
+            yy += dy * dy;
+            cc += dc * dc;
+            yc += dy * dc;
+        }
+        batch.meanY[e] = my;
+        batch.meanC[e] = mc;
+        batch.yy[e] = yy;
+        batch.cc[e] = cc;
+        batch.yc[e] = yc;
+    }
+    return batch;
+}
+
+} // namespace
+
+int MonteCarloGreeks(double K, double S, double r, double q, double T, double sigma, bool isCall, const McOptions &options,
+                     McGreeks &out, ThreadPool *pool) {
+    if (!(K > 0) || !(S > 0) || !(T > 0) || !(sigma > 0) || options.paths == 0 || options.steps == 0 || options.payoff >= NumMcPayoffs ||
+        options.sampler >= NumMcSamplers) {
+        std::cerr << "Invalid Monte Carlo inputs: K, S, T, sigma, paths and steps must be positive." << std::endl;
+        return -1;
+    }
+    if (options.sampler == Sampler_Sobol && options.replications < 2) {
+        std::cerr << "Invalid Monte Carlo inputs: Sobol needs at least 2 replications for its standard errors." << std::endl;
+        return -1;
+    }
+
+    McSetup m;
+    m.K = K; m.S = S; m.r = r; m.q = q; m.T = T; m.sigma = sigma;
+    m.isCall = isCall;
+    m.options = options;
+    m.dims = options.steps;
+    m.pathsPerSample = options.antithetic ? 2 : 1;
+    m.dt = T / options.steps;
+    m.sqrtDt = std::sqrt(m.dt);
+    m.mu = r - q - 0.5 * sigma * sigma;
+    m.lnS = std::log(S);
+    m.discount = std::exp(-r * T);
+    m.bridge = BuildBridge(options.steps, m.dt);
+
+    const size_t replications = options.sampler == Sampler_Sobol ? options.replications : 1;
+    const size_t samples = (options.paths + m.pathsPerSample - 1) / m.pathsPerSample;
+    const size_t perReplication = (samples + replications - 1) / replications;
+    m.batchesPerReplication = (perReplication + BatchSamples - 1) / BatchSamples;
+    const size_t numBatches = m.batchesPerReplication * replications;
+
+    ThreadPool &threads = pool ? *pool : DefaultThreadPool();
+    const size_t rows = BatchSamples * m.pathsPerSample;
+    std::vector<McScratch> scratch(threads.NumThreads());
+    for (McScratch &s : scratch) {
+        s.Z.resize(m.dims * rows);
+        s.W.resize((m.dims + 1) * rows);
+        for (std::vector<double> *v : {&s.lnS, &s.S, &s.sum, &s.sumVega, &s.sumRho, &s.sumTheta, &s.scoreVega, &s.scoreRho, &s.z1,
+                                       &s.dSigmaT, &s.dRateT, &s.dTimeT}) v->resize(rows);
+        s.Y.resize(NumEstimators * rows);
+        s.C.resize(NumEstimators * rows);
+    }
+    std::vector<Moments> batches(numBatches);
+    threads.ParallelFor(numBatches, [&](size_t task, size_t worker) {
+        const size_t replication = task / m.batchesPerReplication, b = task % m.batchesPerReplication;
+        batches[task] = SimulateBatch(m, replication, b * BatchSamples, BatchSamples, scratch[worker]);
+    });
+
+    // merged in batch order : the same result for any number of threads
+    std::vector<Moments> perRep(replications);
+    Moments total;
+    for (size_t k = 0; k < numBatches; ++k) perRep[k / m.batchesPerReplication].Merge(batches[k]);
+    for (const Moments &rep : perRep) total.Merge(rep);
+
+    // control means : the analytic Greeks of the European option
+    double known[NumEstimators] = {};
+    if (options.controlVariate) {
+        known[Est_Price] = Price(K, S, r, q, T, sigma, isCall);
+        known[Est_Delta] = known[Est_DeltaLR] = Delta(K, S, r, q, T, sigma, isCall);
+        known[Est_Vega] = known[Est_VegaLR] = Vega(K, S, r, q, T, sigma, isCall);
+        known[Est_Rho] = known[Est_RhoLR] = Rho(K, S, r, q, T, sigma, isCall);
+        known[Est_Theta] = Theta(K, S, r, q, T, sigma, isCall);
+        known[Est_GammaLR] = Gamma(K, S, r, q, T, sigma, isCall);
+    }
+
+    McEstimate estimates[NumEstimators];
+    for (size_t e = 0; e < NumEstimators; ++e) {
+        const double beta = options.controlVariate && total.cc[e] > 0 ? total.yc[e] / total.cc[e] : 0.0;
+        if (replications == 1) {
+            const double var = std::max(total.yy[e] - 2 * beta * total.yc[e] + beta * beta * total.cc[e], 0.0) / std::max(total.n - 1, 1.0);
+            estimates[e].value = total.meanY[e] - beta * (total.meanC[e] - known[e]);
+            estimates[e].stdError = std::sqrt(var / total.n);
+        } else {
+            // one estimate per randomised replication, the error from their spread
+            double mean = 0, m2 = 0;
+            for (size_t k = 0; k < replications; ++k) {
+                const double x = perRep[k].meanY[e] - beta * (perRep[k].meanC[e] - known[e]);
+                const double d = x - mean;
+                mean += d / (k + 1);
+                m2 += d * (x - mean);
+            }
+            estimates[e].value = mean;
+            estimates[e].stdError = std::sqrt(m2 / (replications - 1) / replications);
+        }
+    }
+    out.price = estimates[Est_Price];
+    out.delta = estimates[Est_Delta];
+    out.vega = estimates[Est_Vega];
+    out.rho = estimates[Est_Rho];
+    out.theta = estimates[Est_Theta];
+    out.deltaLR = estimates[Est_DeltaLR];
+    out.gammaLR = estimates[Est_GammaLR];
+    out.vegaLR = estimates[Est_VegaLR];
+    out.rhoLR = estimates[Est_RhoLR];
+    out.paths = numBatches * rows;
+    return 0;
+}
@@ -0,0 +1,78 @@
+#ifndef MONTECARLO_HPP_
+#define MONTECARLO_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include "ThreadPool.hpp"
+
+// Monte Carlo Greeks of options without a closed form, under Black-Scholes dynamics (geometric Brownian motion
+// with drift r - q, the model of the analytic Greeks).
+//
+// Paths are simulated in batches of 256 samples spread over a ThreadPool. Every random number is a function of
+// (seed, replication, sample, dimension) only : a counter-based generator (Philox4x32-10) or a scrambled Sobol
+// sequence, so a run gives the same result, bit for bit, whatever the number of threads, and no state is shared
+// between them. Each batch keeps its paths as one array per time step (structure of arrays) and builds them with a
+// Brownian bridge, so the first (best distributed) Sobol dimensions set the coarse shape of every path.
+//
+// Every Greek is estimated in the same pass, both pathwise (differentiating the payoff along the path : Delta,
+// Vega, Rho, Theta) and by likelihood ratio (weighting the payoff by the derivative of the log density of the
+// path : Delta, Gamma, Vega, Rho). Gamma has no pathwise estimator, the payoff having a kink. Each estimate
+// comes with its standard error.
+
+// Payoff of the simulated option
+enum McPayoff : unsigned {
+    Payoff_European = 0,   // max(S_T - K, 0) for a call
+    Payoff_Asian,          // max(A - K, 0), A the arithmetic mean of S at T/N, 2T/N ... T (N = steps)
+};
+
+// Source of the normal draws
+enum McSampler : unsigned {
+    Sampler_Philox = 0,    // pseudo-random, standard errors from the spread of the samples
+    Sampler_Sobol,         // quasi-random, randomised (digital shift) per replication, standard errors from the
+                           // spread of the replications. Dimensions past the 32 of the table are Philox draws
+};
+
+constexpr size_t NumMcPayoffs = 2;
+constexpr size_t NumMcSamplers = 2;
+extern const char *const McPayoffNames[NumMcPayoffs];     // "European", "Asian"
+extern const char *const McSamplerNames[NumMcSamplers];   // "Philox", "Sobol"
+
+struct McOptions {
+    McPayoff payoff = Payoff_European;
+    McSampler sampler = Sampler_Philox;
+    size_t paths = 1 << 16;         // paths simulated (rounded up to whole batches), antithetic pairs count twice
+    size_t steps = 1;               // time steps, the fixings of an Asian option
+    bool antithetic = true;         // each draw also simulated with its normals negated, the pair is one sample
+    bool controlVariate = false;    // regress every estimator on the same estimator of the European option of the
+                                    // same strike and maturity, whose value is known (Greeks.hpp) : removes most of
+                                    // the variance of an Asian option, all of it for a European one
+    uint64_t seed = 1;
+    size_t replications = 16;       // Sobol : independently randomised copies of the sequence, at least 2
+};
+
+struct McEstimate {
+    double value = 0;
+    double stdError = 0;
+};
+
+// Theta is dV/dt = -dV/dT per year as the analytic Greeks (an Asian option keeps its fixings at iT/N)
+struct McGreeks {
+    McEstimate price;
+    McEstimate delta, vega, rho, theta;            // pathwise
+    McEstimate deltaLR, gammaLR, vegaLR, rhoLR;    // likelihood ratio
+    size_t paths = 0;                              // paths simulated
+};
+
+// Price and Greeks of a call or put by simulation. Returns 0, -1 on invalid inputs (reported on std::cerr).
+// `pool` nullptr uses DefaultThreadPool()
+int MonteCarloGreeks(double K, double S, double r, double q, double T, double sigma, bool isCall, const McOptions &options,
+                     McGreeks &out, ThreadPool *pool = nullptr);
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", 2011) : 4 random words from a
+// 4 word counter and a 2 word key
+void Philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]);
+
+// Inverse of the standard normal cdf for 0 < p < 1 (Acklam's rational approximations, relative error < 1.2e-9)
+double InverseNormCdf(double p);
+
+#endif /* MONTECARLO_HPP_ */
@@ -0,0 +1,181 @@
+#include "Portfolio.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+const char *SkipBlanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    return p;
+}
+
+const char *const NotAPosition = "not underlying,K,S,T,sigma,r,q,Call|Put,quantity";
+
+// Parse "underlying,K,S,T,sigma,r,q,type,quantity". Returns nullptr, or why the line is not a position that can be
+// priced (NotAPosition for a header or any other text, values out of the domain of the Black-Scholes kernels)
+const char *ParsePosition(const std::string &line, std::string &underlying, double (&v)[6], bool &isCall, double &quantity) {
+    const char *p = line.data(), *end = line.data() + line.size();
+    const char *comma = static_cast<const char *>(std::memchr(p, ',', end - p));
+    if (!comma || comma == p) return NotAPosition;
+    underlying.assign(p, comma);
+    p = comma + 1;
+    for (double &x : v) {
+        p = SkipBlanks(p, end);
+        auto res = std::from_chars(p, end, x);
+        if (res.ec != std::errc()) return NotAPosition;
+        p = SkipBlanks(res.ptr, end);
+        if (p == end || *p != ',') return NotAPosition;
+        ++p;
+    }
+    p = SkipBlanks(p, end);
+    const char *type = p;
+    while (p < end && *p != ',' && *p != ' ' && *p != '\t') ++p;
+    if (p - type == 4 && std::strncmp(type, "Call", 4) == 0) isCall = true;
+    else if (p - type == 3 && std::strncmp(type, "Put", 3) == 0) isCall = false;
+    else return NotAPosition;
+    p = SkipBlanks(p, end);
+    if (p == end || *p != ',') return NotAPosition;
+    p = SkipBlanks(p + 1, end);
+    const auto res = std::from_chars(p, end, quantity);
+    if (res.ec != std::errc() || SkipBlanks(res.ptr, end) != end) return NotAPosition;
+    // one expired option or zero vol would turn its bucket and the whole book into NaN
+    const double K = v[0], S = v[1], T = v[2], sigma = v[3];
+    if (!std::all_of(std::begin(v), std::end(v), [](double x) { return std::isfinite(x); }) || !std::isfinite(quantity)) return "value not finite";
+    if (!(T > 0)) return "T <= 0";
+    if (!(sigma > 0)) return "sigma <= 0";
+    if (!(S > 0)) return "S <= 0";
+    if (!(K > 0)) return "K <= 0";
+    return nullptr;
+}
+
+} // namespace
+
+PortfolioAggregator::PortfolioAggregator(std::vector<double> expiryEdges) : edges_(std::move(expiryEdges)) {
+    std::sort(edges_.begin(), edges_.end());
+}
+
+unsigned PortfolioAggregator::BucketOf(const std::string &underlying, double T) {
+    auto it = underlyingIds_.find(underlying);
+    if (it == underlyingIds_.end()) {
+        it = underlyingIds_.emplace(underlying, static_cast<unsigned>(underlyings_.size())).first;
+        underlyings_.push_back(underlying);
+        totals_.resize(underlyings_.size() * (edges_.size() + 1));
+    }
+    const unsigned expiry = static_cast<unsigned>(std::upper_bound(edges_.begin(), edges_.end(), T) - edges_.begin());
+    return it->second * static_cast<unsigned>(edges_.size() + 1) + expiry;
+}
+
+size_t PortfolioAggregator::ReadChunk(std::istream &in, size_t maxPositions, PositionChunk &chunk) {
+    maxPositions = std::max<size_t>(1, (maxPositions + BlockSize - 1) / BlockSize) * BlockSize;
+    chunk.clear();
+    std::string line, underlying;
+    double v[6];
+    bool isCall;
+    double quantity;
+    while (chunk.size() < maxPositions && std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        ++lines_;
+        const char *error = ParsePosition(line, underlying, v, isCall, quantity);
+        if (error) {
+            if (!line.empty() && (lines_ > 1 || error != NotAPosition)) {   // first line may be a header
+                std::cerr << "Skipping line " << lines_ << " (" << error << "): " << line << std::endl;
+                ++skipped_;
+            }
+            continue;
+        }
+        chunk.options.push_back(v[0], v[1], v[2], v[3], v[4], v[5], isCall);
+        chunk.quantity.push_back(quantity);
+        chunk.bucket.push_back(BucketOf(underlying, v[2]));
+    }
+    return chunk.size();
+}
+
+void PortfolioAggregator::Add(const PositionChunk &chunk, ThreadPool *pool) {
+    const size_t n = chunk.size();
+    if (n == 0) return;
+    ThreadPool &threads = pool ? *pool : DefaultThreadPool();
+    const size_t numBlocks = (n + BlockSize - 1) / BlockSize;
+
+    rows_.resize(8 * n);
+    GreekRows rows;
+    double *base = rows_.data();
+    rows.deltaCall = base; rows.deltaPut = base + n; rows.gamma = base + 2 * n; rows.vega = base + 3 * n;
+    rows.thetaCall = base + 4 * n; rows.thetaPut = base + 5 * n; rows.rhoCall = base + 6 * n; rows.rhoPut = base + 7 * n;
+
+    if (blockSums_.size() < numBlocks) blockSums_.resize(numBlocks);
+    workerSums_.resize(threads.NumThreads());
+    workerTouched_.resize(threads.NumThreads());
+    for (auto &sums : workerSums_) sums.resize(totals_.size());
+
+    threads.ParallelFor(numBlocks, [&](size_t block, size_t worker) {
+        const size_t begin = block * BlockSize, end = std::min(n, begin + BlockSize);
+        FusedGreeksBatch(chunk.options, begin, end, rows);
+
+        // block sums, positions added in book order
+        std::vector<NetGreeks> &sums = workerSums_[worker];
+        std::vector<unsigned> &touched = workerTouched_[worker];
+        touched.clear();
+        for (size_t k = begin; k < end; ++k) {
+            NetGreeks &s = sums[chunk.bucket[k]];
+            if (s.positions == 0) touched.push_back(chunk.bucket[k]);
+            const double w = chunk.quantity[k];
+            const bool call = chunk.options.isCall[k];
+            s.delta += w * (call ? rows.deltaCall[k] : rows.deltaPut[k]);
+            s.gamma += w * rows.gamma[k];
+            s.vega += w * rows.vega[k];
+            s.theta += w * (call ? rows.thetaCall[k] : rows.thetaPut[k]);
+            s.rho += w * (call ? rows.rhoCall[k] : rows.rhoPut[k]);
+            ++s.positions;
+        }
+        std::vector<std::pair<unsigned, NetGreeks>> &out = blockSums_[block];
+        out.clear();
+        for (unsigned b : touched) {
+            out.emplace_back(b, sums[b]);
+            sums[b] = NetGreeks();
+        }
+    });
+
+    // fold the blocks in book order
+    for (size_t block = 0; block < numBlocks; ++block)
+        for (const auto &entry : blockSums_[block]) totals_[entry.first] += entry.second;
+}
+
+int PortfolioAggregator::AddFile(const std::string &filename, size_t chunkSize, ThreadPool *pool) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return -1;
+    }
+    PositionChunk chunk;
+    while (ReadChunk(file, chunkSize, chunk) > 0) Add(chunk, pool);
+    return 0;
+}
+
+std::vector<PortfolioAggregator::Bucket> PortfolioAggregator::Buckets() const {
+    std::vector<unsigned> order(underlyings_.size());
+    for (unsigned u = 0; u < order.size(); ++u) order[u] = u;
+    std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b) { return underlyings_[a] < underlyings_[b]; });
+
+    std::vector<Bucket> buckets;
+    const size_t perUnderlying = edges_.size() + 1;
+    for (unsigned u : order) {
+        for (size_t e = 0; e < perUnderlying; ++e) {
+            const NetGreeks &g = totals_[u * perUnderlying + e];
+            if (g.positions == 0) continue;
+            buckets.push_back({underlyings_[u], e == 0 ? 0.0 : edges_[e - 1],
+                               e < edges_.size() ? edges_[e] : std::numeric_limits<double>::infinity(), g});
+        }
+    }
+    return buckets;
+}
+
+NetGreeks PortfolioAggregator::Total() const {
+    NetGreeks total;
+    for (const NetGreeks &g : totals_) total += g;
+    return total;
+}
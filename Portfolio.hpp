@@ -0,0 +1,86 @@
+#ifndef PORTFOLIO_HPP_
+#define PORTFOLIO_HPP_
+
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Greeks.hpp"
+#include "ThreadPool.hpp"
+
+// Position weighted Greeks summed over a set of positions
+struct NetGreeks {
+    double delta = 0, gamma = 0, vega = 0, theta = 0, rho = 0;
+    size_t positions = 0;
+
+    NetGreeks &operator+=(const NetGreeks &other) {
+        delta += other.delta; gamma += other.gamma; vega += other.vega; theta += other.theta; rho += other.rho;
+        positions += other.positions;
+        return *this;
+    }
+};
+
+// Positions read from file, at most one chunk at a time
+struct PositionChunk {
+    OptionBatch options;
+    std::vector<double> quantity;   // signed number of contracts
+    std::vector<unsigned> bucket;   // underlying * number of expiry buckets + expiry bucket
+
+    size_t size() const { return quantity.size(); }
+    void clear() { options.clear(); quantity.clear(); bucket.clear(); }
+};
+
+// Net Greeks of a book per (underlying, expiry) bucket, streamed chunk by chunk.
+//
+// Positions file, one per line (a header line is skipped) :  underlying,K,S,T,sigma,r,q,type,quantity
+// type Call or Put; any other line, or one whose S, K, T or sigma is not positive, is reported on std::cerr and skipped.
+//
+// Memory is bounded by the chunk size and the number of buckets, never by the size of the book.
+// Positions are priced in blocks of BlockSize by the batch kernel, each block is reduced on its own in
+// position order and the block sums are added in book order; as blocks start at multiples of BlockSize
+// in the book, results are bitwise identical for any number of threads and any chunk size.
+class PortfolioAggregator {
+public:
+    static constexpr size_t BlockSize = 4096;
+
+    struct Bucket {
+        std::string underlying;
+        double expiryFrom, expiryTo;   // T in [expiryFrom, expiryTo)
+        NetGreeks greeks;
+    };
+
+    // expiryEdges : increasing bucket edges in years, e.g. {0.25, 1} gives [0, 0.25), [0.25, 1), [1, inf)
+    explicit PortfolioAggregator(std::vector<double> expiryEdges = {1.0 / 12, 0.25, 0.5, 1, 2, 5});
+
+    // Read up to maxPositions positions (rounded up to a multiple of BlockSize). Returns the number read, 0 at the end
+    size_t ReadChunk(std::istream &in, size_t maxPositions, PositionChunk &chunk);
+    // Price a chunk and add it to the buckets
+    void Add(const PositionChunk &chunk, ThreadPool *pool = nullptr);
+    // Stream a whole file through ReadChunk / Add. Returns 0, -1 if the file cannot be opened
+    int AddFile(const std::string &filename, size_t chunkSize = 65536, ThreadPool *pool = nullptr);
+
+    std::vector<Bucket> Buckets() const;   // non-empty buckets, by underlying then expiry
+    NetGreeks Total() const;
+    size_t SkippedLines() const { return skipped_; }
+    // underlying of a chunk bucket : Underlyings()[bucket / NumExpiryBuckets()]
+    const std::vector<std::string> &Underlyings() const { return underlyings_; }
+    size_t NumExpiryBuckets() const { return edges_.size() + 1; }
+
+private:
+    unsigned BucketOf(const std::string &underlying, double T);
+
+    std::vector<double> edges_;
+    std::unordered_map<std::string, unsigned> underlyingIds_;
+    std::vector<std::string> underlyings_;
+    std::vector<NetGreeks> totals_;                 // per bucket
+    size_t skipped_ = 0;
+    size_t lines_ = 0;
+
+    // per chunk buffers, kept between calls
+    std::vector<double> rows_;                      // 8 Greek rows of the chunk
+    std::vector<std::vector<std::pair<unsigned, NetGreeks>>> blockSums_;
+    std::vector<std::vector<NetGreeks>> workerSums_;   // dense per bucket accumulators, one per thread
+    std::vector<std::vector<unsigned>> workerTouched_;
+};
+
+#endif /* PORTFOLIO_HPP_ */
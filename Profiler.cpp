@@ -0,0 +1,192 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+const char *const ProfileCounterNames[NumProfileCounters] = {"points", "allocations", "bytes"};
+
+namespace {
+
+// namespace scope atomics are constant initialised, so operator new may count before main
+std::atomic<uint64_t> g_counters[NumProfileCounters];
+
+void WriteJsonString(std::ostream &out, const std::string &text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+Profiler::Profiler() : frames_(ProfileFrameCapacity), frameBegin_(Now()) {}
+
+uint64_t Profiler::Now() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::Count(ProfileCounter counter, uint64_t n) {
+    g_counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::Total(ProfileCounter counter) {
+    return g_counters[counter].load(std::memory_order_relaxed);
+}
+
+Profiler::ThreadBuffer &Profiler::LocalBuffer() {
+    // the buffer is shared with threads_ so that the events of a finished thread stay exportable
+    thread_local std::shared_ptr<ThreadBuffer> local;
+    if (!local) {
+        local = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(threadsMutex_);
+        local->id = threads_.size() + 1;
+        local->name = "thread " + std::to_string(local->id);
+        threads_.push_back(local);
+    }
+    return *local;
+}
+
+void Profiler::Record(const char *name, uint64_t begin, uint64_t end) {
+    ThreadBuffer &buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events[buffer.written++ & (ProfileEventCapacity - 1)] = {name, begin, end};
+}
+
+void Profiler::NameThread(const std::string &name) {
+    ThreadBuffer &buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+size_t Profiler::ScopeId(const char *name) {
+    for (size_t id = 0; id < scopeKeys_.size(); ++id)
+        if (scopeKeys_[id] == name) return id;
+    // the same literal may have another address in another translation unit
+    for (size_t id = 0; id < scopeNames_.size(); ++id)
+        if (scopeNames_[id] == name) return id;
+    if (scopeNames_.size() == MaxProfileScopes) return MaxProfileScopes;
+    scopeNames_.emplace_back(name);
+    scopeKeys_.push_back(name);
+    return scopeNames_.size() - 1;
+}
+
+void Profiler::EndFrame() {
+    ProfileFrame &frame = frames_[numFrames_ % ProfileFrameCapacity];
+    frame = ProfileFrame();
+    frame.begin = frameBegin_;
+    frame.end = Now();
+    frameBegin_ = frame.end;
+
+    for (size_t c = 0; c < NumProfileCounters; ++c) {
+        uint64_t total = g_counters[c].load(std::memory_order_relaxed);
+        frame.counters[c] = total - countersAtFrame_[c];
+        countersAtFrame_[c] = total;
+    }
+
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex_);
+        threads = threads_;
+    }
+    for (auto &buffer : threads) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        // events overwritten before this frame could collect them are lost to the history
+        if (buffer->written - buffer->collected > ProfileEventCapacity)
+            buffer->collected = buffer->written - ProfileEventCapacity;
+        for (; buffer->collected < buffer->written; ++buffer->collected) {
+            const Event &event = buffer->events[buffer->collected & (ProfileEventCapacity - 1)];
+            size_t id = ScopeId(event.name);
+            if (id < MaxProfileScopes) frame.scopeMs[id] += float(event.end - event.begin) * 1e-6f;
+        }
+    }
+    ++numFrames_;
+}
+
+const ProfileFrame &Profiler::Frame(size_t age) const {
+    return frames_[(numFrames_ - 1 - age) % ProfileFrameCapacity];
+}
+
+int Profiler::WriteChromeTrace(const std::string &filename) const {
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex_);
+        threads = threads_;
+    }
+
+    // copy the retained events under the locks, write them afterwards
+    struct ThreadEvents {
+        std::string name;
+        size_t id;
+        std::vector<Event> events;
+    };
+    std::vector<ThreadEvents> copies;
+    uint64_t origin = UINT64_MAX;
+    for (auto &buffer : threads) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        ThreadEvents copy{buffer->name, buffer->id, {}};
+        uint64_t first = buffer->written > ProfileEventCapacity ? buffer->written - ProfileEventCapacity : 0;
+        copy.events.reserve(size_t(buffer->written - first));
+        for (uint64_t k = first; k < buffer->written; ++k) {
+            const Event &event = buffer->events[k & (ProfileEventCapacity - 1)];
+            copy.events.push_back(event);
+            if (event.begin < origin) origin = event.begin;
+        }
+        copies.push_back(std::move(copy));
+    }
+    size_t numFrames = NumFrames();
+    if (numFrames) origin = std::min(origin, Frame(numFrames - 1).begin);
+    if (origin == UINT64_MAX) origin = 0;
+
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return -1;
+    }
+    // timestamps are microseconds with ns resolution
+    auto micros = [origin](uint64_t ns) { return double(ns - origin) * 1e-3; };
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&]() -> std::ostream & {
+        file << (first ? "" : ",\n");
+        first = false;
+        return file;
+    };
+    for (const ThreadEvents &copy : copies) {
+        separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << copy.id << ",\"args\":{\"name\":";
+        WriteJsonString(file, copy.name);
+        file << "}}";
+        for (const Event &event : copy.events) {
+            separator() << "{\"name\":";
+            WriteJsonString(file, event.name);
+            file << ",\"cat\":\"greeks\",\"ph\":\"X\",\"pid\":1,\"tid\":" << copy.id << ",\"ts\":" << micros(event.begin)
+                 << ",\"dur\":" << double(event.end - event.begin) * 1e-3 << "}";
+        }
+    }
+    for (size_t age = numFrames; age-- > 0;) {
+        const ProfileFrame &frame = Frame(age);
+        separator() << "{\"name\":\"frame_ms\",\"ph\":\"C\",\"pid\":1,\"ts\":" << micros(frame.end)
+                    << ",\"args\":{\"frame_ms\":" << frame.Ms() << "}}";
+        for (size_t c = 0; c < NumProfileCounters; ++c)
+            separator() << "{\"name\":\"" << ProfileCounterNames[c] << "\",\"ph\":\"C\",\"pid\":1,\"ts\":"
+                        << micros(frame.end) << ",\"args\":{\"" << ProfileCounterNames[c]
+                        << "\":" << frame.counters[c] << "}}";
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    if (!file) {
+        std::cerr << "Error writing file: " << filename << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+Profiler &GlobalProfiler() {
+    static Profiler profiler;
+    return profiler;
+}
@@ -0,0 +1,143 @@
+#ifndef PROFILER_HPP_
+#define PROFILER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Hot path instrumentation: scoped timers, counters and a per-frame history.
+//
+// GREEKS_PROFILE_SCOPE("name") times the enclosing block, GREEKS_PROFILE_COUNT(counter, n) adds to a
+// counter and GREEKS_PROFILE_FRAME() closes a frame. With GREEKS_PROFILE=0 (CMake option) the macros
+// expand to nothing; the Profiler itself still builds so that the panel and the export link.
+//
+// Every thread records into its own ring of events, so a scope costs two clock reads and an
+// uncontended lock. EndFrame, called once per frame by the GUI thread, sums the scopes that ended
+// since the previous frame per name (nested scopes count their inclusive time, worker scopes land
+// in the frame they end in) and the counter deltas into a ring of ProfileFrame.
+// Scope names must be string literals: only the pointer is stored.
+
+enum ProfileCounter : unsigned {
+    Counter_Points = 0,     // grid points evaluated by ComputeGreek
+    Counter_Allocations,    // operator new calls (programs linking AllocationHook.cpp)
+    Counter_Bytes,          // bytes requested from operator new
+    NumProfileCounters,
+};
+extern const char *const ProfileCounterNames[NumProfileCounters];
+
+constexpr size_t MaxProfileScopes = 32;     // distinct scope names kept in the frame history
+constexpr size_t ProfileFrameCapacity = 4096;
+constexpr size_t ProfileEventCapacity = 1 << 15;   // per thread, power of two
+
+struct ProfileFrame {
+    uint64_t begin = 0, end = 0;   // ns, Profiler::Now() clock
+    uint64_t counters[NumProfileCounters] = {};   // increments during the frame
+    float scopeMs[MaxProfileScopes] = {};         // inclusive time per scope id
+
+    float Ms() const { return float(end - begin) * 1e-6f; }
+};
+
+class Profiler {
+public:
+    Profiler();
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    static uint64_t Now();   // steady clock in ns
+
+    // Recording can be paused at run time; a paused scope skips the clock reads
+    bool Recording() const { return recording_.load(std::memory_order_relaxed); }
+    void SetRecording(bool on) { recording_.store(on, std::memory_order_relaxed); }
+
+    void Record(const char *name, uint64_t begin, uint64_t end);   // any thread
+    void NameThread(const std::string &name);                     // label of the calling thread in the trace
+    static void Count(ProfileCounter counter, uint64_t n);        // any thread, never allocates
+    static uint64_t Total(ProfileCounter counter);                // sum of every Count() since the start
+    static void CountAllocation(size_t bytes) {
+        Count(Counter_Allocations, 1);
+        Count(Counter_Bytes, bytes);
+    }
+
+    // GUI thread only
+    void EndFrame();
+    size_t NumFrames() const { return numFrames_ < ProfileFrameCapacity ? numFrames_ : ProfileFrameCapacity; }
+    const ProfileFrame &Frame(size_t age) const;   // age 0 = last completed frame, age < NumFrames()
+    size_t NumScopes() const { return scopeNames_.size(); }
+    const char *ScopeName(size_t id) const { return scopeNames_[id].c_str(); }
+
+    // Chrome trace event JSON (chrome://tracing, ui.perfetto.dev): the retained scopes as complete
+    // events per thread and the counters as counter events at every retained frame end
+    int WriteChromeTrace(const std::string &filename) const;
+
+private:
+    struct Event {
+        const char *name;
+        uint64_t begin, end;
+    };
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<Event> events = std::vector<Event>(ProfileEventCapacity);
+        uint64_t written = 0;     // events ever recorded, events[written % capacity] is next
+        uint64_t collected = 0;   // events already summed into a frame
+        std::string name;
+        size_t id = 0;
+    };
+
+    ThreadBuffer &LocalBuffer();
+    size_t ScopeId(const char *name);
+
+    std::atomic<bool> recording_{true};
+
+    mutable std::mutex threadsMutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> threads_;   // kept after the thread exits for the export
+
+    std::vector<ProfileFrame> frames_;
+    size_t numFrames_ = 0;
+    uint64_t frameBegin_ = 0;
+    uint64_t countersAtFrame_[NumProfileCounters] = {};
+    std::vector<std::string> scopeNames_;
+    std::vector<const char *> scopeKeys_;   // literal seen for each id, checked before comparing strings
+};
+
+// Process wide profiler the macros record into
+Profiler &GlobalProfiler();
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char *name)
+        : name_(GlobalProfiler().Recording() ? name : nullptr), begin_(name_ ? Profiler::Now() : 0) {}
+    ~ProfileScope() {
+        if (name_) GlobalProfiler().Record(name_, begin_, Profiler::Now());
+    }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    const char *name_;
+    uint64_t begin_;
+};
+
+#ifndef GREEKS_PROFILE
+#define GREEKS_PROFILE 0
+#endif
+
+#define GREEKS_PROFILE_CONCAT2(a, b) a##b
+#define GREEKS_PROFILE_CONCAT(a, b) GREEKS_PROFILE_CONCAT2(a, b)
+
+#if GREEKS_PROFILE
+#define GREEKS_PROFILE_SCOPE(name) ProfileScope GREEKS_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define GREEKS_PROFILE_COUNT(counter, n) Profiler::Count(counter, n)
+#define GREEKS_PROFILE_THREAD(name) GlobalProfiler().NameThread(name)
+#define GREEKS_PROFILE_FRAME() GlobalProfiler().EndFrame()
+#else
+#define GREEKS_PROFILE_SCOPE(name) ((void)0)
+#define GREEKS_PROFILE_COUNT(counter, n) ((void)0)
+#define GREEKS_PROFILE_THREAD(name) ((void)0)
+#define GREEKS_PROFILE_FRAME() ((void)0)
+#endif
+
+#endif /* PROFILER_HPP_ */
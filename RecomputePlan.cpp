@@ -0,0 +1,128 @@
+#include "RecomputePlan.hpp"
+#include "Greeks.hpp"
+#include "grid.hpp"
+#include "Profiler.hpp"
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+// Copy slice `from` of `source` into slice `to` of `target` for the columns listed in `columns`
+// (source column k goes to target column columns[k])
+void ScatterColumns(const GreekTensor &source, size_t from, GreekTensor &target, size_t to, const std::vector<size_t> &columns) {
+    for (size_t o = 0; o < target.NumOptions(); ++o) {
+        const SliceView<const double> src = source.Slice(from, o);
+        const SliceView<double> dst = target.Slice(to, o);
+        for (size_t i = 0; i < dst.rows; ++i) {
+            const double *srcRow = src.Row(i);
+            double *dstRow = dst.Row(i);
+            for (size_t k = 0; k < columns.size(); ++k) dstRow[columns[k]] = srcRow[k];
+        }
+    }
+}
+
+} // namespace
+
+unsigned ChangedNodes(const RecomputeRequest &previous, const RecomputeRequest &next) {
+    unsigned nodes = 0;
+    if (previous.K != next.K) nodes |= Node_StockAxis | Node_Values;
+    if (previous.r != next.r || previous.q != next.q || previous.sigma != next.sigma || previous.model != next.model) nodes |= Node_Values;
+    if (previous.T != next.T || previous.numMaturities != next.numMaturities) nodes |= Node_MaturityAxis;
+    if (previous.greeks != next.greeks) nodes |= Node_GreekSlices;
+    if (previous.options != next.options) nodes |= Node_OptionSlices;
+    if (previous.grid != next.grid || previous.gridPoints != next.gridPoints) nodes |= Node_StockAxis | Node_MaturityAxis | Node_Values;
+    if (next.grid == Grid_Adaptive && (nodes & ~Node_GreekSlices)) nodes |= Node_StockAxis | Node_MaturityAxis | Node_Values;
+    return nodes;
+}
+
+int IncrementalRecompute(const RecomputeRequest &request, const GreekGrid &previous, GreekGrid &out,
+                         GreekTensor &scratch, const std::atomic<bool> *cancel) {
+    GREEKS_PROFILE_SCOPE("IncrementalRecompute");
+    RecomputeRequest req = request;   // the compute functions take their parameters by reference
+    const unsigned nodes = previous.version ? ChangedNodes(previous.request, req) : ~0u;
+    if (nodes == 0) return 2;
+
+    // no reusable value : full rebuild
+    if (!previous.version || (nodes & (Node_Values | Node_OptionSlices))) {
+        const int status = Recompute(req.K, req.S0, req.r, req.q, req.T, req.sigma, req.numMaturities, req.greeks, req.options, req.model,
+                                     out.StockPrices, out.TimeToMaturities, out.GreekValues, cancel, req.grid, req.gridPoints);
+        if (status == 0) out.pointsComputed = out.StockPrices.size() * out.TimeToMaturities.size() * CountFlags(req.greeks & Greek_All);
+        return status;
+    }
+    if (req.T <= 0.01 || req.numMaturities < 1 || !(req.greeks & Greek_All)) {
+        std::cerr << "Invalid grid: T - 0.01 must be positive, numMaturities at least 1 and a Greek requested." << std::endl;
+        return -1;
+    }
+
+    // axes : the stock axis only depends on K, which did not change
+    out.StockPrices = previous.StockPrices;
+    if (nodes & Node_MaturityAxis) BuildMaturityAxis(req.T, req.numMaturities, out.TimeToMaturities);
+    else out.TimeToMaturities = previous.TimeToMaturities;
+
+    // match the new T columns against the previous axis (both are increasing). k (T - 0.01) / n and 2k (T - 0.01) / 2n
+    // may round apart : columns within a few ulps of T are the same maturity, their values are kept
+    const std::vector<double> &oldT = previous.TimeToMaturities;
+    std::vector<double> &newT = out.TimeToMaturities;
+    const double tolerance = 8 * std::numeric_limits<double>::epsilon() * req.T;
+    std::vector<size_t> keptNew, keptOld, missingColumns;
+    std::vector<double> missingT;
+    for (size_t j = 0, k = 0; j < newT.size(); ++j) {
+        while (k < oldT.size() && oldT[k] < newT[j] - tolerance) ++k;
+        if (k < oldT.size() && std::fabs(oldT[k] - newT[j]) <= tolerance) {
+            keptNew.push_back(j);
+            keptOld.push_back(k);
+        } else {
+            missingColumns.push_back(j);
+            missingT.push_back(newT[j]);
+        }
+    }
+
+    // match the requested greeks against the previous slices
+    const unsigned newGreeks = req.greeks & Greek_All, oldGreeks = previous.request.greeks & Greek_All;
+    const unsigned keptGreeks = newGreeks & oldGreeks, freshGreeks = newGreeks & ~oldGreeks;
+    std::vector<size_t> keptSlots, freshSlots;   // slots in `out` of the kept and fresh greeks, in flag order
+    for (unsigned flag = 1; flag <= Greek_All; flag <<= 1) {
+        if (keptGreeks & flag) keptSlots.push_back(SlotOf(newGreeks, flag));
+        if (freshGreeks & flag) freshSlots.push_back(SlotOf(newGreeks, flag));
+    }
+
+    const size_t nS = out.StockPrices.size(), nT = newT.size();
+    out.GreekValues.Reshape(CountFlags(newGreeks), CountFlags(req.options & Option_All), nS, nT);
+    out.pointsComputed = 0;
+
+    // 1. values already on the previous grid
+    for (unsigned flag = 1, k = 0; flag <= Greek_All; flag <<= 1) {
+        if (!(keptGreeks & flag)) continue;
+        const size_t oldSlot = SlotOf(oldGreeks, flag), newSlot = keptSlots[k++];
+        for (size_t o = 0; o < out.GreekValues.NumOptions(); ++o) {
+            const SliceView<const double> src = previous.GreekValues.Slice(oldSlot, o);
+            const SliceView<double> dst = out.GreekValues.Slice(newSlot, o);
+            for (size_t i = 0; i < nS; ++i)
+                for (size_t c = 0; c < keptNew.size(); ++c) dst(i, keptNew[c]) = src(i, keptOld[c]);
+        }
+    }
+
+    // 2. previous greeks on the new T columns
+    if (keptGreeks && !missingT.empty()) {
+        scratch.Reshape(keptSlots.size(), out.GreekValues.NumOptions(), nS, missingT.size());
+        const double status = ComputeGreek(out.StockPrices, missingT, keptGreeks, req.options, req.model, req.K, req.S0, req.r, req.q, req.T, req.sigma,
+                                           scratch, nullptr, cancel);
+        if (status != 0) return status == 1 ? 1 : -1;
+        for (size_t k = 0; k < keptSlots.size(); ++k) ScatterColumns(scratch, k, out.GreekValues, keptSlots[k], missingColumns);
+        out.pointsComputed += nS * missingT.size() * keptSlots.size();
+    }
+
+    // 3. newly requested greeks on every column
+    if (freshGreeks) {
+        std::vector<size_t> allColumns(nT);
+        for (size_t j = 0; j < nT; ++j) allColumns[j] = j;
+        scratch.Reshape(freshSlots.size(), out.GreekValues.NumOptions(), nS, nT);
+        const double status = ComputeGreek(out.StockPrices, newT, freshGreeks, req.options, req.model, req.K, req.S0, req.r, req.q, req.T, req.sigma,
+                                           scratch, nullptr, cancel);
+        if (status != 0) return status == 1 ? 1 : -1;
+        for (size_t k = 0; k < freshSlots.size(); ++k) ScatterColumns(scratch, k, out.GreekValues, freshSlots[k], allColumns);
+        out.pointsComputed += nS * nT * freshSlots.size();
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+#ifndef RECOMPUTEPLAN_HPP_
+#define RECOMPUTEPLAN_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "GreekSet.hpp"
+#include "GreekTensor.hpp"
+
+// Inputs of one Recompute call, copied so the GUI can keep editing its own values
+struct RecomputeRequest {
+    double K, S0, r, q, T, sigma;
+    int numMaturities;
+    unsigned greeks;       // GreekFlag mask
+    unsigned options;      // OptionFlag mask
+    PricingModel model;
+    GridMode grid = Grid_Uniform;
+    size_t gridPoints = 0;   // adaptive grid budget, 0 for the default
+};
+
+// Everything Recompute produces
+struct GreekGrid {
+    std::vector<double> StockPrices;
+    std::vector<double> TimeToMaturities;
+    GreekTensor GreekValues;
+    RecomputeRequest request{};
+    unsigned long long version = 0;                      // 0 until a first result is published
+    std::chrono::steady_clock::time_point computedAt;
+    size_t pointsComputed = 0;                           // (S, T, greek) points evaluated by the last update
+};
+
+// Dependency graph between the parameters and the parts of a GreekGrid.
+//
+//   K              -> stock axis, values
+//   r, q, sigma    -> values
+//   model          -> values
+//   T              -> maturity axis
+//   numMaturities  -> maturity axis
+//   greeks         -> greek slices
+//   grid, gridPoints -> both axes, values
+//   options        -> option slices (every value)
+//   S0, ITM, OTM   -> nothing, they only change what is displayed
+//
+// A new stock axis invalidates every value. A new maturity axis only invalidates the columns whose
+// T is not on the previous axis, and a new greek set only the greeks that were not computed before.
+// The maturity axis is 0.01 + k (T - 0.01) / numMaturities, so axes of n and m maturities share gcd(n, m) + 1
+// columns : doubling numMaturities reuses every previous column, but a step of one keeps only the two ends and a
+// new T only the first one, close to a full recompute. Columns are never interpolated, every value stays exact.
+// An adaptive grid places its stock prices from every parameter but the greek set, so any other change
+// rebuilds it.
+enum GridNode : unsigned {
+    Node_StockAxis    = 1u << 0,
+    Node_MaturityAxis = 1u << 1,
+    Node_Values       = 1u << 2,
+    Node_GreekSlices  = 1u << 3,
+    Node_OptionSlices = 1u << 4,
+};
+
+// Nodes invalidated by going from `previous` to `next`
+unsigned ChangedNodes(const RecomputeRequest &previous, const RecomputeRequest &next);
+
+// Bring `out` up to date with `request`, reusing whatever `previous` (the last published grid, version > 0)
+// still holds : unchanged axes, T columns present on both axes and greek slices computed before.
+// `out` must not alias `previous`. `scratch` holds the partial results and keeps its capacity between calls.
+// Returns 0, -1 on error, 1 if cancelled, 2 if nothing depends on the change (`out` is left untouched).
+int IncrementalRecompute(const RecomputeRequest &request, const GreekGrid &previous, GreekGrid &out,
+                         GreekTensor &scratch, const std::atomic<bool> *cancel = nullptr);
+
+#endif /* RECOMPUTEPLAN_HPP_ */
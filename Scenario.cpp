@@ -0,0 +1,142 @@
+#include "Scenario.hpp"
+#include "GreekKernels.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+constexpr size_t BlockSize = 1024;   // options per kernel call, the 15 scratch rows of a block stay in L2
+
+enum ScratchRow {
+    Row_Sigma, Row_R, Row_LogSK, Row_SqrtT, Row_VolSqrtT, Row_Drift, Row_DiscQ, Row_DiscR, Row_Call,
+    Row_Value, Row_Delta, Row_Gamma, Row_Vega, Row_Theta, Row_Rho,
+    NumScratchRows,
+};
+
+struct Sums {
+    double pnl = 0, delta = 0, gamma = 0, vega = 0, theta = 0, rho = 0;
+};
+
+// Options [begin, begin + n) under one (vol, rate) shock : factors into the scratch rows
+void BlockFactors(const ModelKernels &kernels, const OptionBatch &o, size_t begin, size_t n, double volShock, double rateShock,
+                  std::vector<double> &scratch) {
+    double *row[NumScratchRows];
+    for (size_t r = 0; r < NumScratchRows; ++r) row[r] = scratch.data() + r * BlockSize;
+    kernels.scenarioFactors(0, n, o.K.data() + begin, o.S.data() + begin, o.T.data() + begin, o.sigma.data() + begin,
+                            o.r.data() + begin, o.q.data() + begin, o.isCall.data() + begin, volShock, rateShock, ScenarioMinVol,
+                            row[Row_Sigma], row[Row_R], row[Row_LogSK], row[Row_SqrtT], row[Row_VolSqrtT], row[Row_Drift],
+                            row[Row_DiscQ], row[Row_DiscR], row[Row_Call]);
+}
+
+// Same options with S scaled by spotFactor : values and Greeks into the scratch rows
+void BlockPoints(const ModelKernels &kernels, const OptionBatch &o, size_t begin, size_t n, double spotFactor, double logSpotFactor,
+                 std::vector<double> &scratch) {
+    double *row[NumScratchRows];
+    for (size_t r = 0; r < NumScratchRows; ++r) row[r] = scratch.data() + r * BlockSize;
+    kernels.scenario(0, n, spotFactor, logSpotFactor, o.K.data() + begin, o.S.data() + begin, o.T.data() + begin,
+                     o.q.data() + begin, row[Row_Call], row[Row_Sigma], row[Row_R], row[Row_LogSK], row[Row_SqrtT],
+                     row[Row_VolSqrtT], row[Row_Drift], row[Row_DiscQ], row[Row_DiscR],
+                     row[Row_Value], row[Row_Delta], row[Row_Gamma], row[Row_Vega], row[Row_Theta], row[Row_Rho]);
+}
+
+} // namespace
+
+std::vector<double> ShockLadder(double from, double to, size_t steps) {
+    std::vector<double> ladder(steps);
+    for (size_t k = 0; k < steps; ++k) ladder[k] = steps == 1 ? from : from + (to - from) * double(k) / double(steps - 1);
+    return ladder;
+}
+
+int RunScenarios(const OptionBatch &options, const std::vector<double> &quantity, const ShockLattice &lattice, ScenarioCube &cube,
+                 PricingModel model, ThreadPool *pool) {
+    const size_t n = options.size();
+    if (lattice.size() == 0 || quantity.size() != n) {
+        std::cerr << "Scenarios: the lattice needs at least one shock of each kind and one quantity per option." << std::endl;
+        return -1;
+    }
+    if (IsLatticeModel(model)) {
+        std::cerr << "Scenarios: closed form models only (BlackScholes, Black76, Bachelier)." << std::endl;
+        return -1;
+    }
+    if (*std::min_element(lattice.spot.begin(), lattice.spot.end()) <= -1) {
+        std::cerr << "Scenarios: spot shocks must stay above -100%." << std::endl;
+        return -1;
+    }
+    GREEKS_PROFILE_SCOPE("RunScenarios");
+    GREEKS_PROFILE_COUNT(Counter_Points, n * lattice.size());
+
+    const ModelKernels &kernels = KernelsOf(model);
+    ThreadPool &threads = pool ? *pool : DefaultThreadPool();
+    std::vector<std::vector<double>> scratch(threads.NumThreads(), std::vector<double>(NumScratchRows * BlockSize));
+
+    // unshocked values, by the same kernels so that a zero shock reproduces them bit for bit
+    const size_t numBlocks = (n + BlockSize - 1) / BlockSize;
+    std::vector<double> base(n);
+    threads.ParallelFor(numBlocks, [&](size_t block, size_t worker) {
+        const size_t begin = block * BlockSize, count = std::min(BlockSize, n - begin);
+        BlockFactors(kernels, options, begin, count, 0, 0, scratch[worker]);
+        BlockPoints(kernels, options, begin, count, 1, 0, scratch[worker]);
+        std::copy_n(scratch[worker].data() + Row_Value * BlockSize, count, base.data() + begin);
+    });
+    cube.baseValue = 0;
+    for (size_t k = 0; k < n; ++k) cube.baseValue += quantity[k] * base[k];
+
+    // one task per (vol, rate) column and group of options, sums per spot shock
+    const size_t numSpots = lattice.spot.size(), numRates = lattice.rate.size();
+    const size_t numColumns = lattice.vol.size() * numRates;
+    const size_t numGroups = std::max<size_t>(1, (n + ScenarioGroupSize - 1) / ScenarioGroupSize);
+    std::vector<double> logSpot(numSpots);
+    for (size_t i = 0; i < numSpots; ++i) logSpot[i] = std::log1p(lattice.spot[i]);
+    std::vector<Sums> partial(numColumns * numGroups * numSpots);
+
+    threads.ParallelFor(numColumns * numGroups, [&](size_t task, size_t worker) {
+        const size_t column = task / numGroups, group = task % numGroups;
+        const double volShock = lattice.vol[column / numRates], rateShock = lattice.rate[column % numRates];
+        const size_t groupEnd = std::min(n, (group + 1) * ScenarioGroupSize);
+        std::vector<double> &rows = scratch[worker];
+        Sums *sums = partial.data() + task * numSpots;
+        for (size_t begin = group * ScenarioGroupSize; begin < groupEnd; begin += BlockSize) {
+            const size_t count = std::min(BlockSize, groupEnd - begin);
+            BlockFactors(kernels, options, begin, count, volShock, rateShock, rows);
+            const double *value = rows.data() + Row_Value * BlockSize, *delta = rows.data() + Row_Delta * BlockSize;
+            const double *gamma = rows.data() + Row_Gamma * BlockSize, *vega = rows.data() + Row_Vega * BlockSize;
+            const double *theta = rows.data() + Row_Theta * BlockSize, *rho = rows.data() + Row_Rho * BlockSize;
+            for (size_t i = 0; i < numSpots; ++i) {
+                BlockPoints(kernels, options, begin, count, 1 + lattice.spot[i], logSpot[i], rows);
+                Sums &s = sums[i];
+                for (size_t k = 0; k < count; ++k) {
+                    const double w = quantity[begin + k];
+                    s.pnl += w * (value[k] - base[begin + k]);
+                    s.delta += w * delta[k];
+                    s.gamma += w * gamma[k];
+                    s.vega += w * vega[k];
+                    s.theta += w * theta[k];
+                    s.rho += w * rho[k];
+                }
+            }
+        }
+    });
+
+    cube.lattice = lattice;
+    const size_t size = lattice.size();
+    for (std::vector<double> *v : {&cube.pnl, &cube.delta, &cube.gamma, &cube.vega, &cube.theta, &cube.rho}) v->assign(size, 0.0);
+    for (size_t column = 0; column < numColumns; ++column)
+        for (size_t i = 0; i < numSpots; ++i) {
+            Sums total;
+            for (size_t group = 0; group < numGroups; ++group) {
+                const Sums &s = partial[(column * numGroups + group) * numSpots + i];
+                total.pnl += s.pnl; total.delta += s.delta; total.gamma += s.gamma;
+                total.vega += s.vega; total.theta += s.theta; total.rho += s.rho;
+            }
+            const size_t at = cube.Index(i, column / numRates, column % numRates);
+            cube.pnl[at] = total.pnl;
+            cube.delta[at] = total.delta;
+            cube.gamma[at] = total.gamma;
+            cube.vega[at] = total.vega;
+            cube.theta[at] = total.theta;
+            cube.rho[at] = total.rho;
+        }
+    return 0;
+}
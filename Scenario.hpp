@@ -0,0 +1,46 @@
+#ifndef SCENARIO_HPP_
+#define SCENARIO_HPP_
+
+#include <cstddef>
+#include <vector>
+#include "Greeks.hpp"
+#include "ThreadPool.hpp"
+
+// Stress scenarios : a set of options repriced under every spot x vol x rate shock of a lattice in one pass.
+//
+// Spot shocks are relative (S (1 + spot[i])), vol and rate shocks absolute (sigma + vol[j], r + rate[l]);
+// shocked vols are floored at ScenarioMinVol. With Black76 and Bachelier the spot shock moves the forward.
+struct ShockLattice {
+    std::vector<double> spot, vol, rate;
+
+    size_t size() const { return spot.size() * vol.size() * rate.size(); }
+};
+constexpr double ScenarioMinVol = 1e-4;
+
+// steps values evenly spaced from `from` to `to` (both included; {from} for one step)
+std::vector<double> ShockLadder(double from, double to, size_t steps);
+
+// Value change and net Greeks of the options in every scenario, quantity weighted, indexed [spot][vol][rate]
+// with the rate shock fastest. The P&L of a scenario is the sum of the option value changes against the
+// unshocked options, taken option by option : a scenario of zero shocks has a P&L of exactly 0
+struct ScenarioCube {
+    ShockLattice lattice;
+    double baseValue = 0;   // value of the unshocked options
+    std::vector<double> pnl, delta, gamma, vega, theta, rho;
+
+    size_t Index(size_t i, size_t j, size_t l) const { return (i * lattice.vol.size() + j) * lattice.rate.size() + l; }
+};
+
+// Price `options` (quantity[k] contracts of option k) under every scenario of `lattice`.
+//
+// Work is split into (vol, rate) columns x groups of ScenarioGroupSize options. A task computes the factors that
+// depend on the shocked vol and rate (sqrt(T), sigma sqrt(T), the drift, both discounts) and ln(S / K) once per
+// option, in blocks that stay in cache, and reuses them for every spot shock, which only adds ln(1 + spot[i]) to
+// ln(S / K). Group sums are added in group order, so the cube does not depend on the number of threads.
+// Returns 0, -1 for an empty lattice, mismatched sizes or a lattice model (Lattice.hpp)
+int RunScenarios(const OptionBatch &options, const std::vector<double> &quantity, const ShockLattice &lattice, ScenarioCube &cube,
+                 PricingModel model = Model_BlackScholes, ThreadPool *pool = nullptr);
+
+constexpr size_t ScenarioGroupSize = 16384;
+
+#endif /* SCENARIO_HPP_ */
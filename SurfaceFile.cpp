@@ -0,0 +1,207 @@
+#include "SurfaceFile.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t SectionAlignment = 64;
+
+uint64_t AlignUp(uint64_t x) { return (x + SectionAlignment - 1) / SectionAlignment * SectionAlignment; }
+inline uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+std::string NameOf(const char (&name)[SurfaceNameBytes]) { return std::string(name, strnlen(name, SurfaceNameBytes)); }
+
+// Checksum of everything after the header : the axes region seeds the checksum of the values, so the
+// writer never has to hold both in one buffer
+uint64_t PayloadChecksum(const char *axes, size_t axesBytes, const double *values, size_t valuesBytes) {
+    return SurfaceChecksum(values, valuesBytes, SurfaceChecksum(axes, axesBytes));
+}
+
+uint64_t HeaderChecksum(SurfaceHeader header) {
+    header.headerChecksum = 0;
+    return SurfaceChecksum(&header, sizeof header);
+}
+
+} // namespace
+
+uint64_t SurfaceChecksum(const void *data, size_t bytes, uint64_t seed) {
+    constexpr uint64_t P1 = 0x9E3779B185EBCA87ull, P2 = 0xC2B2AE3D27D4EB4Full, P3 = 0x165667B19E3779F9ull;
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    uint64_t lane[4] = {seed + P1 + P2, seed + P2, seed, seed - P1};
+    size_t k = 0;
+    // four independent lanes of 8-byte words
+    for (; k + 32 <= bytes; k += 32) {
+        for (int l = 0; l < 4; ++l) {
+            uint64_t w;
+            std::memcpy(&w, p + k + 8 * l, 8);
+            lane[l] = Rotl(lane[l] + w * P2, 31) * P1;
+        }
+    }
+    uint64_t h = Rotl(lane[0], 1) + Rotl(lane[1], 7) + Rotl(lane[2], 12) + Rotl(lane[3], 18);
+    h += bytes;
+    for (; k + 8 <= bytes; k += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + k, 8);
+        h = Rotl(h ^ (Rotl(w * P2, 31) * P1), 27) * P1 + P3;
+    }
+    for (; k < bytes; ++k) h = Rotl(h ^ (p[k] * P3), 11) * P1;
+    // final mix, every input bit reaches every output bit
+    h ^= h >> 33; h *= P2;
+    h ^= h >> 29; h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+int WriteSurface(const std::string &filename, const GreekGrid &grid) {
+    const GreekTensor &values = grid.GreekValues;
+    const RecomputeRequest &request = grid.request;
+
+    SurfaceHeader header;
+    std::memset(&header, 0, sizeof header);
+
+    // slice names, in the order ComputeGreek fills the slices
+    const std::vector<std::string> greekNames = GreekList(request.greeks), optionNames = OptionList(request.options);
+    const size_t greeks = greekNames.size(), options = optionNames.size();
+    for (size_t g = 0; g < greeks; ++g) std::strncpy(header.greekNames[g], greekNames[g].c_str(), SurfaceNameBytes - 1);
+    for (size_t o = 0; o < options; ++o) std::strncpy(header.optionNames[o], optionNames[o].c_str(), SurfaceNameBytes - 1);
+    if (values.Empty() || greeks != values.NumGreeks() || options != values.NumOptions() ||
+        grid.StockPrices.size() != values.NumStocks() || grid.TimeToMaturities.size() != values.NumMaturities()) {
+        std::cerr << "Cannot write surface: the grid does not match its parameters." << std::endl;
+        return -1;
+    }
+
+    std::memcpy(header.magic, SurfaceMagic, sizeof header.magic);
+    header.version = SurfaceVersion;
+    header.headerBytes = sizeof(SurfaceHeader);
+    header.byteOrder = SurfaceByteOrder;
+    header.K = request.K; header.S0 = request.S0; header.r = request.r;
+    header.q = request.q; header.T = request.T; header.sigma = request.sigma;
+    header.numMaturities = request.numMaturities;
+    header.model = request.model;
+    header.greeks = greeks;
+    header.options = options;
+    header.stocks = values.NumStocks();
+    header.maturities = values.NumMaturities();
+    header.rowStride = values.Stride(2);
+    header.stockAxisOffset = AlignUp(sizeof(SurfaceHeader));
+    header.maturityAxisOffset = AlignUp(header.stockAxisOffset + header.stocks * sizeof(double));
+    header.valuesOffset = AlignUp(header.maturityAxisOffset + header.maturities * sizeof(double));
+    header.valuesBytes = values.Size() * sizeof(double);
+    header.fileBytes = header.valuesOffset + header.valuesBytes;
+
+    // axes and the zero padding up to the values
+    std::vector<char> axes(header.valuesOffset - sizeof(SurfaceHeader), 0);
+    std::memcpy(axes.data() + (header.stockAxisOffset - sizeof(SurfaceHeader)), grid.StockPrices.data(), header.stocks * sizeof(double));
+    std::memcpy(axes.data() + (header.maturityAxisOffset - sizeof(SurfaceHeader)), grid.TimeToMaturities.data(), header.maturities * sizeof(double));
+    header.payloadChecksum = PayloadChecksum(axes.data(), axes.size(), values.Data(), header.valuesBytes);
+    header.headerChecksum = HeaderChecksum(header);
+
+    // written next to the target and renamed, so a reader never maps a half written file
+    const std::string temporary = filename + ".tmp";
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << temporary << std::endl;
+        return -1;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof header);
+    file.write(axes.data(), axes.size());
+    file.write(reinterpret_cast<const char *>(values.Data()), header.valuesBytes);
+    file.close();
+    if (!file || std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Error writing file: " << filename << std::endl;
+        std::remove(temporary.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+int MappedSurface::Open(const std::string &filename) {
+    Close();
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return -1;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SurfaceHeader)) {
+        std::cerr << "Not a surface file: " << filename << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    bytes_ = static_cast<size_t>(info.st_size);
+    void *mapping = ::mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);   // the mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error mapping file: " << filename << std::endl;
+        bytes_ = 0;
+        return -1;
+    }
+    mapping_ = mapping;
+
+    const SurfaceHeader &h = *static_cast<const SurfaceHeader *>(mapping_);
+    const char *error = nullptr;
+    if (std::memcmp(h.magic, SurfaceMagic, sizeof h.magic) != 0) error = "not a surface file";
+    else if (h.version != SurfaceVersion || h.headerBytes != sizeof(SurfaceHeader)) error = "unsupported version";
+    else if (h.byteOrder != SurfaceByteOrder) error = "written with another byte order";
+    else if (h.headerChecksum != HeaderChecksum(h)) error = "corrupted header";
+    else if (h.fileBytes != bytes_) error = "truncated file";
+    else if (h.model >= NumModels) error = "unknown pricing model";
+    else {
+        // shape and offsets, checked without overflow before any view is handed out
+        const uint64_t elements = h.greeks * h.options;
+        const bool shape = h.greeks >= 1 && h.greeks <= SurfaceMaxGreeks && h.options >= 1 && h.options <= SurfaceMaxOptions &&
+                           h.stocks >= 1 && h.maturities >= 1 && h.rowStride % 8 == 0 && h.maturities <= h.rowStride &&
+                           h.stocks <= bytes_ / sizeof(double) && h.rowStride <= bytes_ / sizeof(double);
+        const bool sections = h.stockAxisOffset % SectionAlignment == 0 && h.maturityAxisOffset % SectionAlignment == 0 &&
+                              h.valuesOffset % SectionAlignment == 0 && h.stockAxisOffset >= sizeof(SurfaceHeader) &&
+                              h.maturityAxisOffset >= h.stockAxisOffset + h.stocks * sizeof(double) &&
+                              h.valuesOffset >= h.maturityAxisOffset + h.maturities * sizeof(double) &&
+                              h.valuesOffset <= bytes_ && h.valuesBytes == bytes_ - h.valuesOffset;
+        if (!shape || !sections || elements > h.valuesBytes / sizeof(double) / h.stocks / h.rowStride ||
+            elements * h.stocks * h.rowStride * sizeof(double) != h.valuesBytes)
+            error = "inconsistent layout";
+    }
+    if (error) {
+        std::cerr << "Cannot open surface " << filename << ": " << error << std::endl;
+        Close();
+        return -1;
+    }
+    header_ = &h;
+    return 0;
+}
+
+void MappedSurface::Close() {
+    if (mapping_) ::munmap(mapping_, bytes_);
+    mapping_ = nullptr;
+    header_ = nullptr;
+    bytes_ = 0;
+}
+
+bool MappedSurface::Verify() const {
+    if (!header_) return false;
+    const char *base = static_cast<const char *>(mapping_);
+    return PayloadChecksum(base + sizeof(SurfaceHeader), header_->valuesOffset - sizeof(SurfaceHeader),
+                           Values(), header_->valuesBytes) == header_->payloadChecksum;
+}
+
+std::string MappedSurface::GreekName(size_t g) const { return g < NumGreeks() ? NameOf(header_->greekNames[g]) : std::string(); }
+std::string MappedSurface::OptionName(size_t o) const { return o < NumOptions() ? NameOf(header_->optionNames[o]) : std::string(); }
+
+int MappedSurface::FindGreek(const std::string &name) const {
+    for (size_t g = 0; g < NumGreeks(); ++g)
+        if (GreekName(g) == name) return static_cast<int>(g);
+    return -1;
+}
+
+int MappedSurface::FindOption(const std::string &name) const {
+    for (size_t o = 0; o < NumOptions(); ++o)
+        if (OptionName(o) == name) return static_cast<int>(o);
+    return -1;
+}
@@ -0,0 +1,97 @@
+#ifndef SURFACEFILE_HPP_
+#define SURFACEFILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "GreekTensor.hpp"
+#include "RecomputePlan.hpp"
+
+// Binary surface file : the Greek values of one grid, stored exactly as GreekTensor lays them out so a
+// reader can map the file and use the values in place.
+//
+//   SurfaceHeader (512 bytes)                     parameters, shape, names, offsets, checksums
+//   double StockPrices[stocks]                    64-byte aligned
+//   double TimeToMaturities[maturities]           64-byte aligned
+//   double values[greeks][options][stocks][rowStride]   64-byte aligned, rows padded with zeros
+//
+// Native byte order, recorded in the header and checked on open. The header checksum covers the header,
+// the payload checksum everything after it; only the first is checked by Open(), Verify() reads the whole file.
+constexpr char SurfaceMagic[8] = {'G', 'R', 'K', 'S', 'U', 'R', 'F', '\0'};
+constexpr uint32_t SurfaceVersion = 2;             // 2 : 16 Greek names (the higher order Greeks), 8 in version 1
+constexpr uint64_t SurfaceByteOrder = 0x0102030405060708ull;
+constexpr size_t SurfaceMaxGreeks = 16;
+constexpr size_t SurfaceMaxOptions = 2;
+constexpr size_t SurfaceNameBytes = 16;
+
+struct SurfaceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerBytes;
+    uint64_t byteOrder;
+    double K, S0, r, q, T, sigma;                     // parameters of the grid
+    int32_t numMaturities;
+    uint32_t model;                                   // PricingModel, 0 (BlackScholes) in files written before it was recorded
+    uint64_t greeks, options, stocks, maturities;
+    uint64_t rowStride;                               // doubles between two stock prices (maturities padded to 8)
+    char greekNames[SurfaceMaxGreeks][SurfaceNameBytes];    // zero padded, e.g. "Delta"
+    char optionNames[SurfaceMaxOptions][SurfaceNameBytes];  // "Call", "Put"
+    uint64_t stockAxisOffset, maturityAxisOffset, valuesOffset;   // bytes from the start of the file
+    uint64_t valuesBytes;
+    uint64_t fileBytes;
+    uint64_t payloadChecksum;                         // bytes [headerBytes, fileBytes)
+    uint64_t headerChecksum;                          // header bytes with this field set to 0
+    char reserved1[48];
+};
+static_assert(sizeof(SurfaceHeader) == 512, "SurfaceHeader must keep its on-disk size");
+
+// 64-bit checksum of a byte range, word-wise so multi-GB payloads check at memory speed
+uint64_t SurfaceChecksum(const void *data, size_t bytes, uint64_t seed = 0);
+
+// Write a computed grid (greek and option names from its request, in the engine order). Returns 0, -1 on error
+int WriteSurface(const std::string &filename, const GreekGrid &grid);
+
+// Read-only mapping of a surface file; slices and axes point into the mapping, nothing is copied.
+// The views stay valid until Close() or destruction.
+class MappedSurface {
+public:
+    MappedSurface() = default;
+    ~MappedSurface() { Close(); }
+    MappedSurface(const MappedSurface &) = delete;
+    MappedSurface &operator=(const MappedSurface &) = delete;
+
+    // Map and validate the header. Returns 0, -1 on error (message on std::cerr)
+    int Open(const std::string &filename);
+    void Close();
+    bool IsOpen() const { return header_ != nullptr; }
+    // Check the payload checksum, reading the whole file
+    bool Verify() const;
+
+    const SurfaceHeader &Header() const { return *header_; }
+    size_t NumGreeks() const { return header_->greeks; }
+    size_t NumOptions() const { return header_->options; }
+    size_t NumStocks() const { return header_->stocks; }
+    size_t NumMaturities() const { return header_->maturities; }
+    std::string GreekName(size_t g) const;
+    std::string OptionName(size_t o) const;
+    int FindGreek(const std::string &name) const;     // slice index, -1 if absent
+    int FindOption(const std::string &name) const;
+
+    const double *StockPrices() const { return Base<double>(header_->stockAxisOffset); }
+    const double *TimeToMaturities() const { return Base<double>(header_->maturityAxisOffset); }
+    const double *Values() const { return Base<double>(header_->valuesOffset); }
+    SliceView<const double> Slice(size_t g, size_t o) const {
+        const size_t rowStride = header_->rowStride;
+        return {Values() + (g * header_->options + o) * header_->stocks * rowStride, header_->stocks, header_->maturities, rowStride};
+    }
+
+private:
+    template <typename T>
+    const T *Base(uint64_t offset) const { return reinterpret_cast<const T *>(static_cast<const char *>(mapping_) + offset); }
+
+    void *mapping_ = nullptr;
+    size_t bytes_ = 0;
+    const SurfaceHeader *header_ = nullptr;
+};
+
+#endif /* SURFACEFILE_HPP_ */
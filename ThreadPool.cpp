@@ -0,0 +1,122 @@
+#include "ThreadPool.hpp"
+#include "Profiler.hpp"
+#include <string>
+
+namespace {
+thread_local bool t_insidePool = false;   // true while a thread is running a pool task
+
+std::mutex g_defaultMutex;
+std::unique_ptr<ThreadPool> g_defaultPool;
+size_t g_defaultThreads = 0;
+}
+
+ThreadPool::ThreadPool(size_t numThreads) {
+    if (numThreads == 0) numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0) numThreads = 1;
+
+    for (size_t w = 0; w < numThreads; ++w) queues_.push_back(std::make_unique<Queue>());
+    for (size_t w = 1; w < numThreads; ++w) threads_.emplace_back(&ThreadPool::WorkerLoop, this, w);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &t : threads_) t.join();
+}
+
+void ThreadPool::ParallelFor(size_t numTasks, const Task &task) {
+    if (numTasks == 0) return;
+
+    // nested call or nothing to share : run inline
+    if (t_insidePool || numTasks == 1 || NumThreads() == 1) {
+        for (size_t k = 0; k < numTasks; ++k) task(k, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> call(callMutex_);
+    task_ = &task;
+    remaining_.store(numTasks);
+
+    // deal contiguous blocks so that neighbouring tiles stay on the same thread unless stolen
+    const size_t W = NumThreads();
+    for (size_t w = 0; w < W; ++w) {
+        std::lock_guard<std::mutex> lock(queues_[w]->mutex);
+        for (size_t k = w * numTasks / W; k < (w + 1) * numTasks / W; ++k) queues_[w]->tasks.push_back(k);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    t_insidePool = true;
+    while (RunOne(0)) {}
+    t_insidePool = false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&] { return remaining_.load() == 0; });
+    task_ = nullptr;
+}
+
+bool ThreadPool::RunOne(size_t worker) {
+    size_t k = 0;
+    bool found = false;
+    {
+        Queue &own = *queues_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            k = own.tasks.front();
+            own.tasks.pop_front();
+            found = true;
+        }
+    }
+    // steal from the back of the other queues
+    for (size_t v = 1; !found && v < queues_.size(); ++v) {
+        Queue &victim = *queues_[(worker + v) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            k = victim.tasks.back();
+            victim.tasks.pop_back();
+            found = true;
+        }
+    }
+    if (!found) return false;
+
+    (*task_)(k, worker);
+    if (remaining_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::WorkerLoop(size_t worker) {
+    t_insidePool = true;
+    GREEKS_PROFILE_THREAD("pool " + std::to_string(worker));
+    unsigned long long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+        while (RunOne(worker)) {}
+    }
+}
+
+ThreadPool &DefaultThreadPool() {
+    std::lock_guard<std::mutex> lock(g_defaultMutex);
+    if (!g_defaultPool) g_defaultPool = std::make_unique<ThreadPool>(g_defaultThreads);
+    return *g_defaultPool;
+}
+
+void SetNumThreads(size_t numThreads) {
+    std::lock_guard<std::mutex> lock(g_defaultMutex);
+    g_defaultThreads = numThreads;
+    if (g_defaultPool && g_defaultPool->NumThreads() != (numThreads ? numThreads : std::thread::hardware_concurrency()))
+        g_defaultPool.reset();
+}
@@ -0,0 +1,62 @@
+#ifndef THREADPOOL_HPP_
+#define THREADPOOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed size pool of worker threads with one task deque per thread and work stealing.
+//
+// ParallelFor(n, task) runs task(k, worker) for every k in [0, n) and returns when all are done.
+// Tasks are dealt to the deques in contiguous blocks; a thread pops from the front of its own
+// deque and, once empty, steals from the back of the others. The calling thread takes part as
+// worker 0, so `worker` is always < NumThreads() and can index per-thread scratch buffers.
+// A ParallelFor issued from inside a task runs serially on the calling worker.
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t task, size_t worker)>;
+
+    // numThreads = 0 uses every hardware thread
+    explicit ThreadPool(size_t numThreads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t NumThreads() const { return queues_.size(); }   // workers + calling thread
+    void ParallelFor(size_t numTasks, const Task &task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void WorkerLoop(size_t worker);
+    bool RunOne(size_t worker);   // run one task of its own queue or a stolen one, false if every queue is empty
+
+    std::vector<std::unique_ptr<Queue>> queues_;   // queues_[0] belongs to the calling thread
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const Task *task_ = nullptr;
+    std::atomic<size_t> remaining_{0};
+    unsigned long long generation_ = 0;
+    bool stop_ = false;
+
+    std::mutex callMutex_;   // one ParallelFor at a time
+};
+
+// Process wide pool used by the grid kernels when no pool is given
+ThreadPool &DefaultThreadPool();
+// Resize the default pool (0 = every hardware thread). Must not be called while it is in use
+void SetNumThreads(size_t numThreads);
+
+#endif /* THREADPOOL_HPP_ */
@@ -0,0 +1,248 @@
+#include "TickReplay.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+const char *SkipBlanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    return p;
+}
+
+// Optional number followed by a comma or the end of the line, NaN when empty
+bool ParseField(const char *&p, const char *end, double &x, bool last) {
+    p = SkipBlanks(p, end);
+    x = std::numeric_limits<double>::quiet_NaN();
+    if (p < end && *p != ',') {
+        auto res = std::from_chars(p, end, x);
+        if (res.ec != std::errc()) return false;
+        p = SkipBlanks(res.ptr, end);
+    }
+    if (last) return p == end;
+    if (p == end || *p != ',') return false;
+    ++p;
+    return true;
+}
+
+} // namespace
+
+bool ParseTick(const std::string &line, Tick &tick) {
+    const char *p = SkipBlanks(line.data(), line.data() + line.size()), *end = line.data() + line.size();
+    auto res = std::from_chars(p, end, tick.time);
+    if (res.ec != std::errc()) return false;
+    p = SkipBlanks(res.ptr, end);
+    if (p == end || *p != ',') return false;
+    ++p;
+    const char *comma = static_cast<const char *>(std::memchr(p, ',', end - p));
+    if (!comma || comma == p) return false;
+    tick.underlying.assign(p, comma);
+    p = comma + 1;
+    if (!ParseField(p, end, tick.spot, false) || !ParseField(p, end, tick.vol, false) || !ParseField(p, end, tick.rate, true))
+        return false;
+    return !(tick.vol <= 0);   // NaN (unchanged) passes
+}
+
+size_t LatencyHistogram::BucketOf(uint64_t ns) {
+    if (ns < SubBuckets) return size_t(ns);
+    unsigned e = 63;
+    while (!(ns >> e)) --e;   // e >= 4
+    return size_t(e - 3) * SubBuckets + size_t((ns >> (e - 4)) & (SubBuckets - 1));
+}
+
+uint64_t LatencyHistogram::UpperEdge(size_t bucket) {
+    if (bucket < SubBuckets) return bucket;
+    const unsigned e = unsigned(bucket / SubBuckets) + 3;
+    const uint64_t lower = uint64_t(SubBuckets + bucket % SubBuckets) << (e - 4);
+    return lower + ((uint64_t(1) << (e - 4)) - 1);
+}
+
+void LatencyHistogram::Add(uint64_t ns) {
+    ++counts_[BucketOf(ns)];
+    ++count_;
+    sum_ += ns;
+    max_ = std::max(max_, ns);
+}
+
+void LatencyHistogram::Clear() {
+    counts_.fill(0);
+    count_ = max_ = sum_ = 0;
+}
+
+uint64_t LatencyHistogram::Percentile(double p) const {
+    if (count_ == 0) return 0;
+    const uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(std::clamp(p, 0.0, 1.0) * double(count_))));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < counts_.size(); ++b) {
+        seen += counts_[b];
+        if (seen >= rank) return std::min(UpperEdge(b), max_);
+    }
+    return max_;
+}
+
+int StreamingBook::Load(std::istream &in, ThreadPool *pool) {
+    // PortfolioAggregator parses the positions; without expiry edges its buckets are the underlyings
+    PortfolioAggregator reader(std::vector<double>{});
+    PositionChunk chunk, all;
+    while (reader.ReadChunk(in, 65536, chunk) > 0) {
+        for (size_t k = 0; k < chunk.size(); ++k) {
+            const OptionBatch &o = chunk.options;
+            all.options.push_back(o.K[k], o.S[k], o.T[k], o.sigma[k], o.r[k], o.q[k], o.isCall[k] != 0);
+        }
+        all.quantity.insert(all.quantity.end(), chunk.quantity.begin(), chunk.quantity.end());
+        all.bucket.insert(all.bucket.end(), chunk.bucket.begin(), chunk.bucket.end());
+    }
+    skipped_ = reader.SkippedLines();
+    const size_t n = all.size();
+    if (n == 0) {
+        std::cerr << "The book holds no position." << std::endl;
+        return -1;
+    }
+
+    // group by underlying, book order kept within each
+    names_ = reader.Underlyings();
+    ids_.clear();
+    for (size_t u = 0; u < names_.size(); ++u) ids_[names_[u]] = u;
+    first_.assign(names_.size() + 1, 0);
+    for (unsigned b : all.bucket) ++first_[b + 1];
+    for (size_t u = 0; u < names_.size(); ++u) first_[u + 1] += first_[u];
+    std::vector<size_t> next(first_.begin(), first_.end() - 1), order(n);
+    for (size_t k = 0; k < n; ++k) order[next[all.bucket[k]]++] = k;
+
+    options_.clear();
+    quantity_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        const size_t k = order[i];
+        const OptionBatch &o = all.options;
+        options_.push_back(o.K[k], o.S[k], o.T[k], o.sigma[k], o.r[k], o.q[k], o.isCall[k] != 0);
+        quantity_[i] = all.quantity[k];
+    }
+
+    values_.assign(8 * n, 0.0);
+    double *base = values_.data();
+    rows_ = GreekRows{base, base + n, base + 2 * n, base + 3 * n, base + 4 * n, base + 5 * n, base + 6 * n, base + 7 * n};
+    net_.assign(names_.size(), NetGreeks());
+    for (size_t u = 0; u < names_.size(); ++u) Reprice(u, pool);
+    return 0;
+}
+
+int StreamingBook::LoadFile(const std::string &filename, ThreadPool *pool) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return -1;
+    }
+    return Load(file, pool);
+}
+
+void StreamingBook::Reprice(size_t u, ThreadPool *pool) {
+    const size_t begin = first_[u], end = first_[u + 1];
+    const size_t block = PortfolioAggregator::BlockSize;
+    const size_t numBlocks = (end - begin + block - 1) / block;
+    blockSums_.assign(numBlocks, NetGreeks());
+
+    auto task = [&](size_t b, size_t) {
+        const size_t from = begin + b * block, to = std::min(end, from + block);
+        FusedGreeksBatch(options_, from, to, rows_, model_);
+        NetGreeks &s = blockSums_[b];
+        for (size_t k = from; k < to; ++k) {
+            const double w = quantity_[k];
+            const bool call = options_.isCall[k];
+            s.delta += w * (call ? rows_.deltaCall[k] : rows_.deltaPut[k]);
+            s.gamma += w * rows_.gamma[k];
+            s.vega += w * rows_.vega[k];
+            s.theta += w * (call ? rows_.thetaCall[k] : rows_.thetaPut[k]);
+            s.rho += w * (call ? rows_.rhoCall[k] : rows_.rhoPut[k]);
+            ++s.positions;
+        }
+    };
+    // a single block stays on the calling thread, waking the pool costs more than it saves
+    if (numBlocks > 1) (pool ? *pool : DefaultThreadPool()).ParallelFor(numBlocks, task);
+    else if (numBlocks == 1) task(0, 0);
+
+    NetGreeks net;
+    for (const NetGreeks &s : blockSums_) net += s;
+    net_[u] = net;
+}
+
+int StreamingBook::Apply(const Tick &tick, ThreadPool *pool) {
+    GREEKS_PROFILE_SCOPE("TickApply");
+    const auto it = ids_.find(tick.underlying);
+    if (it == ids_.end()) return -1;
+    const size_t u = it->second;
+    for (size_t k = first_[u]; k < first_[u + 1]; ++k) {
+        if (!std::isnan(tick.spot)) options_.S[k] = tick.spot;
+        if (!std::isnan(tick.vol)) options_.sigma[k] = tick.vol;
+        if (!std::isnan(tick.rate)) options_.r[k] = tick.rate;
+    }
+    Reprice(u, pool);
+    GREEKS_PROFILE_COUNT(Counter_Points, first_[u + 1] - first_[u]);
+    return static_cast<int>(u);
+}
+
+NetGreeks StreamingBook::Total() const {
+    NetGreeks total;
+    for (const NetGreeks &n : net_) total += n;
+    return total;
+}
+
+int ReplayFeed(std::istream &feed, StreamingBook &book, double speed, const TickPublisher &publish, ReplayStats &stats,
+               ThreadPool *pool) {
+    using Clock = std::chrono::steady_clock;
+    if (!(speed >= 0)) {
+        std::cerr << "Replay speed must be 0 (as fast as possible) or positive." << std::endl;
+        return -1;
+    }
+    // also allocates the profiler's event ring of this thread here rather than in the first tick
+    GREEKS_PROFILE_THREAD("replay");
+    const Clock::time_point start = Clock::now();
+    Clock::time_point origin;   // wall time of the first tick when paced
+    double firstTime = 0;
+    bool first = true;
+    std::string line;
+    Tick tick;
+    size_t lines = 0;
+    while (std::getline(feed, line)) {
+        Clock::time_point arrival = Clock::now();
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        ++lines;
+        if (!ParseTick(line, tick)) {
+            if (!line.empty() && lines > 1) {   // first line may be a header
+                std::cerr << "Skipping line: " << line << std::endl;
+                ++stats.ignored;
+            }
+            continue;
+        }
+        if (speed > 0) {
+            if (first) {
+                origin = arrival;
+                firstTime = tick.time;
+                first = false;
+            }
+            // a tick read late keeps its scheduled arrival, the backlog is part of its latency
+            arrival = origin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((tick.time - firstTime) / speed));
+            // sleep wakes up tens of us late : sleep to just before the arrival and spin the rest
+            std::this_thread::sleep_until(arrival - std::chrono::microseconds(200));
+            while (Clock::now() < arrival) std::this_thread::yield();
+        }
+
+        const int u = book.Apply(tick, pool);
+        if (u < 0) {
+            ++stats.ignored;
+            continue;
+        }
+        const uint64_t latency = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - arrival).count());
+        stats.latency.Add(latency);
+        ++stats.ticks;
+        stats.optionsRepriced += book.First(size_t(u) + 1) - book.First(size_t(u));
+        if (publish) publish(tick, size_t(u), latency);
+    }
+    stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return 0;
+}
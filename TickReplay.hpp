@@ -0,0 +1,114 @@
+#ifndef TICKREPLAY_HPP_
+#define TICKREPLAY_HPP_
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Greeks.hpp"
+#include "Portfolio.hpp"
+#include "ThreadPool.hpp"
+
+// Streaming mode : a book whose Greeks follow a feed of market updates, replayed from a file or a pipe.
+//
+// Feed, one tick per line (a header line is skipped) :  time,underlying,spot,vol,rate
+// time in seconds on the feed clock (increasing), an empty spot, vol or rate keeps its last value.
+// A tick sets S, sigma and r of every option on its underlying; T is not aged by the feed clock.
+
+struct Tick {
+    double time = 0;
+    std::string underlying;
+    double spot = std::numeric_limits<double>::quiet_NaN();   // NaN = unchanged
+    double vol = std::numeric_limits<double>::quiet_NaN();
+    double rate = std::numeric_limits<double>::quiet_NaN();
+};
+
+// Parse "time,underlying,spot,vol,rate". Returns false for a line that is not a tick
+bool ParseTick(const std::string &line, Tick &tick);
+
+// Latency distribution in ns : 16 linear buckets per power of two (6.25% resolution) up to 2^64 ns
+class LatencyHistogram {
+public:
+    void Add(uint64_t ns);
+    void Clear();
+    // Upper edge of the bucket holding the p quantile (p in [0, 1]), never above Max(); 0 when empty
+    uint64_t Percentile(double p) const;
+    uint64_t Count() const { return count_; }
+    uint64_t Max() const { return max_; }
+    double Mean() const { return count_ ? double(sum_) / double(count_) : 0; }
+
+private:
+    static constexpr unsigned SubBuckets = 16;
+    static size_t BucketOf(uint64_t ns);
+    static uint64_t UpperEdge(size_t bucket);
+
+    std::array<uint64_t, (64 - 3) * SubBuckets> counts_{};
+    uint64_t count_ = 0, max_ = 0, sum_ = 0;
+};
+
+// Positions (PortfolioAggregator format) grouped by underlying, with their Greeks and the net Greeks of every
+// underlying kept current tick by tick. A tick reprices the options of its underlying only, in blocks of
+// PortfolioAggregator::BlockSize shared between the threads when there are several; the net Greeks of the
+// underlying are the block sums added in book order, so they do not depend on the number of threads.
+class StreamingBook {
+public:
+    explicit StreamingBook(PricingModel model = Model_BlackScholes) : model_(model) {}
+
+    // Read and price a book. Returns 0, -1 if it holds no position or cannot be opened
+    int Load(std::istream &in, ThreadPool *pool = nullptr);
+    int LoadFile(const std::string &filename, ThreadPool *pool = nullptr);
+
+    // Update the options of the tick's underlying and their Greeks. Returns the underlying's index,
+    // -1 for an underlying the book does not hold (nothing changes)
+    int Apply(const Tick &tick, ThreadPool *pool = nullptr);
+
+    size_t NumUnderlyings() const { return names_.size(); }
+    const std::string &Underlying(size_t u) const { return names_[u]; }
+    const NetGreeks &Net(size_t u) const { return net_[u]; }
+    NetGreeks Total() const;   // over the underlyings, in their order
+    // options of underlying u are [First(u), First(u + 1)) of Options() and Rows()
+    size_t First(size_t u) const { return first_[u]; }
+    const OptionBatch &Options() const { return options_; }
+    const GreekRows &Rows() const { return rows_; }
+    const std::vector<double> &Quantities() const { return quantity_; }
+    size_t SkippedLines() const { return skipped_; }
+
+private:
+    void Reprice(size_t u, ThreadPool *pool);
+
+    PricingModel model_;
+    OptionBatch options_;
+    std::vector<double> quantity_;
+    std::vector<double> values_;   // 8 Greek rows
+    GreekRows rows_;
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, size_t> ids_;
+    std::vector<size_t> first_;    // NumUnderlyings() + 1 offsets
+    std::vector<NetGreeks> net_;
+    std::vector<NetGreeks> blockSums_;
+    size_t skipped_ = 0;
+};
+
+struct ReplayStats {
+    size_t ticks = 0;            // applied
+    size_t ignored = 0;          // lines that are not ticks, ticks of unknown underlyings
+    size_t optionsRepriced = 0;
+    double seconds = 0;          // wall time of the replay
+    LatencyHistogram latency;    // tick to Greeks, ns
+};
+
+// Called for every applied tick once the Greeks of its underlying are current, with the tick to Greek latency
+using TickPublisher = std::function<void(const Tick &tick, size_t underlying, uint64_t latencyNs)>;
+
+// Replay a feed into the book. speed 1 replays at the recorded pace of the time column, 2 twice as fast ...,
+// 0 as fast as possible (also the choice for a live pipe, whose ticks arrive at their own pace).
+// Latency runs from the arrival of the tick (its scheduled wall time when paced, the end of its read otherwise)
+// to the call of `publish`. Returns 0, -1 for a negative speed
+int ReplayFeed(std::istream &feed, StreamingBook &book, double speed, const TickPublisher &publish, ReplayStats &stats,
+               ThreadPool *pool = nullptr);
+
+#endif /* TICKREPLAY_HPP_ */
@@ -0,0 +1,32 @@
+#include "VecMath.hpp"
+
+GREEKS_DISPATCH
+void VecExp(const double *x, double *out, size_t n) {
+    for (size_t k = 0; k < n; ++k) out[k] = FastExp(x[k]);
+}
+
+GREEKS_DISPATCH
+void VecLog(const double *x, double *out, size_t n) {
+    for (size_t k = 0; k < n; ++k) out[k] = FastLog(x[k]);
+}
+
+GREEKS_DISPATCH
+void VecNormPdf(const double *x, double *out, size_t n) {
+    for (size_t k = 0; k < n; ++k) out[k] = FastNormPdf(x[k]);
+}
+
+GREEKS_DISPATCH
+void VecNormCdf(const double *x, double *out, size_t n) {
+    for (size_t k = 0; k < n; ++k) out[k] = FastNormCdf(x[k]);
+}
+
+const char *VecIsaName() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__linux__) && !defined(GREEKS_NO_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return "avx512f";
+    if (__builtin_cpu_supports("avx2")) return "avx2";
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
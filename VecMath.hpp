@@ -0,0 +1,338 @@
+#ifndef VECMATH_HPP_
+#define VECMATH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#endif
+
+// Vectorisable math kernels for the grid sweeps.
+//
+// The Fast* functions below are branch-free (every branch is a select), use no libm call and no
+// double <-> int64 conversion, so loops calling them are auto-vectorised to 2/4/8 lanes
+// (SSE2/AVX2/AVX-512). Loops tagged GREEKS_DISPATCH are compiled once per ISA and the best clone
+// is picked at load time from the CPU features (GCC/Clang ifunc, x86-64 Linux only).
+//
+// Max error against the scalar path (std::exp, std::log, norm_pdf and norm_cdf of Greeks.cpp),
+// measured over 10^7 uniform points per range :
+//   FastExp      x in [-708.39, 709.78]   1 ulp    (0 below : subnormal results are flushed)
+//   FastLog      x in (0, inf)            2 ulp
+//   FastNormPdf  x in [-37.6, 37.6]       2 ulp    (0 beyond)
+//   FastNormCdf  x in [-37, 37]           2.2e-16 absolute
+// FastNormCdf uses Hart's rational approximation (algorithm 5666, coefficients from G. West,
+// "Better approximations to cumulative normal functions") up to |x| = 7.07 and a continued fraction
+// beyond. Against the exact 0.5 * erfc(-x / sqrt(2)) of norm_cdf its relative error stays below 3e-9 everywhere.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__linux__) && !defined(GREEKS_NO_DISPATCH)
+#define GREEKS_DISPATCH __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define GREEKS_DISPATCH
+#endif
+
+// Inline every call of a kernel whatever the inlining budget, for kernels instantiated many times over
+#if defined(__GNUC__)
+#define GREEKS_FLATTEN __attribute__((flatten))
+#else
+#define GREEKS_FLATTEN
+#endif
+
+namespace vecmath_detail {
+
+inline uint64_t AsBits(double x) { uint64_t b; std::memcpy(&b, &x, sizeof b); return b; }
+inline double AsDouble(uint64_t b) { double x; std::memcpy(&x, &b, sizeof x); return x; }
+inline double Select(bool c, double a, double b) { return c ? a : b; }
+
+constexpr double Ln2Hi = 6.93147180369123816490e-01;   // fdlibm split of ln(2), n * Ln2Hi is exact
+constexpr double Ln2Lo = 1.90821492927058770002e-10;
+constexpr double Log2e = 1.44269504088896338700e+00;
+constexpr double Shifter = 6755399441055744.0;          // 1.5 * 2^52, rounds to integer in the low mantissa bits
+constexpr double InvSqrt2Pi = 0.398942280401432677940;
+
+} // namespace vecmath_detail
+
+// exp(x), 0 below -708.39 and +inf above 709.78
+inline double FastExp(double x) {
+    using namespace vecmath_detail;
+    const double xc = x < -708.3964185322641 ? -708.3964185322641 : (x > 709.782712893384 ? 709.782712893384 : x);
+    const double t = xc * Log2e + Shifter;                 // n = round(x / ln2) sits in the low bits of t
+    const double n = t - Shifter;
+    const double r = (xc - n * Ln2Hi) - n * Ln2Lo;         // |r| <= ln2 / 2
+
+    // Taylor series to degree 13, truncation error < 5e-18 on |r| <= ln2/2
+    double p = 1.0 / 6227020800.0;
+    p = p * r + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+
+    // 2^n built directly in the exponent field, as 2 * 2^(n-1) for n = 1024
+    const bool top = n > 1023.0;
+    const double scale = AsDouble(((AsBits(t) - uint64_t(top)) << 52) + (uint64_t(1023) << 52));
+    double y = p * scale * Select(top, 2.0, 1.0);
+    y = Select(x < -708.3964185322641, 0.0, y);
+    y = Select(x > 709.782712893384, AsDouble(0x7ff0000000000000ULL), y);
+    return Select(x != x, x, y);
+}
+
+// log(x), -inf at 0, NaN below 0
+inline double FastLog(double x) {
+    using namespace vecmath_detail;
+    // bring subnormals into the normal range
+    const bool tiny = x < 2.2250738585072014e-308;
+    const double xs = Select(tiny, x * 18014398509481984.0, x);   // * 2^54
+    const uint64_t bits = AsBits(xs);
+
+    // x = m * 2^e with m in [1, 2), exponent converted to double without an int64 conversion
+    const double e0 = AsDouble(0x4330000000000000ULL | (bits >> 52)) - 4503599627370496.0 - 1023.0;
+    double m = AsDouble((bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+    const bool big = m > 1.4142135623730951;
+    m = Select(big, 0.5 * m, m);
+    const double e = e0 + Select(big, 1.0, 0.0) - Select(tiny, 54.0, 0.0);
+
+    // log(m) = 2 atanh(f), f = (m - 1) / (m + 1), |f| <= 0.1716
+    const double f = (m - 1.0) / (m + 1.0);
+    const double s = f * f;
+    double p = 1.0 / 23.0;
+    p = p * s + 1.0 / 21.0;
+    p = p * s + 1.0 / 19.0;
+    p = p * s + 1.0 / 17.0;
+    p = p * s + 1.0 / 15.0;
+    p = p * s + 1.0 / 13.0;
+    p = p * s + 1.0 / 11.0;
+    p = p * s + 1.0 / 9.0;
+    p = p * s + 1.0 / 7.0;
+    p = p * s + 1.0 / 5.0;
+    p = p * s + 1.0 / 3.0;
+    const double logm = 2.0 * f + 2.0 * f * s * p;
+
+    double y = e * Ln2Hi + (logm + e * Ln2Lo);
+    y = Select(x == 0.0, AsDouble(0xfff0000000000000ULL), y);
+    y = Select(x < 0.0 || x != x, AsDouble(0x7ff8000000000000ULL), y);
+    return Select(x > 1.7976931348623157e308, x, y);
+}
+
+// Standard normal density N'(x)
+inline double FastNormPdf(double x) {
+    return vecmath_detail::InvSqrt2Pi * FastExp(-0.5 * x * x);
+}
+
+namespace vecmath_detail {
+
+// N(-a) for a >= 0
+inline double NormTail(double a) {
+    const double e = FastExp(-0.5 * a * a);
+
+    // |x| < 7.07 : rational approximation
+    double num = 3.52624965998911e-02;
+    num = num * a + 0.700383064443688;
+    num = num * a + 6.37396220353165;
+    num = num * a + 33.912866078383;
+    num = num * a + 112.079291497871;
+    num = num * a + 221.213596169931;
+    num = num * a + 220.206867912376;
+    double den = 8.83883476483184e-02;
+    den = den * a + 1.75566716318264;
+    den = den * a + 16.064177579207;
+    den = den * a + 86.7807322029461;
+    den = den * a + 296.564248779674;
+    den = den * a + 637.333633378831;
+    den = den * a + 793.826512519948;
+    den = den * a + 440.413735824752;
+    const double tailRational = e * num / den;
+
+    // |x| >= 7.07 : Laplace continued fraction a + 1/(a + 2/(a + ... 12/a)), kept as num/den so
+    // that it costs a single division
+    double num2 = a, den2 = 1.0;
+    for (int k = 12; k >= 1; --k) {
+        const double next = a * num2 + k * den2;
+        den2 = num2;
+        num2 = next;
+    }
+    const double tailFraction = e * den2 / num2 * InvSqrt2Pi;
+
+    const double tail = Select(a < 7.07106781186547, tailRational, tailFraction);
+    return Select(a > 37.0, 0.0, tail);
+}
+
+} // namespace vecmath_detail
+
+// Standard normal distribution N(x)
+inline double FastNormCdf(double x) {
+    const double tail = vecmath_detail::NormTail(x < 0 ? -x : x);
+    return vecmath_detail::Select(x > 0, 1.0 - tail, tail);
+}
+
+// N(x) and N(-x) from one evaluation, each keeping the relative accuracy of its tail (1 - N(x) loses it
+// as N(x) gets close to 1). The kernels take put Greeks from N(-d) rather than from put-call parity
+inline void FastNormCdfPair(double x, double &lower, double &upper) {
+    const double tail = vecmath_detail::NormTail(x < 0 ? -x : x);
+    lower = vecmath_detail::Select(x > 0, 1.0 - tail, tail);
+    upper = vecmath_detail::Select(x > 0, tail, 1.0 - tail);
+}
+
+// Single precision overloads, for the float and mixed modes of the grid and batch kernels (see Precision in
+// GreekSet.hpp). Same structure with shorter polynomials : twice the lanes per vector, no float <-> int32
+// conversion either. Max error against the exact values, over 10^7 uniform float points per range :
+//   FastExp      x in [-87.33, 88.72]     2 ulp    (0 below : subnormal results are flushed)
+//   FastLog      x in (0, inf)            2 ulp
+//   FastNormPdf  x in [-4, 4]             6 ulp    (65 ulp at |x| = 13, from the rounding of x * x; 0 beyond 13.2)
+//   FastNormCdf  x in [-13.2, 13.2]       1.3e-7 absolute; relative error of the tail 7e-7 up to |x| = 4,
+//                                         6e-6 at |x| = 13 (0 or 1 beyond)
+namespace vecmath_detail {
+
+inline uint32_t AsBits(float x) { uint32_t b; std::memcpy(&b, &x, sizeof b); return b; }
+inline float AsFloat(uint32_t b) { float x; std::memcpy(&x, &b, sizeof x); return x; }
+inline float Select(bool c, float a, float b) { return c ? a : b; }
+
+constexpr float Ln2HiF = 0.693359375f;                  // 9 bit head of ln(2), n * Ln2HiF is exact
+constexpr float Ln2LoF = -2.12194440e-4f;
+constexpr float Log2eF = 1.44269504088896341f;
+constexpr float ShifterF = 12582912.0f;                 // 1.5 * 2^23
+constexpr float InvSqrt2PiF = 0.398942280401432677940f;
+
+} // namespace vecmath_detail
+
+// exp(x), 0 below -87.33 and +inf above 88.72
+inline float FastExp(float x) {
+    using namespace vecmath_detail;
+    const float xc = x < -87.33654f ? -87.33654f : (x > 88.72283f ? 88.72283f : x);
+    const float t = xc * Log2eF + ShifterF;
+    const float n = t - ShifterF;
+    const float r = (xc - n * Ln2HiF) - n * Ln2LoF;
+
+    // Taylor series to degree 7, truncation error < 2e-9 on |r| <= ln2/2
+    float p = 1.0f / 5040.0f;
+    p = p * r + 1.0f / 720.0f;
+    p = p * r + 1.0f / 120.0f;
+    p = p * r + 1.0f / 24.0f;
+    p = p * r + 1.0f / 6.0f;
+    p = p * r + 0.5f;
+    p = p * r + 1.0f;
+    p = p * r + 1.0f;
+
+    // n in [-126, 128] : 2^n as 2 * 2^(n-1) for n = 128
+    const bool top = n > 127.0f;
+    const float scale = AsFloat(((AsBits(t) - uint32_t(top)) << 23) + (uint32_t(127) << 23));
+    float y = p * scale * Select(top, 2.0f, 1.0f);
+    y = Select(x < -87.33654f, 0.0f, y);
+    y = Select(x > 88.72283f, AsFloat(0x7f800000u), y);
+    return Select(x != x, x, y);
+}
+
+// log(x), -inf at 0, NaN below 0
+inline float FastLog(float x) {
+    using namespace vecmath_detail;
+    const bool tiny = x < 1.17549435e-38f;
+    const float xs = Select(tiny, x * 16777216.0f, x);   // * 2^24
+    const uint32_t bits = AsBits(xs);
+
+    const float e0 = AsFloat(0x4b000000u | (bits >> 23)) - 8388608.0f - 127.0f;
+    float m = AsFloat((bits & 0x007fffffu) | 0x3f800000u);
+    const bool big = m > 1.41421356f;
+    m = Select(big, 0.5f * m, m);
+    const float e = e0 + Select(big, 1.0f, 0.0f) - Select(tiny, 24.0f, 0.0f);
+
+    const float f = (m - 1.0f) / (m + 1.0f);
+    const float s = f * f;
+    float p = 1.0f / 9.0f;
+    p = p * s + 1.0f / 7.0f;
+    p = p * s + 1.0f / 5.0f;
+    p = p * s + 1.0f / 3.0f;
+    const float logm = 2.0f * f + 2.0f * f * s * p;
+
+    float y = e * Ln2HiF + (logm + e * Ln2LoF);
+    y = Select(x == 0.0f, AsFloat(0xff800000u), y);
+    y = Select(x < 0.0f || x != x, AsFloat(0x7fc00000u), y);
+    return Select(x > 3.40282347e38f, x, y);
+}
+
+inline float FastNormPdf(float x) {
+    return vecmath_detail::InvSqrt2PiF * FastExp(-0.5f * x * x);
+}
+
+namespace vecmath_detail {
+
+inline float NormTail(float a) {
+    const float e = FastExp(-0.5f * a * a);
+
+    float num = 3.52624965998911e-02f;
+    num = num * a + 0.700383064443688f;
+    num = num * a + 6.37396220353165f;
+    num = num * a + 33.912866078383f;
+    num = num * a + 112.079291497871f;
+    num = num * a + 221.213596169931f;
+    num = num * a + 220.206867912376f;
+    float den = 8.83883476483184e-02f;
+    den = den * a + 1.75566716318264f;
+    den = den * a + 16.064177579207f;
+    den = den * a + 86.7807322029461f;
+    den = den * a + 296.564248779674f;
+    den = den * a + 637.333633378831f;
+    den = den * a + 793.826512519948f;
+    den = den * a + 440.413735824752f;
+    const float tailRational = e * num / den;
+
+    // 8 terms are enough at float precision for |x| >= 7.07
+    float num2 = a, den2 = 1.0f;
+    for (int k = 8; k >= 1; --k) {
+        const float next = a * num2 + k * den2;
+        den2 = num2;
+        num2 = next;
+    }
+    const float tailFraction = e * den2 / num2 * InvSqrt2PiF;
+
+    return Select(a < 7.07106781f, tailRational, tailFraction);
+}
+
+} // namespace vecmath_detail
+
+inline float FastNormCdf(float x) {
+    const float tail = vecmath_detail::NormTail(x < 0 ? -x : x);
+    return vecmath_detail::Select(x > 0, 1.0f - tail, tail);
+}
+
+inline void FastNormCdfPair(float x, float &lower, float &upper) {
+    const float tail = vecmath_detail::NormTail(x < 0 ? -x : x);
+    lower = vecmath_detail::Select(x > 0, 1.0f - tail, tail);
+    upper = vecmath_detail::Select(x > 0, tail, 1.0f - tail);
+}
+
+// Flush-to-zero and denormals-are-zero on the calling thread for the lifetime of the object (x86, no-op
+// elsewhere). Deep in the tails the float kernels round intermediate results into the subnormal range, where
+// every operation takes a microcode assist : the Greeks there are below 1e-38 and become 0 either way
+class ScopedFlushDenormals {
+public:
+#if defined(__SSE__) || defined(__x86_64__)
+    ScopedFlushDenormals() : saved_(_mm_getcsr()) { _mm_setcsr(saved_ | 0x8040); }   // FTZ | DAZ
+    ~ScopedFlushDenormals() { _mm_setcsr(saved_); }
+private:
+    unsigned saved_;
+#else
+    ScopedFlushDenormals() {}
+#endif
+    ScopedFlushDenormals(const ScopedFlushDenormals &) = delete;
+    ScopedFlushDenormals &operator=(const ScopedFlushDenormals &) = delete;
+};
+
+// Span versions : out[k] = f(x[k]) for k < n, dispatched to the best ISA of the running CPU.
+// in-place calls (out == x) are allowed
+void VecExp(const double *x, double *out, size_t n);
+void VecLog(const double *x, double *out, size_t n);
+void VecNormPdf(const double *x, double *out, size_t n);
+void VecNormCdf(const double *x, double *out, size_t n);
+
+// Name of the instruction set picked by the dispatcher ("avx512f", "avx2", "sse2" or "scalar")
+const char *VecIsaName();
+
+#endif /* VECMATH_HPP_ */
@@ -16,9 +16,9 @@ void ReadParameters(const std::string &filename, Parameters &params) {
             std::string key = line.substr(0, pos);
             std::string raw_value = line.substr(pos + 1);
 
-            // Trim whitespace
-            raw_value.erase(0, raw_value.find_first_not_of(" \t"));
-            raw_value.erase(raw_value.find_last_not_of(" \t") + 1);
+            // Trim whitespace, and the \r of a CRLF file (param.txt) read on Linux
+            raw_value.erase(0, raw_value.find_first_not_of(" \t\r"));
+            raw_value.erase(raw_value.find_last_not_of(" \t\r") + 1);
 
             if (key == "InitialStock") {
                 params.S0 = std::stod(raw_value);
@@ -38,10 +38,26 @@ void ReadParameters(const std::string &filename, Parameters &params) {
                 params.OTM = std::stod(raw_value);
             } else if (key == "NumberOfMaturities") {
                 params.numMaturities = std::stod(raw_value);
+            } else if (key == "Threads") {
+                params.numThreads = std::stoi(raw_value);
             } else if (key == "Greeks") {
-                params.greekTypes = raw_value; 
+                ParseGreeks(raw_value, params.greeks);
             } else if (key == "Options") {
-                params.optionTypes = raw_value; 
+                ParseOptions(raw_value, params.options);
+            } else if (key == "Model") {
+                ParseModel(raw_value, params.model);
+            } else if (key == "Renderer") {
+                if (raw_value == "OpenGL") params.renderer = Renderer_OpenGL;
+                else if (raw_value == "Matplot") params.renderer = Renderer_Matplot;
+                else std::cerr << "Unknown renderer: '" << raw_value << "' (OpenGL or Matplot)" << std::endl;
+            } else if (key == "Grid") {
+                ParseGridMode(raw_value, params.grid);
+            } else if (key == "TreeSteps") {
+                params.treeSteps = std::stoul(raw_value);
+            } else if (key == "ChainFile") {
+                params.chainFile = raw_value;
+            } else if (key == "GridPoints") {
+                params.gridPoints = std::stoul(raw_value);
             } else if (key == "Plots") {
                 params.plotTypes = raw_value; 
             } else {
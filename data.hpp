@@ -5,6 +5,14 @@
 #include <iostream>
 #include <string>
 #include <cmath>
+#include "GreekSet.hpp"
+
+// How the GUI draws the figures
+enum PlotRenderer : unsigned {
+    Renderer_OpenGL = 0,   // in the window, GreekRenderer.hpp
+    Renderer_Matplot,      // Matplot++ figures (gnuplot)
+};
+
 struct Parameters {
     double S0;     // Initial Stock Price
     double T;      // Time to Maturity
@@ -14,12 +22,20 @@ struct Parameters {
     double q;      // Dividend Yield
     double ITM;    // In-The-Money percentage
     double OTM;    // Out-Of-The-Money percentage
-    std::string optionTypes; // "Call" and/or "Put"
-    std::string greekTypes;  // "Delta", "Gamma", "Vega", "Theta", "Rho"
-    std::string plotTypes;  // "Simple" -> plot greek versus stock prices, "3D" -> plot greek versus stock prices and maturities, "Moneyness" -> plot greek for ITM,OTM,ATM
+    unsigned options = Option_All;    // "Call" and/or "Put", as OptionFlag bits
+    unsigned greeks = Greek_FirstOrder;   // "Delta", "Gamma", "Vega", "Theta", "Rho" ... "Zomma", as GreekFlag bits
+    PricingModel model = Model_BlackScholes;   // "BlackScholes", "Black76", "Bachelier", "AmericanCRR", "AmericanLeisenReimer" or "AmericanTrinomial"
+    size_t treeSteps = 0;             // Steps of the trees of the American models, 0 = DefaultLatticeSteps (Lattice.hpp)
+    std::string plotTypes;  // "Simple" -> plot greek versus stock prices, "3D" -> plot greek versus stock prices and maturities, "Moneyness" -> plot greek for ITM,OTM,ATM, "Chain" -> plot greek versus strikes and expiries of ChainFile
+    std::string chainFile = "../chain.csv";   // Strikes, expiries and smile of the "Chain" plot (Chain.hpp)
     double numMaturities; // Number of maturities
+    int numThreads = 0;   // Threads used by the grid computation, 0 = all cores
+    PlotRenderer renderer = Renderer_OpenGL;   // "OpenGL" or "Matplot"
+    GridMode grid = Grid_Uniform;     // "Uniform" or "Adaptive"
+    size_t gridPoints = 0;            // Adaptive grid budget in (S, T) points and probe evaluations, 0 = 64 stock prices per maturity
 };
 
+// Unknown keys and invalid Greek, option, model, renderer or grid names are reported on std::cerr and leave the default
 void ReadParameters(const std::string& filename, Parameters& params);
 
 
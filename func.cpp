@@ -1,12 +1,22 @@
 #include "func.hpp"
+#include "Chain.hpp"
 #include "Greeks.hpp"
+#include "AsyncRecompute.hpp"
+#include "SurfaceFile.hpp"
+#include "GreekRenderer.hpp"
+#include "Decimate.hpp"
+#include "Profiler.hpp"
 #include "imgui.h"
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <sstream>
 #include <algorithm>
+#include <chrono>
+#include <utility>
 #include <matplot/matplot.h>
 using namespace matplot;
 
@@ -22,59 +32,12 @@ bool find(const std::string& target, const std::string& source) {
 }
 
 
-// Helper: split comma-separated string
-std::vector<std::string> split(const std::string &s, char delimiter = ',') {
-    if (s.find(',') != std::string::npos) { 
-    std::vector<std::string> tokens;
-    std::stringstream ss(s);
-    std::string item;
-    while (std::getline(ss, item, delimiter)) {
-        if (!item.empty()) tokens.push_back(item);
-    }
-    return tokens;
-    } else {
-        return {s}; // return the whole string as a single element vector
-    }
-}
-
-
-int Recompute(double &K, double &S0, double &r, double &q, double &T, double &sigma, int numMaturities,const std::string &greekTypes, const std::string &optionTypes,
-              std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities,
-              std::vector<std::vector<std::vector<std::vector<double>>>> &GreekValues) {
-
-    StockPrices.clear();
-    TimeToMaturities.clear();
-
-
-    double S_start = 0, S_end = 2 * K, S_step = K / 100.0;
-    for (double S = S_start; S <= S_end; S += S_step)
-        StockPrices.push_back(S);
-
-    double T_start = 0.01, T_end = T, T_step = (T_end - T_start) / static_cast<double>(numMaturities);
-    for (double t = T_start; t <= T_end; t += T_step)
-        TimeToMaturities.push_back(t);
-
-    size_t countGreeks = std::count(greekTypes.begin(), greekTypes.end(), ',') + 1;
-    size_t countOptions = std::count(optionTypes.begin(), optionTypes.end(), ',') + 1;
-
-    GreekValues.resize(countGreeks,
-        std::vector<std::vector<std::vector<double>>>(countOptions,
-            std::vector<std::vector<double>>(StockPrices.size(),
-                std::vector<double>(TimeToMaturities.size()))));
-
-    if (ComputeGreek(StockPrices, TimeToMaturities, greekTypes, optionTypes, K, S0, r, q, T, sigma, GreekValues) != 0) {
-        ComputeGreek(StockPrices, TimeToMaturities, greekTypes, optionTypes, K, S0, r, q, T, sigma, GreekValues);
-        std::cerr << "Error in ComputeGreek function." << std::endl;
-        return -1;
-    }
-    return 0;
-}
-
-
-void Plot2D(double &ITM, double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma,
-            int &numMaturities, const std::string &GreekTypes, std::vector<double> &X, std::vector<double> &Y,
-            std::vector<std::vector<std::vector<std::vector<double>>>> &GreekValues,
-            const std::string &optionTypes, const std::string &plotTypes) {
+// Sliders, recompute requests and status lines shared by every plot type.
+// Returns true when a new result has been published and should be plotted
+static bool ParameterControls(double &ITM, double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma,
+                              int &numMaturities, unsigned greekSet, unsigned optionSet, PricingModel model,
+                              GridMode &gridMode, int &gridPoints, AsyncRecompute &recompute) {
+    GREEKS_PROFILE_SCOPE("ParameterControls");
 
     bool changed = false;
 
@@ -99,366 +62,587 @@ void Plot2D(double &ITM, double &OTM, double &K, double &S0, double &r, double &
     changed |= ImGui::SliderScalar("ITM (%)", ImGuiDataType_Double, &ITM, &minITM, &maxITM, "%.2f");
     changed |= ImGui::SliderScalar("OTM (%)", ImGuiDataType_Double, &OTM, &minOTM, &maxOTM, "%.2f");
 
-    bool doShow = false;
+    // adaptive grid : stock prices and maturities placed where the Greeks bend, within a point budget (0 = default)
+    bool adaptive = gridMode == Grid_Adaptive;
+    if (ImGui::Checkbox("Adaptive grid", &adaptive)) {
+        gridMode = adaptive ? Grid_Adaptive : Grid_Uniform;
+        changed = true;
+    }
+    if (adaptive) changed |= ImGui::SliderInt("Grid points", &gridPoints, 0, 20000);
 
+    const RecomputeRequest request{K, S0, r, q, T, sigma, numMaturities, greekSet, optionSet, model, gridMode, static_cast<size_t>(std::max(gridPoints, 0))};
+
+    // manual recompute
     if (ImGui::Button("Recompute Greeks")) {
-        if (Recompute(K, S0, r, q, T, sigma, numMaturities, GreekTypes, optionTypes, X, Y, GreekValues) == 0)
-            doShow = true;
+        recompute.Submit(request);
     }
 
-        static bool pending_recompute = false;
-        if (changed) {
-            pending_recompute = true;
-        }
-        if (pending_recompute && !ImGui::IsAnyItemActive()) {
-            if (Recompute(K, S0, r, q, T, sigma, numMaturities, GreekTypes, optionTypes, X, Y, GreekValues) == 0) doShow = true;
-            pending_recompute = false;
-        }
+    // automatic recompute once the slider is released, on the background worker
+    static bool pending_recompute = false;
+    if (changed) {
+        pending_recompute = true;
+    }
+    if (pending_recompute && !ImGui::IsAnyItemActive()) {
+        recompute.Submit(request);
+        pending_recompute = false;
+    }
 
     // Display current parameter values
     ImGui::Text("Current parameters:");
     ImGui::Text("S0=%.2f  K=%.2f  T=%.2f", S0, K, T);
     ImGui::Text("sigma=%.2f  r=%.2f  q=%.2f", sigma, r, q);
 
-    // Skip plotting if recomputation not requested
-    if (!doShow) return;
-
-    // plots
-    auto greeks  = split(GreekTypes);
-    auto options = split(optionTypes);
-
-    size_t gCount = greeks.size();
-    size_t oCount = options.size();
-
-    // Determine subplot layout
-    int rows = 1, cols = 1;
-    if (gCount == 1) { rows = 1; cols = 1; }
-    else if (gCount == 2) { rows = 1; cols = 2; }
-    else if (gCount == 3) { rows = 1; cols = 3; }
-    else if (gCount == 4) { rows = 2; cols = 2; }
-    else if (gCount <= 6) { rows = 2; cols = 3; }
-    else if (gCount <= 9) { rows = 3; cols = 3; }
-    else { rows = (gCount + 2) / 3; cols = 3; }
-
-    figure_handle f = figure(true);
-    f->size(1200, 800);
+    // Status of the shown result
+    const bool published = recompute.Poll();
+    if (recompute.Busy()) ImGui::Text("Computing...");
+    const double age = recompute.AgeSeconds();
+    if (age >= 0) ImGui::Text("Shown result computed %.1f s ago (%zu points updated)", age, recompute.Front().pointsComputed);
+    else ImGui::Text("No result yet");
+
+    // save the shown surface for other tools (SurfaceFile.hpp)
+    static std::string exportStatus;
+    if (age >= 0 && ImGui::Button("Export surface")) {
+        exportStatus = WriteSurface("greeks_surface.grs", recompute.Front()) == 0 ? "Written to greeks_surface.grs" : "Export failed";
+    }
+    if (!exportStatus.empty()) ImGui::Text("%s", exportStatus.c_str());
 
-    // Plot all Greeks for all option types
-    for (size_t g = 0; g < gCount; g++) {
-        auto ax = f->add_subplot(rows, cols, g + 1);
+    return published;
+}
 
-        for (size_t o = 0; o < oCount; o++) {
-            std::string call = "Call";
-            bool isCall = (find(call, options[o]));
-            std::array<float, 3> base = isCall ? std::array<float, 3>{0.f, 0.f, 1.f}  // blue
-                                               : std::array<float, 3>{1.f, 0.f, 0.f}; // red
+// Stock row nearest to S on an increasing axis (uniform or adaptive)
+static size_t NearestRow(const std::vector<double> &StockPrices, double S) {
+    const size_t i = std::lower_bound(StockPrices.begin(), StockPrices.end(), S) - StockPrices.begin();
+    if (i == 0) return 0;
+    if (i == StockPrices.size()) return i - 1;
+    return S - StockPrices[i - 1] <= StockPrices[i] - S ? i - 1 : i;
+}
 
-            ax->colororder_index(0);
-
-            for (size_t j = 1; j < Y.size(); j++) {
-                std::vector<double> Z;
-                Z.reserve(X.size());
-                for (size_t i = 0; i < X.size(); i++) {
-                    if (i < GreekValues[g][o].size() && j < GreekValues[g][o][i].size()) {
-                        Z.push_back(GreekValues[g][o][i][j]);
-                    } else {
-                        Z.push_back(0.0);
-                    }
-                }
-                // Fading colors
-                float fade = (Y.size() > 1) ?
-                                 static_cast<float>(j) / static_cast<float>(Y.size() - 1)
-                                 : 0.f;
+// Stock rows of the ITM, ATM and OTM curves : ATM is the row nearest to the strike, ITM and OTM the rows nearest
+// to K plus or minus a percentage of the half axis (above is ITM for a call, OTM for a put)
+static MoneynessRows MoneynessIndices(const std::vector<double> &StockPrices, double K, bool isCall, double ITM, double OTM) {
+    if (StockPrices.empty()) return MoneynessRows{};
+    const double step = (StockPrices.back() - StockPrices.front()) / 200.0;
+    MoneynessRows rows{};
+    rows.atm = NearestRow(StockPrices, K);
+    rows.itm = NearestRow(StockPrices, K + (isCall ? ITM : -ITM) * step);
+    rows.otm = NearestRow(StockPrices, K - (isCall ? OTM : -OTM) * step);
+    return rows;
+}
 
-                std::array<float, 3> faded_color = {
-                    base[0] - (1.f - base[0]) * fade,
-                    base[1] - (1.f - base[1]) * fade,
-                    base[2] - (1.f - base[2]) * fade
-                };
+// Native figure : bring the GPU buffers up to date (only the slices that changed are uploaded) and draw the
+// panels into the window, every frame. Labels are ImGui text over the image, the surfaces orbit with the mouse
+static void DrawNative(GreekRenderer &renderer, PlotKind kind, const GreekGrid &grid, double ITM, double OTM) {
+    if (grid.version == 0) return;
+    GREEKS_PROFILE_SCOPE("DrawNative");
+    renderer.Update(grid);
+
+    MoneynessRows rows[NumOptionKinds];
+    for (size_t o = 0; o < NumOptionKinds; ++o) rows[o] = MoneynessIndices(grid.StockPrices, grid.request.K, o == 0, ITM, OTM);
+
+    const ImVec2 avail = ImGui::GetContentRegionAvail();
+    const ImVec2 size(std::max(avail.x, 320.0f), std::max(avail.y - 2 * ImGui::GetTextLineHeightWithSpacing(), 240.0f));
+    static PlotCamera camera;
+    const unsigned texture = renderer.Draw(kind, (int)size.x, (int)size.y, camera, rows);
+    if (!texture) return;
+
+    if (kind == Plot_Surface) ImGui::Text("Drag to orbit, wheel to zoom, double-click to reset the view. Call in blue, put in red");
+    else if (kind == Plot_Curves) ImGui::Text("Call in blue, put in red, darker as T grows");
+    else ImGui::Text("ITM in the option colour, ATM in green, OTM lighter (call blue, put red)");
+    ImGui::Text("GPU: %zu slices uploaded in %.2f ms, drawn in %.2f ms", renderer.LastUploadedSlices(), renderer.LastUploadMs(), renderer.LastDrawMs());
+
+    // the texture has its origin at the bottom left corner
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::Image((ImTextureID)(intptr_t)texture, size, ImVec2(0, 1), ImVec2(1, 0));
+    if (kind == Plot_Surface && ImGui::IsItemHovered()) {
+        const ImGuiIO &io = ImGui::GetIO();
+        if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) camera.Reset();
+        else if (ImGui::IsMouseDragging(ImGuiMouseButton_Left)) camera.Orbit(io.MouseDelta.x, io.MouseDelta.y);
+        if (io.MouseWheel != 0) camera.Zoom(io.MouseWheel);
+    }
 
-                auto line = ax->plot(X, Z);
-                line->line_width(2);
-                line->color({0.5f, faded_color[0], faded_color[1], faded_color[2]});
-                std::string leg = "T=" + std::to_string(clamp(Y[j], 0.01, 99.0)) + " " + options[o];
-                line->display_name(leg);
-                ax->hold(on);
-            }
+    // panel labels, at the margins PlotTransform leaves in GreekRenderer.cpp
+    ImDrawList *draw = ImGui::GetWindowDrawList();
+    const ImU32 color = IM_COL32(220, 220, 220, 255);
+    const int axis = kind == Plot_Moneyness ? 1 : 0;
+    char text[96];
+    for (const PlotPanel &panel : renderer.Panels()) {
+        const float left = origin.x + panel.x, top = origin.y + panel.y;
+        const char *name = GreekNames[panel.greek];
+        draw->AddText(ImVec2(left + panel.width / 2 - ImGui::CalcTextSize(name).x / 2, top + 2), color, name);
+        if (kind == Plot_Surface) {
+            snprintf(text, sizeof text, "%s from %.4g to %.4g", name, panel.minValue, panel.maxValue);
+            draw->AddText(ImVec2(left + 4, top + panel.height - ImGui::GetTextLineHeight() - 2), color, text);
+            continue;
         }
-
-        ax->title(greeks[g]);
-        ax->xlabel("Stock Price (S0)");
-        ax->ylabel(greeks[g]);
-        ax->legend();
-        ax->grid(true);
+        snprintf(text, sizeof text, "%.4g", panel.maxValue);
+        draw->AddText(ImVec2(left + 0.06f * panel.width + 3, top + 0.06f * panel.height + 2), color, text);
+        snprintf(text, sizeof text, "%.4g", panel.minValue);
+        draw->AddText(ImVec2(left + 0.06f * panel.width + 3, top + 0.91f * panel.height - ImGui::GetTextLineHeight() - 2), color, text);
+        snprintf(text, sizeof text, "%s from %.4g to %.4g", axis == 0 ? "Stock Price (S0)" : "Time to Maturity (T)",
+                 renderer.AxisMin(axis), renderer.AxisMax(axis));
+        draw->AddText(ImVec2(left + 0.06f * panel.width, top + 0.91f * panel.height + 2), color, text);
     }
-
-    f->draw();
 }
 
-void Plot3D(double &ITM, double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma,
-            int &numMaturities, const std::string &GreekTypes, std::vector<double> &X, std::vector<double> &Y,
-            std::vector<std::vector<std::vector<std::vector<double>>>> &GreekValues,
-            const std::string &optionTypes, const std::string &plotTypes) {
-
-    bool changed = false;
-
-    // parameter ranges
-    double minS0 = 00.0,  maxS0 = 999.0;
-    double minK  = 00.0,  maxK  = 999.0;
-    double minT  = 0.1,   maxT  = 5.0;
-    double minR  = 0.0,   maxR  = 0.3;
-    double minSigma = 0.05, maxSigma = 1.0;
-    double minQ  = 0.0,   maxQ  = 0.3;
-    double minITM = 0.0,  maxITM = 99.0;
-    double minOTM = 0.0,  maxOTM = 99.0;
-
-    // sliders
-    changed |= ImGui::SliderScalar("S0",    ImGuiDataType_Double, &S0,    &minS0,    &maxS0,    "%.2f");
-    changed |= ImGui::SliderScalar("K",     ImGuiDataType_Double, &K,     &minK,     &maxK,     "%.2f");
-    changed |= ImGui::SliderScalar("T",     ImGuiDataType_Double, &T,     &minT,     &maxT,     "%.2f");
-    changed |= ImGui::SliderScalar("r",     ImGuiDataType_Double, &r,     &minR,     &maxR,     "%.4f");
-    changed |= ImGui::SliderScalar("sigma", ImGuiDataType_Double, &sigma, &minSigma, &maxSigma, "%.3f");
-    changed |= ImGui::SliderScalar("q",     ImGuiDataType_Double, &q,     &minQ,     &maxQ,     "%.4f");
-    changed |= ImGui::SliderInt("Number of maturities", &numMaturities, 1, 50);
-    changed |= ImGui::SliderScalar("ITM (%)", ImGuiDataType_Double, &ITM, &minITM, &maxITM, "%.2f");
-    changed |= ImGui::SliderScalar("OTM (%)", ImGuiDataType_Double, &OTM, &minOTM, &maxOTM, "%.2f");
-
-    bool doShow = false;
-
-    // manual recompute
-    if (ImGui::Button("Recompute Greeks")) {
-        if (Recompute(K, S0, r, q, T, sigma, numMaturities, GreekTypes, optionTypes, X, Y, GreekValues) == 0)
-            doShow = true;
+// Matplot++ figure kept across results : its gnuplot process, axes and line or surface handles live as long as
+// the layout (Greek and option sets, number of maturities) does not change, a new result only replaces their data.
+// Lines carry at most PanelPoints(cols) points (DecimateLttb), surfaces every `stride`-th stock price
+struct MatplotFigure {
+    figure_handle figure;
+    unsigned greeks = 0, options = 0;
+    size_t maturities = 0;
+    std::vector<axes_handle> axes;            // one per Greek
+    std::vector<line_handle> lines;           // Plot2D [greek][option][maturity], PlotMoneyness [greek][option][ITM, ATM, OTM]
+    std::vector<surface_handle> surfaces;     // [greek][option]
+    std::vector<double> meshS, meshT;         // axes of the meshgrid below
+    size_t stride = 1;
+    vector_2d meshX, meshY, meshZ;
+    std::vector<size_t> kept;                 // DecimateLttb output
+    std::vector<double> lineX, lineY;
+};
+
+static const int FigureWidth = 1200, FigureHeight = 800;
+
+// Points sent per curve : one every 2 pixels of a panel, a line can not show more
+static size_t PanelPoints(int cols) { return static_cast<size_t>(FigureWidth / cols / 2); }
+
+// Create the figure on first use or when the Greek set changes, clear its axes when the option set or the
+// number of maturities changes. Returns true when the axes are empty and their children must be created
+static bool PrepareFigure(MatplotFigure &fig, const GreekGrid &grid, bool threeD, int &cols) {
+    const unsigned greeks = grid.request.greeks & Greek_All, options = grid.request.options & Option_All;
+    const size_t gCount = CountFlags(greeks);
+    int rows = 1;
+    PlotLayout(gCount, rows, cols);
+    if (fig.figure && greeks == fig.greeks && options == fig.options && grid.TimeToMaturities.size() == fig.maturities) return false;
+
+    if (!fig.figure || greeks != fig.greeks) {
+        fig.figure = figure(true);
+        fig.figure->size(FigureWidth, FigureHeight);
+        fig.axes.clear();
+        for (size_t g = 0; g < gCount; g++) fig.axes.push_back(fig.figure->add_subplot(rows, cols, g + 1, threeD));
+    } else {
+        for (auto &ax : fig.axes) ax->clear();
     }
+    fig.greeks = greeks;
+    fig.options = options;
+    fig.maturities = grid.TimeToMaturities.size();
+    fig.lines.clear();
+    fig.surfaces.clear();
+    return true;
+}
 
-    // automatic recompute
-    static bool pending_recompute = false;
-    if (changed) {
-        pending_recompute = true;
-    }
-    if (pending_recompute && !ImGui::IsAnyItemActive()) {
-        if (Recompute(K, S0, r, q, T, sigma, numMaturities, GreekTypes, optionTypes, X, Y, GreekValues) == 0)
-            doShow = true;
-        pending_recompute = false;
+// Kept points of one S curve of `slice`, into fig.lineX / fig.lineY
+static void DecimatedCurve(MatplotFigure &fig, const std::vector<double> &X, StridedView<const double> column, size_t maxPoints) {
+    DecimateLttb(X, column, maxPoints, fig.kept);
+    fig.lineX.resize(fig.kept.size());
+    fig.lineY.resize(fig.kept.size());
+    for (size_t k = 0; k < fig.kept.size(); ++k) {
+        fig.lineX[k] = X[fig.kept[k]];
+        fig.lineY[k] = column[fig.kept[k]];
     }
+}
 
-    // parameters display
-    ImGui::Text("Current parameters:");
-    ImGui::Text("S0=%.2f  K=%.2f  T=%.2f", S0, K, T);
-    ImGui::Text("sigma=%.2f  r=%.2f  q=%.2f", sigma, r, q);
-
-    if (!doShow) return; 
+// Matplot++ surfaces of every [greek][option] slice of `grid` over its two axes, into `fig`
+static void MatplotSurfaces(MatplotFigure &fig, const GreekGrid &grid, const char *xLabel, const char *yLabel) {
+    const std::vector<double> &X = grid.StockPrices;
+    const std::vector<double> &Y = grid.TimeToMaturities;
+    const GreekTensor &GreekValues = grid.GreekValues;
 
     // plot section
-    auto greeks  = split(GreekTypes);
-    auto options = split(optionTypes);
+    // slice names of the shown result, in the order its tensor holds them
+    auto greeks  = GreekList(grid.request.greeks);
+    auto options = OptionList(grid.request.options);
 
     size_t gCount = greeks.size();
     size_t oCount = options.size();
 
-    // Determine subplot layout
-    int rows = 1, cols = 1;
-    if (gCount == 1) { rows = 1; cols = 1; }
-    else if (gCount == 2) { rows = 1; cols = 2; }
-    else if (gCount == 3) { rows = 1; cols = 3; }
-    else if (gCount == 4) { rows = 2; cols = 2; }
-    else if (gCount <= 6) { rows = 2; cols = 3; }
-    else if (gCount <= 9) { rows = 3; cols = 3; }
-    else { rows = (gCount + 2) / 3; cols = 3; }
-
-    figure_handle f = figure(true);
-    f->size(1200, 800);
+    int cols = 1;
+    const bool create = PrepareFigure(fig, grid, true, cols);
+
+    // meshgrid X,Y, built once per axes : every stride-th stock price (and the last), a quad every 4 pixels at most
+    if (X != fig.meshS || Y != fig.meshT) {
+        GREEKS_PROFILE_SCOPE("Meshgrid");
+        fig.meshS = X;
+        fig.meshT = Y;
+        fig.stride = std::max<size_t>(1, (X.size() * 4 + FigureWidth / cols - 1) / (FigureWidth / cols));
+        const size_t rowsKept = (X.size() + fig.stride - 2) / fig.stride + 1;
+        fig.meshX.assign(rowsKept, std::vector<double>(Y.size()));
+        fig.meshY.assign(rowsKept, std::vector<double>(Y.size()));
+        fig.meshZ.assign(rowsKept, std::vector<double>(Y.size()));
+        for (size_t k = 0; k < rowsKept; k++) {
+            const size_t i = std::min(k * fig.stride, X.size() - 1);
+            for (size_t j = 0; j < Y.size(); j++) {
+                fig.meshX[k][j] = X[i];
+                fig.meshY[k][j] = Y[j];
+            }
+        }
+    }
 
     // Greek and options loops
+    size_t n = 0;
     for (size_t g = 0; g < gCount; g++) {
-        auto ax = f->add_subplot(rows, cols, g + 1, true);
-        ax->hold(on);
+        GREEKS_PROFILE_SCOPE("SurfaceData");
+        auto ax = fig.axes[g];
+        if (create) ax->hold(on);
 
-        for (size_t o = 0; o < oCount; o++) {
-            std::string call = "Call";
-            bool isCall = (find(call, options[o]));
-            std::array<float,3> base = isCall ? std::array<float,3>{0.f,0.f,1.f}  // blue
-                                              : std::array<float,3>{1.f,0.f,0.f}; // red
+        for (size_t o = 0; o < oCount; o++, n++) {
+            const bool inTensor = g < GreekValues.NumGreeks() && o < GreekValues.NumOptions();
+            const SliceView<const double> slice = std::as_const(GreekValues).Slice(g, o);
 
-            // meshgird X,Y
-            std::vector<std::vector<double>> x(X.size(), std::vector<double>(Y.size()));
-            std::vector<std::vector<double>> y(X.size(), std::vector<double>(Y.size()));
-            std::vector<std::vector<double>> z(X.size(), std::vector<double>(Y.size()));
-
-            for (size_t i = 0; i < X.size(); i++) {
+            for (size_t k = 0; k < fig.meshZ.size(); k++) {
+                const size_t i = std::min(k * fig.stride, X.size() - 1);
                 for (size_t j = 0; j < Y.size(); j++) {
-                    x[i][j] = X[i];
-                    y[i][j] = Y[j];
-                    if (i < GreekValues[g][o].size() && j < GreekValues[g][o][i].size())
-                        z[i][j] = GreekValues[g][o][i][j];
+                    if (inTensor && i < slice.rows && j < slice.cols)
+                        fig.meshZ[k][j] = slice(i, j);
                     else
-                        z[i][j] = 0.0;
+                        fig.meshZ[k][j] = 0.0;
                 }
             }
 
+            if (!create) {
+                fig.surfaces[n]->x_data(fig.meshX);
+                fig.surfaces[n]->y_data(fig.meshY);
+                fig.surfaces[n]->z_data(fig.meshZ);
+                continue;
+            }
+
             // plot surface
-            auto s = ax->surf(x, y, z);
+            auto s = ax->surf(fig.meshX, fig.meshY, fig.meshZ);
             s->edge_color("none"); 
             s->face_alpha(0.8);
-            //s->color({base[0], base[1], base[2]});
+            fig.surfaces.push_back(s);
         }
 
-        ax->xlabel("Stock Price (S0)");
-        ax->ylabel("Time to Maturity (T)");
+        if (!create) continue;
+        ax->xlabel(xLabel);
+        ax->ylabel(yLabel);
         ax->zlabel(greeks[g]);
         ax->title(greeks[g]);
         ax->grid(true);
     }
 
-    f->draw();
+    {
+        GREEKS_PROFILE_SCOPE("FigureDraw");   // Matplot++ hands the figure to gnuplot and waits for it
+        fig.figure->draw();
+    }
 }
 
+void Plot2D(double &ITM, double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma,
+            int &numMaturities, unsigned greekSet, AsyncRecompute &recompute,
+            unsigned optionSet, PricingModel model, GridMode &gridMode, int &gridPoints, const std::string &plotTypes, GreekRenderer *renderer) {
+    GREEKS_PROFILE_SCOPE("Plot2D");
+
+    const bool published = ParameterControls(ITM, OTM, K, S0, r, q, T, sigma, numMaturities, greekSet, optionSet, model, gridMode, gridPoints, recompute);
+    if (renderer) {
+        DrawNative(*renderer, Plot_Curves, recompute.Front(), ITM, OTM);
+        return;
+    }
 
-void PlotMoneyness(double &ITM, double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma,
-                   int &numMaturities, const std::string &GreekTypes, std::vector<double> &X, std::vector<double> &Y,
-                   std::vector<std::vector<std::vector<std::vector<double>>>> &GreekValues,
-                   const std::string &optionTypes, const std::string &plotTypes) {
+    // Matplot++ : plot only when a new result has been published
+    if (!published) return;
 
-    bool changed = false;
+    const GreekGrid &grid = recompute.Front();
+    const std::vector<double> &X = grid.StockPrices;
+    const std::vector<double> &Y = grid.TimeToMaturities;
+    const GreekTensor &GreekValues = grid.GreekValues;
 
-    // parameter ranges
-    double minS0 = 00.0,  maxS0 = 999.0;
-    double minK  = 00.0,  maxK  = 999.0;
-    double minT  = 0.1,   maxT  = 5.0;
-    double minR  = 0.0,   maxR  = 0.3;
-    double minSigma = 0.05, maxSigma = 1.0;
-    double minQ  = 0.0,   maxQ  = 0.3;
-    double minITM = 0.0,  maxITM = 99.0;
-    double minOTM = 0.0,  maxOTM = 99.0;
+    // plots
+    // slice names of the shown result, in the order its tensor holds them
+    auto greeks  = GreekList(grid.request.greeks);
+    auto options = OptionList(grid.request.options);
 
-    // sliders
-    changed |= ImGui::SliderScalar("S0",    ImGuiDataType_Double, &S0,    &minS0,    &maxS0,    "%.2f");
-    changed |= ImGui::SliderScalar("K",     ImGuiDataType_Double, &K,     &minK,     &maxK,     "%.2f");
-    changed |= ImGui::SliderScalar("T",     ImGuiDataType_Double, &T,     &minT,     &maxT,     "%.2f");
-    changed |= ImGui::SliderScalar("r",     ImGuiDataType_Double, &r,     &minR,     &maxR,     "%.4f");
-    changed |= ImGui::SliderScalar("sigma", ImGuiDataType_Double, &sigma, &minSigma, &maxSigma, "%.3f");
-    changed |= ImGui::SliderScalar("q",     ImGuiDataType_Double, &q,     &minQ,     &maxQ,     "%.4f");
-    changed |= ImGui::SliderInt("Number of maturities", &numMaturities, 1, 50);
-    changed |= ImGui::SliderScalar("ITM (%)", ImGuiDataType_Double, &ITM, &minITM, &maxITM, "%.2f");
-    changed |= ImGui::SliderScalar("OTM (%)", ImGuiDataType_Double, &OTM, &minOTM, &maxOTM, "%.2f");
+    size_t gCount = greeks.size();
+    size_t oCount = options.size();
 
-    bool doShow = false;
+    static MatplotFigure fig;
+    int cols = 1;
+    const bool create = PrepareFigure(fig, grid, false, cols);
+    const size_t maxPoints = PanelPoints(cols);
+    const std::vector<double> zeros(X.size(), 0.0);
+    size_t n = 0;
 
-    // manual recompute
-    if (ImGui::Button("Recompute Greeks")) {
-        if (Recompute(K, S0, r, q, T, sigma, numMaturities, GreekTypes, optionTypes, X, Y, GreekValues) == 0)
-            doShow = true;
+    // Plot all Greeks for all option types
+    for (size_t g = 0; g < gCount; g++) {
+        auto ax = fig.axes[g];
+
+        for (size_t o = 0; o < oCount; o++) {
+            std::string call = "Call";
+            bool isCall = (find(call, options[o]));
+            std::array<float, 3> base = isCall ? std::array<float, 3>{0.f, 0.f, 1.f}  // blue
+                                               : std::array<float, 3>{1.f, 0.f, 0.f}; // red
+
+            if (create) ax->colororder_index(0);
+
+            const bool inTensor = g < GreekValues.NumGreeks() && o < GreekValues.NumOptions();
+            const SliceView<const double> slice = std::as_const(GreekValues).Slice(g, o);
+
+            for (size_t j = 1; j < Y.size(); j++, n++) {
+                const StridedView<const double> column = inTensor && j < slice.cols ? slice.AlongS(j)
+                                                                                    : StridedView<const double>{zeros.data(), zeros.size(), 1};
+                DecimatedCurve(fig, X, column, maxPoints);
+                // the maturities change with T and with the adaptive axis, so do the names
+                const std::string leg = "T=" + std::to_string(clamp(Y[j], 0.01, 99.0)) + " " + options[o];
+                if (!create) {
+                    fig.lines[n]->x_data(fig.lineX);
+                    fig.lines[n]->y_data(fig.lineY);
+                    fig.lines[n]->display_name(leg);
+                    continue;
+                }
+
+                // Fading colors
+                float fade = (Y.size() > 1) ?
+                                 static_cast<float>(j) / static_cast<float>(Y.size() - 1)
+                                 : 0.f;
+
+                std::array<float, 3> faded_color = {
+                    base[0] - (1.f - base[0]) * fade,
+                    base[1] - (1.f - base[1]) * fade,
+                    base[2] - (1.f - base[2]) * fade
+                };
+
+                auto line = ax->plot(fig.lineX, fig.lineY);
+                line->line_width(2);
+                line->color({0.5f, faded_color[0], faded_color[1], faded_color[2]});
+                line->display_name(leg);
+                ax->hold(on);
+                fig.lines.push_back(line);
+            }
+        }
+        ax->legend();   // rebuilt from the names of the lines
+
+        if (!create) continue;
+        ax->title(greeks[g]);
+        ax->xlabel("Stock Price (S0)");
+        ax->ylabel(greeks[g]);
+        ax->grid(true);
     }
 
-    // automatic recompute
-    static bool pending_recompute = false;
-    if (changed) {
-        pending_recompute = true;
+    {
+        GREEKS_PROFILE_SCOPE("FigureDraw");   // Matplot++ hands the figure to gnuplot and waits for it
+        fig.figure->draw();
     }
-    if (pending_recompute && !ImGui::IsAnyItemActive()) {
-        if (Recompute(K, S0, r, q, T, sigma, numMaturities, GreekTypes, optionTypes, X, Y, GreekValues) == 0)
-            doShow = true;
-        pending_recompute = false;
+}
+
+void Plot3D(double &ITM, double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma,
+            int &numMaturities, unsigned greekSet, AsyncRecompute &recompute,
+            unsigned optionSet, PricingModel model, GridMode &gridMode, int &gridPoints, const std::string &plotTypes, GreekRenderer *renderer) {
+    GREEKS_PROFILE_SCOPE("Plot3D");
+
+    const bool published = ParameterControls(ITM, OTM, K, S0, r, q, T, sigma, numMaturities, greekSet, optionSet, model, gridMode, gridPoints, recompute);
+    if (renderer) {
+        DrawNative(*renderer, Plot_Surface, recompute.Front(), ITM, OTM);
+        return;
     }
 
-    // Display parameters values
-    ImGui::Text("Current parameters:");
-    ImGui::Text("S0=%.2f  K=%.2f  T=%.2f", S0, K, T);
-    ImGui::Text("sigma=%.2f  r=%.2f  q=%.2f", sigma, r, q);
+    // Matplot++ : plot only when a new result has been published
+    if (!published) return;
+    static MatplotFigure fig;
+    MatplotSurfaces(fig, recompute.Front(), "Stock Price (S0)", "Time to Maturity (T)");
+}
 
-    if (!doShow) return; 
+
+void PlotMoneyness(double &ITM, double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma,
+                   int &numMaturities, unsigned greekSet, AsyncRecompute &recompute,
+                   unsigned optionSet, PricingModel model, GridMode &gridMode, int &gridPoints, const std::string &plotTypes, GreekRenderer *renderer) {
+    GREEKS_PROFILE_SCOPE("PlotMoneyness");
+
+    const bool published = ParameterControls(ITM, OTM, K, S0, r, q, T, sigma, numMaturities, greekSet, optionSet, model, gridMode, gridPoints, recompute);
+    if (renderer) {
+        DrawNative(*renderer, Plot_Moneyness, recompute.Front(), ITM, OTM);
+        return;
+    }
+
+    // Matplot++ : plot only when a new result has been published
+    if (!published) return;
+
+    const GreekGrid &grid = recompute.Front();
+    const std::vector<double> &X = grid.StockPrices;
+    const std::vector<double> &Y = grid.TimeToMaturities;
+    const GreekTensor &GreekValues = grid.GreekValues;
 
     //Plots
-    auto greeks  = split(GreekTypes);
-    auto options = split(optionTypes);
-    // print options
-    if (options.size()==1){std::string opt = options[0];}
+    // slice names of the shown result, in the order its tensor holds them
+    auto greeks  = GreekList(grid.request.greeks);
+    auto options = OptionList(grid.request.options);
 
     size_t gCount = greeks.size();
     size_t oCount = options.size();
 
-    // Subplot layout
-    int rows = 1, cols = 1;
-    if (gCount == 1) { rows = 1; cols = 1; }
-    else if (gCount == 2) { rows = 1; cols = 2; }
-    else if (gCount == 3) { rows = 1; cols = 3; }
-    else if (gCount == 4) { rows = 2; cols = 2; }
-    else if (gCount <= 6) { rows = 2; cols = 3; }
-    else if (gCount <= 9) { rows = 3; cols = 3; }
-    else { rows = (gCount + 2) / 3; cols = 3; }
-
-    figure_handle f = figure(true);
-    f->size(1200, 800);
+    static MatplotFigure fig;
+    int cols = 1;
+    const bool create = PrepareFigure(fig, grid, false, cols);
+    size_t n = 0;
 
     // Greek loop
     for (size_t g = 0; g < gCount; g++) {
-        auto ax = f->add_subplot(rows, cols, g + 1);
-        ax->hold(on);
+        auto ax = fig.axes[g];
+        if (create) ax->hold(on);
+        std::vector<std::string> legends;
 
         for (size_t o = 0; o < oCount; o++) {
             std::string call = "Call";
-            std::string opt;
-            if (options.size()==1){opt = options[0];}
-            else {opt = options[o];}
-            //opt = "Call"; // temporary force Call option for testing
             bool isCall = (find(call, options[o])); // true if Call option
             std::array<float, 3> base = isCall ? std::array<float, 3>{0.f, 0.f, 1.f}  // blue
                                                : std::array<float, 3>{1.f, 0.f, 0.f}; // red
 
             // Compute approximate index for moneyness
-            int idxATM = (int)std::round((X.size() - 1) / 2.0); // middle index = ATM
-            int idxITM = idxATM;
-            int idxOTM = idxATM;
-
-            // Adjust for ITM / OTM relative to ATM
-            double step = (X.size() - 1) / 100.0;
-            if (isCall) {
-                idxITM = clamp((int)(idxATM + ITM * step), 0, (int)X.size() - 1);
-                idxOTM = clamp((int)(idxATM - OTM * step), 0, (int)X.size() - 1);
-            } else {
-                idxITM = clamp((int)(idxATM - ITM * step), 0, (int)X.size() - 1);
-                idxOTM = clamp((int)(idxATM + OTM * step), 0, (int)X.size() - 1);
-            }
+            const MoneynessRows picks = MoneynessIndices(X, grid.request.K, isCall, ITM, OTM);
+            const size_t idxATM = picks.atm, idxITM = picks.itm, idxOTM = picks.otm;
 
             // Extract Greek values
+            const SliceView<const double> slice = std::as_const(GreekValues).Slice(g, o);
             std::vector<double> GreekITM(Y.size()), GreekOTM(Y.size()), GreekATM(Y.size());
             for (size_t j = 0; j < Y.size(); ++j) {
-                GreekITM[j] = GreekValues[g][o][idxITM][j];
-                GreekOTM[j] = GreekValues[g][o][idxOTM][j];
-                GreekATM[j] = GreekValues[g][o][idxATM][j];
+                GreekITM[j] = slice(idxITM, j);
+                GreekOTM[j] = slice(idxOTM, j);
+                GreekATM[j] = slice(idxATM, j);
             }
 
-            // Plot curves
-            std::vector<std::string> legends;
-            legends.reserve(3);
-            auto l1 = ax->plot(Y, GreekITM);
+            // Plot curves (ITM and OTM change with the sliders, so do their names)
             std::string name1 = "ITM (" + std::to_string((int)ITM) + "%)-" + std::string(isCall ? " Call" : " Put");
+            std::string name2 = "ATM-" + std::string(isCall ? " Call" : " Put");
+            std::string name3 = "OTM (" + std::to_string((int)OTM) + "%)-" + std::string(isCall ? " Call" : " Put");
+            legends.insert(legends.end(), {name1, name2, name3});
+            if (!create) {
+                fig.lines[n]->x_data(Y);     fig.lines[n]->y_data(GreekITM);     fig.lines[n]->display_name(name1);
+                fig.lines[n + 1]->x_data(Y); fig.lines[n + 1]->y_data(GreekATM);
+                fig.lines[n + 2]->x_data(Y); fig.lines[n + 2]->y_data(GreekOTM); fig.lines[n + 2]->display_name("OTM (" + std::to_string((int)OTM) + "%)");
+                n += 3;
+                continue;
+            }
+
+            auto l1 = ax->plot(Y, GreekITM);
             l1->line_width(2); l1->color(base); l1->display_name(name1  );
-            legends.push_back(name1);
-            //l1->legend_string("ITM (" + std::to_string((int)ITM) + "%)-" + std::string(isCall ? " Call" : " Put"));
 
             auto l2 = ax->plot(Y, GreekATM);
-            std::string name2 = "ATM-" + std::string(isCall ? " Call" : " Put");
-            legends.push_back(name2);
             l2->line_width(2); l2->color({0.3f, 0.8f, 0.3f}); l2->display_name("ATM");
-            //l2->legend_string("ATM-" + std::string(isCall ? " Call" : " Put"));
 
             auto l3 = ax->plot(Y, GreekOTM);
-            std::string name3 = "OTM (" + std::to_string((int)OTM) + "%)-" + std::string(isCall ? " Call" : " Put");
-            legends.push_back(name3);
             l3->line_width(2); l3->color(base); l3->display_name("OTM (" + std::to_string((int)OTM) + "%)");
-            //l3->legend_string("OTM (" + std::to_string((int)OTM) + "%)-" + std::string(isCall ? " Call" : " Put"));
-            //ax->hold(on);
-            ax->legend(legends);
-            //ax->legend();
+            fig.lines.insert(fig.lines.end(), {l1, l2, l3});
+            n += 3;
         }
+        ax->legend(legends);
 
+        if (!create) continue;
         ax->xlabel("Time to Maturity");
         ax->ylabel("Greek Value");
         ax->title(greeks[g]);
-        //ax->legend();
         ax->grid(true);
     }
 
-    f->draw();
+    {
+        GREEKS_PROFILE_SCOPE("FigureDraw");   // Matplot++ hands the figure to gnuplot and waits for it
+        fig.figure->draw();
+    }
+}
+
+void PlotChain(double &S0, double &r, double &q, unsigned greekSet, unsigned optionSet, PricingModel model, OptionChain &chain,
+               GreekRenderer *renderer) {
+    GREEKS_PROFILE_SCOPE("PlotChain");
+
+    double minS0 = 0.0, maxS0 = 999.0;
+    double minR  = 0.0, maxR  = 0.3;
+    double minQ  = 0.0, maxQ  = 0.3;
+    bool changed = false;
+    changed |= ImGui::SliderScalar("S0", ImGuiDataType_Double, &S0, &minS0, &maxS0, "%.2f");
+    changed |= ImGui::SliderScalar("r",  ImGuiDataType_Double, &r,  &minR,  &maxR,  "%.4f");
+    changed |= ImGui::SliderScalar("q",  ImGuiDataType_Double, &q,  &minQ,  &maxQ,  "%.4f");
+
+    // on the GUI thread, every frame a slider moves : the whole chain costs well under a frame
+    static GreekGrid grid;
+    static bool first = true, figurePending = false;
+    static double computeMs = 0;
+    if (changed || first) {
+        first = false;
+        const auto start = std::chrono::steady_clock::now();
+        if (chain.Compute(S0, r, q, greekSet, optionSet, model, grid.GreekValues) == 0) {
+            grid.StockPrices = chain.Strikes();
+            grid.TimeToMaturities = chain.Expiries();
+            grid.request = {S0, S0, r, q, chain.Expiries().back(), 0, static_cast<int>(chain.Expiries().size()), greekSet & Greek_All,
+                            optionSet & Option_All, model};
+            grid.computedAt = std::chrono::steady_clock::now();
+            grid.pointsComputed = chain.size();
+            ++grid.version;
+            figurePending = true;
+        }
+        computeMs = std::chrono::duration<double, std::milli>(grid.computedAt - start).count();
+    }
+    if (grid.version == 0) {
+        ImGui::Text("No result : see the console");
+        return;
+    }
+    ImGui::Text("%zu strikes from %.4g to %.4g x %zu expiries from %.4g to %.4g, computed in %.3f ms", chain.Strikes().size(),
+                chain.Strikes().front(), chain.Strikes().back(), chain.Expiries().size(), chain.Expiries().front(), chain.Expiries().back(),
+                computeMs);
+
+    if (renderer) {
+        DrawNative(*renderer, Plot_Surface, grid, 0, 0);
+        return;
+    }
+
+    // Matplot++ : gnuplot is too slow to follow a slider, the figure is drawn once it is released
+    if (!figurePending || ImGui::IsAnyItemActive()) return;
+    figurePending = false;
+    static MatplotFigure fig;
+    MatplotSurfaces(fig, grid, "Strike (K)", "Expiry (T)");
+}
+
+void ProfilerPanel() {
+    Profiler &profiler = GlobalProfiler();
+    ImGui::SetNextWindowPos(ImVec2(860, 20), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(400, 560), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler");
+#if !GREEKS_PROFILE
+    ImGui::Text("Built with GREEKS_PROFILE=OFF : nothing is recorded.");
+#endif
+    bool recording = profiler.Recording();
+    if (ImGui::Checkbox("Record", &recording)) profiler.SetRecording(recording);
+
+    // the last HistoryFrames frames, oldest first, of one quantity; returns its mean and max
+    constexpr int HistoryFrames = 240;
+    static float history[HistoryFrames];
+    const int frames = static_cast<int>(std::min<size_t>(profiler.NumFrames(), HistoryFrames));
+    float mean = 0, max = 0;
+    auto fill = [&](auto value) {
+        mean = max = 0;
+        for (int k = 0; k < frames; ++k) {
+            history[k] = static_cast<float>(value(profiler.Frame(frames - 1 - k)));
+            mean += history[k];
+            max = std::max(max, history[k]);
+        }
+        if (frames) mean /= frames;
+    };
+
+    if (frames > 0) {
+        fill([](const ProfileFrame &f) { return f.Ms(); });
+        ImGui::Text("Frame %.2f ms  mean %.2f  max %.2f", history[frames - 1], mean, max);
+        ImGui::PlotHistogram("##frame", history, frames, 0, nullptr, 0.0f, max, ImVec2(-1, 60));
+
+        for (unsigned c = 0; c < NumProfileCounters; ++c) {
+            fill([c](const ProfileFrame &f) { return f.counters[c]; });
+            ImGui::Text("%s per frame : %.0f  mean %.0f  max %.0f", ProfileCounterNames[c], history[frames - 1], mean, max);
+            ImGui::PushID(static_cast<int>(c));
+            ImGui::PlotLines("##counter", history, frames, 0, nullptr, 0.0f, max, ImVec2(-1, 40));
+            ImGui::PopID();
+        }
+
+        // inclusive time per scope; scopes of the worker threads land in the frame they end in
+        ImGui::Separator();
+        for (size_t id = 0; id < profiler.NumScopes(); ++id) {
+            fill([id](const ProfileFrame &f) { return f.scopeMs[id]; });
+            ImGui::Text("%-20s %8.3f ms  mean %.3f  max %.3f", profiler.ScopeName(id), history[frames - 1], mean, max);
+            ImGui::PushID(static_cast<int>(NumProfileCounters + id));
+            ImGui::PlotHistogram("##scope", history, frames, 0, nullptr, 0.0f, max, ImVec2(-1, 30));
+            ImGui::PopID();
+        }
+    }
+
+    // offline analysis of slow sessions : open in chrome://tracing or ui.perfetto.dev
+    static std::string traceStatus;
+    if (ImGui::Button("Export Chrome trace")) {
+        traceStatus = profiler.WriteChromeTrace("greeks_trace.json") == 0 ? "Written to greeks_trace.json" : "Export failed";
+    }
+    if (!traceStatus.empty()) ImGui::Text("%s", traceStatus.c_str());
+    ImGui::End();
 }
@@ -7,19 +7,24 @@
 #include <string>
 #include <matplot/matplot.h>
 #include "data.hpp"
+#include "grid.hpp"
 #include <cstdlib>
 
+class AsyncRecompute;
+class GreekRenderer;
+class OptionChain;
 
-double Price(double &K, double &S, double &r, double &T, double &sigma);
-
-// Recompute GreekValues and X/Y grids from parameters
-int Recompute(double &K, double &S0, double &r, double &q, double &T, double &sigma, int numMaturities,const std::string &greekTypes, const std::string &optionTypes,
-              std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities,
-              std::vector<std::vector<std::vector<std::vector<double>>>> &GreekValues);
-
-// Plot functions 
-void Plot2D(double &ITM,double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma, int &numMaturities,const std::string &GreekTypes,std::vector<double> &X,std::vector<double> &Y,std::vector<std::vector<std::vector<std::vector<double>>>> &GreekValues,const std::string &optionTypes, const std::string &plotTypes);
-void Plot3D(double &ITM,double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma, int &numMaturities,const std::string &GreekTypes,std::vector<double> &X,std::vector<double> &Y,std::vector<std::vector<std::vector<std::vector<double>>>> &GreekValues,const std::string &optionTypes, const std::string &plotTypes);
+// Plot functions : sliders submit recomputes to `recompute`, figures are drawn from its latest published result.
+// With a `renderer` (GreekRenderer.hpp) the figure is drawn in the window every frame, without one a Matplot++ figure
+// is opened on each new result
+void Plot2D(double &ITM,double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma, int &numMaturities, unsigned greekSet,AsyncRecompute &recompute, unsigned optionSet, PricingModel model, GridMode &gridMode, int &gridPoints, const std::string &plotTypes, GreekRenderer *renderer = nullptr);
+void Plot3D(double &ITM,double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma, int &numMaturities, unsigned greekSet,AsyncRecompute &recompute, unsigned optionSet, PricingModel model, GridMode &gridMode, int &gridPoints, const std::string &plotTypes, GreekRenderer *renderer = nullptr);
 // Plot Greeks vs Moneyness for ITM and OTM options -> ITM and OTM are percentages of the strike price and must be integer between 0 and 100
-void PlotMoneyness(double &ITM,double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma, int &numMaturities,const std::string &GreekTypes,std::vector<double> &X,std::vector<double> &Y,std::vector<std::vector<std::vector<std::vector<double>>>> &GreekValues,const std::string &optionTypes, const std::string &plotTypes);
+void PlotMoneyness(double &ITM,double &OTM, double &K, double &S0, double &r, double &q, double &T, double &sigma, int &numMaturities, unsigned greekSet,AsyncRecompute &recompute, unsigned optionSet, PricingModel model, GridMode &gridMode, int &gridPoints, const std::string &plotTypes, GreekRenderer *renderer = nullptr);
+// Greeks of every contract of an option chain (Chain.hpp) over strike x expiry, each at the vol of its smile. The chain
+// is recomputed on the GUI thread whenever S0, r or q moves
+void PlotChain(double &S0, double &r, double &q, unsigned greekSet, unsigned optionSet, PricingModel model, OptionChain &chain, GreekRenderer *renderer = nullptr);
+// "Profiler" window (Profiler.hpp) : rolling histograms of the frame time, the counters and every scope,
+// and the export of a Chrome trace. Draw it once per frame, before GREEKS_PROFILE_FRAME()
+void ProfilerPanel();
 #endif /* FUNC_HPP_ */
\ No newline at end of file
@@ -0,0 +1,1343 @@
+// Benchmark suite of the Greeks engine, results written as JSON to track regressions between versions.
+//
+//   functions : throughput of the scalar reference functions (norm_cdf, d1, Delta ...) and of the fused kernels
+//   grids     : ComputeGreek over custom grids (200x30 up to 10000x1000) and Recompute over the GUI grid,
+//               for several Greek / option / model combinations
+//   books     : synthetic option books priced end to end with ComputeBatch, for every thread count
+//   implied_vols : implied volatilities of the same books recovered from their prices, for every thread count
+//   approximations : GreekApprox tables of each Greek they offer for a call against FusedGreeksBatch and the scalar function
+//                    they replace
+//   precision : float and mixed precision grids of every model, timed against the double grid (their accuracy is
+//               asserted by the precision test of greeks_tests)
+//   decimation : LTTB decimation of Greek curves (GUI axis and a dense one) to the point budgets of the Matplot++ panels
+//   adaptive : uniform and adaptive GUI grids, interpolated against the exact Greeks on a dense grid
+//   aad : prices and first order sensitivities from one AAD backward sweep, timed against one price and the analytic
+//         kernels (their accuracy is asserted by the aad test of greeks_tests)
+//   monte_carlo : simulated Greeks of European (against the analytic ones) and Asian options, variance reduction,
+//                 Philox against Sobol, thread counts
+//   higher_order : Vanna ... Zomma of every model against finite differences of the first order Greeks, and the
+//                  cost of a grid from Delta alone to all eleven Greeks
+//   profiler : cost of a recorded and of a paused scope, of a counter, of closing a frame and of the Chrome trace
+//              export, and the GUI grid with recording on and off
+//   streaming : tick replay into a book of 100 underlyings, as fast as possible and at a recorded pace, against
+//               repricing the whole book on every tick
+//   scenarios : books under a 41 spot x 21 vol x 5 rate shock lattice in one RunScenarios pass, against repricing
+//               every scenario option by option with FusedGreeks, for every thread count
+//   lattice : American trees (CRR, Leisen-Reimer, trinomial) against the closed form on calls without dividends and
+//             against a 6401-step tree on a put, cost per node, per option and of the GUI grid, books for every thread count
+//   chain : a 500 strike x 40 expiry chain on a smile, every Greek of every contract against FusedGreeks at its vol,
+//           from Delta alone to all eleven Greeks, against ComputeBatch on the same contracts, for every thread count
+//
+// Every entry reports, per JSON section :
+//   functions, grids, books : ns per option (grid point or contract), options/sec per core, heap allocations per call
+//   implied_vols : ns per inversion, options not solved, worst relative vol error where the price resolves the vol
+//   approximations : build time, cells, memory, worst error, ns per lookup against the exact function and FusedGreeksBatch
+//   precision : ns per option and tensor size
+//   decimation : points kept, largest distance to the full curve (fraction of its height), ns per input point
+//   adaptive : grid points, budget, build time, worst and rms interpolation error per Greek (fraction of its range)
+//   aad : ns per option against one price and the analytic Greeks, tape nodes
+//   monte_carlo : ns per path, per Greek the estimate, its standard error and its distance to the analytic value
+//   higher_order : worst error per Greek (fraction of its largest value), ns per option against Delta alone
+//   profiler : ns per operation (per event for the export), ns per option of the GUI grid
+//   streaming : options repriced per tick, ticks per second, p50 / p99 / p99.9 / max tick to Greek latency
+//   scenarios : ms per lattice, ns per option and scenario, speedup and worst P&L and Delta error against repricing
+//   lattice : worst error per Greek or put price error, ns per node, us per option, ms per grid or book
+//   chain : ms per chain, ns per contract, speedup over ComputeBatch, worst error per Greek
+// Times are the median of the calls made in --min-time; book speedups are against the scalar functions and the
+// first thread count.
+//
+// Usage : greeks_bench [--out file.json] [--quick] [--min-time seconds] [--threads 1,2,4] [--max-mb N]
+#include "Aad.hpp"
+#include "Chain.hpp"
+#include "Decimate.hpp"
+#include "GreekApprox.hpp"
+#include "Greeks.hpp"
+#include "ImpliedVol.hpp"
+#include "Lattice.hpp"
+#include "MonteCarlo.hpp"
+#include "Profiler.hpp"
+#include "Scenario.hpp"
+#include "ThreadPool.hpp"
+#include "TickReplay.hpp"
+#include "VecMath.hpp"
+#include "grid.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef GREEKS_VERSION
+#define GREEKS_VERSION "unknown"
+#endif
+
+namespace {
+
+struct Options {
+    std::string output = "greeks_bench.json";
+    bool quick = false;
+    double minTime = 0.5;           // seconds spent measuring each entry
+    std::vector<size_t> threads;    // thread counts of the scaling runs
+    double maxMegabytes = 512;      // grids whose tensor is larger are skipped
+};
+
+struct Timing {
+    double seconds;           // median duration of one call
+    double allocsPerCall;
+    size_t calls;
+};
+
+// Call f() (after one warm-up call) until minTime has elapsed, at least 3 times
+template <class F>
+Timing Measure(F &&f, double minTime) {
+    using Clock = std::chrono::steady_clock;
+    f();
+    std::vector<double> durations;
+    unsigned long long allocs = 0;
+    const Clock::time_point start = Clock::now();
+    do {
+        const uint64_t allocs0 = Profiler::Total(Counter_Allocations);
+        const Clock::time_point t0 = Clock::now();
+        f();
+        const Clock::time_point t1 = Clock::now();
+        allocs += Profiler::Total(Counter_Allocations) - allocs0;
+        durations.push_back(std::chrono::duration<double>(t1 - t0).count());
+    } while (durations.size() < 3 || std::chrono::duration<double>(Clock::now() - start).count() < minTime);
+    std::nth_element(durations.begin(), durations.begin() + durations.size() / 2, durations.end());
+    return {durations[durations.size() / 2], double(allocs) / durations.size(), durations.size()};
+}
+
+// Keeps the results of the measured loops alive
+volatile double g_sink;
+
+// Minimal JSON writer : one array of flat records per section
+class JsonWriter {
+public:
+    void BeginSection(const std::string &name) {
+        out_ << (sections_++ ? "\n  ],\n" : "") << "  \"" << name << "\": [";
+        records_ = 0;
+    }
+    void BeginRecord() { out_ << (records_++ ? "," : "") << "\n    {"; fields_ = 0; }
+    void EndRecord() { out_ << "}"; }
+    void Field(const std::string &key, const std::string &value) { Key(key); out_ << '"' << value << '"'; }
+    void Field(const std::string &key, double value) {
+        Key(key);
+        char buf[32];
+        std::snprintf(buf, sizeof buf, "%.6g", value);
+        out_ << buf;
+    }
+    void Field(const std::string &key, size_t value) { Key(key); out_ << value; }
+    std::string Finish(const std::string &header) const {
+        return "{\n" + header + out_.str() + (sections_ ? "\n  ]\n" : "") + "}\n";
+    }
+
+private:
+    void Key(const std::string &key) { out_ << (fields_++ ? ", " : "") << '"' << key << "\": "; }
+    std::ostringstream out_;
+    int sections_ = 0, records_ = 0, fields_ = 0;
+};
+
+std::string Today() {
+    char buf[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(buf, sizeof buf, "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    return buf;
+}
+
+std::string Compiler() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#else
+    return "unknown";
+#endif
+}
+
+int ParseArguments(int argc, char **argv, Options &options) {
+    for (int a = 1; a < argc; ++a) {
+        const std::string arg = argv[a];
+        const bool hasValue = a + 1 < argc;
+        if (arg == "--out" && hasValue) options.output = argv[++a];
+        else if (arg == "--quick") options.quick = true;
+        else if (arg == "--min-time" && hasValue) options.minTime = std::atof(argv[++a]);
+        else if (arg == "--max-mb" && hasValue) options.maxMegabytes = std::atof(argv[++a]);
+        else if (arg == "--threads" && hasValue) {
+            std::stringstream list(argv[++a]);
+            std::string item;
+            while (std::getline(list, item, ',')) options.threads.push_back(std::stoul(item));
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            std::cerr << "Usage: greeks_bench [--out file.json] [--quick] [--min-time seconds] [--threads 1,2,4] [--max-mb N]" << std::endl;
+            return -1;
+        }
+    }
+    if (options.quick && options.minTime == 0.5) options.minTime = 0.05;
+    if (options.threads.empty()) {
+        const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t t = 1; t < hardware; t *= 2) options.threads.push_back(t);
+        options.threads.push_back(hardware);
+    }
+    return 0;
+}
+
+// Random but reproducible contracts around K = 100
+OptionBatch SyntheticBook(size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> S(50, 150), T(0.02, 3), sigma(0.05, 0.8), r(0, 0.08), q(0, 0.04), type(0, 1);
+    OptionBatch book;
+    for (size_t k = 0; k < n; ++k) book.push_back(100.0, S(rng), T(rng), sigma(rng), r(rng), q(rng), type(rng) < 0.5);
+    return book;
+}
+
+// ---- per-function throughput, single thread ----
+void BenchFunctions(const Options &options, JsonWriter &json) {
+    const size_t n = 4096;
+    OptionBatch in = SyntheticBook(n, 1);
+    std::vector<double> x(n), y(n);
+    for (size_t k = 0; k < n; ++k) x[k] = (in.S[k] - 100.0) / 12.5;   // normal quantiles in [-4, 4]
+    std::vector<double> rows(8 * n);
+    GreekRows out{rows.data(), rows.data() + n, rows.data() + 2 * n, rows.data() + 3 * n,
+                  rows.data() + 4 * n, rows.data() + 5 * n, rows.data() + 6 * n, rows.data() + 7 * n};
+
+    // every entry runs over the n inputs once per call
+    auto run = [&](const std::string &name, auto &&pass) {
+        const Timing t = Measure(pass, options.minTime);
+        const double ns = t.seconds * 1e9 / n;
+        std::fprintf(stderr, "  %-22s %8.2f ns/call\n", name.c_str(), ns);
+        json.BeginRecord();
+        json.Field("name", name);
+        json.Field("ns_per_call", ns);
+        json.Field("calls_per_sec", 1e9 / ns);
+        json.Field("allocs_per_call", t.allocsPerCall / n);
+        json.EndRecord();
+    };
+    auto scalar = [&](const std::string &name, auto &&f) {
+        run(name, [&] {
+            double sum = 0;
+            for (size_t k = 0; k < n; ++k) sum += f(k);
+            g_sink = sum;
+        });
+    };
+
+    json.BeginSection("functions");
+    std::fprintf(stderr, "functions\n");
+    scalar("norm_pdf", [&](size_t k) { return norm_pdf(0, 1, x[k]); });
+    scalar("norm_cdf", [&](size_t k) { return norm_cdf(0, 1, x[k]); });
+    scalar("d1", [&](size_t k) { return d1(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k]); });
+    scalar("d2", [&](size_t k) { return d2(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k]); });
+    scalar("Delta", [&](size_t k) { return Delta(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k], in.isCall[k]); });
+    scalar("Gamma", [&](size_t k) { return Gamma(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k], in.isCall[k]); });
+    scalar("Vega", [&](size_t k) { return Vega(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k], in.isCall[k]); });
+    scalar("Theta", [&](size_t k) { return Theta(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k], in.isCall[k]); });
+    scalar("Rho", [&](size_t k) { return Rho(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k], in.isCall[k]); });
+    scalar("FusedGreeks", [&](size_t k) {
+        const GreekPoint p = FusedGreeks(in.K[k], in.S[k], in.r[k], in.q[k], in.sigma[k], ComputeMaturityFactors(in.r[k], in.q[k], in.T[k], in.sigma[k]));
+        return p.deltaCall + p.gamma + p.vega + p.thetaCall + p.rhoCall;
+    });
+    run("VecNormPdf", [&] { VecNormPdf(x.data(), y.data(), n); g_sink = y[n / 2]; });
+    run("VecNormCdf", [&] { VecNormCdf(x.data(), y.data(), n); g_sink = y[n / 2]; });
+    run("VecExp", [&] { VecExp(x.data(), y.data(), n); g_sink = y[n / 2]; });
+    run("VecLog", [&] { VecLog(in.S.data(), y.data(), n); g_sink = y[n / 2]; });
+    run("FusedGreeksBatch", [&] { FusedGreeksBatch(in, 0, n, out); g_sink = rows[n / 2]; });
+}
+
+struct Combination {
+    unsigned greeks;
+    unsigned options;
+    PricingModel model;
+};
+
+const Combination Combinations[] = {
+    {Greek_Delta, Option_Call, Model_BlackScholes},
+    {Greek_Delta | Greek_Gamma, Option_All, Model_BlackScholes},
+    {Greek_FirstOrder, Option_All, Model_BlackScholes},
+    {Greek_FirstOrder, Option_All, Model_Black76},
+    {Greek_FirstOrder, Option_All, Model_Bachelier},
+    {Greek_All, Option_All, Model_BlackScholes},
+};
+
+void GridRecord(JsonWriter &json, const char *name, size_t nS, size_t nT, const Combination &c, size_t threads, const Timing &t) {
+    const double points = double(nS) * nT;
+    const double ns = t.seconds * 1e9 / points;
+    const std::string greeks = JoinNames(GreekList(c.greeks)), optionTypes = JoinNames(OptionList(c.options));
+    std::fprintf(stderr, "  %-13s %5zux%-5zu %-27s %-9s %-12s %2zu threads %8.2f ns/option %9.3f ms/call %6.1f allocs/call\n",
+                 name, nS, nT, greeks.c_str(), optionTypes.c_str(), ModelNames[c.model], threads, ns, t.seconds * 1e3, t.allocsPerCall);
+    json.BeginRecord();
+    json.Field("name", std::string(name));
+    json.Field("stocks", nS);
+    json.Field("maturities", nT);
+    json.Field("greeks", greeks);
+    json.Field("options", optionTypes);
+    json.Field("model", std::string(ModelNames[c.model]));
+    json.Field("threads", threads);
+    json.Field("ns_per_option", ns);
+    json.Field("options_per_sec_per_core", 1e9 / ns / threads);
+    json.Field("ms_per_call", t.seconds * 1e3);
+    json.Field("allocs_per_call", t.allocsPerCall);
+    json.EndRecord();
+}
+
+// ---- ComputeGreek / Recompute across grid sizes ----
+void BenchGrids(const Options &options, JsonWriter &json) {
+    std::vector<std::pair<size_t, size_t>> sizes = {{200, 30}, {1000, 100}, {2000, 500}, {10000, 1000}};
+    if (options.quick) sizes.resize(2);
+    const size_t allThreads = DefaultThreadPool().NumThreads();
+
+    json.BeginSection("grids");
+    std::fprintf(stderr, "grids\n");
+    GreekTensor values;
+    for (const auto &size : sizes) {
+        // same axes as the GUI, stretched to the requested number of points
+        double K = 100, S = 100, r = 0.05, q = 0.01, T = 2.0, sigma = 0.2;
+        std::vector<double> StockPrices(size.first), TimeToMaturities(size.second);
+        for (size_t i = 0; i < size.first; ++i) StockPrices[i] = (i + 1) * 2 * K / size.first;
+        for (size_t j = 0; j < size.second; ++j) TimeToMaturities[j] = 0.01 + j * (T - 0.01) / size.second;
+
+        for (const Combination &c : Combinations) {
+            const double megabytes = 8.0 * size.first * size.second * CountFlags(c.greeks) * CountFlags(c.options) / (1 << 20);
+            if (megabytes > options.maxMegabytes) {
+                std::fprintf(stderr, "  ComputeGreek  %5zux%-5zu %-27s skipped (%.0f MB > --max-mb)\n", size.first, size.second,
+                             JoinNames(GreekList(c.greeks)).c_str(), megabytes);
+                continue;
+            }
+            values.Reshape(CountFlags(c.greeks), CountFlags(c.options), size.first, size.second);
+            const Timing t = Measure([&] {
+                ComputeGreek(StockPrices, TimeToMaturities, c.greeks, c.options, c.model, K, S, r, q, T, sigma, values);
+            }, options.minTime);
+            GridRecord(json, "ComputeGreek", size.first, size.second, c, allThreads, t);
+        }
+    }
+
+    // Recompute : GUI grid (201 stock prices), axes and tensor rebuilt on every call
+    std::vector<int> maturities = {30, 100, 1000};
+    if (options.quick) maturities.resize(2);
+    for (int numMaturities : maturities) {
+        for (const Combination &c : Combinations) {
+            double K = 100, S0 = 100, r = 0.05, q = 0.01, T = 2.0, sigma = 0.2;
+            std::vector<double> StockPrices, TimeToMaturities;
+            const Timing t = Measure([&] {
+                Recompute(K, S0, r, q, T, sigma, numMaturities, c.greeks, c.options, c.model, StockPrices, TimeToMaturities, values);
+            }, options.minTime);
+            GridRecord(json, "Recompute", StockPrices.size(), TimeToMaturities.size(), c, allThreads, t);
+        }
+    }
+
+    // thread scaling of one mid-sized grid
+    {
+        const Combination &c = Combinations[2];
+        double K = 100, S = 100, r = 0.05, q = 0.01, T = 2.0, sigma = 0.2;
+        const size_t nS = options.quick ? 1000 : 2000, nT = options.quick ? 100 : 500;
+        std::vector<double> StockPrices(nS), TimeToMaturities(nT);
+        for (size_t i = 0; i < nS; ++i) StockPrices[i] = (i + 1) * 2 * K / nS;
+        for (size_t j = 0; j < nT; ++j) TimeToMaturities[j] = 0.01 + j * (T - 0.01) / nT;
+        values.Reshape(CountFlags(c.greeks), CountFlags(c.options), nS, nT);
+        for (size_t threads : options.threads) {
+            ThreadPool pool(threads);
+            const Timing t = Measure([&] {
+                ComputeGreek(StockPrices, TimeToMaturities, c.greeks, c.options, c.model, K, S, r, q, T, sigma, values, &pool);
+            }, options.minTime);
+            GridRecord(json, "ComputeGreek", nS, nT, c, threads, t);
+        }
+    }
+}
+
+// ---- end to end option books ----
+void BenchBooks(const Options &options, JsonWriter &json) {
+    std::vector<size_t> sizes = {100000, 1000000};
+    if (options.quick) sizes.resize(1);
+
+    json.BeginSection("books");
+    std::fprintf(stderr, "books\n");
+    for (size_t n : sizes) {
+        const OptionBatch book = SyntheticBook(n, 2);
+        std::vector<double> rows(8 * n);
+        GreekRows out{rows.data(), rows.data() + n, rows.data() + 2 * n, rows.data() + 3 * n,
+                      rows.data() + 4 * n, rows.data() + 5 * n, rows.data() + 6 * n, rows.data() + 7 * n};
+
+        auto record = [&](const std::string &engine, size_t threads, const Timing &t, double baseline) {
+            const double ns = t.seconds * 1e9 / n;
+            std::fprintf(stderr, "  %-16s %8zu options %2zu threads %8.2f ns/option  x%.2f\n", engine.c_str(), n, threads, ns, baseline / t.seconds);
+            json.BeginRecord();
+            json.Field("engine", engine);
+            json.Field("options", n);
+            json.Field("threads", threads);
+            json.Field("ns_per_option", ns);
+            json.Field("options_per_sec_per_core", 1e9 / ns / threads);
+            json.Field("speedup", baseline / t.seconds);
+            json.Field("allocs_per_call", t.allocsPerCall);
+            json.EndRecord();
+        };
+
+        // scalar reference functions, one call per Greek
+        OptionBatch in = book;   // the reference functions take non-const references
+        const Timing scalar = Measure([&] {
+            for (size_t k = 0; k < n; ++k) {
+                out.deltaCall[k] = Delta(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k], in.isCall[k]);
+                out.gamma[k] = Gamma(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k], in.isCall[k]);
+                out.vega[k] = Vega(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k], in.isCall[k]);
+                out.thetaCall[k] = Theta(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k], in.isCall[k]);
+                out.rhoCall[k] = Rho(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k], in.isCall[k]);
+            }
+        }, options.minTime);
+        record("scalar", 1, scalar, scalar.seconds);
+
+        double single = 0;
+        for (size_t threads : options.threads) {
+            ThreadPool pool(threads);
+            const Timing t = Measure([&] { ComputeBatch(book, out, &pool); }, options.minTime);
+            if (threads == options.threads.front()) single = t.seconds;
+            record("ComputeBatch", threads, t, single);
+        }
+    }
+}
+
+// ---- implied volatilities from the prices of the books ----
+void BenchImpliedVols(const Options &options, JsonWriter &json) {
+    std::vector<size_t> sizes = {100000, 1000000};
+    if (options.quick) sizes.resize(1);
+
+    json.BeginSection("implied_vols");
+    std::fprintf(stderr, "implied_vols\n");
+    for (size_t n : sizes) {
+        OptionBatch book = SyntheticBook(n, 3);
+        std::vector<double> prices(n), vols;
+        std::vector<unsigned char> status;
+        for (size_t k = 0; k < n; ++k)
+            prices[k] = Price(book.K[k], book.S[k], book.r[k], book.q[k], book.T[k], book.sigma[k], book.isCall[k]);
+
+        double single = 0;
+        for (size_t threads : options.threads) {
+            ThreadPool pool(threads);
+            const Timing t = Measure([&] { ComputeImpliedVols(book, prices, vols, status, &pool); }, options.minTime);
+            if (threads == options.threads.front()) single = t.seconds;
+
+            size_t failures = 0;
+            double maxError = 0;
+            for (size_t k = 0; k < n; ++k) {
+                if (status[k] != Iv_Ok) {
+                    ++failures;
+                    continue;
+                }
+                const double vega = Vega(book.K[k], book.S[k], book.r[k], book.q[k], book.T[k], book.sigma[k], book.isCall[k]);
+                if (vega * book.sigma[k] > 1e-6 * prices[k]) maxError = std::max(maxError, std::fabs(vols[k] / book.sigma[k] - 1));
+            }
+            const double ns = t.seconds * 1e9 / n;
+            std::fprintf(stderr, "  %8zu options %2zu threads %8.2f ns/inversion  x%.2f  %zu failures, max rel error %.2g\n",
+                         n, threads, ns, single / t.seconds, failures, maxError);
+            json.BeginRecord();
+            json.Field("options", n);
+            json.Field("threads", threads);
+            json.Field("ns_per_inversion", ns);
+            json.Field("inversions_per_sec_per_core", 1e9 / ns / threads);
+            json.Field("speedup", single / t.seconds);
+            json.Field("failures", failures);
+            json.Field("max_rel_vol_error", maxError);
+            json.Field("allocs_per_call", t.allocsPerCall);
+            json.EndRecord();
+        }
+    }
+}
+
+// ---- GreekApprox tables against FusedGreeksBatch and the exact scalar functions ----
+void BenchApproximations(const Options &options, JsonWriter &json) {
+    const size_t n = options.quick ? 1 << 14 : 1 << 16;
+    const double r = 0.03, q = 0.01;
+    const ApproxDomain domain;
+    std::mt19937_64 rng(4);
+    std::uniform_real_distribution<double> K(50, 150), moneyness(domain.moneynessMin, domain.moneynessMax),
+        T(domain.TMin, domain.TMax), sigma(domain.sigmaMin, domain.sigmaMax);
+    OptionBatch in;
+    for (size_t k = 0; k < n; ++k) {
+        const double strike = K(rng);
+        in.push_back(strike, strike * moneyness(rng), T(rng), sigma(rng), r, q, true);
+    }
+    std::vector<double> exact(n), approx(n), rows(8 * n);
+    const GreekRows out{rows.data(), rows.data() + n, rows.data() + 2 * n, rows.data() + 3 * n,
+                        rows.data() + 4 * n, rows.data() + 5 * n, rows.data() + 6 * n, rows.data() + 7 * n};
+    // every Greek of the contracts at once, the path a table has to beat
+    const Timing fusedTime = Measure([&] {
+        FusedGreeksBatch(in, 0, n, out);
+        g_sink = rows[n / 2];
+    }, options.minTime);
+    const double nsFused = fusedTime.seconds * 1e9 / n;
+
+    typedef double (*GreekFunction)(double &, double &, double &, double &, double &, double &, bool);
+    const std::pair<const char *, GreekFunction> greeks[] = {{"Delta", Delta}, {"Theta", Theta}, {"Rho", Rho}};
+
+    json.BeginSection("approximations");
+    std::fprintf(stderr, "approximations (FusedGreeksBatch %.2f ns/option)\n", nsFused);
+    for (const auto &greek : greeks) {
+        GreekApprox table;
+        const auto start = std::chrono::steady_clock::now();
+        const int status = table.Build(greek.first, true, r, q, domain);
+        const double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const Timing exactTime = Measure([&] {
+            for (size_t k = 0; k < n; ++k) exact[k] = greek.second(in.K[k], in.S[k], in.r[k], in.q[k], in.T[k], in.sigma[k], true);
+            g_sink = exact[n / 2];
+        }, options.minTime);
+        const Timing approxTime = Measure([&] {
+            table.EvaluateBatch(n, in.K.data(), in.S.data(), in.T.data(), in.sigma.data(), approx.data());
+            g_sink = approx[n / 2];
+        }, options.minTime);
+
+        // errors for a strike of 1, as the tolerance is stated
+        const double strikePower = greek.first[0] == 'D' ? 0 : 1;
+        double maxError = 0;
+        for (size_t k = 0; k < n; ++k) maxError = std::max(maxError, std::fabs(approx[k] - exact[k]) / std::pow(in.K[k], strikePower));
+
+        const double cells = double(table.NumCells(0)) * table.NumCells(1) * table.NumCells(2);
+        const double nsExact = exactTime.seconds * 1e9 / n, nsApprox = approxTime.seconds * 1e9 / n;
+        std::fprintf(stderr, "  %-5s %8.0f cells %7.1f MB %6.2f s build  max error %.2g (checks %.2g)  %6.2f ns vs %6.2f ns exact  x%.2f, x%.2f vs fused%s\n",
+                     greek.first, cells, table.MemoryBytes() / 1048576.0, buildSeconds, maxError, table.MaxError(),
+                     nsApprox, nsExact, nsExact / nsApprox, nsFused / nsApprox, status == 0 ? "" : "  (tolerance not met)");
+        json.BeginRecord();
+        json.Field("greek", std::string(greek.first));
+        json.Field("built", std::string(status == 0 ? "yes" : "no"));
+        json.Field("build_seconds", buildSeconds);
+        json.Field("cells", cells);
+        json.Field("megabytes", table.MemoryBytes() / 1048576.0);
+        json.Field("max_check_error", table.MaxError());
+        json.Field("max_error", maxError);
+        json.Field("ns_per_lookup", nsApprox);
+        json.Field("ns_per_exact_call", nsExact);
+        json.Field("speedup", nsExact / nsApprox);
+        json.Field("ns_per_fused_option", nsFused);
+        json.Field("speedup_vs_fused", nsFused / nsApprox);
+        json.EndRecord();
+    }
+}
+
+// ---- float and mixed precision grids, timed against the double grid ----
+void BenchPrecision(const Options &options, JsonWriter &json) {
+    // deep out of the money (S / K down to 0.002) to deep in, maturities from 9 hours to 2 years on a log scale
+    const size_t nS = 1000, nT = options.quick ? 100 : 200;
+    double K = 100, S = 100, r = 0.05, q = 0.01, T = 2.0;
+    std::vector<double> StockPrices(nS), TimeToMaturities(nT);
+    for (size_t i = 0; i < nS; ++i) StockPrices[i] = (i + 1) * 2 * K / nS;
+    for (size_t j = 0; j < nT; ++j) TimeToMaturities[j] = 1e-3 * std::pow(T / 1e-3, double(j) / (nT - 1));
+    const unsigned greeks = Greek_FirstOrder;
+    GreekTensor reference(CountFlags(greeks), NumOptionKinds, nS, nT);
+    GreekTensorF values(CountFlags(greeks), NumOptionKinds, nS, nT);
+
+    json.BeginSection("precision");
+    std::fprintf(stderr, "precision\n");
+    for (size_t model = 0; model < NumClosedFormModels; ++model) {
+        const PricingModel m = static_cast<PricingModel>(model);
+        double sigma = m == Model_Bachelier ? 20.0 : 0.2;   // normal vol in price units
+        for (size_t precision = 0; precision < NumPrecisions; ++precision) {
+            const Precision p = static_cast<Precision>(precision);
+            const Timing t = Measure([&] {
+                if (p == Precision_Double) ComputeGreek(StockPrices, TimeToMaturities, greeks, Option_All, m, K, S, r, q, T, sigma, reference);
+                else ComputeGreek(StockPrices, TimeToMaturities, greeks, Option_All, m, K, S, r, q, T, sigma, values, p);
+            }, options.minTime);
+            const double ns = t.seconds * 1e9 / (nS * nT);
+            const double megabytes = (p == Precision_Double ? reference.Size() * sizeof(double) : values.Size() * sizeof(float)) / 1048576.0;
+            std::fprintf(stderr, "  %-12s %-6s %7.2f ns/option %6.1f MB\n", ModelNames[model], PrecisionNames[precision], ns, megabytes);
+            json.BeginRecord();
+            json.Field("model", std::string(ModelNames[model]));
+            json.Field("precision", std::string(PrecisionNames[precision]));
+            json.Field("ns_per_option", ns);
+            json.Field("megabytes", megabytes);
+            json.EndRecord();
+        }
+    }
+}
+
+// ---- LTTB decimation of Greek curves ----
+void BenchDecimation(const Options &options, JsonWriter &json) {
+    // the GUI stock axis (201 points, 0 to 2K) and a dense one, maturities from short (sharp Gamma) to long
+    double K = 100, S = 100, r = 0.05, q = 0.01, T = 2.0, sigma = 0.2;
+    std::vector<double> guiAxis, denseAxis(20001);
+    BuildStockAxis(K, guiAxis);
+    for (size_t i = 0; i < denseAxis.size(); ++i) denseAxis[i] = i * 2 * K / (denseAxis.size() - 1);
+    std::vector<double> TimeToMaturities = {0.01, 0.25, 2.0};
+    const unsigned greeks = Greek_Delta | Greek_Gamma;
+    const size_t budgets[] = {200, 100};
+
+    json.BeginSection("decimation");
+    std::fprintf(stderr, "decimation\n");
+    std::vector<size_t> kept;
+    for (std::vector<double> *axis : {&guiAxis, &denseAxis}) {
+        GreekTensor values(CountFlags(greeks), 1, axis->size(), TimeToMaturities.size());
+        ComputeGreek(*axis, TimeToMaturities, greeks, Option_Call, Model_BlackScholes, K, S, r, q, T, sigma, values);
+        for (size_t g = 0; g < values.NumGreeks(); ++g)
+            for (size_t j = 0; j < TimeToMaturities.size(); ++j)
+                for (size_t budget : budgets) {
+                    const StridedView<const double> curve = static_cast<const GreekTensor &>(values).Slice(g, 0).AlongS(j);
+                    const Timing t = Measure([&] {
+                        DecimateLttb(*axis, curve, budget, kept);
+                        g_sink = kept.back();
+                    }, options.minTime);
+                    const double error = DecimationError(*axis, curve, kept);
+                    const double ns = t.seconds * 1e9 / axis->size();
+                    const std::string greek = GreekNames[g];
+                    std::fprintf(stderr, "  %-5s T=%-4g %6zu -> %4zu points  max error %.1e of the height  %.2f ns/point\n",
+                                 greek.c_str(), TimeToMaturities[j], axis->size(), kept.size(), error, ns);
+                    json.BeginRecord();
+                    json.Field("greek", greek);
+                    json.Field("maturity", TimeToMaturities[j]);
+                    json.Field("points", axis->size());
+                    json.Field("kept", kept.size());
+                    json.Field("max_error", error);
+                    json.Field("ns_per_point", ns);
+                    json.EndRecord();
+                }
+    }
+}
+
+// ---- uniform and adaptive grids against a dense grid ----
+void BenchAdaptive(const Options &options, JsonWriter &json) {
+    // GUI defaults (param.txt), checked on a dense grid over the range both kinds of axes cover
+    double K = 100, S0 = 90, r = 0.05, q = 0.0, T = 2.0, sigma = 0.2;
+    const int numMaturities = 30;
+    const size_t nS = options.quick ? 501 : 1001, nT = options.quick ? 151 : 301;
+    std::vector<double> denseS(nS), denseT(nT);
+    for (size_t i = 0; i < nS; ++i) denseS[i] = K / 100 + i * (2 * K - K / 100) / (nS - 1);
+    for (size_t j = 0; j < nT; ++j) denseT[j] = 0.01 + j * (T - 0.01) / (nT - 1);
+    const unsigned greeks = Greek_FirstOrder;
+    GreekTensor exact(CountFlags(greeks), NumOptionKinds, nS, nT);
+    ComputeGreek(denseS, denseT, greeks, Option_All, Model_BlackScholes, K, S0, r, q, T, sigma, exact);
+
+    struct Case { const char *name; GridMode grid; size_t points; };
+    const size_t columns = numMaturities + 1;
+    const Case cases[] = {{"uniform", Grid_Uniform, 0}, {"adaptive", Grid_Adaptive, 32 * columns},
+                          {"adaptive", Grid_Adaptive, 64 * columns}, {"adaptive", Grid_Adaptive, 128 * columns}};
+
+    json.BeginSection("adaptive");
+    std::fprintf(stderr, "adaptive\n");
+    std::vector<double> StockPrices, TimeToMaturities;
+    GreekTensor values;
+    for (const Case &c : cases) {
+        const Timing t = Measure([&] {
+            Recompute(K, S0, r, q, T, sigma, numMaturities, greeks, Option_All, Model_BlackScholes, StockPrices, TimeToMaturities, values,
+                      nullptr, c.grid, c.points);
+        }, options.minTime);
+        const size_t points = StockPrices.size() * TimeToMaturities.size();
+        std::fprintf(stderr, "  %-8s %3zu x %2zu = %5zu points (budget %zu)  %.3f ms\n", c.name, StockPrices.size(), TimeToMaturities.size(), points, c.points, t.seconds * 1e3);
+
+        // bilinear interpolation at every dense point, worst and rms error of a Greek over both option types
+        for (size_t g = 0; g < exact.NumGreeks(); ++g) {
+            double worst = 0, squares = 0;
+            size_t count = 0;
+            for (size_t o = 0; o < NumOptionKinds; ++o) {
+                const SliceView<const double> ref = static_cast<const GreekTensor &>(exact).Slice(g, o);
+                const SliceView<const double> grid = static_cast<const GreekTensor &>(values).Slice(g, o);
+                double lo = INFINITY, hi = -INFINITY;
+                for (size_t i = 0; i < nS; ++i)
+                    for (size_t j = 0; j < nT; ++j) { lo = std::min(lo, ref(i, j)); hi = std::max(hi, ref(i, j)); }
+                for (size_t i = 0; i < nS; ++i) {
+                    const size_t a = std::min<size_t>(std::upper_bound(StockPrices.begin(), StockPrices.end(), denseS[i]) - StockPrices.begin(), StockPrices.size() - 1) - 1;
+                    const double u = (denseS[i] - StockPrices[a]) / (StockPrices[a + 1] - StockPrices[a]);
+                    for (size_t j = 0; j < nT; ++j) {
+                        const size_t b = std::min<size_t>(std::upper_bound(TimeToMaturities.begin(), TimeToMaturities.end(), denseT[j]) - TimeToMaturities.begin(), TimeToMaturities.size() - 1) - 1;
+                        const double v = (denseT[j] - TimeToMaturities[b]) / (TimeToMaturities[b + 1] - TimeToMaturities[b]);
+                        const double interpolated = (1 - u) * ((1 - v) * grid(a, b) + v * grid(a, b + 1)) + u * ((1 - v) * grid(a + 1, b) + v * grid(a + 1, b + 1));
+                        const double error = std::fabs(interpolated - ref(i, j)) / (hi - lo);
+                        worst = std::max(worst, error);
+                        squares += error * error;
+                        ++count;
+                    }
+                }
+            }
+            const double rms = std::sqrt(squares / count);
+            std::fprintf(stderr, "    %-5s max error %.1e  rms %.1e of the range\n", GreekNames[g], worst, rms);
+            json.BeginRecord();
+            json.Field("grid", std::string(c.name));
+            json.Field("points", points);
+            json.Field("budget", c.points);
+            json.Field("stocks", StockPrices.size());
+            json.Field("maturities", TimeToMaturities.size());
+            json.Field("build_ms", t.seconds * 1e3);
+            json.Field("greek", std::string(GreekNames[g]));
+            json.Field("max_error", worst);
+            json.Field("rms_error", rms);
+            json.EndRecord();
+        }
+    }
+}
+
+// ---- AAD sensitivities, timed against one price and the analytic kernels ----
+void BenchAad(const Options &options, JsonWriter &json) {
+    const size_t n = options.quick ? 1024 : 4096;
+    std::vector<AadSensitivities> aad(n);
+    std::vector<double> rows(8 * n);
+    GreekRows analytic{rows.data(), rows.data() + n, rows.data() + 2 * n, rows.data() + 3 * n,
+                       rows.data() + 4 * n, rows.data() + 5 * n, rows.data() + 6 * n, rows.data() + 7 * n};
+    AadTape tape;
+
+    json.BeginSection("aad");
+    std::fprintf(stderr, "aad\n");
+    for (size_t model = 0; model < NumClosedFormModels; ++model) {
+        const PricingModel m = static_cast<PricingModel>(model);
+        OptionBatch book = SyntheticBook(n, 5);
+        if (m == Model_Bachelier)
+            for (size_t k = 0; k < n; ++k) book.sigma[k] *= book.S[k];   // normal vol in price units
+
+        // one price per option, every sensitivity by AAD, the analytic Greeks of the kernels (call and put rows)
+        const Timing price = Measure([&] {
+            double sum = 0;
+            for (size_t k = 0; k < n; ++k)
+                sum += OptionPrice(book.K[k], book.S[k], book.r[k], book.q[k], book.T[k], book.sigma[k], book.isCall[k] != 0, m);
+            g_sink = sum;
+        }, options.minTime);
+        const Timing sweep = Measure([&] { ComputeAadBatch(book, 0, n, aad.data(), tape, m); g_sink = aad[n / 2].delta; }, options.minTime);
+        const Timing kernels = Measure([&] { FusedGreeksBatch(book, 0, n, analytic, m); g_sink = rows[n / 2]; }, options.minTime);
+        const double priceNs = price.seconds * 1e9 / n, aadNs = sweep.seconds * 1e9 / n, kernelNs = kernels.seconds * 1e9 / n;
+        std::fprintf(stderr, "  %-12s price %6.1f ns  aad %6.1f ns (%.1fx, %zu nodes, %.2f allocs/option)  analytic kernels %5.1f ns\n",
+                     ModelNames[model], priceNs, aadNs, aadNs / priceNs, tape.Size(), sweep.allocsPerCall / n, kernelNs);
+        json.BeginRecord();
+        json.Field("model", std::string(ModelNames[model]));
+        json.Field("price_ns", priceNs);
+        json.Field("aad_ns", aadNs);
+        json.Field("aad_over_price", aadNs / priceNs);
+        json.Field("analytic_ns", kernelNs);
+        json.Field("tape_nodes", tape.Size());
+        json.Field("allocs_per_option", sweep.allocsPerCall / n);
+        json.EndRecord();
+    }
+}
+
+// ---- Monte Carlo Greeks ----
+void BenchMonteCarlo(const Options &options, JsonWriter &json) {
+    const double K = 100, S = 100, r = 0.05, q = 0.01, T = 1.0, sigma = 0.2;
+    const size_t paths = options.quick ? 1 << 17 : 1 << 20;
+    double k = K, s = S, rate = r, yield = q, t = T, vol = sigma;   // the analytic Greeks take non-const references
+
+    json.BeginSection("monte_carlo");
+    std::fprintf(stderr, "monte_carlo\n");
+    auto run = [&](const std::string &name, const McOptions &mc, bool compare, ThreadPool *pool) {
+        McGreeks g;
+        const Timing timing = Measure([&] { MonteCarloGreeks(K, S, r, q, T, sigma, true, mc, g, pool); }, options.minTime);
+        const double ns = timing.seconds * 1e9 / g.paths;
+        std::fprintf(stderr, "  %-28s %8zu paths %7.1f ns/path\n", name.c_str(), g.paths, ns);
+        const struct { const char *greek; McEstimate estimate; double analytic; } rows[] = {
+            {"Price", g.price, Price(k, s, rate, yield, t, vol, true)},
+            {"Delta", g.delta, Delta(k, s, rate, yield, t, vol, true)},
+            {"Vega", g.vega, Vega(k, s, rate, yield, t, vol, true)},
+            {"Rho", g.rho, Rho(k, s, rate, yield, t, vol, true)},
+            {"Theta", g.theta, Theta(k, s, rate, yield, t, vol, true)},
+            {"DeltaLR", g.deltaLR, Delta(k, s, rate, yield, t, vol, true)},
+            {"GammaLR", g.gammaLR, Gamma(k, s, rate, yield, t, vol, true)},
+            {"VegaLR", g.vegaLR, Vega(k, s, rate, yield, t, vol, true)},
+            {"RhoLR", g.rhoLR, Rho(k, s, rate, yield, t, vol, true)},
+        };
+        for (const auto &row : rows) {
+            const double errors = row.estimate.stdError > 0 ? (row.estimate.value - row.analytic) / row.estimate.stdError : 0.0;
+            if (compare) std::fprintf(stderr, "    %-8s %10.6f +- %.2e  (analytic %10.6f, %+.1f errors)\n", row.greek, row.estimate.value, row.estimate.stdError, row.analytic, errors);
+            else std::fprintf(stderr, "    %-8s %10.6f +- %.2e\n", row.greek, row.estimate.value, row.estimate.stdError);
+            json.BeginRecord();
+            json.Field("run", name);
+            json.Field("paths", g.paths);
+            json.Field("ns_per_path", ns);
+            json.Field("greek", std::string(row.greek));
+            json.Field("value", row.estimate.value);
+            json.Field("std_error", row.estimate.stdError);
+            if (compare) json.Field("errors_from_analytic", errors);
+            json.EndRecord();
+        }
+        return g;
+    };
+
+    // European call against the closed forms, pseudo and quasi random
+    for (size_t sampler = 0; sampler < NumMcSamplers; ++sampler) {
+        McOptions mc;
+        mc.paths = paths;
+        mc.sampler = static_cast<McSampler>(sampler);
+        run(std::string("European ") + McSamplerNames[sampler], mc, true, nullptr);
+    }
+
+    // Asian call, 12 monthly fixings : plain, antithetic, antithetic and control variate
+    for (size_t sampler = 0; sampler < NumMcSamplers; ++sampler)
+        for (int variant = 0; variant < 3; ++variant) {
+            McOptions mc;
+            mc.payoff = Payoff_Asian;
+            mc.steps = 12;
+            mc.paths = paths;
+            mc.sampler = static_cast<McSampler>(sampler);
+            mc.antithetic = variant > 0;
+            mc.controlVariate = variant > 1;
+            static const char *const variants[3] = {" plain", " antithetic", " antithetic+cv"};
+            run(std::string("Asian ") + McSamplerNames[sampler] + variants[variant], mc, false, nullptr);
+        }
+
+    // thread counts : the same result bit for bit
+    McOptions mc;
+    mc.payoff = Payoff_Asian;
+    mc.steps = 12;
+    mc.paths = paths;
+    McGreeks first;
+    for (size_t threads : options.threads) {
+        ThreadPool pool(threads);
+        McGreeks g;
+        const Timing timing = Measure([&] { MonteCarloGreeks(K, S, r, q, T, sigma, true, mc, g, &pool); }, options.minTime);
+        if (threads == options.threads.front()) first = g;
+        const bool same = g.price.value == first.price.value && g.delta.value == first.delta.value && g.gammaLR.value == first.gammaLR.value;
+        std::fprintf(stderr, "  Asian Philox %2zu threads %7.1f ns/path  %s\n", threads, timing.seconds * 1e9 / g.paths, same ? "identical" : "DIFFERENT");
+        json.BeginRecord();
+        json.Field("run", std::string("Asian Philox threads"));
+        json.Field("threads", threads);
+        json.Field("ns_per_path", timing.seconds * 1e9 / g.paths);
+        json.Field("identical", std::string(same ? "yes" : "no"));
+        json.EndRecord();
+    }
+}
+
+// ---- higher order Greeks against finite differences of the first order ones, and their cost ----
+void BenchHigherOrder(const Options &options, JsonWriter &json) {
+    json.BeginSection("higher_order");
+    std::fprintf(stderr, "higher_order\n");
+
+    // Accuracy : every higher order Greek against a central difference of the first order Greek it differentiates,
+    // bumped by 1e-4 relative (S axis, T axis or sigma). Errors are scaled by the largest |Greek| of the slice
+    const size_t nS = 101, nT = 40;
+    const double h = 1e-4;
+    for (size_t model = 0; model < NumClosedFormModels; ++model) {
+        const PricingModel m = static_cast<PricingModel>(model);
+        double K = 100, S = 100, r = 0.05, q = 0.02, T = 2.0, sigma = m == Model_Bachelier ? 20.0 : 0.25;
+        std::vector<double> StockPrices(nS), TimeToMaturities(nT);
+        for (size_t i = 0; i < nS; ++i) StockPrices[i] = 50 + i;
+        for (size_t j = 0; j < nT; ++j) TimeToMaturities[j] = 0.05 + j * (T - 0.05) / (nT - 1);
+        GreekTensor analytic(NumGreekKinds, NumOptionKinds, nS, nT);
+        ComputeGreek(StockPrices, TimeToMaturities, Greek_All, Option_All, m, K, S, r, q, T, sigma, analytic);
+
+        // first order Greeks on bumped axes or volatility, up and down
+        const unsigned first = Greek_FirstOrder;
+        GreekTensor up[3], down[3];   // bumped S, T, sigma
+        for (int bump = 0; bump < 3; ++bump) {
+            std::vector<double> stocksUp = StockPrices, stocksDown = StockPrices, maturitiesUp = TimeToMaturities, maturitiesDown = TimeToMaturities;
+            double sigmaUp = sigma, sigmaDown = sigma;
+            if (bump == 0) for (size_t i = 0; i < nS; ++i) { stocksUp[i] *= 1 + h; stocksDown[i] *= 1 - h; }
+            if (bump == 1) for (size_t j = 0; j < nT; ++j) { maturitiesUp[j] *= 1 + h; maturitiesDown[j] *= 1 - h; }
+            if (bump == 2) { sigmaUp *= 1 + h; sigmaDown *= 1 - h; }
+            up[bump].Reshape(CountFlags(first), NumOptionKinds, nS, nT);
+            down[bump].Reshape(CountFlags(first), NumOptionKinds, nS, nT);
+            ComputeGreek(stocksUp, maturitiesUp, first, Option_All, m, K, S, r, q, T, sigmaUp, up[bump]);
+            ComputeGreek(stocksDown, maturitiesDown, first, Option_All, m, K, S, r, q, T, sigmaDown, down[bump]);
+        }
+
+        // Greek : first order Greek differentiated, bump, sign (-1 for the calendar time derivatives)
+        struct Check { unsigned greek, of; int bump; double sign; };
+        const Check checks[] = {{Greek_Vanna, Greek_Delta, 2, 1}, {Greek_Volga, Greek_Vega, 2, 1}, {Greek_Charm, Greek_Delta, 1, -1},
+                                {Greek_Speed, Greek_Gamma, 0, 1}, {Greek_Color, Greek_Gamma, 1, -1}, {Greek_Zomma, Greek_Gamma, 2, 1}};
+        for (const Check &c : checks)
+            for (size_t o = 0; o < NumOptionKinds; ++o) {
+                const SliceView<const double> exact = static_cast<const GreekTensor &>(analytic).Slice(SlotOf(Greek_All, c.greek), o);
+                const SliceView<const double> hi = static_cast<const GreekTensor &>(up[c.bump]).Slice(SlotOf(first, c.of), o);
+                const SliceView<const double> lo = static_cast<const GreekTensor &>(down[c.bump]).Slice(SlotOf(first, c.of), o);
+                double largest = 0, worst = 0;
+                for (size_t i = 0; i < nS; ++i)
+                    for (size_t j = 0; j < nT; ++j) {
+                        const double step = 2 * h * (c.bump == 0 ? StockPrices[i] : c.bump == 1 ? TimeToMaturities[j] : sigma);
+                        const double difference = c.sign * (hi(i, j) - lo(i, j)) / step;
+                        largest = std::max(largest, std::fabs(exact(i, j)));
+                        worst = std::max(worst, std::fabs(exact(i, j) - difference));
+                    }
+                const char *name = GreekNames[SlotOf(Greek_All, c.greek)];
+                std::fprintf(stderr, "  %-12s %-5s %-4s error %.1e of the largest value (%.3g)\n", ModelNames[model], name, OptionNames[o],
+                             worst / largest, largest);
+                json.BeginRecord();
+                json.Field("model", std::string(ModelNames[model]));
+                json.Field("greek", std::string(name));
+                json.Field("option", std::string(OptionNames[o]));
+                json.Field("largest", largest);
+                json.Field("scaled_error", worst / largest);
+                json.EndRecord();
+            }
+    }
+
+    // Cost : one grid, Delta alone up to all eleven Greeks, both option types
+    const size_t gridS = options.quick ? 500 : 1000, gridT = 100;
+    std::vector<double> StockPrices(gridS), TimeToMaturities(gridT);
+    for (size_t i = 0; i < gridS; ++i) StockPrices[i] = (i + 1) * 200.0 / gridS;
+    for (size_t j = 0; j < gridT; ++j) TimeToMaturities[j] = 0.01 + j * 1.99 / gridT;
+    const unsigned sets[] = {Greek_Delta, Greek_FirstOrder, Greek_Vanna, Greek_HigherOrder, Greek_All};
+    GreekTensor values;
+    for (size_t model = 0; model < NumClosedFormModels; ++model) {
+        const PricingModel m = static_cast<PricingModel>(model);
+        double K = 100, S = 100, r = 0.05, q = 0.02, T = 2.0, sigma = m == Model_Bachelier ? 20.0 : 0.25;
+        double baseline = 0;
+        for (unsigned greeks : sets) {
+            values.Reshape(CountFlags(greeks), NumOptionKinds, gridS, gridT);
+            const Timing t = Measure([&] {
+                ComputeGreek(StockPrices, TimeToMaturities, greeks, Option_All, m, K, S, r, q, T, sigma, values);
+            }, options.minTime);
+            const double ns = t.seconds * 1e9 / (gridS * gridT);
+            if (greeks == Greek_Delta) baseline = ns;
+            const std::string names = JoinNames(GreekList(greeks));
+            std::fprintf(stderr, "  %-12s %-52s %7.2f ns/option  x%.2f Delta alone\n", ModelNames[model], names.c_str(), ns, ns / baseline);
+            json.BeginRecord();
+            json.Field("model", std::string(ModelNames[model]));
+            json.Field("greeks", names);
+            json.Field("ns_per_option", ns);
+            json.Field("relative_to_delta", ns / baseline);
+            json.Field("allocs_per_call", t.allocsPerCall);
+            json.EndRecord();
+        }
+    }
+}
+
+// ---- instrumentation overhead (Profiler.hpp) ----
+void BenchProfiler(const Options &options, JsonWriter &json) {
+    json.BeginSection("profiler");
+    std::fprintf(stderr, "profiler\n");
+    Profiler &profiler = GlobalProfiler();
+    auto record = [&](const std::string &operation, double ns, double allocs) {
+        std::fprintf(stderr, "  %-24s %9.2f ns  %.2f allocs\n", operation.c_str(), ns, allocs);
+        json.BeginRecord();
+        json.Field("operation", operation);
+        json.Field("ns", ns);
+        json.Field("allocs_per_call", allocs);
+        json.EndRecord();
+    };
+
+    // ProfileScope is what GREEKS_PROFILE_SCOPE expands to, timed here whatever the build option
+    const size_t repeats = 1000;
+    for (bool recording : {true, false}) {
+        profiler.SetRecording(recording);
+        const Timing t = Measure([&] {
+            for (size_t k = 0; k < repeats; ++k) ProfileScope scope("bench");
+        }, options.minTime);
+        record(recording ? "scope" : "scope_paused", t.seconds * 1e9 / repeats, t.allocsPerCall / repeats);
+    }
+    profiler.SetRecording(true);
+    {
+        const Timing t = Measure([&] {
+            for (size_t k = 0; k < repeats; ++k) Profiler::Count(Counter_Points, k);
+        }, options.minTime);
+        record("count", t.seconds * 1e9 / repeats, t.allocsPerCall / repeats);
+    }
+
+    // a frame of 100 scopes, about what the GUI records with a recompute in flight
+    {
+        const Timing t = Measure([&] {
+            for (size_t k = 0; k < 100; ++k) ProfileScope scope("bench");
+            profiler.EndFrame();
+        }, options.minTime);
+        record("frame_of_100_scopes", t.seconds * 1e9, t.allocsPerCall);
+    }
+
+    // export of the retained events (the ring of this thread is full after the loops above)
+    const std::string trace = "greeks_bench_trace.json";
+    const Timing t = Measure([&] { g_sink = profiler.WriteChromeTrace(trace); }, options.minTime);
+    record("chrome_trace_per_event", t.seconds * 1e9 / ProfileEventCapacity, t.allocsPerCall);
+    std::remove(trace.c_str());
+
+    // the GUI grid with the scopes and counters of SweepGrid recorded or paused
+    double K = 100, S = 100, r = 0.05, q = 0.01, T = 2.0, sigma = 0.2;
+    std::vector<double> StockPrices, TimeToMaturities;
+    BuildStockAxis(K, StockPrices);
+    BuildMaturityAxis(T, 20, TimeToMaturities);
+    GreekTensor values(CountFlags(Greek_FirstOrder), NumOptionKinds, StockPrices.size(), TimeToMaturities.size());
+    for (bool recording : {true, false}) {
+        profiler.SetRecording(recording);
+        const Timing g = Measure([&] {
+            ComputeGreek(StockPrices, TimeToMaturities, Greek_FirstOrder, Option_All, Model_BlackScholes, K, S, r, q, T, sigma, values);
+        }, options.minTime);
+        record(recording ? "gui_grid_per_option" : "gui_grid_per_option_paused",
+               g.seconds * 1e9 / (StockPrices.size() * TimeToMaturities.size()), g.allocsPerCall);
+    }
+    profiler.SetRecording(true);
+}
+
+// ---- tick replay (TickReplay.hpp) ----
+void BenchStreaming(const Options &options, JsonWriter &json) {
+    json.BeginSection("streaming");
+    std::fprintf(stderr, "streaming\n");
+
+    // positions on 100 underlyings, written and read back in the positions format
+    const size_t numOptions = options.quick ? 20000 : 100000, numUnderlyings = 100;
+    const OptionBatch synthetic = SyntheticBook(numOptions, 5);
+    std::ostringstream positions;
+    positions << "underlying,K,S,T,sigma,r,q,type,quantity\n";
+    positions.precision(17);
+    for (size_t k = 0; k < numOptions; ++k)
+        positions << "U" << k % numUnderlyings << ',' << synthetic.K[k] << ",100," << synthetic.T[k] << ',' << synthetic.sigma[k] << ','
+                  << synthetic.r[k] << ',' << synthetic.q[k] << ',' << (synthetic.isCall[k] ? "Call" : "Put") << ',' << int(k % 21) - 10 << '\n';
+    StreamingBook book;
+    std::istringstream positionsIn(positions.str());
+    if (book.Load(positionsIn) != 0) return;
+
+    // a random walk of spot and vol, one underlying per tick, 1 ms apart
+    auto feedOf = [&](size_t ticks) {
+        std::mt19937_64 rng(6);
+        std::normal_distribution<double> move(0, 1e-3);
+        std::uniform_int_distribution<size_t> pick(0, numUnderlyings - 1);
+        std::vector<double> spot(numUnderlyings, 100), vol(numUnderlyings, 0.25);
+        std::ostringstream feed;
+        feed.precision(17);
+        for (size_t t = 0; t < ticks; ++t) {
+            const size_t u = pick(rng);
+            spot[u] *= 1 + move(rng);
+            vol[u] *= 1 + move(rng);
+            feed << t * 1e-3 << ",U" << u << ',' << spot[u] << ',' << vol[u] << ",\n";
+        }
+        return feed.str();
+    };
+
+    auto record = [&](const std::string &mode, const ReplayStats &stats) {
+        const LatencyHistogram &l = stats.latency;
+        const double perTick = stats.ticks ? double(stats.optionsRepriced) / stats.ticks : 0;
+        std::fprintf(stderr, "  %-10s %6zu ticks %7.1f options/tick %9.0f ticks/s  latency p50 %6.1f us  p99 %6.1f us  p99.9 %6.1f us  max %6.1f us\n",
+                     mode.c_str(), stats.ticks, perTick, stats.ticks / stats.seconds, l.Percentile(0.5) * 1e-3, l.Percentile(0.99) * 1e-3,
+                     l.Percentile(0.999) * 1e-3, l.Max() * 1e-3);
+        json.BeginRecord();
+        json.Field("mode", mode);
+        json.Field("options", numOptions);
+        json.Field("underlyings", numUnderlyings);
+        json.Field("ticks", stats.ticks);
+        json.Field("options_per_tick", perTick);
+        json.Field("ticks_per_sec", stats.ticks / stats.seconds);
+        json.Field("p50_us", l.Percentile(0.5) * 1e-3);
+        json.Field("p99_us", l.Percentile(0.99) * 1e-3);
+        json.Field("p999_us", l.Percentile(0.999) * 1e-3);
+        json.Field("max_us", l.Max() * 1e-3);
+        json.EndRecord();
+    };
+
+    for (double speed : {0.0, 1.0}) {
+        const size_t ticks = speed == 0 ? (options.quick ? 20000 : 100000) : (options.quick ? 200 : 1000);
+        std::istringstream feed(feedOf(ticks));
+        ReplayStats stats;
+        ReplayFeed(feed, book, speed, nullptr, stats);
+        record(speed == 0 ? "fastest" : "recorded", stats);
+    }
+
+    // without the grouping by underlying every tick would reprice the whole book
+    std::vector<double> rows(8 * numOptions);
+    GreekRows out{rows.data(), rows.data() + numOptions, rows.data() + 2 * numOptions, rows.data() + 3 * numOptions,
+                  rows.data() + 4 * numOptions, rows.data() + 5 * numOptions, rows.data() + 6 * numOptions, rows.data() + 7 * numOptions};
+    const Timing full = Measure([&] { ComputeBatch(book.Options(), out); }, options.minTime);
+    std::fprintf(stderr, "  full book  %6zu options %9.1f us per tick\n", numOptions, full.seconds * 1e6);
+    json.BeginRecord();
+    json.Field("mode", std::string("full_book"));
+    json.Field("options", numOptions);
+    json.Field("us_per_tick", full.seconds * 1e6);
+    json.EndRecord();
+}
+
+// ---- stress scenarios ----
+
+void BenchScenarios(const Options &options, JsonWriter &json) {
+    json.BeginSection("scenarios");
+    std::fprintf(stderr, "scenarios\n");
+    const ShockLattice lattice = {ShockLadder(-0.2, 0.2, 41), ShockLadder(-0.1, 0.1, 21), ShockLadder(-0.01, 0.01, 5)};
+
+    for (size_t n : {size_t(1000), size_t(options.quick ? 5000 : 20000)}) {
+        const OptionBatch book = SyntheticBook(n, 7);
+        std::vector<double> quantity(n);
+        for (size_t k = 0; k < n; ++k) quantity[k] = int(k % 21) - 10;
+
+        // every scenario repriced from scratch, the reference and the baseline (small book only)
+        Timing naive{};
+        double pnlError = 0, deltaError = 0;
+        if (n == 1000) {
+            std::vector<double> pnl(lattice.size()), delta(lattice.size());
+            auto reprice = [&] {
+                double base = 0;
+                for (size_t k = 0; k < n; ++k) {
+                    const GreekPoint g = FusedGreeks(book.K[k], book.S[k], book.r[k], book.q[k], book.sigma[k],
+                                                     ComputeMaturityFactors(book.r[k], book.q[k], book.T[k], book.sigma[k]));
+                    base += quantity[k] * (book.isCall[k] ? g.priceCall : g.pricePut);
+                }
+                for (size_t i = 0; i < lattice.spot.size(); ++i)
+                    for (size_t j = 0; j < lattice.vol.size(); ++j)
+                        for (size_t l = 0; l < lattice.rate.size(); ++l) {
+                            double value = 0, d = 0;
+                            for (size_t k = 0; k < n; ++k) {
+                                const double sigma = std::max(ScenarioMinVol, book.sigma[k] + lattice.vol[j]), r = book.r[k] + lattice.rate[l];
+                                const GreekPoint g = FusedGreeks(book.K[k], book.S[k] * (1 + lattice.spot[i]), r, book.q[k], sigma,
+                                                                 ComputeMaturityFactors(r, book.q[k], book.T[k], sigma));
+                                value += quantity[k] * (book.isCall[k] ? g.priceCall : g.pricePut);
+                                d += quantity[k] * (book.isCall[k] ? g.deltaCall : g.deltaPut);
+                            }
+                            const size_t at = (i * lattice.vol.size() + j) * lattice.rate.size() + l;
+                            pnl[at] = value - base;
+                            delta[at] = d;
+                        }
+            };
+            naive = Measure(reprice, 0);
+
+            ScenarioCube cube;
+            RunScenarios(book, quantity, lattice, cube);
+            double gross = 0, grossDelta = 0;
+            for (size_t k = 0; k < n; ++k) {
+                const GreekPoint g = FusedGreeks(book.K[k], book.S[k], book.r[k], book.q[k], book.sigma[k],
+                                                 ComputeMaturityFactors(book.r[k], book.q[k], book.T[k], book.sigma[k]));
+                gross += std::abs(quantity[k]) * (book.isCall[k] ? g.priceCall : g.pricePut);
+                grossDelta += std::abs(quantity[k] * (book.isCall[k] ? g.deltaCall : g.deltaPut));
+            }
+            for (size_t at = 0; at < lattice.size(); ++at) {
+                pnlError = std::max(pnlError, std::abs(cube.pnl[at] - pnl[at]) / gross);
+                deltaError = std::max(deltaError, std::abs(cube.delta[at] - delta[at]) / grossDelta);
+            }
+            ShockLattice zero = {{0}, {0}, {0}};
+            RunScenarios(book, quantity, zero, cube);
+            if (cube.pnl[0] != 0) std::fprintf(stderr, "  zero shock P&L %g, expected 0\n", cube.pnl[0]);
+        }
+
+        for (size_t threads : options.threads) {
+            ThreadPool pool(threads);
+            ScenarioCube cube;
+            const Timing t = Measure([&] { RunScenarios(book, quantity, lattice, cube, Model_BlackScholes, &pool); }, options.minTime);
+            const double nsPerPoint = t.seconds * 1e9 / double(n * lattice.size());
+            std::fprintf(stderr, "  %6zu options x %zu scenarios, %2zu threads %9.2f ms %6.2f ns/option-scenario", n, lattice.size(), threads,
+                         t.seconds * 1e3, nsPerPoint);
+            if (naive.calls) std::fprintf(stderr, "  x%.1f over repricing, P&L err %.1e Delta err %.1e", naive.seconds / t.seconds, pnlError, deltaError);
+            std::fprintf(stderr, "\n");
+            json.BeginRecord();
+            json.Field("options", n);
+            json.Field("scenarios", lattice.size());
+            json.Field("threads", threads);
+            json.Field("ms_per_lattice", t.seconds * 1e3);
+            json.Field("ns_per_option_scenario", nsPerPoint);
+            json.Field("allocs_per_call", t.allocsPerCall);
+            if (naive.calls) {
+                json.Field("speedup_vs_repricing", naive.seconds / t.seconds);
+                json.Field("pnl_error", pnlError);
+                json.Field("delta_error", deltaError);
+            }
+            json.EndRecord();
+        }
+    }
+}
+
+// ---- American options on trees (Lattice.hpp) ----
+
+void BenchLattice(const Options &options, JsonWriter &json) {
+    json.BeginSection("lattice");
+    std::fprintf(stderr, "lattice\n");
+    const PricingModel models[] = {Model_AmericanCRR, Model_AmericanLeisenReimer, Model_AmericanTrinomial};
+
+    // Accuracy : without dividends an American call is never exercised early, every Greek must match the closed
+    // form. Worst error over a few spots and maturities, as a fraction of the largest |Greek|
+    const double K = 100, r = 0.05, sigma = 0.25;
+    const double spots[] = {80, 90, 100, 110, 120}, maturities[] = {0.25, 1, 2};
+    for (PricingModel model : models)
+        for (size_t steps : {size_t(51), size_t(201), size_t(801)}) {
+            LatticeEngine engine(model, steps);
+            double worst[NumGreekKinds] = {}, largest[NumGreekKinds] = {}, priceError = 0;
+            for (double S : spots)
+                for (double T : maturities) {
+                    const GreekPoint e = FusedGreeks(K, S, r, 0, sigma, ComputeMaturityFactors(r, 0, T, sigma));
+                    const GreekPoint g = engine.Greeks(K, S, T, sigma, r, 0, true, Greek_All);
+                    const double exact[NumGreekKinds] = {e.deltaCall, e.gamma, e.vega, e.thetaCall, e.rhoCall, e.vanna, e.volga, e.charmCall,
+                                                         e.speed, e.color, e.zomma};
+                    const double tree[NumGreekKinds] = {g.deltaCall, g.gamma, g.vega, g.thetaCall, g.rhoCall, g.vanna, g.volga, g.charmCall,
+                                                        g.speed, g.color, g.zomma};
+                    for (size_t k = 0; k < NumGreekKinds; ++k) {
+                        largest[k] = std::max(largest[k], std::fabs(exact[k]));
+                        worst[k] = std::max(worst[k], std::fabs(tree[k] - exact[k]));
+                    }
+                    priceError = std::max(priceError, std::fabs(g.priceCall - e.priceCall));
+                }
+            std::fprintf(stderr, "  %-20s %4zu steps  call price %.1e", ModelNames[model], engine.Steps(), priceError);
+            json.BeginRecord();
+            json.Field("model", std::string(ModelNames[model]));
+            json.Field("steps", engine.Steps());
+            json.Field("call_price_error", priceError);
+            for (size_t k = 0; k < NumGreekKinds; ++k) {
+                std::fprintf(stderr, " %s %.0e", GreekNames[k], worst[k] / largest[k]);
+                json.Field(std::string(GreekNames[k]) + "_error", worst[k] / largest[k]);
+            }
+            std::fprintf(stderr, "\n");
+            json.EndRecord();
+        }
+
+    // American put S 36, K 40, r 6%, sigma 20%, T 1 against a 6401-step Leisen-Reimer tree; cost of one tree
+    LatticeEngine reference(Model_AmericanLeisenReimer, 6401);
+    const double exact = reference.Value(40, 36, 1, 0.2, 0.06, 0, false).price;
+    for (PricingModel model : models)
+        for (size_t steps : {size_t(51), size_t(201), size_t(801)}) {
+            LatticeEngine engine(model, steps);
+            double price = 0;
+            const Timing t = Measure([&] { price = engine.Value(40, 36, 1, 0.2, 0.06, 0, false).price; }, options.minTime);
+            const double n = double(engine.Steps());
+            const double nodes = model == Model_AmericanTrinomial ? n * n : n * (n + 1) / 2;
+            std::fprintf(stderr, "  %-20s %4zu steps  put %.6f error %+.1e  %8.2f us/tree %5.2f ns/node\n", ModelNames[model], engine.Steps(), price,
+                         price - exact, t.seconds * 1e6, t.seconds * 1e9 / nodes);
+            json.BeginRecord();
+            json.Field("model", std::string(ModelNames[model]));
+            json.Field("steps", engine.Steps());
+            json.Field("put_price", price);
+            json.Field("put_error", price - exact);
+            json.Field("us_per_tree", t.seconds * 1e6);
+            json.Field("ns_per_node", t.seconds * 1e9 / nodes);
+            json.Field("allocs_per_call", t.allocsPerCall);
+            json.EndRecord();
+        }
+
+    // GUI grid (201 stock prices x 31 maturities, calls and puts) and books, DefaultLatticeSteps
+    std::vector<double> StockPrices, TimeToMaturities;
+    for (int i = 0; i <= 200; ++i) StockPrices.push_back(i);
+    for (int j = 0; j <= 30; ++j) TimeToMaturities.push_back(0.01 + j * (2 - 0.01) / 30);
+    const size_t n = options.quick ? 200 : 1000;
+    OptionBatch book = SyntheticBook(n, 8);
+    std::vector<double> rows(8 * n);
+    const GreekRows out{rows.data(), rows.data() + n, rows.data() + 2 * n, rows.data() + 3 * n,
+                        rows.data() + 4 * n, rows.data() + 5 * n, rows.data() + 6 * n, rows.data() + 7 * n};
+    GreekTensor values;
+    for (PricingModel model : models) {
+        for (unsigned greeks : {unsigned(Greek_Delta), unsigned(Greek_FirstOrder)}) {
+            double k = 100, s = 100, rate = 0.05, q = 0.02, T = 2, vol = 0.25;
+            values.Reshape(CountFlags(greeks), NumOptionKinds, StockPrices.size(), TimeToMaturities.size());
+            const Timing t = Measure([&] {
+                ComputeGreek(StockPrices, TimeToMaturities, greeks, Option_All, model, k, s, rate, q, T, vol, values);
+            }, 0);
+            const std::string names = JoinNames(GreekList(greeks));
+            std::fprintf(stderr, "  %-20s GUI grid %-26s %8.1f ms\n", ModelNames[model], names.c_str(), t.seconds * 1e3);
+            json.BeginRecord();
+            json.Field("model", std::string(ModelNames[model]));
+            json.Field("grid", std::string("gui"));
+            json.Field("greeks", names);
+            json.Field("ms_per_grid", t.seconds * 1e3);
+            json.EndRecord();
+        }
+        for (size_t threads : options.threads) {
+            ThreadPool pool(threads);
+            const Timing t = Measure([&] { ComputeBatch(book, out, &pool, model); }, 0);
+            std::fprintf(stderr, "  %-20s %6zu options %2zu threads %8.1f us/option (first order Greeks)\n", ModelNames[model], n, threads,
+                         t.seconds * 1e6 / n);
+            json.BeginRecord();
+            json.Field("model", std::string(ModelNames[model]));
+            json.Field("options", n);
+            json.Field("threads", threads);
+            json.Field("us_per_option", t.seconds * 1e6 / n);
+            json.EndRecord();
+        }
+    }
+}
+
+// ---- strike x expiry chains on a smile (Chain.hpp) ----
+
+void BenchChain(const Options &options, JsonWriter &json) {
+    json.BeginSection("chain");
+    std::fprintf(stderr, "chain\n");
+
+    // 500 strikes x 40 expiries around S = 100, skewed smile flattening with T
+    ChainSpec spec;
+    for (size_t i = 0; i < 500; ++i) spec.strikes.push_back(50 + i * 100.0 / 499);
+    for (size_t j = 0; j < 40; ++j) spec.expiries.push_back(0.05 + j * 1.95 / 39);
+    spec.smile.strikes = {50, 75, 100, 125, 150};
+    spec.smile.maturities = {0.05, 0.5, 2};
+    for (double T : spec.smile.maturities)
+        for (double K : spec.smile.strikes) spec.smile.vols.push_back(0.2 + (0.15 * std::log(100 / K) + 0.1 * std::pow(std::log(K / 100), 2)) / std::sqrt(T / 0.05));
+    OptionChain chain;
+    const Timing set = Measure([&] { chain.Set(spec); }, 0);
+    const size_t nK = chain.Strikes().size(), nT = chain.Expiries().size(), n = chain.size();
+    const double S = 100, r = 0.04, q = 0.01;
+
+    // accuracy : every Greek of both types against FusedGreeks at the vol of the contract
+    GreekTensor values;
+    chain.Compute(S, r, q, Greek_All, Option_All, Model_BlackScholes, values);
+    double worst[NumGreekKinds] = {}, largest[NumGreekKinds] = {};
+    for (size_t i = 0; i < nK; ++i)
+        for (size_t j = 0; j < nT; ++j) {
+            const double vol = chain.Vol(i, j);
+            const GreekPoint e = FusedGreeks(chain.Strikes()[i], S, r, q, vol, ComputeMaturityFactors(r, q, chain.Expiries()[j], vol));
+            for (size_t o = 0; o < NumOptionKinds; ++o) {
+                const bool call = o == 0;
+                const double exact[NumGreekKinds] = {call ? e.deltaCall : e.deltaPut, e.gamma, e.vega, call ? e.thetaCall : e.thetaPut,
+                                                     call ? e.rhoCall : e.rhoPut, e.vanna, e.volga, call ? e.charmCall : e.charmPut,
+                                                     e.speed, e.color, e.zomma};
+                for (size_t k = 0; k < NumGreekKinds; ++k) {
+                    largest[k] = std::max(largest[k], std::fabs(exact[k]));
+                    worst[k] = std::max(worst[k], std::fabs(values(k, o, i, j) - exact[k]));
+                }
+            }
+        }
+    std::fprintf(stderr, "  %zu strikes x %zu expiries, smile interpolated in %.2f ms, worst error", nK, nT, set.seconds * 1e3);
+    json.BeginRecord();
+    json.Field("strikes", nK);
+    json.Field("expiries", nT);
+    json.Field("ms_per_set", set.seconds * 1e3);
+    for (size_t k = 0; k < NumGreekKinds; ++k) {
+        std::fprintf(stderr, " %s %.0e", GreekNames[k], worst[k] / largest[k]);
+        json.Field(std::string(GreekNames[k]) + "_error", worst[k] / largest[k]);
+    }
+    std::fprintf(stderr, "\n");
+    json.EndRecord();
+
+    // the same contracts one by one through ComputeBatch, first order Greeks, the first thread count
+    OptionBatch book;
+    for (size_t i = 0; i < nK; ++i)
+        for (size_t j = 0; j < nT; ++j) book.push_back(chain.Strikes()[i], S, chain.Expiries()[j], chain.Vol(i, j), r, q, true);
+    std::vector<double> rows(8 * n);
+    const GreekRows out{rows.data(), rows.data() + n, rows.data() + 2 * n, rows.data() + 3 * n,
+                        rows.data() + 4 * n, rows.data() + 5 * n, rows.data() + 6 * n, rows.data() + 7 * n};
+    ThreadPool first(options.threads.front());
+    const Timing batch = Measure([&] { ComputeBatch(book, out, &first); }, options.minTime);
+
+    for (unsigned greeks : {unsigned(Greek_Delta), unsigned(Greek_FirstOrder), unsigned(Greek_All)})
+        for (size_t threads : options.threads) {
+            if (greeks != Greek_FirstOrder && threads != options.threads.front()) continue;
+            ThreadPool pool(threads);
+            const Timing t = Measure([&] { chain.Compute(S, r, q, greeks, Option_All, Model_BlackScholes, values, &pool); }, options.minTime);
+            const std::string names = greeks == Greek_All ? std::string("all") : JoinNames(GreekList(greeks));
+            std::fprintf(stderr, "  %-26s %2zu threads %8.3f ms/chain %6.2f ns/contract", names.c_str(), threads, t.seconds * 1e3,
+                         t.seconds * 1e9 / n);
+            json.BeginRecord();
+            json.Field("greeks", names);
+            json.Field("threads", threads);
+            json.Field("ms_per_chain", t.seconds * 1e3);
+            json.Field("ns_per_contract", t.seconds * 1e9 / n);
+            json.Field("allocs_per_call", t.allocsPerCall);
+            if (greeks == Greek_FirstOrder && threads == options.threads.front()) {
+                std::fprintf(stderr, "  x%.2f over ComputeBatch (%.3f ms)", batch.seconds / t.seconds, batch.seconds * 1e3);
+                json.Field("speedup_vs_batch", batch.seconds / t.seconds);
+            }
+            std::fprintf(stderr, "\n");
+            json.EndRecord();
+        }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (ParseArguments(argc, argv, options) != 0) return 1;
+
+    JsonWriter json;
+    BenchFunctions(options, json);
+    BenchGrids(options, json);
+    BenchBooks(options, json);
+    BenchImpliedVols(options, json);
+    BenchApproximations(options, json);
+    BenchPrecision(options, json);
+    BenchDecimation(options, json);
+    BenchAdaptive(options, json);
+    BenchAad(options, json);
+    BenchMonteCarlo(options, json);
+    BenchHigherOrder(options, json);
+    BenchProfiler(options, json);
+    BenchStreaming(options, json);
+    BenchScenarios(options, json);
+    BenchLattice(options, json);
+    BenchChain(options, json);
+
+    std::ostringstream header;
+    header << "  \"version\": \"" << GREEKS_VERSION << "\",\n"
+           << "  \"date\": \"" << Today() << "\",\n"
+           << "  \"compiler\": \"" << Compiler() << "\",\n"
+           << "  \"isa\": \"" << VecIsaName() << "\",\n"
+           << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+           << "  \"min_time\": " << options.minTime << ",\n";
+
+    std::ofstream file(options.output);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << options.output << std::endl;
+        return 1;
+    }
+    file << json.Finish(header.str());
+    std::cerr << "Results written to " << options.output << std::endl;
+    return 0;
+}
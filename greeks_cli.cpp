@@ -0,0 +1,637 @@
+// Headless batch mode : reads an option book from CSV and streams the Greeks of every option to CSV or binary.
+// Needs no display, GLFW, OpenGL or Matplot++ (links greeks_core only).
+//
+// Input, one option per line (the first line may be a header) :  K,S,T,sigma,r,q,type      type = Call or Put
+// Any other line that is not an option, or whose T, sigma (and S and K, but with Bachelier) are not positive, is
+// reported on stderr and skipped; the exit code is 1 if no option was read.
+//
+// Usage : greeks_batch <options.csv | -> [--out file] [--binary] [--greeks Delta,Gamma,Vega,Theta,Rho]
+//                      (also Vanna,Volga,Charm,Speed,Color,Zomma, first order Greeks only by default)
+//                      [--model BlackScholes|Black76|Bachelier|AmericanCRR|AmericanLeisenReimer|AmericanTrinomial]
+//                      [--steps N] [--precision Double|Float|Mixed] [--threads N] [--chunk N] [--implied]
+//                      [--portfolio [--buckets 0.25,1,5]]
+//        greeks_batch <positions.csv> --replay <feed.csv | -> [--speed X] [--out file] [--model ...]
+//        greeks_batch <positions.csv> --scenarios [--spot -0.2:0.2:41] [--vol -0.1:0.1:21] [--rate -0.01:0.01:5] [--out file]
+//        greeks_batch <param.txt> --surface out.grs
+//        greeks_batch <param.txt> --chain chain.csv [--out file]
+//        greeks_batch <surface.grs> --inspect
+//
+// With --model Black76 or Bachelier the S column is the forward and q is ignored (GreekSet.hpp). The American models
+// price each option on binomial or trinomial trees of --steps steps (Lattice.hpp) : only the rows of its own type
+// are meaningful, the other type's are NaN.
+// --precision Float or Mixed runs the reduced precision kernels (Precision in GreekSet.hpp) : CSV output
+// then prints the float values, binary output still stores doubles.
+// CSV output repeats the inputs followed by the requested Greeks. Binary output is
+//   "GRKBIN01" | uint32 column count | uint32 0 | column names (16 bytes each, zero padded) | rows of doubles
+// with the requested Greeks only, in input order and native byte order.
+//
+// --implied (Black-Scholes only) reads option prices in the sigma column : the implied volatility (IV) and its status (IVStatus, see
+// ImpliedVol.hpp) are written before the Greeks, which are then taken at the implied volatility (NaN where none fits).
+//
+// --portfolio reads positions instead (underlying,K,S,T,sigma,r,q,type,quantity) and writes the net Greeks of
+// every (underlying, expiry) bucket as CSV, expiry buckets split at the --buckets edges (years).
+//
+// --replay keeps the Greeks of a positions book current under a feed of ticks (time,underlying,spot,vol,rate, see
+// TickReplay.hpp) read from a file, a pipe or stdin, at the recorded pace (--speed 1, the default), faster
+// (--speed 10) or as fast as possible (--speed 0). Each tick reprices the options of its underlying only and writes
+// time,underlying,positions,Delta,Gamma,Vega,Theta,Rho,latency_us with the net Greeks of that underlying; the tick
+// to Greek latency percentiles are printed at the end.
+//
+// --scenarios reprices a positions book under every spot x vol x rate shock of a lattice (Scenario.hpp), each axis
+// given as from:to:steps (or one value) : spot shocks relative, vol and rate shocks absolute. One CSV line per
+// scenario, spot_shock,vol_shock,rate_shock,PnL,Delta,Gamma,Vega,Theta,Rho, with the rate shock fastest.
+//
+// --chain computes every contract of a strike x expiry chain at the vols of its smile (Chain.hpp), with the spot,
+// rate, yield, Greeks, option types and model of a parameter file. One CSV line per contract and option type,
+// K,T,IV,type followed by the Greeks.
+//
+// --surface computes the GUI grid of a parameter file and writes it as a surface file (SurfaceFile.hpp);
+// --inspect maps a surface file, checks it and prints its header.
+#include "Chain.hpp"
+#include "Greeks.hpp"
+#include "ImpliedVol.hpp"
+#include "Lattice.hpp"
+#include "Portfolio.hpp"
+#include "Scenario.hpp"
+#include "TickReplay.hpp"
+#include "SurfaceFile.hpp"
+#include "data.hpp"
+#include "grid.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string input;
+    std::string output;     // empty = stdout
+    bool binary = false;
+    unsigned greeks = Greek_FirstOrder;
+    PricingModel model = Model_BlackScholes;
+    Precision precision = Precision_Double;
+    int threads = 0;
+    size_t steps = 0;       // --steps, trees of the American models
+    size_t chunk = 65536;
+    bool implied = false;
+    bool portfolio = false;
+    std::string surface;    // --surface output
+    std::string chain;      // --chain file
+    bool inspect = false;
+    std::vector<double> buckets = {1.0 / 12, 0.25, 0.5, 1, 2, 5};
+    std::string replay;     // --replay feed
+    double speed = 1;
+    bool scenarios = false;
+    ShockLattice lattice = {ShockLadder(-0.2, 0.2, 41), ShockLadder(-0.1, 0.1, 21), ShockLadder(-0.01, 0.01, 5)};
+};
+
+void Usage() {
+    std::cerr << "Usage: greeks_batch <options.csv | -> [--out file] [--binary] [--greeks Delta,Gamma,...,Zomma] [--model BlackScholes|...|AmericanTrinomial] [--steps N]" << std::endl;
+    std::cerr << "                    [--precision Double|Float|Mixed] [--threads N] [--chunk N] [--implied] [--portfolio [--buckets 0.25,1,5]]" << std::endl;
+    std::cerr << "       greeks_batch <positions.csv> --replay <feed.csv | -> [--speed X] [--out file] [--model BlackScholes|Black76|Bachelier]" << std::endl;
+    std::cerr << "       greeks_batch <positions.csv> --scenarios [--spot from:to:steps] [--vol from:to:steps] [--rate from:to:steps] [--out file]" << std::endl;
+    std::cerr << "       greeks_batch <param.txt> --surface out.grs" << std::endl;
+    std::cerr << "       greeks_batch <param.txt> --chain chain.csv [--out file]" << std::endl;
+    std::cerr << "       greeks_batch <surface.grs> --inspect" << std::endl;
+}
+
+// The whole of `text` as a number. Prints the option and its value otherwise
+template <typename Number>
+bool ParseNumber(const std::string &option, const std::string &text, Number &value) {
+    const char *end = text.data() + text.size();
+    const auto res = std::from_chars(text.data(), end, value);
+    if (res.ec == std::errc() && res.ptr == end) return true;
+    std::cerr << "Invalid value for " << option << ": " << text << std::endl;
+    return false;
+}
+
+// "from:to:steps" or a single shock
+int ParseLadder(const std::string &text, std::vector<double> &ladder) {
+    double from = 0, to = 0;
+    unsigned long steps = 1;
+    char extra;
+    if (std::sscanf(text.c_str(), "%lf:%lf:%lu%c", &from, &to, &steps, &extra) == 3 && steps > 0) {
+        ladder = ShockLadder(from, to, steps);
+        return 0;
+    }
+    if (std::sscanf(text.c_str(), "%lf%c", &from, &extra) == 1) {
+        ladder = {from};
+        return 0;
+    }
+    std::cerr << "Invalid shock ladder (from:to:steps or one value): " << text << std::endl;
+    return -1;
+}
+
+int ParseArguments(int argc, char **argv, Options &options) {
+    for (int a = 1; a < argc; ++a) {
+        const std::string arg = argv[a];
+        const bool hasValue = a + 1 < argc;
+        if (arg == "--out" && hasValue) options.output = argv[++a];
+        else if (arg == "--binary") options.binary = true;
+        else if (arg == "--greeks" && hasValue) {
+            if (ParseGreeks(argv[++a], options.greeks) != 0) return -1;
+        }
+        else if (arg == "--model" && hasValue) {
+            if (ParseModel(argv[++a], options.model) != 0) return -1;
+        }
+        else if (arg == "--precision" && hasValue) {
+            if (ParsePrecision(argv[++a], options.precision) != 0) return -1;
+        }
+        else if (arg == "--threads" && hasValue) {
+            if (!ParseNumber(arg, argv[++a], options.threads)) return -1;
+        }
+        else if (arg == "--steps" && hasValue) {
+            if (!ParseNumber(arg, argv[++a], options.steps)) return -1;
+        }
+        else if (arg == "--chunk" && hasValue) {
+            if (!ParseNumber(arg, argv[++a], options.chunk)) return -1;
+        }
+        else if (arg == "--implied") options.implied = true;
+        else if (arg == "--portfolio") options.portfolio = true;
+        else if (arg == "--surface" && hasValue) options.surface = argv[++a];
+        else if (arg == "--chain" && hasValue) options.chain = argv[++a];
+        else if (arg == "--inspect") options.inspect = true;
+        else if (arg == "--replay" && hasValue) options.replay = argv[++a];
+        else if (arg == "--speed" && hasValue) {
+            if (!ParseNumber(arg, argv[++a], options.speed)) return -1;
+        }
+        else if (arg == "--scenarios") options.scenarios = true;
+        else if ((arg == "--spot" || arg == "--vol" || arg == "--rate") && hasValue) {
+            std::vector<double> &ladder = arg == "--spot" ? options.lattice.spot : arg == "--vol" ? options.lattice.vol : options.lattice.rate;
+            if (ParseLadder(argv[++a], ladder) != 0) return -1;
+        }
+        else if (arg == "--buckets" && hasValue) {
+            std::stringstream list(argv[++a]);
+            std::string item;
+            options.buckets.clear();
+            while (std::getline(list, item, ',')) {
+                double edge;
+                if (!ParseNumber(arg, item, edge)) return -1;
+                options.buckets.push_back(edge);
+            }
+        }
+        else if (options.input.empty() && (arg == "-" || arg[0] != '-')) options.input = arg;
+        else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return -1;
+        }
+    }
+    if (options.input.empty() || options.chunk == 0) return -1;
+    if (options.model != Model_BlackScholes && (options.implied || options.portfolio)) {
+        std::cerr << "--implied and --portfolio use the Black-Scholes model only." << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// Parse "K,S,T,sigma,r,q,type" into the batch. Returns nullptr, or why the line is not an option that can be priced
+// (header, blank, values out of the domain of the model), and then leaves the batch untouched. With `implied` the
+// sigma column holds a price, checked by the solver (IVStatus BadInput)
+const char *ParseOption(const std::string &line, OptionBatch &batch, PricingModel model, bool implied) {
+    double v[6];
+    const char *p = line.data(), *end = line.data() + line.size();
+    for (double &x : v) {
+        while (p < end && (*p == ' ' || *p == '\t')) ++p;
+        auto res = std::from_chars(p, end, x);
+        if (res.ec != std::errc()) return "not K,S,T,sigma,r,q,Call|Put";
+        p = res.ptr;
+        while (p < end && (*p == ' ' || *p == '\t')) ++p;
+        if (p == end || *p != ',') return "not K,S,T,sigma,r,q,Call|Put";
+        ++p;
+    }
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    const char *type = p;
+    while (p < end && *p != ' ' && *p != '\t') ++p;
+    const bool isCall = (p - type == 4 && std::strncmp(type, "Call", 4) == 0);
+    const bool isPut = (p - type == 3 && std::strncmp(type, "Put", 3) == 0);
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if ((!isCall && !isPut) || p != end) return "not K,S,T,sigma,r,q,Call|Put";
+    // the Greeks of an expired option or of a zero vol are NaN, a negative vol gives plausible but meaningless
+    // values; Bachelier alone takes a forward and a strike of any sign
+    const double K = v[0], S = v[1], T = v[2], sigma = v[3];
+    if (!std::all_of(std::begin(v), std::end(v), [](double x) { return std::isfinite(x); })) return "value not finite";
+    if (!(T > 0)) return "T <= 0";
+    if (!implied && !(sigma > 0)) return "sigma <= 0";
+    if (model != Model_Bachelier && !(S > 0)) return "S <= 0";
+    if (model != Model_Bachelier && !(K > 0)) return "K <= 0";
+    batch.push_back(v[0], v[1], v[2], v[3], v[4], v[5], isCall);
+    return nullptr;
+}
+
+// A header is a first line whose first field is not a number
+bool IsHeader(const std::string &line) {
+    double x;
+    const char *p = line.data(), *end = line.data() + line.size();
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    return std::from_chars(p, end, x).ec != std::errc();
+}
+
+void AppendNumber(std::string &out, double x) {
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof buf, x);
+    out.append(buf, res.ptr);
+}
+
+// shortest representation of the float, not of its double widening
+void AppendNumber(std::string &out, float x) {
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof buf, x);
+    out.append(buf, res.ptr);
+}
+
+// Net Greeks per (underlying, expiry) bucket of a positions file
+int RunPortfolio(const Options &options, std::istream &in, std::ostream &out) {
+    PortfolioAggregator portfolio(options.buckets);
+    PositionChunk chunk;
+    while (portfolio.ReadChunk(in, options.chunk, chunk) > 0) portfolio.Add(chunk);
+
+    std::string text = "underlying,expiry_from,expiry_to,positions,Delta,Gamma,Vega,Theta,Rho\n";
+    auto append = [&](const std::string &name, double from, double to, const NetGreeks &g) {
+        text += name; text += ',';
+        AppendNumber(text, from); text += ',';
+        AppendNumber(text, to); text += ',';
+        text += std::to_string(g.positions);
+        for (double x : {g.delta, g.gamma, g.vega, g.theta, g.rho}) {
+            text += ',';
+            AppendNumber(text, x);
+        }
+        text += '\n';
+    };
+    for (const PortfolioAggregator::Bucket &b : portfolio.Buckets()) append(b.underlying, b.expiryFrom, b.expiryTo, b.greeks);
+    const NetGreeks total = portfolio.Total();
+    append("TOTAL", 0, std::numeric_limits<double>::infinity(), total);
+    out << text;
+    out.flush();
+
+    std::cerr << total.positions << " positions aggregated";
+    if (portfolio.SkippedLines()) std::cerr << ", " << portfolio.SkippedLines() << " lines skipped";
+    std::cerr << std::endl;
+    return out ? 0 : 1;
+}
+
+// Net Greeks per underlying of a positions file, updated tick by tick from a feed
+int RunReplay(const Options &options, std::istream &in, std::ostream &out) {
+    if (options.input == "-" && options.replay == "-") {
+        std::cerr << "The positions and the feed cannot both come from stdin." << std::endl;
+        return 1;
+    }
+    StreamingBook book(options.model);
+    if (book.Load(in) != 0) return 1;
+
+    std::ifstream file;
+    if (options.replay != "-") {
+        file.open(options.replay);
+        if (!file.is_open()) {
+            std::cerr << "Error opening file: " << options.replay << std::endl;
+            return 1;
+        }
+    }
+    std::istream &feed = (options.replay == "-") ? std::cin : file;
+
+    // one line per tick, flushed so that a reader of a pipe sees it at once
+    out << "time,underlying,positions,Delta,Gamma,Vega,Theta,Rho,latency_us\n";
+    std::string text;
+    auto publish = [&](const Tick &tick, size_t u, uint64_t latencyNs) {
+        const NetGreeks &g = book.Net(u);
+        text.clear();
+        AppendNumber(text, tick.time); text += ',';
+        text += book.Underlying(u); text += ',';
+        text += std::to_string(g.positions);
+        for (double x : {g.delta, g.gamma, g.vega, g.theta, g.rho}) {
+            text += ',';
+            AppendNumber(text, x);
+        }
+        text += ',';
+        AppendNumber(text, latencyNs * 1e-3);
+        text += '\n';
+        out << text;
+        out.flush();
+    };
+    ReplayStats stats;
+    if (ReplayFeed(feed, book, options.speed, publish, stats) != 0) return 1;
+
+    const LatencyHistogram &l = stats.latency;
+    std::fprintf(stderr, "%zu ticks in %.3f s (%zu ignored), %.1f options repriced per tick\n", stats.ticks, stats.seconds, stats.ignored,
+                 stats.ticks ? double(stats.optionsRepriced) / stats.ticks : 0.0);
+    std::fprintf(stderr, "tick to Greeks latency : p50 %.1f us  p99 %.1f us  p99.9 %.1f us  max %.1f us\n", l.Percentile(0.5) * 1e-3,
+                 l.Percentile(0.99) * 1e-3, l.Percentile(0.999) * 1e-3, l.Max() * 1e-3);
+    return out ? 0 : 1;
+}
+
+// P&L and net Greeks of a positions book under every scenario of a shock lattice
+int RunScenarioLattice(const Options &options, std::istream &in, std::ostream &out) {
+    PortfolioAggregator reader(std::vector<double>{});
+    PositionChunk chunk;
+    OptionBatch book;
+    std::vector<double> quantity;
+    while (reader.ReadChunk(in, options.chunk, chunk) > 0) {
+        const OptionBatch &o = chunk.options;
+        for (size_t k = 0; k < chunk.size(); ++k) book.push_back(o.K[k], o.S[k], o.T[k], o.sigma[k], o.r[k], o.q[k], o.isCall[k] != 0);
+        quantity.insert(quantity.end(), chunk.quantity.begin(), chunk.quantity.end());
+    }
+
+    ScenarioCube cube;
+    const auto start = std::chrono::steady_clock::now();
+    if (RunScenarios(book, quantity, options.lattice, cube, options.model) != 0) return 1;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const ShockLattice &l = cube.lattice;
+    std::string text = "spot_shock,vol_shock,rate_shock,PnL,Delta,Gamma,Vega,Theta,Rho\n";
+    for (size_t i = 0; i < l.spot.size(); ++i)
+        for (size_t j = 0; j < l.vol.size(); ++j)
+            for (size_t r = 0; r < l.rate.size(); ++r) {
+                const size_t at = cube.Index(i, j, r);
+                AppendNumber(text, l.spot[i]); text += ',';
+                AppendNumber(text, l.vol[j]); text += ',';
+                AppendNumber(text, l.rate[r]);
+                for (double x : {cube.pnl[at], cube.delta[at], cube.gamma[at], cube.vega[at], cube.theta[at], cube.rho[at]}) {
+                    text += ',';
+                    AppendNumber(text, x);
+                }
+                text += '\n';
+            }
+    out << text;
+    out.flush();
+
+    std::fprintf(stderr, "%zu positions x %zu scenarios in %.1f ms, book value %.6g\n", book.size(), l.size(), seconds * 1e3, cube.baseValue);
+    if (reader.SkippedLines()) std::cerr << reader.SkippedLines() << " lines skipped" << std::endl;
+    return out ? 0 : 1;
+}
+
+// Greeks of every contract of a chain, at the parameters of a parameter file
+int RunChain(const Options &options, std::ostream &out) {
+    Parameters params;
+    ReadParameters(options.input, params);
+    ChainSpec spec;
+    OptionChain chain;
+    if (ReadChainFile(options.chain, spec) != 0 || chain.Set(spec) != 0) return 1;
+
+    GreekTensor values;
+    const auto start = std::chrono::steady_clock::now();
+    if (chain.Compute(params.S0, params.r, params.q, params.greeks, params.options, params.model, values) != 0) return 1;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const std::vector<std::string> greeks = GreekList(params.greeks), types = OptionList(params.options);
+    std::string text = "K,T,IV,type";
+    for (const std::string &name : greeks) text += ',' + name;
+    text += '\n';
+    for (size_t i = 0; i < chain.Strikes().size(); ++i)
+        for (size_t j = 0; j < chain.Expiries().size(); ++j)
+            for (size_t o = 0; o < types.size(); ++o) {
+                AppendNumber(text, chain.Strikes()[i]); text += ',';
+                AppendNumber(text, chain.Expiries()[j]); text += ',';
+                AppendNumber(text, chain.Vol(i, j)); text += ',';
+                text += types[o];
+                for (size_t g = 0; g < greeks.size(); ++g) {
+                    text += ',';
+                    AppendNumber(text, values(g, o, i, j));
+                }
+                text += '\n';
+            }
+    out << text;
+    out.flush();
+
+    std::fprintf(stderr, "%zu strikes x %zu expiries in %.3f ms\n", chain.Strikes().size(), chain.Expiries().size(), seconds * 1e3);
+    return out ? 0 : 1;
+}
+
+// GUI grid of a parameter file, written as a surface file
+int RunSurface(const Options &options) {
+    Parameters params;
+    ReadParameters(options.input, params);
+    if (params.treeSteps && !options.steps) SetLatticeSteps(params.treeSteps);
+    GreekGrid grid;
+    grid.request = {params.K, params.S0, params.r, params.q, params.T, params.sigma,
+                    static_cast<int>(params.numMaturities), params.greeks, params.options, params.model, params.grid, params.gridPoints};
+    RecomputeRequest &p = grid.request;
+    if (Recompute(p.K, p.S0, p.r, p.q, p.T, p.sigma, p.numMaturities, p.greeks, p.options, p.model,
+                  grid.StockPrices, grid.TimeToMaturities, grid.GreekValues, nullptr, p.grid, p.gridPoints) != 0) return 1;
+    if (WriteSurface(options.surface, grid) != 0) return 1;
+    std::cerr << grid.GreekValues.NumGreeks() << "x" << grid.GreekValues.NumOptions() << " slices of "
+              << grid.StockPrices.size() << "x" << grid.TimeToMaturities.size() << " points written to " << options.surface << std::endl;
+    return 0;
+}
+
+// Header of a surface file, after a full checksum
+int RunInspect(const Options &options) {
+    MappedSurface surface;
+    if (surface.Open(options.input) != 0) return 1;
+    const SurfaceHeader &h = surface.Header();
+    std::cout << "version " << h.version << ", " << h.fileBytes << " bytes, payload checksum "
+              << (surface.Verify() ? "ok" : "MISMATCH") << '\n'
+              << "K=" << h.K << " S0=" << h.S0 << " r=" << h.r << " q=" << h.q << " T=" << h.T << " sigma=" << h.sigma
+              << " numMaturities=" << h.numMaturities << " model=" << ModelNames[h.model] << '\n'
+              << "stocks " << h.stocks << " [" << surface.StockPrices()[0] << ", " << surface.StockPrices()[h.stocks - 1] << "], "
+              << "maturities " << h.maturities << " [" << surface.TimeToMaturities()[0] << ", " << surface.TimeToMaturities()[h.maturities - 1] << "]\n";
+    for (size_t g = 0; g < surface.NumGreeks(); ++g)
+        for (size_t o = 0; o < surface.NumOptions(); ++o) {
+            const SliceView<const double> slice = surface.Slice(g, o);
+            const size_t i = slice.rows / 2, j = slice.cols - 1;
+            std::cout << surface.GreekName(g) << ' ' << surface.OptionName(o) << " at S=" << surface.StockPrices()[i]
+                      << " T=" << surface.TimeToMaturities()[j] << " : " << slice(i, j) << '\n';
+        }
+    return std::cout ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (ParseArguments(argc, argv, options) != 0) {
+        Usage();
+        return 1;
+    }
+    SetNumThreads(options.threads > 0 ? options.threads : 0);
+    if (options.steps) SetLatticeSteps(options.steps);
+    if (!options.surface.empty()) return RunSurface(options);
+    if (options.inspect) return RunInspect(options);
+
+    std::ifstream file;
+    if (options.input != "-") {
+        file.open(options.input);
+        if (!file.is_open()) {
+            std::cerr << "Error opening file: " << options.input << std::endl;
+            return 1;
+        }
+    }
+    std::istream &in = (options.input == "-") ? std::cin : file;
+
+    std::ofstream outFile;
+    if (!options.output.empty()) {
+        outFile.open(options.output, options.binary ? std::ios::binary : std::ios::out);
+        if (!outFile.is_open()) {
+            std::cerr << "Error opening file: " << options.output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = options.output.empty() ? std::cout : outFile;
+
+    if (!options.chain.empty()) return RunChain(options, out);
+    if (!options.replay.empty()) return RunReplay(options, in, out);
+    if (options.scenarios) return RunScenarioLattice(options, in, out);
+    if (options.portfolio) return RunPortfolio(options, in, out);
+
+    // requested greeks, in the engine order
+    std::vector<int> greeks;
+    for (int g = 0; g < static_cast<int>(NumGreekKinds); ++g)
+        if (options.greeks & (1u << g)) greeks.push_back(g);
+
+    // header
+    if (options.binary) {
+        const uint32_t columns = static_cast<uint32_t>(greeks.size() + (options.implied ? 2 : 0)), reserved = 0;
+        out.write("GRKBIN01", 8);
+        out.write(reinterpret_cast<const char *>(&columns), sizeof columns);
+        out.write(reinterpret_cast<const char *>(&reserved), sizeof reserved);
+        auto writeName = [&](const char *column) {
+            char name[16] = {};
+            std::strncpy(name, column, sizeof name - 1);
+            out.write(name, sizeof name);
+        };
+        if (options.implied) {
+            writeName("IV");
+            writeName("IVStatus");
+        }
+        for (int g : greeks) writeName(GreekNames[g]);
+    } else {
+        out << (options.implied ? "K,S,T,price,r,q,type,IV,IVStatus" : "K,S,T,sigma,r,q,type");
+        for (int g : greeks) out << ',' << GreekNames[g];
+        out << '\n';
+    }
+
+    OptionBatch batch;
+    const bool reduced = options.precision != Precision_Double;
+    const bool higherOrder = (options.greeks & Greek_HigherOrder) != 0;
+    const size_t numRows = higherOrder ? 15 : 8;
+    std::vector<double> values(reduced ? 0 : numRows * options.chunk);
+    std::vector<float> valuesF(reduced ? numRows * options.chunk : 0);
+    std::string text;
+    std::vector<double> record;
+    std::vector<double> prices, vols;
+    std::vector<unsigned char> ivStatus;
+    size_t total = 0, skipped = 0, unsolved = 0, lines = 0;
+
+    std::string line;
+    bool eof = false;
+    while (!eof) {
+        // read one chunk
+        batch.clear();
+        while (batch.size() < options.chunk) {
+            if (!std::getline(in, line)) {
+                eof = true;
+                break;
+            }
+            ++lines;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            // the first line may be a header, any other line that is not an option is reported
+            if (line.empty()) continue;
+            const char *error = ParseOption(line, batch, options.model, options.implied);
+            if (error && !(lines == 1 && IsHeader(line))) {
+                std::cerr << "Skipping line " << lines << " (" << error << "): " << line << std::endl;
+                ++skipped;
+            }
+        }
+        const size_t n = batch.size();
+        if (n == 0) break;
+
+        // compute, at the implied volatility of the price in the sigma column with --implied
+        if (options.implied) {
+            prices.assign(batch.sigma.begin(), batch.sigma.end());
+            ComputeImpliedVols(batch, prices, vols, ivStatus);
+            batch.sigma.assign(vols.begin(), vols.end());
+            for (size_t k = 0; k < n; ++k) unsolved += ivStatus[k] != Iv_Ok;
+        }
+        GreekRows rows;
+        GreekRowsF rowsF;
+        // higher order rows after the first eight, only when requested
+        auto setRows = [&](auto &r, auto *base) {
+            r = {base, base + n, base + 2 * n, base + 3 * n, base + 4 * n, base + 5 * n, base + 6 * n, base + 7 * n};
+            if (!higherOrder) return;
+            r.vanna = base + 8 * n; r.volga = base + 9 * n; r.charmCall = base + 10 * n; r.charmPut = base + 11 * n;
+            r.speed = base + 12 * n; r.color = base + 13 * n; r.zomma = base + 14 * n;
+        };
+        if (reduced) {
+            setRows(rowsF, valuesF.data());
+            ComputeBatch(batch, rowsF, options.precision, nullptr, options.model);
+        } else {
+            setRows(rows, values.data());
+            ComputeBatch(batch, rows, nullptr, options.model);
+        }
+
+        // value of greek g for option k, picking the call or put row
+        auto pick = [&](const auto &r, int g, size_t k) {
+            const bool call = batch.isCall[k];
+            switch (g) {
+                case 0: return call ? r.deltaCall[k] : r.deltaPut[k];
+                case 1: return r.gamma[k];
+                case 2: return r.vega[k];
+                case 3: return call ? r.thetaCall[k] : r.thetaPut[k];
+                case 4: return call ? r.rhoCall[k] : r.rhoPut[k];
+                case 5: return r.vanna[k];
+                case 6: return r.volga[k];
+                case 7: return call ? r.charmCall[k] : r.charmPut[k];
+                case 8: return r.speed[k];
+                case 9: return r.color[k];
+                default: return r.zomma[k];
+            }
+        };
+        auto value = [&](int g, size_t k) { return reduced ? double(pick(rowsF, g, k)) : pick(rows, g, k); };
+
+        // write
+        if (options.binary) {
+            const size_t first = options.implied ? 2 : 0, columns = first + greeks.size();
+            record.resize(n * columns);
+            for (size_t k = 0; k < n; ++k) {
+                if (options.implied) {
+                    record[k * columns] = vols[k];
+                    record[k * columns + 1] = ivStatus[k];
+                }
+                for (size_t c = 0; c < greeks.size(); ++c) record[k * columns + first + c] = value(greeks[c], k);
+            }
+            out.write(reinterpret_cast<const char *>(record.data()), record.size() * sizeof(double));
+        } else {
+            text.clear();
+            for (size_t k = 0; k < n; ++k) {
+                AppendNumber(text, batch.K[k]); text += ',';
+                AppendNumber(text, batch.S[k]); text += ',';
+                AppendNumber(text, batch.T[k]); text += ',';
+                AppendNumber(text, options.implied ? prices[k] : batch.sigma[k]); text += ',';
+                AppendNumber(text, batch.r[k]); text += ',';
+                AppendNumber(text, batch.q[k]); text += ',';
+                text += batch.isCall[k] ? "Call" : "Put";
+                if (options.implied) {
+                    text += ',';
+                    AppendNumber(text, vols[k]);
+                    text += ',';
+                    text += IvStatusName(ivStatus[k]);
+                }
+                for (int g : greeks) {
+                    text += ',';
+                    if (reduced) AppendNumber(text, pick(rowsF, g, k));
+                    else AppendNumber(text, pick(rows, g, k));
+                }
+                text += '\n';
+            }
+            out.write(text.data(), text.size());
+        }
+        total += n;
+    }
+    out.flush();
+
+    std::cerr << total << " options priced";
+    if (options.implied) std::cerr << ", " << unsolved << " implied volatilities not solved";
+    if (skipped) std::cerr << ", " << skipped << " lines skipped";
+    std::cerr << std::endl;
+    // a book of which nothing could be read, empty or not, is an error rather than an empty result
+    return out && total > 0 ? 0 : 1;
+}
@@ -0,0 +1,413 @@
+// Accuracy tests of the engine, one ctest test per section :
+//
+//   precision : float and mixed precision grids of every closed-form model against the double grid, per Greek and
+//               option type, over the whole grid, the maturities under a week and the deep out of the money options
+//   aad       : AAD price and sensitivities of every closed-form model against the analytic Greeks
+//   lattice   : Greeks of the American trees against the closed form on calls without dividends, and trees at vols
+//               too low for a binomial tree to branch
+//   implied   : implied vols of prices at their intrinsic value, within its rounding, below it and tiny out of the money
+//   adaptive  : adaptive grid axes within their point budget, probes included, and budgets too small to be met
+//   decimation : LTTB decimation of curves with gaps, buckets of non-finite values keeping no point
+//   approx    : GreekApprox tables against the exact functions inside their domain, on its faces and corners
+//
+// Each check prints a line when it fails; the process exits with 1 if any did. greeks_bench measures the speed of
+// the same code paths, these tests hold the bounds the README documents.
+//
+// Usage : greeks_tests [section ...]   (every section by default)
+#include "Aad.hpp"
+#include "Decimate.hpp"
+#include "GreekApprox.hpp"
+#include "Greeks.hpp"
+#include "ImpliedVol.hpp"
+#include "Lattice.hpp"
+#include "grid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+int g_checks = 0, g_failures = 0;
+
+// Counts a check, prints it (printf format) when it fails
+void Expect(bool ok, const char *format, ...) {
+    ++g_checks;
+    if (ok) return;
+    ++g_failures;
+    std::va_list args;
+    va_start(args, format);
+    std::fprintf(stderr, "  FAILED ");
+    std::vfprintf(stderr, format, args);
+    std::fprintf(stderr, "\n");
+    va_end(args);
+}
+
+// ---- float and mixed precision grids against the double grid ----
+
+// Worst errors of one Greek allowed at a reduced precision : `scaled` against the largest |Greek| of the grid,
+// the others relative, over the points whose |Greek| is above `floor` times the largest
+struct PrecisionBound {
+    double scaled, relative, week, deepOtm, floor;
+};
+
+// Per Greek (Delta ... Rho), for Float and Mixed. Theta crosses zero : its relative error is taken 1e-3 of its
+// largest value away from it. Rho of Black76 is -T times the price, whose float N(d1) and N(d2) cancel in the money
+const PrecisionBound FloatBounds[5] = {{1e-5, 1e-4, 1e-4, 2e-5, 1e-6}, {1e-5, 1e-4, 1e-4, 2e-5, 1e-6}, {1e-6, 1e-4, 1e-4, 2e-5, 1e-6},
+                                       {1e-5, 5e-4, 5e-4, 2e-5, 1e-3}, {1e-6, 2e-4, 2e-4, 1e-4, 1e-6}};
+const PrecisionBound MixedBounds[5] = {{5e-7, 5e-6, 5e-6, 5e-6, 1e-6}, {5e-7, 5e-6, 5e-6, 5e-6, 1e-6}, {5e-7, 5e-6, 5e-6, 5e-6, 1e-6},
+                                       {5e-7, 2e-5, 2e-5, 5e-6, 1e-3}, {5e-7, 5e-6, 5e-6, 5e-6, 1e-6}};
+const PrecisionBound Black76RhoBound[2] = {{1e-6, 2e-4, 2e-4, 1e-4, 1e-6}, {5e-7, 2e-4, 2e-4, 1e-4, 1e-6}};
+
+void TestPrecision() {
+    // deep out of the money (S / K down to 0.002) to deep in, maturities from 9 hours to 2 years on a log scale
+    const size_t nS = 1000, nT = 200;
+    double K = 100, S = 100, r = 0.05, q = 0.01, T = 2.0;
+    std::vector<double> StockPrices(nS), TimeToMaturities(nT);
+    for (size_t i = 0; i < nS; ++i) StockPrices[i] = (i + 1) * 2 * K / nS;
+    for (size_t j = 0; j < nT; ++j) TimeToMaturities[j] = 1e-3 * std::pow(T / 1e-3, double(j) / (nT - 1));
+    const unsigned greeks = Greek_FirstOrder;
+    GreekTensor reference(CountFlags(greeks), NumOptionKinds, nS, nT);
+    GreekTensorF values(CountFlags(greeks), NumOptionKinds, nS, nT);
+
+    for (size_t model = 0; model < NumClosedFormModels; ++model) {
+        const PricingModel m = static_cast<PricingModel>(model);
+        double sigma = m == Model_Bachelier ? 20.0 : 0.2;   // normal vol in price units
+        ComputeGreek(StockPrices, TimeToMaturities, greeks, Option_All, m, K, S, r, q, T, sigma, reference);
+        for (Precision p : {Precision_Float, Precision_Mixed}) {
+            ComputeGreek(StockPrices, TimeToMaturities, greeks, Option_All, m, K, S, r, q, T, sigma, values, p);
+            for (size_t g = 0; g < reference.NumGreeks(); ++g)
+                for (size_t o = 0; o < NumOptionKinds; ++o) {
+                    const PrecisionBound &bound = m == Model_Black76 && g == 4 ? Black76RhoBound[p == Precision_Mixed]
+                                                                               : (p == Precision_Float ? FloatBounds : MixedBounds)[g];
+                    const SliceView<const double> ref = static_cast<const GreekTensor &>(reference).Slice(g, o);
+                    const SliceView<const float> got = static_cast<const GreekTensorF &>(values).Slice(g, o);
+                    double largest = 0;
+                    for (size_t i = 0; i < nS; ++i)
+                        for (size_t j = 0; j < nT; ++j) largest = std::max(largest, std::fabs(ref(i, j)));
+                    double scaled = 0, relative = 0, week = 0, deepOtm = 0, flushed = 0;
+                    for (size_t i = 0; i < nS; ++i) {
+                        const double moneyness = std::log(StockPrices[i] / K);
+                        const bool otm = (o == 0 ? -moneyness : moneyness) > 0.5;
+                        for (size_t j = 0; j < nT; ++j) {
+                            const double error = std::fabs(got(i, j) - ref(i, j));
+                            scaled = std::max(scaled, error / largest);
+                            if (got(i, j) == 0) flushed = std::max(flushed, std::fabs(ref(i, j)) / largest);
+                            if (!std::isfinite(got(i, j))) scaled = INFINITY;
+                            if (std::fabs(ref(i, j)) < bound.floor * largest) continue;
+                            const double rel = error / std::fabs(ref(i, j));
+                            relative = std::max(relative, rel);
+                            if (TimeToMaturities[j] < 7.0 / 365) week = std::max(week, rel);
+                            if (otm) deepOtm = std::max(deepOtm, rel);
+                        }
+                    }
+                    const char *names[3] = {ModelNames[model], PrecisionNames[p], OptionNames[o]};
+                    Expect(scaled <= bound.scaled, "%s %s %s %s : error %.2g of the largest |Greek| > %.2g", names[0], names[1],
+                           GreekNames[g], names[2], scaled, bound.scaled);
+                    Expect(relative <= bound.relative, "%s %s %s %s : relative error %.2g > %.2g", names[0], names[1], GreekNames[g],
+                           names[2], relative, bound.relative);
+                    Expect(week <= bound.week, "%s %s %s %s : relative error under a week %.2g > %.2g", names[0], names[1], GreekNames[g],
+                           names[2], week, bound.week);
+                    Expect(deepOtm <= bound.deepOtm, "%s %s %s %s : relative error deep out of the money %.2g > %.2g", names[0], names[1],
+                           GreekNames[g], names[2], deepOtm, bound.deepOtm);
+                    // only values below the float range (1e-38) may be flushed to 0
+                    Expect(flushed < 1e-30, "%s %s %s %s : %.2g of the largest |Greek| flushed to 0", names[0], names[1], GreekNames[g],
+                           names[2], flushed);
+                }
+        }
+    }
+}
+
+// ---- AAD sensitivities against the analytic Greeks ----
+
+// Random but reproducible contracts around K = 100, as the books of greeks_bench
+OptionBatch SyntheticBook(size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> S(50, 150), T(0.02, 3), sigma(0.05, 0.8), r(0, 0.08), q(0, 0.04), type(0, 1);
+    OptionBatch book;
+    for (size_t k = 0; k < n; ++k) book.push_back(100.0, S(rng), T(rng), sigma(rng), r(rng), q(rng), type(rng) < 0.5);
+    return book;
+}
+
+void TestAad() {
+    // Errors relative to the analytic value, floored at 1e-6 of the largest |value| : deep in or out of the money,
+    // the terms of the chain rule cancel and a tiny Delta or Rho keeps only an absolute accuracy
+    const double tolerance = 1e-9, floor = 1e-6;
+    const size_t n = 4096;
+    std::vector<AadSensitivities> aad(n);
+    std::vector<double> rows(8 * n);
+    const GreekRows analytic{rows.data(), rows.data() + n, rows.data() + 2 * n, rows.data() + 3 * n,
+                             rows.data() + 4 * n, rows.data() + 5 * n, rows.data() + 6 * n, rows.data() + 7 * n};
+    AadTape tape;
+    for (size_t model = 0; model < NumClosedFormModels; ++model) {
+        const PricingModel m = static_cast<PricingModel>(model);
+        OptionBatch book = SyntheticBook(n, 5);
+        if (m == Model_Bachelier)
+            for (size_t k = 0; k < n; ++k) book.sigma[k] *= book.S[k];   // normal vol in price units
+        ComputeAadBatch(book, 0, n, aad.data(), tape, m);
+        FusedGreeksBatch(book, 0, n, analytic, m);
+
+        // price and dV/dq of Black-Scholes from the scalar Price and the closed form of dV/dq, the others from the
+        // call or put rows of the kernels
+        static const char *const names[6] = {"Price", "Delta", "Vega", "Theta", "Rho", "Dividend"};
+        std::vector<double> ref(n);
+        for (size_t s = 0; s < 6; ++s) {
+            if ((s == 0 || s == 5) && m != Model_BlackScholes) continue;
+            for (size_t k = 0; k < n; ++k) {
+                double K = book.K[k], S = book.S[k], r = book.r[k], q = book.q[k], T = book.T[k], sigma = book.sigma[k];
+                const bool call = book.isCall[k] != 0;
+                const double sign = call ? 1.0 : -1.0;
+                switch (s) {
+                case 0: ref[k] = Price(K, S, r, q, T, sigma, call); break;
+                case 1: ref[k] = (call ? analytic.deltaCall : analytic.deltaPut)[k]; break;
+                case 2: ref[k] = analytic.vega[k]; break;
+                case 3: ref[k] = (call ? analytic.thetaCall : analytic.thetaPut)[k]; break;
+                case 4: ref[k] = (call ? analytic.rhoCall : analytic.rhoPut)[k]; break;
+                default: ref[k] = -sign * T * S * std::exp(-q * T) * norm_cdf(0.0, 1.0, sign * d1(K, S, r, q, T, sigma)); break;
+                }
+            }
+            double largest = 0, worst = 0;
+            for (size_t k = 0; k < n; ++k) largest = std::max(largest, std::fabs(ref[k]));
+            for (size_t k = 0; k < n; ++k) {
+                const AadSensitivities &a = aad[k];
+                const double got[6] = {a.price, a.delta, a.vega, a.theta, a.rho, a.dividend};
+                worst = std::max(worst, std::fabs(got[s] - ref[k]) / std::max(std::fabs(ref[k]), floor * largest));
+            }
+            Expect(worst <= tolerance, "%s %s : relative error %.2g > %.2g", ModelNames[model], names[s], worst, tolerance);
+        }
+    }
+}
+
+// ---- American trees ----
+
+void TestLattice() {
+    const PricingModel models[] = {Model_AmericanCRR, Model_AmericanLeisenReimer, Model_AmericanTrinomial};
+
+    // Without dividends an American call is never exercised early : every Greek of DefaultLatticeSteps trees
+    // against the closed form, worst error as a fraction of the largest |Greek| over a few spots and maturities,
+    // bounds about 1.5 times the errors of each tree (Vega and Vanna of CRR and trinomial trees oscillate with the strike)
+    const double K = 100, r = 0.05, sigma = 0.25;
+    const double spots[] = {80, 90, 100, 110, 120}, maturities[] = {0.25, 1, 2};
+    const double bounds[3][NumGreekKinds] = {
+        // Delta   Gamma  Vega   Theta   Rho     Vanna   Volga   Charm   Speed   Color   Zomma
+        {1.5e-3, 3e-3, 3e-2,   2e-3,   1e-3,   3e-2,   1.5e-3, 1.5e-2, 8e-3,   8e-3,   8e-3},     // CRR
+        {1e-3,   7e-3, 6e-4,   3.5e-3, 5e-6,   3e-3,   1.5e-3, 3e-3,   1.1e-2, 1e-2,   8e-3},     // Leisen-Reimer
+        {5e-4,   4e-3, 2.5e-2, 3e-3,   5e-4,   2.5e-2, 1.5e-3, 2e-2,   1.5e-2, 1e-2,   1.2e-2}};  // trinomial
+    for (size_t m = 0; m < 3; ++m) {
+        const PricingModel model = models[m];
+        LatticeEngine engine(model);
+        double worst[NumGreekKinds] = {}, largest[NumGreekKinds] = {};
+        for (double S : spots)
+            for (double T : maturities) {
+                const GreekPoint e = FusedGreeks(K, S, r, 0, sigma, ComputeMaturityFactors(r, 0, T, sigma));
+                const GreekPoint g = engine.Greeks(K, S, T, sigma, r, 0, true, Greek_All);
+                const double exact[NumGreekKinds] = {e.deltaCall, e.gamma, e.vega, e.thetaCall, e.rhoCall, e.vanna, e.volga, e.charmCall,
+                                                     e.speed, e.color, e.zomma};
+                const double tree[NumGreekKinds] = {g.deltaCall, g.gamma, g.vega, g.thetaCall, g.rhoCall, g.vanna, g.volga, g.charmCall,
+                                                    g.speed, g.color, g.zomma};
+                for (size_t k = 0; k < NumGreekKinds; ++k) {
+                    largest[k] = std::max(largest[k], std::fabs(exact[k]));
+                    worst[k] = std::max(worst[k], std::isfinite(tree[k]) ? std::fabs(tree[k] - exact[k]) : INFINITY);
+                }
+            }
+        for (size_t k = 0; k < NumGreekKinds; ++k)
+            Expect(worst[k] <= bounds[m][k] * largest[k], "%s %s : error %.2g of the largest |Greek| > %.2g", ModelNames[model], GreekNames[k],
+                   worst[k] / largest[k], bounds[m][k]);
+    }
+
+    // Vols so low that sigma sqrt(dt) < r dt : finite prices within their no-arbitrage bounds
+    for (PricingModel model : models) {
+        LatticeEngine engine(model);
+        for (double vol : {0.005, 0.001})
+            for (bool call : {true, false}) {
+                const double S = 100, T = 1, rate = 0.10;
+                const GreekPoint g = engine.Greeks(K, S, T, vol, rate, 0, call, Greek_All);
+                const double price = call ? g.priceCall : g.pricePut, delta = call ? g.deltaCall : g.deltaPut;
+                const double low = std::max(call ? S - K * std::exp(-rate * T) : K - S, 0.0), high = call ? S : K;
+                Expect(price >= low - 1e-6 && price <= high, "%s sigma %g %s : price %g outside [%g, %g]", ModelNames[model], vol,
+                       call ? "call" : "put", price, low, high);
+                Expect(std::fabs(delta) <= 1 + 1e-9, "%s sigma %g %s : Delta %g", ModelNames[model], vol, call ? "call" : "put", delta);
+                const double values[] = {g.gamma, g.vega, g.volga, call ? g.thetaCall : g.thetaPut, call ? g.rhoCall : g.rhoPut};
+                Expect(std::all_of(std::begin(values), std::end(values), [](double x) { return std::isfinite(x); }),
+                       "%s sigma %g %s : Greeks not finite", ModelNames[model], vol, call ? "call" : "put");
+            }
+    }
+}
+
+// ---- implied volatilities at and around the intrinsic value ----
+
+// Status and vol of one price
+unsigned char Implied(double K, double S, double T, double r, double q, bool call, double price, double &vol) {
+    OptionBatch batch;
+    batch.push_back(K, S, T, 0.2, r, q, call);
+    unsigned char status;
+    ImpliedVolBatch(batch, &price, 0, 1, &vol, &status);
+    return status;
+}
+
+void TestImplied() {
+    double vol;
+    // exactly the intrinsic value
+    unsigned char status = Implied(100, 120, 1, 0, 0, true, 20, vol);
+    Expect(status == Iv_Ok && vol == 0, "S 120 K 100 call at 20 : %s, vol %g instead of 0", IvStatusName(status), vol);
+
+    // intrinsic values rounded as they would be computed, a few ulps either way : vol 0, never BelowIntrinsic
+    const double strikes[] = {50, 90, 99.5, 100.5, 110, 200}, maturities[] = {0.01, 1, 5};
+    for (double K : strikes)
+        for (double T : maturities)
+            for (bool call : {true, false}) {
+                const double S = 100, r = 0.05, q = 0.02;
+                const double intrinsic = call ? S * std::exp(-q * T) - K * std::exp(-r * T) : K * std::exp(-r * T) - S * std::exp(-q * T);
+                if (intrinsic <= 0) continue;
+                for (int ulps : {-4, 0, 4}) {
+                    const double price = intrinsic + ulps * std::numeric_limits<double>::epsilon() * std::max(S, K);
+                    status = Implied(K, S, T, r, q, call, price, vol);
+                    Expect(status == Iv_Ok && vol == 0, "K %g T %g %s at intrinsic %+d ulps : %s, vol %g instead of 0", K, T,
+                           call ? "call" : "put", ulps, IvStatusName(status), vol);
+                }
+                // a time value the price resolves, and a price clearly below the intrinsic value
+                status = Implied(K, S, T, r, q, call, intrinsic * (1 + 1e-6) + 1e-9, vol);
+                Expect(status == Iv_Ok && vol > 0, "K %g T %g %s above intrinsic : %s, vol %g", K, T, call ? "call" : "put", IvStatusName(status), vol);
+                status = Implied(K, S, T, r, q, call, intrinsic * (1 - 1e-6), vol);
+                Expect(status == Iv_BelowIntrinsic, "K %g T %g %s below intrinsic : %s", K, T, call ? "call" : "put", IvStatusName(status));
+            }
+
+    // model prices deep in the money at low vol : the time value is lost in the rounding of the price
+    for (double sigma : {0.01, 0.05}) {
+        const double K = 100, S = 200, T = 0.1, r = 0.03, q = 0;
+        const GreekPoint g = FusedGreeks(K, S, r, q, sigma, ComputeMaturityFactors(r, q, T, sigma));
+        status = Implied(K, S, T, r, q, true, g.priceCall, vol);
+        Expect(status == Iv_Ok && vol == 0, "model call S 200 K 100 sigma %g : %s, vol %g instead of 0", sigma, IvStatusName(status), vol);
+    }
+
+    // tiny out-of-the-money prices carry no intrinsic value and are still solved
+    for (double K : {300.0, 500.0}) {
+        const double S = 100, T = 0.5, r = 0.03, q = 0, sigma = 0.2;
+        const GreekPoint g = FusedGreeks(K, S, r, q, sigma, ComputeMaturityFactors(r, q, T, sigma));
+        status = Implied(K, S, T, r, q, true, g.priceCall, vol);
+        Expect(status == Iv_Ok && std::fabs(vol / sigma - 1) < 1e-6, "call K %g priced %.3g : %s, vol %g instead of %g", K, g.priceCall,
+               IvStatusName(status), vol, sigma);
+    }
+}
+
+// ---- adaptive grid budget ----
+
+void TestAdaptive() {
+    const double K = 100, r = 0.05, q = 0, T = 2, sigma = 0.2;
+    std::vector<double> S, Ts;
+    for (int numMaturities : {1, 3, 30})
+        for (size_t budget : {300, 1000, 2000, 20000}) {
+            size_t evaluations = 0;
+            const int status = BuildAdaptiveAxes(K, r, q, T, sigma, Model_BlackScholes, numMaturities, budget, S, Ts, &evaluations);
+            const size_t used = S.size() * Ts.size() + evaluations;
+            Expect(status == 0 && used <= budget, "%d maturities, budget %zu : status %d, %zu x %zu points + %zu probes = %zu", numMaturities,
+                   budget, status, S.size(), Ts.size(), evaluations, used);
+            Expect(Ts.size() == size_t(numMaturities) + 1 && S.size() >= 3 && std::binary_search(S.begin(), S.end(), K) &&
+                       S.front() == K / 100 && S.back() == 2 * K && Ts.front() == 0.01 && Ts.back() == T,
+                   "%d maturities, budget %zu : axes %zu x %zu without their ends or K", numMaturities, budget, S.size(), Ts.size());
+        }
+    // 31 maturities cannot get 3 stock prices and their probes out of 100 points
+    Expect(BuildAdaptiveAxes(K, r, q, T, sigma, Model_BlackScholes, 30, 100, S, Ts) == -1, "budget of 100 points for 31 maturities accepted");
+}
+
+// ---- decimation of curves with gaps ----
+
+void TestDecimation() {
+    // 100 points, NaN from 10 to 39 (whole buckets of 8 to 10 points at 12 kept points) and at S = 0 as a Greek
+    // can be : only the first point may be non-finite
+    std::vector<double> x(100), y(100);
+    for (size_t i = 0; i < x.size(); ++i) {
+        x[i] = double(i);
+        y[i] = i >= 10 && i < 40 ? NAN : std::sin(0.1 * double(i));
+    }
+    y[0] = INFINITY;
+    std::vector<size_t> kept;
+    for (size_t maxPoints : {5, 12, 30}) {
+        DecimateLttb(x, {y.data(), y.size()}, maxPoints, kept);
+        Expect(kept.size() >= 2 && kept.size() <= maxPoints && kept.front() == 0 && kept.back() == x.size() - 1 &&
+                   std::is_sorted(kept.begin(), kept.end()) && std::adjacent_find(kept.begin(), kept.end()) == kept.end(),
+               "%zu points : %zu kept, not the increasing indices of both ends", maxPoints, kept.size());
+        for (size_t k = 1; k + 1 < kept.size(); ++k)
+            Expect(std::isfinite(y[kept[k]]), "%zu points : non-finite point %zu kept", maxPoints, kept[k]);
+    }
+    // a curve of NaN keeps its ends only
+    std::fill(y.begin(), y.end(), NAN);
+    DecimateLttb(x, {y.data(), y.size()}, 12, kept);
+    Expect(kept.size() == 2, "all NaN curve : %zu points kept instead of 2", kept.size());
+}
+
+// ---- approximation tables ----
+
+void TestApprox() {
+    typedef double (*GreekFunction)(double &, double &, double &, double &, double &, double &, bool);
+    const std::pair<const char *, GreekFunction> greeks[] = {{"Delta", Delta}, {"Theta", Theta}, {"Rho", Rho}};
+    const ApproxDomain domain;
+    const ApproxTolerance tolerance;
+    double r = 0.03, q = 0.01;
+
+    // random contracts inside the box, then every corner, face and edge centre of it (3 values per axis)
+    std::vector<double> moneyness, T, sigma;
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> m(domain.moneynessMin, domain.moneynessMax), t(domain.TMin, domain.TMax),
+        s(domain.sigmaMin, domain.sigmaMax);
+    for (int k = 0; k < 4000; ++k) { moneyness.push_back(m(rng)); T.push_back(t(rng)); sigma.push_back(s(rng)); }
+    for (double a : {domain.moneynessMin, 1.0, domain.moneynessMax})
+        for (double b : {domain.TMin, 0.5 * (domain.TMin + domain.TMax), domain.TMax})
+            for (double c : {domain.sigmaMin, 0.5 * (domain.sigmaMin + domain.sigmaMax), domain.sigmaMax}) {
+                moneyness.push_back(a); T.push_back(b); sigma.push_back(c);
+            }
+
+    for (const auto &greek : greeks)
+        for (bool call : {true, false}) {
+            GreekApprox table;
+            const int status = table.Build(greek.first, call, r, q, domain, tolerance);
+            Expect(status == 0 && table.WorstRatio() <= 1, "%s %s : Build status %d, worst check %.2g of the tolerance", greek.first,
+                   call ? "call" : "put", status, table.WorstRatio());
+            // the tolerance holds for K = 1, Theta and Rho scale with K
+            double worst = 0;
+            for (double K : {1.0, 80.0}) {
+                const double scale = greek.first[0] == 'D' ? 1 : K;
+                for (size_t k = 0; k < moneyness.size(); ++k) {
+                    double strike = K, S = K * moneyness[k], tk = T[k], vol = sigma[k];
+                    const double exact = greek.second(strike, S, r, q, tk, vol, call) / scale;
+                    const double error = std::fabs(table.Evaluate(K, S, tk, vol) / scale - exact);
+                    worst = std::max(worst, error / std::max(tolerance.absolute, tolerance.relative * std::fabs(exact)));
+                }
+            }
+            Expect(worst <= 1, "%s %s : error %.2g of the tolerance", greek.first, call ? "call" : "put", worst);
+        }
+
+    GreekApprox table;
+    for (const char *greek : {"Gamma", "Vega", "Vanna"})
+        Expect(table.Build(greek, true, r, q, domain) == -1, "%s table built", greek);
+}
+
+struct Section {
+    const char *name;
+    void (*run)();
+};
+const Section Sections[] = {{"precision", TestPrecision}, {"aad", TestAad},           {"lattice", TestLattice},
+                            {"implied", TestImplied},     {"adaptive", TestAdaptive}, {"decimation", TestDecimation},
+                            {"approx", TestApprox}};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    for (int a = 1; a < argc; ++a)
+        if (std::none_of(std::begin(Sections), std::end(Sections), [&](const Section &s) { return std::strcmp(s.name, argv[a]) == 0; })) {
+            std::fprintf(stderr, "Unknown section: %s\nUsage: greeks_tests [section ...]\n", argv[a]);
+            return 1;
+        }
+    for (const Section &section : Sections) {
+        if (argc > 1 && std::none_of(argv + 1, argv + argc, [&](const char *arg) { return std::strcmp(section.name, arg) == 0; })) continue;
+        const int failures = g_failures, checks = g_checks;
+        section.run();
+        std::fprintf(stderr, "%-10s %d checks, %d failed\n", section.name, g_checks - checks, g_failures - failures);
+    }
+    return g_failures ? 1 : 0;
+}
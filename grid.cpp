@@ -0,0 +1,177 @@
+#include "grid.hpp"
+#include "Greeks.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <queue>
+
+void BuildStockAxis(double K, std::vector<double> &StockPrices) {
+    StockPrices.clear();
+    const double S_step = K / 100.0;
+    for (int i = 0; i <= 200; ++i)
+        StockPrices.push_back(i * S_step);
+}
+
+void BuildMaturityAxis(double T, int numMaturities, std::vector<double> &TimeToMaturities) {
+    TimeToMaturities.clear();
+    const double T_start = 0.01, T_step = (T - T_start) / static_cast<double>(numMaturities);
+    for (int k = 0; k <= numMaturities; ++k)
+        TimeToMaturities.push_back(T_start + k * T_step);
+}
+
+namespace {
+
+// Greeks per probe : the 8 rows of GreekRows
+constexpr size_t RowsPerProbe = 8;
+constexpr size_t NumProbes = 3;
+
+GreekRows ProbeRows(double *values, size_t stride) {
+    return {values, values + stride, values + 2 * stride, values + 3 * stride,
+            values + 4 * stride, values + 5 * stride, values + 6 * stride, values + 7 * stride};
+}
+
+// Greedy refinement of an axis starting from `seeds` (increasing), up to `count` points. Each interval between two
+// axis points is scored by how badly the linear interpolation of its ends predicts its midpoint, over `width` probe
+// curves each scaled by its range on the seeds, plus a term proportional to its length so that flat stretches still
+// get some points. The worst interval is split at its midpoint, which joins the axis. `evaluate(x, values)` fills the
+// `width` probe values at x. Returns the number of evaluations
+template <class Evaluate>
+size_t RefineAxis(const std::vector<double> &seeds, size_t count, size_t width, Evaluate &&evaluate, std::vector<double> &axis) {
+    const double LengthWeight = 1e-2;   // a lone interval spanning the whole axis scores as a 1% error
+    std::vector<double> xs, values;     // evaluated points, values[k * width + c]
+    auto add = [&](double x) {
+        xs.push_back(x);
+        values.resize(xs.size() * width);
+        evaluate(x, &values[(xs.size() - 1) * width]);
+        return xs.size() - 1;
+    };
+
+    std::vector<size_t> nodes;
+    for (double x : seeds) nodes.push_back(add(x));
+    std::vector<double> scale(width, 0.0);
+    for (size_t c = 0; c < width; ++c) {
+        double lo = INFINITY, hi = -INFINITY;
+        for (size_t k = 0; k < xs.size(); ++k) {
+            const double v = values[k * width + c];
+            if (std::isfinite(v)) { lo = std::min(lo, v); hi = std::max(hi, v); }
+        }
+        if (hi > lo) scale[c] = 1.0 / (hi - lo);
+    }
+
+    struct Candidate {
+        double score;
+        size_t a, b, mid;
+        bool operator<(const Candidate &other) const { return score < other.score; }
+    };
+    std::priority_queue<Candidate> heap;
+    const double span = seeds.back() - seeds.front();
+    auto push = [&](size_t a, size_t b) {
+        if (!(xs[b] - xs[a] > 1e-9 * span)) return;
+        const size_t mid = add(0.5 * (xs[a] + xs[b]));
+        double worst = 0;
+        for (size_t c = 0; c < width; ++c) {
+            const double va = values[a * width + c], vb = values[b * width + c], vm = values[mid * width + c];
+            if (std::isfinite(va) && std::isfinite(vb) && std::isfinite(vm))
+                worst = std::max(worst, std::fabs(vm - 0.5 * (va + vb)) * scale[c]);
+        }
+        heap.push({worst + LengthWeight * (xs[b] - xs[a]) / span, a, b, mid});
+    };
+    for (size_t k = 0; k + 1 < nodes.size(); ++k) push(nodes[k], nodes[k + 1]);
+    while (nodes.size() < count && !heap.empty()) {
+        const Candidate worst = heap.top();
+        heap.pop();
+        nodes.push_back(worst.mid);
+        push(worst.a, worst.mid);
+        push(worst.mid, worst.b);
+    }
+
+    axis.clear();
+    for (size_t k : nodes) axis.push_back(xs[k]);
+    std::sort(axis.begin(), axis.end());
+    return xs.size();
+}
+
+} // namespace
+
+int BuildAdaptiveAxes(double K, double r, double q, double T, double sigma, PricingModel model, int numMaturities, size_t gridPoints,
+                      std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities, size_t *evaluations) {
+    if (K <= 0 || T <= 0.01 || numMaturities < 1) {
+        std::cerr << "Invalid grid: K and T - 0.01 must be positive and numMaturities at least 1." << std::endl;
+        return -1;
+    }
+    const size_t nT = static_cast<size_t>(numMaturities) + 1;
+    // RefineAxis evaluates 2 count - 1 points per probe : the budget holds nS nT + NumProbes (2 nS - 1 + 2 nT - 1)
+    const size_t probeCost = NumProbes * (2 * nT - 1) - NumProbes;
+    const size_t nS = gridPoints ? (gridPoints > probeCost ? (gridPoints - probeCost) / (nT + 2 * NumProbes) : 0) : DefaultAdaptiveStocks;
+    if (nS < 3) {
+        std::cerr << "Adaptive grid budget of " << gridPoints << " points is too small: " << nT << " maturities need at least "
+                  << 3 * (nT + 2 * NumProbes) + probeCost << " (3 stock prices and the probes placing them)." << std::endl;
+        return -1;
+    }
+    const double sMin = K / 100.0, sMax = 2 * K, tMin = 0.01;
+    size_t evaluated = 0;
+
+    // stock axis, probed at the shortest, a middle (geometric mean) and the longest maturity
+    const std::vector<double> probeT = {tMin, std::sqrt(tMin * T), T};
+    MaturityColumns columns;
+    columns.Compute(r, q, probeT, sigma, model);
+    // seeds : the ends, K and up to 15 evenly spaced points, never more than the budget's nS
+    const size_t uniform = std::min<size_t>(16, nS - 2);
+    std::vector<double> seeds;
+    for (size_t k = 0; k <= uniform; ++k) seeds.push_back(sMin + k * (sMax - sMin) / uniform);
+    seeds.insert(std::upper_bound(seeds.begin(), seeds.end(), K), K);
+    seeds.erase(std::unique(seeds.begin(), seeds.end()), seeds.end());
+    evaluated += NumProbes * RefineAxis(seeds, nS, RowsPerProbe * NumProbes, [&](double S, double *values) {
+        FusedGreeksRow(K, S, r, q, sigma, columns, 0, NumProbes, ProbeRows(values, NumProbes), model);
+    }, StockPrices);
+
+    // maturity axis, probed at the money and 25% either side of it
+    const double probeS[NumProbes] = {0.75 * K, K, 1.25 * K};
+    std::vector<double> single(1);
+    seeds.clear();
+    const size_t steps = std::min<size_t>(4, nT - 1);
+    for (size_t k = 0; k <= steps; ++k) seeds.push_back(tMin + k * (T - tMin) / steps);
+    evaluated += NumProbes * RefineAxis(seeds, nT, RowsPerProbe * NumProbes, [&](double t, double *values) {
+        single[0] = t;
+        MaturityColumns column;
+        column.Compute(r, q, single, sigma, model);
+        for (size_t p = 0; p < NumProbes; ++p) FusedGreeksRow(K, probeS[p], r, q, sigma, column, 0, 1, ProbeRows(values + p * RowsPerProbe, 1), model);
+    }, TimeToMaturities);
+
+    if (evaluations) *evaluations = evaluated;
+    return 0;
+}
+
+int Recompute(double &K, double &S0, double &r, double &q, double &T, double &sigma, int numMaturities, unsigned greeks, unsigned options, PricingModel model,
+              std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities,
+              GreekTensor &GreekValues, const std::atomic<bool> *cancel, GridMode grid, size_t gridPoints) {
+    GREEKS_PROFILE_SCOPE("Recompute");
+
+    if (K <= 0 || T <= 0.01 || numMaturities < 1) {
+        std::cerr << "Invalid grid: K and T - 0.01 must be positive and numMaturities at least 1." << std::endl;
+        return -1;
+    }
+    if (!(greeks & Greek_All) || !(options & Option_All)) {
+        std::cerr << "Invalid grid: no Greek or no option type requested." << std::endl;
+        return -1;
+    }
+
+    if (grid == Grid_Adaptive) {
+        if (BuildAdaptiveAxes(K, r, q, T, sigma, model, numMaturities, gridPoints, StockPrices, TimeToMaturities) != 0) return -1;
+    } else {
+        BuildStockAxis(K, StockPrices);
+        BuildMaturityAxis(T, numMaturities, TimeToMaturities);
+    }
+
+    // Reshape (not resize) so every slice matches the new grid; the buffer is reused when it is large enough
+    GreekValues.Reshape(CountFlags(greeks & Greek_All), CountFlags(options & Option_All), StockPrices.size(), TimeToMaturities.size());
+
+    const double status = ComputeGreek(StockPrices, TimeToMaturities, greeks, options, model, K, S0, r, q, T, sigma, GreekValues, nullptr, cancel);
+    if (status == 1) return 1;   // cancelled
+    if (status != 0) {
+        std::cerr << "Error in ComputeGreek function." << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+#ifndef GRID_HPP_
+#define GRID_HPP_
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "GreekSet.hpp"
+#include "GreekTensor.hpp"
+
+// Grid axes, built from the point index so that a point keeps bit-identical values across rebuilds
+void BuildStockAxis(double K, std::vector<double> &StockPrices);                                // 0 to 2K in K/100 steps
+void BuildMaturityAxis(double T, int numMaturities, std::vector<double> &TimeToMaturities);     // 0.01 to T in numMaturities steps
+
+// Stock prices per maturity of an adaptive grid when no budget is given
+constexpr size_t DefaultAdaptiveStocks = 64;
+
+// Axes of Grid_Adaptive : numMaturities + 1 maturities from 0.01 to T and stock prices from K/100 to 2K, K always on
+// the stock axis. Each axis is refined where linear interpolation between its points misses every Greek of both option
+// types most, probed along a few maturities (S axis) or stock prices (T axis), so the axes only depend on the model
+// parameters, not on the Greeks requested. gridPoints caps the (S, T) points plus the probe evaluations placing them,
+// which sets the number of stock prices (gridPoints 0 : DefaultAdaptiveStocks per maturity, no cap).
+// `evaluations` (optional) receives the number of probe evaluations. Returns 0, -1 on error or when gridPoints is
+// below what 3 stock prices and their probes cost (reported on std::cerr)
+int BuildAdaptiveAxes(double K, double r, double q, double T, double sigma, PricingModel model, int numMaturities, size_t gridPoints,
+                      std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities, size_t *evaluations = nullptr);
+
+// Recompute GreekValues and X/Y grids from parameters, one [greek][option] slice per flag of `greeks` and `options`
+// (GreekSet.hpp), on uniform or adaptive axes (`gridPoints` : budget of Grid_Adaptive, see BuildAdaptiveAxes).
+// Returns 0, -1 on error, 1 if cancelled through `cancel`
+int Recompute(double &K, double &S0, double &r, double &q, double &T, double &sigma, int numMaturities, unsigned greeks, unsigned options, PricingModel model,
+              std::vector<double> &StockPrices, std::vector<double> &TimeToMaturities,
+              GreekTensor &GreekValues, const std::atomic<bool> *cancel = nullptr, GridMode grid = Grid_Uniform, size_t gridPoints = 0);
+
+#endif /* GRID_HPP_ */
@@ -1,6 +1,11 @@
 #include "data.hpp"
 #include "func.hpp"
 #include "Greeks.hpp"
+#include "AsyncRecompute.hpp"
+#include "Chain.hpp"
+#include "GreekRenderer.hpp"
+#include "Lattice.hpp"
+#include "Profiler.hpp"
 #include <iostream>
 #include <vector>
 #include <string>
@@ -14,9 +19,29 @@ using namespace std;
 using namespace matplot;
 
 int main() {
+    //  parameters (read before any window is created)
+    Parameters params;
+    ReadParameters("../param.txt", params);
+    double S0 = params.S0; double T = params.T; double K = params.K; double sigma = params.sigma; double r = params.r; double q = params.q; double ITM = params.ITM; double OTM = params.OTM;
+    unsigned greeks = params.greeks; unsigned options = params.options; PricingModel model = params.model; int numMaturities = static_cast<int>(params.numMaturities);
+    GridMode gridMode = params.grid; int gridPoints = static_cast<int>(params.gridPoints);
+    SetNumThreads(params.numThreads > 0 ? params.numThreads : 0);
+    if (params.treeSteps) SetLatticeSteps(params.treeSteps);
+
+    // chain plot : strikes, expiries and smile read once
+    OptionChain chain;
+    if (params.plotTypes.find("Chain") != std::string::npos) {
+        ChainSpec spec;
+        if (ReadChainFile(params.chainFile, spec) != 0 || chain.Set(spec) != 0) {
+            std::cerr << "No chain to plot, defaulting to Simple." << std::endl;
+            params.plotTypes = "Simple";
+        }
+    }
+    
+
     // ---- Initialize GLFW + ImGui ----
     if (!glfwInit()) return -1;
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Option Greeks Control Panel", NULL, NULL);
+    GLFWwindow* window = glfwCreateWindow(1280, 960, "Option Greeks Control Panel", NULL, NULL);
     glfwMakeContextCurrent(window);
     glfwSwapInterval(1);
 
@@ -27,22 +52,22 @@ int main() {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 130");
 
-    //  parameters 
-    Parameters params;
-    ReadParameters("../param.txt", params);
-    double S0 = params.S0; double T = params.T; double K = params.K; double sigma = params.sigma; double r = params.r; double q = params.q; double ITM = params.ITM; double OTM = params.OTM;
-    std::string greekTypes = params.greekTypes; std::string optionTypes = params.optionTypes; int numMaturities = static_cast<int>(params.numMaturities);
-    
+    // figures drawn in the window, unless Renderer=Matplot or the context has no OpenGL 3 (Matplot++ figures then)
+    GreekRenderer renderer;
+    GreekRenderer *plotRenderer = nullptr;
+    if (params.renderer == Renderer_OpenGL) {
+        if (renderer.Init(glfwGetProcAddress) == 0) plotRenderer = &renderer;
+        else std::cerr << "OpenGL renderer unavailable, plotting with Matplot++." << std::endl;
+    }
 
-    vector<double> StockPrices, TimeToMaturities;
-    std::vector<std::vector<std::vector<std::vector<double>>>> GreekValues;
 
-    if (Recompute(K, S0, r, q, T, sigma, numMaturities, greekTypes, optionTypes, StockPrices, TimeToMaturities, GreekValues) != 0) {
-        std::cerr << "Initial Recompute failed" << std::endl;
-    }
+    // Greeks are computed on a background worker, the GUI shows the last published result
+    AsyncRecompute recompute;
+    recompute.Submit({K, S0, r, q, T, sigma, numMaturities, greeks, options, model, gridMode, params.gridPoints});
 
 
     // ---- GUI Loop ----
+    GREEKS_PROFILE_THREAD("GUI");
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
 
@@ -50,30 +75,42 @@ int main() {
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        if (plotRenderer) ImGui::SetNextWindowSize(ImVec2(1240, 920), ImGuiCond_FirstUseEver);
         ImGui::Begin("Parameter Controls");
         // plot either 2D, 3D or Moneyness based on params.plotTypes -> can't do multiple plots in the same run
         if (params.plotTypes.find("Simple") != std::string::npos){
-            Plot2D(ITM, OTM, K, S0, r, q, T, sigma, numMaturities, greekTypes, StockPrices, TimeToMaturities, GreekValues, optionTypes, params.plotTypes);
+            Plot2D(ITM, OTM, K, S0, r, q, T, sigma, numMaturities, greeks, recompute, options, model, gridMode, gridPoints, params.plotTypes, plotRenderer);
         } else if (params.plotTypes.find("3D") != std::string::npos){
-            Plot3D(ITM, OTM, K, S0, r, q, T, sigma, numMaturities, greekTypes, StockPrices, TimeToMaturities, GreekValues, optionTypes, params.plotTypes);
+            Plot3D(ITM, OTM, K, S0, r, q, T, sigma, numMaturities, greeks, recompute, options, model, gridMode, gridPoints, params.plotTypes, plotRenderer);
+        } else if (params.plotTypes.find("Chain") != std::string::npos){
+            PlotChain(S0, r, q, greeks, options, model, chain, plotRenderer);
         } else if (params.plotTypes.find("Moneyness") != std::string::npos){
-            PlotMoneyness(ITM, OTM, K, S0, r, q, T, sigma, numMaturities, greekTypes, StockPrices, TimeToMaturities, GreekValues, optionTypes, params.plotTypes);
+            PlotMoneyness(ITM, OTM, K, S0, r, q, T, sigma, numMaturities, greeks, recompute, options, model, gridMode, gridPoints, params.plotTypes, plotRenderer);
         } else {
             std::cerr << "Unknown plot type: " << params.plotTypes << ". Defaulting to Simple." << std::endl;
         }
         ImGui::End();
+        ProfilerPanel();
 
         // Render
-        ImGui::Render();
-        int display_w, display_h;
-        glfwGetFramebufferSize(window, &display_w, &display_h);
-        glViewport(0, 0, display_w, display_h);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        glfwSwapBuffers(window);
+        {
+            GREEKS_PROFILE_SCOPE("Render");
+            ImGui::Render();
+            int display_w, display_h;
+            glfwGetFramebufferSize(window, &display_w, &display_h);
+            glViewport(0, 0, display_w, display_h);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        {
+            GREEKS_PROFILE_SCOPE("SwapBuffers");   // includes the wait for vsync
+            glfwSwapBuffers(window);
+        }
+        GREEKS_PROFILE_FRAME();
     }
 
     // cleanup
+    renderer.Release();   // while the context is current
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();